@@ -0,0 +1,1191 @@
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "../inc/steam.h"
+#include "../inc/steamdef.h"
+#include "../inc/inventory.h"
+#include "../inc/listings.h"
+#include "../inc/history.h"
+#include "../inc/price.h"
+#include "../inc/description_cache.h"
+
+#define BENCH_MIN_SECONDS     0.5
+#define BENCH_MIN_ITERATIONS  3
+#define BENCH_MAX_ITERATIONS  10000000
+#define BENCH_NAME_SIZE       64
+#define BENCH_PATH_SIZE       512
+#define BENCH_INVENTORY_ID    "76561190000000000"
+#define BENCH_MAX_FIXTURES    32
+
+/* glibc entry points behind malloc () and friends, the bench replaces
+ * the public ones to count allocations of the library, curl and json-c */
+extern void *__libc_malloc (size_t);
+extern void *__libc_calloc (size_t, size_t);
+extern void *__libc_realloc (void *, size_t);
+extern void __libc_free (void *);
+
+typedef struct tBenchCounters {
+	uint64_t  count_allocations;
+	uint64_t  bytes_allocated;
+} BenchCounters;
+
+typedef struct tBenchResult {
+	char      name[BENCH_NAME_SIZE];
+	uint64_t  count_items;
+	uint64_t  iterations;
+	double    ns_per_op;
+	double    allocations_per_op;
+	double    bytes_per_op;
+	long      peak_rss_kb;
+} BenchResult;
+
+/* Runs one operation, returns nanoseconds to count (setup excluded) */
+typedef uint64_t (*BenchOperation) (void *);
+
+typedef struct tBenchCase {
+	const char      *name;
+	uint64_t         count_items;
+	BenchOperation   operation;
+} BenchCase;
+
+static BenchCounters s_counters = { 0, 0 };
+static char s_fixture_dir[BENCH_PATH_SIZE] = {0};
+static char s_fixture_paths[BENCH_MAX_FIXTURES][BENCH_PATH_SIZE * 2];
+static uint32_t s_count_fixture_paths = 0;
+static char s_work_buffer[URL_SIZE * 3] = {0};
+static char *s_price_history = NULL;
+static struct json_object *s_description_json = NULL;
+
+void *malloc (size_t);
+void *calloc (size_t, size_t);
+void *realloc (void *, size_t);
+void free (void *);
+
+static uint64_t now_ns (void);
+static int8_t write_fixture (const char *, const char *, size_t);
+static int8_t make_fixture_dirs (const char *);
+static void remember_fixture_path (const char *);
+static void remove_fixtures (void);
+static int8_t write_inventory_fixture (uint64_t);
+static int8_t write_listings_fixture (uint64_t);
+static int8_t write_history_fixture (uint64_t);
+static char *build_price_history (uint64_t);
+static uint64_t bench_url_encode (void *);
+static uint64_t bench_base64_encode (void *);
+static uint64_t bench_get_json_object_as_string (void *);
+static uint64_t bench_get_inventory_items (void *);
+static uint64_t bench_free_steam_inventory (void *);
+static uint64_t bench_get_my_listings (void *);
+static uint64_t bench_parse_price_history (void *);
+static int8_t count_history_event (const HistoryEvent *, void *);
+static uint64_t bench_history_store (void *);
+static uint64_t bench_sync_market_history (void *);
+static void run_bench_case (const BenchCase *, BenchResult *);
+static int8_t run_bench_case_isolated (const BenchCase *, BenchResult *);
+static void print_bench_result (const BenchResult *, int8_t);
+
+/*===========================================================================*
+ * Function name    : malloc, calloc, realloc, free                          *
+ *                                                                           *
+ * Description      : These functions count allocations and requested        *
+ *                    bytes, then call glibc allocator                       *
+ *                                                                           *
+ * Input values(s)  : As of libc                                             *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : As of libc                                             *
+ *===========================================================================*/
+void *malloc (size_t size)
+{
+	__atomic_add_fetch (&s_counters.count_allocations, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch (&s_counters.bytes_allocated, size, __ATOMIC_RELAXED);
+
+	return __libc_malloc (size);
+}
+
+void *calloc (size_t count, size_t size)
+{
+	__atomic_add_fetch (&s_counters.count_allocations, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch (&s_counters.bytes_allocated, count * size, __ATOMIC_RELAXED);
+
+	return __libc_calloc (count, size);
+}
+
+void *realloc (void *ptr, size_t size)
+{
+	__atomic_add_fetch (&s_counters.count_allocations, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch (&s_counters.bytes_allocated, size, __ATOMIC_RELAXED);
+
+	return __libc_realloc (ptr, size);
+}
+
+void free (void *ptr)
+{
+	__libc_free (ptr);
+}
+
+/*===========================================================================*
+ * Function name    : now_ns                                                 *
+ *                                                                           *
+ * Description      : This function get monotonic time                       *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t now_ns (void)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/*===========================================================================*
+ * Function name    : remember_fixture_path                                  *
+ *                                                                           *
+ * Description      : This function remember created file or directory to    *
+ *                    remove it at exit                                      *
+ *                                                                           *
+ * Input values(s)  : path - full path                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void remember_fixture_path (const char *path)
+{
+	for (uint32_t index = 0; index < s_count_fixture_paths; index++)
+	{
+		if (strcmp (s_fixture_paths[index], path) == STRINGS_EQUAL)
+			return;
+	}
+
+	if (s_count_fixture_paths < BENCH_MAX_FIXTURES)
+	{
+		snprintf (s_fixture_paths[s_count_fixture_paths++], BENCH_PATH_SIZE * 2, "%s", path);
+	}
+}
+
+/*===========================================================================*
+ * Function name    : remove_fixtures                                        *
+ *                                                                           *
+ * Description      : This function remove fixtures, files written by the    *
+ *                    library (cookie jar, history store) and the fixture    *
+ *                    directory                                              *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void remove_fixtures (void)
+{
+	unlink ("cookie.txt");
+	unlink ("history.bench");
+	unlink ("history.bench.idx");
+
+	/* Directories were remembered before the files inside them */
+	while (s_count_fixture_paths > 0)
+	{
+		remove (s_fixture_paths[--s_count_fixture_paths]);
+	}
+
+	if (chdir ("/") == 0)
+	{
+		rmdir (s_fixture_dir);
+	}
+}
+
+/*===========================================================================*
+ * Function name    : make_fixture_dirs                                      *
+ *                                                                           *
+ * Description      : This function create directories of fixture path       *
+ *                                                                           *
+ * Input values(s)  : path - relative to fixture directory, ends with file   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t make_fixture_dirs (const char *path)
+{
+	char full_path[BENCH_PATH_SIZE * 2] = {0};
+	size_t length_dir = strlen (s_fixture_dir);
+
+	snprintf (full_path, sizeof (full_path), "%s/%s", s_fixture_dir, path);
+
+	for (char *ptr = full_path + length_dir + 1; *ptr != '\0'; ptr++)
+	{
+		if (*ptr != '/')
+			continue;
+
+		*ptr = '\0';
+
+		if (mkdir (full_path, 0700) != 0 && errno != EEXIST)
+		{
+			return FAILURE;
+		}
+
+		remember_fixture_path (full_path);
+
+		*ptr = '/';
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : write_fixture                                          *
+ *                                                                           *
+ * Description      : This function write fixture file                       *
+ *                                                                           *
+ * Input values(s)  : path - relative to fixture directory                   *
+ *                    data                                                   *
+ *                    size_data                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t write_fixture (const char *path, const char *data, size_t size_data)
+{
+	char full_path[BENCH_PATH_SIZE * 2] = {0};
+	FILE *file = NULL;
+	int8_t return_value = SUCCESS;
+
+	if (make_fixture_dirs (path) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	snprintf (full_path, sizeof (full_path), "%s/%s", s_fixture_dir, path);
+
+	file = fopen (full_path, "wb");
+
+	if (file == NULL)
+	{
+		return FAILURE;
+	}
+
+	remember_fixture_path (full_path);
+
+	if (fwrite (data, 1, size_data, file) != size_data)
+		return_value = FAILURE;
+
+	if (fclose (file) != 0)
+		return_value = FAILURE;
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : write_inventory_fixture                                *
+ *                                                                           *
+ * Description      : This function write one page inventory response, four  *
+ *                    assets per description as in trading card inventories  *
+ *                                                                           *
+ * Input values(s)  : count_items                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t write_inventory_fixture (uint64_t count_items)
+{
+	char path[BENCH_PATH_SIZE] = {0};
+	char *data = NULL;
+	size_t size_data = 0;
+	size_t length = 0;
+	uint64_t count_descriptions = (count_items + 3) / 4;
+	int8_t return_value = FAILURE;
+
+	size_data = 64 + count_items * 160 + count_descriptions * 192;
+	data = malloc (size_data);
+
+	if (data == NULL)
+	{
+		return FAILURE;
+	}
+
+	length += snprintf (data + length, size_data - length, "{\"assets\":[");
+
+	for (uint64_t index = 0; index < count_items; index++)
+	{
+		length += snprintf (data + length, size_data - length,
+		                    "%s{\"appid\":753,\"contextid\":\"6\",\"assetid\":\"%llu\","
+		                    "\"classid\":\"%llu\",\"instanceid\":\"0\",\"amount\":\"1\"}",
+		                    index > 0 ? "," : "",
+		                    (unsigned long long)(20000000000ULL + index),
+		                    (unsigned long long)(100000 + index / 4));
+	}
+
+	length += snprintf (data + length, size_data - length, "],\"descriptions\":[");
+
+	for (uint64_t index = 0; index < count_descriptions; index++)
+	{
+		length += snprintf (data + length, size_data - length,
+		                    "%s{\"appid\":753,\"classid\":\"%llu\",\"instanceid\":\"0\","
+		                    "\"marketable\":1,\"market_hash_name\":"
+		                    "\"%llu-Trading Card %llu (Foil)\"}",
+		                    index > 0 ? "," : "",
+		                    (unsigned long long)(100000 + index),
+		                    (unsigned long long)(200000 + index % 997),
+		                    (unsigned long long)index);
+	}
+
+	length += snprintf (data + length, size_data - length,
+	                    "],\"total_inventory_count\":%llu,\"success\":1}",
+	                    (unsigned long long)count_items);
+
+	/* The query string is not part of a file:// path */
+	snprintf (path, BENCH_PATH_SIZE, "inventory/%s%llu/753/6", BENCH_INVENTORY_ID,
+	          (unsigned long long)count_items);
+
+	return_value = write_fixture (path, data, length);
+
+	free (data);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : write_listings_fixture                                 *
+ *                                                                           *
+ * Description      : This function write mylistings page, every page offset *
+ *                    reads the same file                                    *
+ *                                                                           *
+ * Input values(s)  : count_listings - num_active_listings                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t write_listings_fixture (uint64_t count_listings)
+{
+	char *data = NULL;
+	size_t size_data = 256 + MY_LISTINGS_PAGE_SIZE * 320;
+	size_t length = 0;
+	int8_t return_value = FAILURE;
+
+	data = malloc (size_data);
+
+	if (data == NULL)
+	{
+		return FAILURE;
+	}
+
+	length += snprintf (data + length, size_data - length,
+	                    "{\"success\":true,\"num_active_listings\":%llu,\"listings\":[",
+	                    (unsigned long long)count_listings);
+
+	for (uint32_t index = 0; index < MY_LISTINGS_PAGE_SIZE; index++)
+	{
+		length += snprintf (data + length, size_data - length,
+		                    "%s{\"listingid\":\"%u\",\"time_created\":1600000000,"
+		                    "\"price\":%u,\"fee\":%u,\"asset\":{\"appid\":753,"
+		                    "\"contextid\":\"6\",\"id\":\"%u\",\"market_hash_name\":"
+		                    "\"200000-Trading Card %u\"}}",
+		                    index > 0 ? "," : "", 3000000000U + index, 100 + index,
+		                    15 + index / 10, 100000 + index, index);
+	}
+
+	length += snprintf (data + length, size_data - length,
+	                    "],\"listings_on_hold\":[],\"listings_to_confirm\":[],"
+	                    "\"buy_orders\":[]}");
+
+	/* Listing count is baked in, one directory per size */
+	snprintf (s_work_buffer, sizeof (s_work_buffer), "listings%llu/market/mylistings",
+	          (unsigned long long)count_listings);
+
+	return_value = write_fixture (s_work_buffer, data, length);
+
+	free (data);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : write_history_fixture                                  *
+ *                                                                           *
+ * Description      : This function write myhistory render page of sold      *
+ *                    items: rows, hovers linking them to assets and assets  *
+ *                                                                           *
+ * Input values(s)  : count_events - rows and total_count                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t write_history_fixture (uint64_t count_events)
+{
+	char *data = NULL;
+	size_t size_data = 256 + count_events * 1024;
+	size_t length = 0;
+	int8_t return_value = FAILURE;
+
+	data = malloc (size_data);
+
+	if (data == NULL)
+	{
+		return FAILURE;
+	}
+
+	length += snprintf (data + length, size_data - length,
+	                    "{\"success\":true,\"pagesize\":%llu,\"total_count\":%llu,"
+	                    "\"start\":0,\"results_html\":\"",
+	                    (unsigned long long)count_events,
+	                    (unsigned long long)count_events);
+
+	/* Newest first, twenty events a day */
+	for (uint64_t index = 0; index < count_events; index++)
+	{
+		length += snprintf (data + length, size_data - length,
+		                    "<div class=\\\"market_listing_row market_recent_listing_row\\\""
+		                    " id=\\\"history_row_%llu_%llu\\\">"
+		                    "<div class=\\\"market_listing_left_cell market_listing_gainorloss\\\">"
+		                    "+</div><div class=\\\"market_listing_right_cell"
+		                    " market_listing_their_price\\\"><span class=\\\"market_table_value\\\">"
+		                    "<span class=\\\"market_listing_price\\\">$%llu.%02llu</span></span>"
+		                    "</div><div class=\\\"market_listing_right_cell market_listing_listed_date"
+		                    " can_combine\\\">%llu Oct</div><div class=\\\"market_listing_right_cell"
+		                    " market_listing_listed_date can_combine\\\">%llu Oct</div>"
+		                    "<div class=\\\"market_listing_right_cell market_listing_whoactedwith\\\">"
+		                    "Buyer:</div><span id=\\\"history_row_%llu_%llu_name\\\""
+		                    " class=\\\"market_listing_item_name\\\">200000-Trading Card %llu"
+		                    "</span></div>",
+		                    (unsigned long long)(4000000000ULL - index),
+		                    (unsigned long long)(5000000000ULL - index),
+		                    (unsigned long long)(index % 50),
+		                    (unsigned long long)(index % 100),
+		                    (unsigned long long)(28 - index / 20 % 28),
+		                    (unsigned long long)(28 - index / 20 % 28),
+		                    (unsigned long long)(4000000000ULL - index),
+		                    (unsigned long long)(5000000000ULL - index),
+		                    (unsigned long long)(index % 997));
+	}
+
+	length += snprintf (data + length, size_data - length, "\",\"hovers\":\"");
+
+	for (uint64_t index = 0; index < count_events; index++)
+	{
+		length += snprintf (data + length, size_data - length,
+		                    "CreateItemHoverFromContainer( g_rgAssets, 'history_row_%llu_%llu"
+		                    "_name', 753, '6', '%llu', 0 );",
+		                    (unsigned long long)(4000000000ULL - index),
+		                    (unsigned long long)(5000000000ULL - index),
+		                    (unsigned long long)(20000000000ULL + index));
+	}
+
+	length += snprintf (data + length, size_data - length,
+	                    "\",\"assets\":{\"753\":{\"6\":{");
+
+	for (uint64_t index = 0; index < count_events; index++)
+	{
+		length += snprintf (data + length, size_data - length,
+		                    "%s\"%llu\":{\"appid\":753,\"contextid\":\"6\",\"id\":\"%llu\","
+		                    "\"market_hash_name\":\"200000-Trading Card %llu\"}",
+		                    index > 0 ? "," : "",
+		                    (unsigned long long)(20000000000ULL + index),
+		                    (unsigned long long)(20000000000ULL + index),
+		                    (unsigned long long)(index % 997));
+	}
+
+	length += snprintf (data + length, size_data - length, "}}}}");
+
+	return_value = write_fixture ("myhistory/render", data, length);
+
+	free (data);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : build_price_history                                    *
+ *                                                                           *
+ * Description      : This function build pricehistory response of hourly    *
+ *                    points                                                 *
+ *                                                                           *
+ * Input values(s)  : count_points                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Response or NULL                                       *
+ *===========================================================================*/
+static char *build_price_history (uint64_t count_points)
+{
+	static const char *months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+	                                "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+	size_t size_data = 128 + count_points * 48;
+	size_t length = 0;
+	char *data = malloc (size_data);
+
+	if (data == NULL)
+	{
+		return NULL;
+	}
+
+	length += snprintf (data, size_data, "{\"success\":true,\"price_prefix\":\"$\","
+	                    "\"price_suffix\":\"\",\"prices\":[");
+
+	for (uint64_t index = 0; index < count_points; index++)
+	{
+		uint64_t hour = index % 24;
+		uint64_t day = index / 24;
+
+		length += snprintf (data + length, size_data - length,
+		                    "%s[\"%s %02llu %llu %02llu: +0\",%llu.%03llu,\"%llu\"]",
+		                    index > 0 ? "," : "", months[(day / 28) % 12],
+		                    (unsigned long long)(day % 28 + 1),
+		                    (unsigned long long)(2014 + day / 336),
+		                    (unsigned long long)hour,
+		                    (unsigned long long)(index % 50),
+		                    (unsigned long long)(index * 7 % 1000),
+		                    (unsigned long long)(index % 300 + 1));
+	}
+
+	snprintf (data + length, size_data - length, "]}");
+
+	return data;
+}
+
+/*===========================================================================*
+ * Function name    : bench_url_encode                                       *
+ *                                                                           *
+ * Description      : This function encode market hash name                  *
+ *                                                                           *
+ * Input values(s)  : context - not used                                     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t bench_url_encode (void *context)
+{
+	uint64_t start = now_ns ();
+
+	(void)context;
+
+	url_encode ("StatTrak\xe2\x84\xa2 AK-47 | Redline (Field-Tested)",
+	            s_work_buffer, g_rfc3986);
+
+	return now_ns () - start;
+}
+
+/*===========================================================================*
+ * Function name    : bench_base64_encode                                    *
+ *                                                                           *
+ * Description      : This function encode RSA encrypted password            *
+ *                                                                           *
+ * Input values(s)  : context - not used                                     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t bench_base64_encode (void *context)
+{
+	static uint8_t input[256];
+	uint64_t start = now_ns ();
+
+	(void)context;
+
+	/* Size of RSA encrypted password */
+	base64_encode (input, sizeof (input), s_work_buffer, NULL);
+
+	return now_ns () - start;
+}
+
+/*===========================================================================*
+ * Function name    : bench_get_json_object_as_string                        *
+ *                                                                           *
+ * Description      : This function copy market hash name of description     *
+ *                                                                           *
+ * Input values(s)  : context - not used                                     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t bench_get_json_object_as_string (void *context)
+{
+	char *ptr_value = NULL;
+	uint64_t start = now_ns ();
+
+	(void)context;
+
+	get_json_object_as_string (&ptr_value, s_description_json, "market_hash_name");
+	steam_free (ptr_value);
+
+	return now_ns () - start;
+}
+
+/*===========================================================================*
+ * Function name    : bench_get_inventory_items                              *
+ *                                                                           *
+ * Description      : This function load inventory from fixture (parse and   *
+ *                    join of assets with descriptions)                      *
+ *                                                                           *
+ * Input values(s)  : context - count items                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t bench_get_inventory_items (void *context)
+{
+	const uint64_t *count_items = context;
+	SteamInventory *steam_inventory = NULL;
+	uint64_t elapsed = 0;
+	uint64_t start = 0;
+
+	snprintf (s_work_buffer, sizeof (s_work_buffer), "%s%llu", BENCH_INVENTORY_ID,
+	          (unsigned long long)*count_items);
+
+	start = now_ns ();
+
+	steam_inventory = get_inventory_items (s_work_buffer);
+
+	elapsed = now_ns () - start;
+
+	if (steam_inventory == NULL || steam_inventory->count_items != *count_items)
+	{
+		fprintf (stderr, "get_inventory_items () failed\n");
+		exit (EXIT_FAILURE);
+	}
+
+	free_steam_inventory (steam_inventory);
+
+	return elapsed;
+}
+
+/*===========================================================================*
+ * Function name    : bench_free_steam_inventory                             *
+ *                                                                           *
+ * Description      : This function free loaded inventory, loading is not    *
+ *                    measured                                               *
+ *                                                                           *
+ * Input values(s)  : context - count items                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t bench_free_steam_inventory (void *context)
+{
+	const uint64_t *count_items = context;
+	SteamInventory *steam_inventory = NULL;
+	uint64_t count_allocations = 0;
+	uint64_t bytes_allocated = 0;
+	uint64_t start = 0;
+
+	snprintf (s_work_buffer, sizeof (s_work_buffer), "%s%llu", BENCH_INVENTORY_ID,
+	          (unsigned long long)*count_items);
+
+	/* Only the free is measured, allocations of the setup are not counted */
+	count_allocations = s_counters.count_allocations;
+	bytes_allocated = s_counters.bytes_allocated;
+
+	steam_inventory = get_inventory_items (s_work_buffer);
+
+	if (steam_inventory == NULL)
+	{
+		fprintf (stderr, "get_inventory_items () failed\n");
+		exit (EXIT_FAILURE);
+	}
+
+	s_counters.count_allocations = count_allocations;
+	s_counters.bytes_allocated = bytes_allocated;
+
+	start = now_ns ();
+
+	free_steam_inventory (steam_inventory);
+
+	return now_ns () - start;
+}
+
+/*===========================================================================*
+ * Function name    : bench_get_my_listings                                  *
+ *                                                                           *
+ * Description      : This function load all pages of own listings           *
+ *                                                                           *
+ * Input values(s)  : context - not used                                     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t bench_get_my_listings (void *context)
+{
+	MyListings *my_listings = NULL;
+	uint64_t start = now_ns ();
+
+	(void)context;
+
+	my_listings = get_my_listings (8);
+
+	if (my_listings == NULL)
+	{
+		fprintf (stderr, "get_my_listings () failed\n");
+		exit (EXIT_FAILURE);
+	}
+
+	free_my_listings (my_listings);
+
+	return now_ns () - start;
+}
+
+/*===========================================================================*
+ * Function name    : bench_parse_price_history                              *
+ *                                                                           *
+ * Description      : This function scan pricehistory response               *
+ *                                                                           *
+ * Input values(s)  : context - not used                                     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t bench_parse_price_history (void *context)
+{
+	PriceSeries *series = NULL;
+	uint64_t start = now_ns ();
+
+	(void)context;
+
+	series = create_price_series (0);
+
+	if (series == NULL || parse_price_history (s_price_history, series) != SUCCESS)
+	{
+		fprintf (stderr, "parse_price_history () failed\n");
+		exit (EXIT_FAILURE);
+	}
+
+	free_price_series (series);
+
+	return now_ns () - start;
+}
+
+/*===========================================================================*
+ * Function name    : count_history_event                                    *
+ *                                                                           *
+ * Description      : This function count visited history events             *
+ *                                                                           *
+ * Input values(s)  : event                                                  *
+ *                    user_data - counter                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS                                                *
+ *===========================================================================*/
+static int8_t count_history_event (const HistoryEvent *event, void *user_data)
+{
+	uint64_t *count_events = user_data;
+
+	(void)event;
+
+	(*count_events)++;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : bench_history_store                                    *
+ *                                                                           *
+ * Description      : This function append events to new history store       *
+ *                    and visit them all                                     *
+ *                                                                           *
+ * Input values(s)  : context - count events                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t bench_history_store (void *context)
+{
+	const uint64_t *count_events = context;
+	HistoryStore *store = NULL;
+	HistoryEvent *events = NULL;
+	uint64_t count_visited = 0;
+	uint64_t count_allocations = 0;
+	uint64_t bytes_allocated = 0;
+	uint64_t elapsed = 0;
+	uint64_t start = 0;
+
+	/* Only the store is measured, allocations of the setup are not counted */
+	count_allocations = s_counters.count_allocations;
+	bytes_allocated = s_counters.bytes_allocated;
+
+	events = calloc (*count_events, sizeof (HistoryEvent));
+
+	if (events == NULL)
+	{
+		exit (EXIT_FAILURE);
+	}
+
+	for (uint64_t index = 0; index < *count_events; index++)
+	{
+		events[index].row_id = 1000000 + index;
+		events[index].time_acted = 1400000000 + (int64_t)(index / 40) * 86400;
+		events[index].event_type = HISTORY_EVENT_SOLD;
+		events[index].app_id = 753;
+		events[index].context_id = 6;
+		events[index].asset_id = 20000000000ULL + index;
+		events[index].price = 100 + index % 1000;
+		snprintf (events[index].market_hash_name, HISTORY_NAME_SIZE,
+		          "200000-Trading Card %llu", (unsigned long long)(index % 997));
+	}
+
+	unlink ("history.bench");
+	unlink ("history.bench.idx");
+
+	s_counters.count_allocations = count_allocations;
+	s_counters.bytes_allocated = bytes_allocated;
+
+	start = now_ns ();
+
+	store = open_history_store ("history.bench");
+
+	if (store == NULL ||
+	    append_history_events (store, events, *count_events) != SUCCESS ||
+	    visit_history_events (store, 0, INT64_MAX, count_history_event,
+	                          &count_visited) != SUCCESS ||
+	    count_visited != *count_events)
+	{
+		fprintf (stderr, "history store failed\n");
+		exit (EXIT_FAILURE);
+	}
+
+	close_history_store (store);
+
+	elapsed = now_ns () - start;
+
+	free (events);
+
+	return elapsed;
+}
+
+/*===========================================================================*
+ * Function name    : bench_sync_market_history                              *
+ *                                                                           *
+ * Description      : This function sync history page from fixture into new  *
+ *                    history store (parse of rows, hovers and assets and    *
+ *                    append), opening the store is not measured             *
+ *                                                                           *
+ * Input values(s)  : context - count events                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Nanoseconds                                            *
+ *===========================================================================*/
+static uint64_t bench_sync_market_history (void *context)
+{
+	const uint64_t *count_events = context;
+	HistoryStore *store = NULL;
+	uint64_t count_new_events = 0;
+	uint64_t count_allocations = 0;
+	uint64_t bytes_allocated = 0;
+	uint64_t elapsed = 0;
+	uint64_t start = 0;
+
+	count_allocations = s_counters.count_allocations;
+	bytes_allocated = s_counters.bytes_allocated;
+
+	unlink ("history.bench");
+	unlink ("history.bench.idx");
+
+	store = open_history_store ("history.bench");
+
+	if (store == NULL)
+	{
+		fprintf (stderr, "open_history_store () failed\n");
+		exit (EXIT_FAILURE);
+	}
+
+	s_counters.count_allocations = count_allocations;
+	s_counters.bytes_allocated = bytes_allocated;
+
+	start = now_ns ();
+
+	if (sync_market_history (store, &count_new_events) != SUCCESS ||
+	    count_new_events != *count_events)
+	{
+		fprintf (stderr, "sync_market_history () failed\n");
+		exit (EXIT_FAILURE);
+	}
+
+	elapsed = now_ns () - start;
+
+	close_history_store (store);
+
+	return elapsed;
+}
+
+/*===========================================================================*
+ * Function name    : run_bench_case                                         *
+ *                                                                           *
+ * Description      : This function repeat operation for at least            *
+ *                    BENCH_MIN_SECONDS after a warm-up call                 *
+ *                                                                           *
+ * Input values(s)  : bench_case                                             *
+ *                                                                           *
+ * Output values(s) : result                                                 *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void run_bench_case (const BenchCase *bench_case, BenchResult *result)
+{
+	struct rusage usage;
+	uint64_t count_items = bench_case->count_items;
+	uint64_t elapsed = 0;
+	uint64_t iterations = 0;
+	uint64_t count_allocations = 0;
+	uint64_t bytes_allocated = 0;
+	uint64_t started = 0;
+
+	memset (result, 0, sizeof (BenchResult));
+
+	snprintf (result->name, BENCH_NAME_SIZE, "%s", bench_case->name);
+	result->count_items = count_items;
+
+	/* Warm-up: description cache, connection and page faults */
+	bench_case->operation (&count_items);
+
+	count_allocations = s_counters.count_allocations;
+	bytes_allocated = s_counters.bytes_allocated;
+	started = now_ns ();
+
+	do
+	{
+		elapsed += bench_case->operation (&count_items);
+		iterations++;
+	} while (iterations < BENCH_MAX_ITERATIONS &&
+	         (iterations < BENCH_MIN_ITERATIONS ||
+	          (double)(now_ns () - started) / 1e9 < BENCH_MIN_SECONDS));
+
+	result->iterations = iterations;
+	result->ns_per_op = (double)elapsed / iterations;
+	result->allocations_per_op = (double)(s_counters.count_allocations -
+	                                      count_allocations) / iterations;
+	result->bytes_per_op = (double)(s_counters.bytes_allocated -
+	                                bytes_allocated) / iterations;
+
+	getrusage (RUSAGE_SELF, &usage);
+	result->peak_rss_kb = usage.ru_maxrss;
+}
+
+/*===========================================================================*
+ * Function name    : run_bench_case_isolated                                *
+ *                                                                           *
+ * Description      : This function run case in child process, so peak RSS   *
+ *                    belongs to this case only                              *
+ *                                                                           *
+ * Input values(s)  : bench_case                                             *
+ *                                                                           *
+ * Output values(s) : result                                                 *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t run_bench_case_isolated (const BenchCase *bench_case,
+                                       BenchResult *result)
+{
+	int pipe_fd[2] = { -1, -1 };
+	int status = 0;
+	pid_t pid = 0;
+	ssize_t count_read = 0;
+
+	if (pipe (pipe_fd) != 0)
+	{
+		return FAILURE;
+	}
+
+	fflush (stdout);
+
+	pid = fork ();
+
+	if (pid < 0)
+	{
+		close (pipe_fd[0]);
+		close (pipe_fd[1]);
+
+		return FAILURE;
+	}
+
+	if (pid == 0)
+	{
+		close (pipe_fd[0]);
+
+		run_bench_case (bench_case, result);
+
+		/* exit () rather than _exit () so profiling runtimes flush their data */
+		exit (write (pipe_fd[1], result, sizeof (BenchResult)) ==
+		      (ssize_t)sizeof (BenchResult) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	close (pipe_fd[1]);
+
+	count_read = read (pipe_fd[0], result, sizeof (BenchResult));
+
+	close (pipe_fd[0]);
+	waitpid (pid, &status, 0);
+
+	if (count_read != (ssize_t)sizeof (BenchResult) ||
+	    !WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : print_bench_result                                     *
+ *                                                                           *
+ * Description      : This function print result as json object              *
+ *                                                                           *
+ * Input values(s)  : result                                                 *
+ *                    is_first - no separating comma                         *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void print_bench_result (const BenchResult *result, int8_t is_first)
+{
+	printf ("%s\n    {\"name\": \"%s\", \"items\": %llu, \"iterations\": %llu, "
+	        "\"ns_per_op\": %.1f, \"ns_per_item\": %.2f, \"allocs_per_op\": %.2f, "
+	        "\"bytes_per_op\": %.0f, \"peak_rss_kb\": %ld}",
+	        is_first ? "" : ",", result->name,
+	        (unsigned long long)result->count_items,
+	        (unsigned long long)result->iterations, result->ns_per_op,
+	        result->ns_per_op / (result->count_items > 0 ? result->count_items : 1),
+	        result->allocations_per_op, result->bytes_per_op, result->peak_rss_kb);
+}
+
+int main (int argc, char *argv[])
+{
+	static const BenchCase bench_cases[] = {
+		{ "url_encode", 1, bench_url_encode },
+		{ "base64_encode", 1, bench_base64_encode },
+		{ "get_json_object_as_string", 1, bench_get_json_object_as_string },
+		{ "get_inventory_items_1k", 1000, bench_get_inventory_items },
+		{ "get_inventory_items_10k", 10000, bench_get_inventory_items },
+		{ "get_inventory_items_100k", 100000, bench_get_inventory_items },
+		{ "free_steam_inventory_1k", 1000, bench_free_steam_inventory },
+		{ "free_steam_inventory_10k", 10000, bench_free_steam_inventory },
+		{ "free_steam_inventory_100k", 100000, bench_free_steam_inventory },
+		{ "get_my_listings_1k", 1000, bench_get_my_listings },
+		{ "get_my_listings_10k", 10000, bench_get_my_listings },
+		{ "get_my_listings_100k", 100000, bench_get_my_listings },
+		{ "parse_price_history_10k", 10000, bench_parse_price_history },
+		{ "history_store_10k", 10000, bench_history_store },
+		{ "sync_market_history_500", HISTORY_PAGE_SIZE, bench_sync_market_history }
+	};
+	const char *filter = argc > 1 ? argv[1] : NULL;
+	char base_url[BENCH_PATH_SIZE * 2] = {0};
+	BenchResult result;
+	int8_t is_first = 1;
+	int8_t return_value = SUCCESS;
+
+	g_debug_state = DEBUG_DISABLE;
+
+	init_encode_method ();
+
+	/* Responses are served by curl from fixture files, every run
+	 * measures the same bytes without network noise */
+	snprintf (s_fixture_dir, BENCH_PATH_SIZE, "/tmp/steam_bench.XXXXXX");
+
+	if (mkdtemp (s_fixture_dir) == NULL || chdir (s_fixture_dir) != 0)
+	{
+		perror ("steam_bench");
+		return EXIT_FAILURE;
+	}
+
+	snprintf (base_url, sizeof (base_url), "file://%s/", s_fixture_dir);
+	setenv ("STEAM_COMMUNITY_URL", base_url, 1);
+
+	if (write_inventory_fixture (1000) != SUCCESS ||
+	    write_inventory_fixture (10000) != SUCCESS ||
+	    write_inventory_fixture (100000) != SUCCESS)
+	{
+		fprintf (stderr, "Failed to write fixtures to %s\n", s_fixture_dir);
+		remove_fixtures ();
+
+		return EXIT_FAILURE;
+	}
+
+	s_price_history = build_price_history (10000);
+	s_description_json = json_tokener_parse ("{\"appid\":753,\"classid\":\"100000\","
+	                                         "\"market_hash_name\":\"200000-Trading"
+	                                         " Card 1 (Foil)\"}");
+
+	if (s_price_history == NULL || s_description_json == NULL)
+	{
+		return EXIT_FAILURE;
+	}
+
+	printf ("{\n  \"benchmark\": \"steam_bench\",\n  \"results\": [");
+
+	for (size_t index = 0; index < sizeof (bench_cases) / sizeof (bench_cases[0]); index++)
+	{
+		if (filter != NULL && strstr (bench_cases[index].name, filter) == NULL)
+			continue;
+
+		/* Listing fixtures differ by num_active_listings only */
+		if (bench_cases[index].operation == bench_get_my_listings)
+		{
+			if (write_listings_fixture (bench_cases[index].count_items) != SUCCESS)
+			{
+				return_value = FAILURE;
+				continue;
+			}
+
+			snprintf (base_url, sizeof (base_url), "file://%s/listings%llu/",
+			          s_fixture_dir, (unsigned long long)bench_cases[index].count_items);
+			setenv ("STEAM_COMMUNITY_URL", base_url, 1);
+		}
+
+		/* The render url ends with '/', a file can't be named like that.
+		 * Behind '?' all of it is query, which file:// ignores */
+		if (bench_cases[index].operation == bench_sync_market_history)
+		{
+			if (write_history_fixture (bench_cases[index].count_items) != SUCCESS)
+			{
+				return_value = FAILURE;
+				continue;
+			}
+
+			snprintf (base_url, sizeof (base_url), "file://%s/myhistory/render?",
+			          s_fixture_dir);
+			setenv ("STEAM_COMMUNITY_URL", base_url, 1);
+		}
+
+		if (run_bench_case_isolated (&bench_cases[index], &result) != SUCCESS)
+		{
+			fprintf (stderr, "%s failed\n", bench_cases[index].name);
+			return_value = FAILURE;
+			continue;
+		}
+
+		print_bench_result (&result, is_first);
+		is_first = 0;
+	}
+
+	printf ("\n  ]\n}\n");
+
+	json_object_put (s_description_json);
+	free (s_price_history);
+
+	remove_fixtures ();
+
+	return return_value == SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,47 @@
+#ifndef __ALLOCATOR_H__
+#define __ALLOCATOR_H__
+
+#include <stddef.h>
+
+#include "steamdef.h"
+
+/* Subsystem a block is accounted to */
+typedef enum tAllocationTag {
+	ALLOC_TAG_TRANSPORT = 0,
+	ALLOC_TAG_JSON,
+	ALLOC_TAG_INVENTORY,
+	ALLOC_TAG_MARKET,
+	ALLOC_TAG_SESSION,
+	ALLOC_TAG_TRADE,
+	ALLOC_TAG_OTHER,
+	ALLOC_TAG_COUNT
+} AllocationTag;
+
+/* Backend behind steam_malloc () and friends. Deallocation is sized, the
+ * size given is the one the block was last allocated with */
+typedef struct tSteamAllocator {
+	void  *(*allocate) (size_t, void *);
+	void  *(*reallocate) (void *, size_t, size_t, void *);
+	void   (*release) (void *, size_t, void *);
+	void   *user_data;
+} SteamAllocator;
+
+typedef struct tAllocationStats {
+	uint64_t  live_bytes;
+	uint64_t  peak_bytes;
+	uint64_t  live_blocks;
+	uint64_t  count_allocations;
+} AllocationStats;
+
+int8_t set_steam_allocator (const SteamAllocator *);
+SteamAllocator *create_pool_allocator (void);
+int8_t free_pool_allocator (SteamAllocator *);
+void *steam_malloc (size_t, AllocationTag);
+void *steam_calloc (size_t, size_t, AllocationTag);
+void *steam_realloc (void *, size_t, AllocationTag);
+char *steam_strdup (const char *, AllocationTag);
+void steam_free (void *);
+void get_allocation_stats (AllocationTag, AllocationStats *);
+const char *get_allocation_tag_name (AllocationTag);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef __BUY_ORDER_H__
+#define __BUY_ORDER_H__
+
+#include "steamdef.h"
+
+extern char *g_steam_id;
+extern char g_session_id[128];
+extern char g_rfc3986[256];
+extern char g_html5[256];
+
+typedef struct tBuyOrder {
+	uint64_t  buy_order_id;
+	uint32_t  app_id;
+	char     *market_hash_name;
+	uint32_t  price;
+	uint32_t  quantity;
+	uint32_t  quantity_remaining;
+} BuyOrder;
+
+/* Local record of open buy orders, prices are per item in cents */
+typedef struct tBuyOrderBook {
+	BuyOrder  *buy_orders;
+	size_t     count_orders;
+	size_t     capacity;
+	uint32_t   currency;
+} BuyOrderBook;
+
+typedef struct tBuyOrderSpec {
+	const char  *market_hash_name;
+	uint32_t     app_id;
+	uint32_t     price;
+	uint32_t     quantity;
+} BuyOrderSpec;
+
+typedef struct tBuyOrderResult {
+	int8_t    success;
+	uint64_t  buy_order_id;
+	long      http_code;
+	char      message[STEAM_MESSAGE_SIZE];
+} BuyOrderResult;
+
+BuyOrderBook *create_buy_order_book (uint32_t);
+void free_buy_order_book (BuyOrderBook *);
+int8_t sync_buy_order_book (BuyOrderBook *);
+BuyOrder *find_buy_order (BuyOrderBook *, uint64_t);
+BuyOrder *find_buy_order_by_name (BuyOrderBook *, uint32_t, const char *);
+int8_t create_buy_orders (BuyOrderBook *, const BuyOrderSpec *, size_t,
+                          BuyOrderResult *, uint32_t);
+int8_t cancel_buy_orders (BuyOrderBook *, const uint64_t *, size_t,
+                          BuyOrderResult *, uint32_t);
+int8_t replace_buy_orders (BuyOrderBook *, const uint64_t *,
+                           const BuyOrderSpec *, size_t, BuyOrderResult *,
+                           uint32_t);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __CONFIRMATION_H__
+#define __CONFIRMATION_H__
+
+#include "steamdef.h"
+
+extern char *g_steam_id;
+
+typedef enum tConfirmationType {
+	CONFIRMATION_UNKNOWN = 0,
+	CONFIRMATION_TRADE = 2,
+	CONFIRMATION_MARKET_LISTING = 3,
+	CONFIRMATION_ACCOUNT_RECOVERY = 6,
+	CONFIRMATION_API_KEY = 9
+} ConfirmationType;
+
+/* creator_id is the listing id of market listings, trade offer id of
+ * trades */
+typedef struct tConfirmation {
+	uint64_t          id;
+	uint64_t          nonce;
+	uint64_t          creator_id;
+	uint64_t          creation_time;
+	ConfirmationType  type;
+	char             *headline;
+} Confirmation;
+
+typedef struct tConfirmationList {
+	Confirmation  *confirmations;
+	size_t         count_confirmations;
+} ConfirmationList;
+
+int8_t parse_confirmations (const char *, ConfirmationList *);
+ConfirmationList *get_confirmations (const char *);
+void free_confirmations (ConfirmationList *);
+int8_t respond_to_confirmations (const char *, const Confirmation *, size_t,
+                                 int8_t);
+
+#endif
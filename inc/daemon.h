@@ -0,0 +1,54 @@
+#ifndef __DAEMON_H__
+#define __DAEMON_H__
+
+#include "steamdef.h"
+
+extern char *g_steam_id;
+
+/* Every message on the socket is a frame, integers are big-endian:
+ *
+ *   request  : u32 length | u8 operation | u32 tag | arguments
+ *   response : u32 length | u8 status    | u32 tag | body
+ *
+ * length counts the bytes after itself. The tag is chosen by the client
+ * and echoed back, responses of one client may come out of order.
+ *
+ *   operation                arguments                      body
+ *   DAEMON_OP_PING           -                              -
+ *   DAEMON_OP_INVENTORY      u8 ExportFormat, u8 refresh    exported items
+ *   DAEMON_OP_SELL           u64 asset_id, u32 price        u8 SellStatus,
+ *                                                           message
+ *   DAEMON_OP_CREATE_BUY     u32 app_id, u32 price,         u64 buy_order_id,
+ *                            u32 quantity, market_hash_name message
+ *   DAEMON_OP_CANCEL_BUY     u64 buy_order_id               message
+ *   DAEMON_OP_REMOVE_LISTING u64 listing_id                 -
+ *   DAEMON_OP_LISTINGS       -                              one line per
+ *                                                           active listing
+ *
+ * Prices are in cents, the sell price is what the seller receives. Lines
+ * of DAEMON_OP_LISTINGS are listing_id, app_id, asset_id, price, fee and
+ * market_hash_name separated by tabs. */
+typedef enum tDaemonOperation {
+	DAEMON_OP_PING = 0,
+	DAEMON_OP_INVENTORY,
+	DAEMON_OP_SELL,
+	DAEMON_OP_CREATE_BUY,
+	DAEMON_OP_CANCEL_BUY,
+	DAEMON_OP_REMOVE_LISTING,
+	DAEMON_OP_LISTINGS
+} DaemonOperation;
+
+typedef enum tDaemonStatus {
+	DAEMON_STATUS_OK = 0,
+	DAEMON_STATUS_FAILED,
+	DAEMON_STATUS_BAD_REQUEST,
+	DAEMON_STATUS_NOT_FOUND
+} DaemonStatus;
+
+#define DAEMON_LENGTH_SIZE  4
+#define DAEMON_HEADER_SIZE  (DAEMON_LENGTH_SIZE + 1 + 4)
+
+int8_t run_steam_daemon (const char *, uint32_t, uint32_t);
+void stop_steam_daemon (void);
+
+#endif
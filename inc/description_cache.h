@@ -0,0 +1,18 @@
+#ifndef __DESCRIPTION_CACHE_H__
+#define __DESCRIPTION_CACHE_H__
+
+#include "steamdef.h"
+
+int8_t init_description_cache (uint32_t);
+void free_description_cache (void);
+int8_t description_cache_contains (uint32_t, uint64_t, uint64_t);
+int8_t description_cache_insert (uint32_t, uint64_t, uint64_t, const char *,
+                                 int8_t);
+int8_t description_cache_lookup (uint32_t, uint64_t, uint64_t, char **,
+                                 int8_t *);
+char *acquire_description_name (char *);
+void release_description_name (char *);
+int8_t load_description_cache (const char *);
+int8_t save_description_cache (const char *);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef __EXPORT_H__
+#define __EXPORT_H__
+
+#include "steamdef.h"
+
+typedef enum tExportFormat {
+	EXPORT_FORMAT_TEXT,
+	EXPORT_FORMAT_NDJSON,
+	EXPORT_FORMAT_CSV,
+	EXPORT_FORMAT_BINARY
+} ExportFormat;
+
+typedef struct tExportSink {
+	int           fd;
+	int8_t        owns_fd;
+	int8_t        error;
+	ExportFormat  format;
+	char         *buffer;
+	size_t        size;
+	size_t        capacity;
+	uint64_t      count_items;
+} ExportSink;
+
+ExportSink *open_export_sink (const char *, ExportFormat);
+ExportSink *open_export_sink_fd (int, ExportFormat);
+ExportSink *open_export_sink_memory (ExportFormat);
+int8_t export_inventory_item (ExportSink *, const InventoryItem *);
+int8_t export_steam_inventory (ExportSink *, const SteamInventory *);
+int8_t flush_export_sink (ExportSink *);
+int8_t close_export_sink (ExportSink *);
+
+#endif
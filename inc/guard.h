@@ -0,0 +1,23 @@
+#ifndef __GUARD_H__
+#define __GUARD_H__
+
+#include <time.h>
+
+#include "steamdef.h"
+
+/* Secrets are the base64 strings of the mobile authenticator (maFile) */
+typedef struct tSteamCredentials {
+	char  login[LOGIN_LENGTH];
+	char  password[PASSWORD_LENGTH];
+	char  shared_secret[STEAM_SECRET_SIZE];
+	char  identity_secret[STEAM_SECRET_SIZE];
+} SteamCredentials;
+
+int8_t sync_steam_time (void);
+int64_t get_steam_time (void);
+int8_t generate_steam_guard_code (const char *, int64_t, char *);
+int8_t generate_confirmation_key (const char *, int64_t, const char *, char *);
+void generate_device_id (const char *, char *);
+int8_t load_steam_credentials (SteamCredentials *, const char *);
+
+#endif
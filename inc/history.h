@@ -0,0 +1,59 @@
+#ifndef __HISTORY_H__
+#define __HISTORY_H__
+
+#include <stdio.h>
+
+#include "steamdef.h"
+
+typedef enum tHistoryEventType {
+	HISTORY_EVENT_UNKNOWN,
+	HISTORY_EVENT_LISTED,
+	HISTORY_EVENT_CANCELED,
+	HISTORY_EVENT_SOLD,
+	HISTORY_EVENT_PURCHASED
+} HistoryEventType;
+
+/* One row of market history, the key is history_row_<row_id>_<row_sub_id>.
+ * Steam shows only the day of an event, time_acted is its midnight (UTC) */
+typedef struct tHistoryEvent {
+	uint64_t          row_id;
+	uint64_t          row_sub_id;
+	int64_t           time_acted;
+	HistoryEventType  event_type;
+	uint32_t          app_id;
+	uint64_t          context_id;
+	uint64_t          asset_id;
+	uint32_t          price;
+	char              market_hash_name[HISTORY_NAME_SIZE];
+} HistoryEvent;
+
+typedef struct tHistoryIndexEntry {
+	int64_t   time_acted;
+	uint64_t  offset;
+} HistoryIndexEntry;
+
+/* Append-only event log, oldest event first, with a sparse time index
+ * (every HISTORY_INDEX_STRIDE event) kept in "<log>.idx" */
+typedef struct tHistoryStore {
+	FILE               *log_file;
+	FILE               *index_file;
+	HistoryIndexEntry  *index;
+	size_t              count_index;
+	size_t              capacity_index;
+	uint64_t            count_events;
+	uint64_t            log_size;
+	uint64_t            newest_row_id;
+	uint64_t            newest_row_sub_id;
+	int64_t             newest_time;
+} HistoryStore;
+
+typedef int8_t (*HistoryEventVisitor)(const HistoryEvent *, void *);
+
+HistoryStore *open_history_store (const char *);
+void close_history_store (HistoryStore *);
+int8_t append_history_events (HistoryStore *, const HistoryEvent *, size_t);
+int8_t visit_history_events (HistoryStore *, int64_t, int64_t,
+                             HistoryEventVisitor, void *);
+int8_t sync_market_history (HistoryStore *, uint64_t *);
+
+#endif
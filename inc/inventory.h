@@ -1,12 +1,23 @@
 #ifndef __INVENTORY_H__
 #define __INVENTORY_H__
 
+#include <json-c/json.h>
+
 #include "steamdef.h"
+#include "export.h"
 
 extern char *g_steam_id;
 extern char g_rfc3986[256];
 
+/* Called once per inventory page, see visit_inventory_items () */
+typedef int8_t (*InventoryPageVisitor) (InventoryItem *, uint64_t, void *);
+
 SteamInventory *get_inventory_items (char *);
+int8_t visit_inventory_items (char *, InventoryPageVisitor, void *);
+int8_t export_inventory_items (char *, ExportSink *);
+void cache_item_descriptions (struct json_object *);
+int8_t parse_inventory_item (struct json_object *, InventoryItem *);
+void free_inventory_items (InventoryItem *, uint64_t);
 void free_steam_inventory (SteamInventory *);
 void print_steam_inventory (SteamInventory *);
 
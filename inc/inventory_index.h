@@ -0,0 +1,47 @@
+#ifndef __INVENTORY_INDEX_H__
+#define __INVENTORY_INDEX_H__
+
+#include "steamdef.h"
+
+/* A list of positions in SteamInventory.inventory_items. The ids point
+ * into the index itself and stay valid until free_inventory_index (). */
+typedef struct tInventoryIdList {
+	const uint64_t  *ids;
+	uint64_t         count;
+} InventoryIdList;
+
+typedef struct tInventoryIndexRange {
+	uint64_t  hash;
+	uint64_t  start;
+	uint64_t  count;
+	uint64_t  count_marketable;
+} InventoryIndexRange;
+
+typedef struct tInventoryIndex {
+	SteamInventory       *steam_inventory;
+	uint64_t             *by_name;
+	uint64_t             *by_class;
+	uint64_t             *marketable_items;
+	uint64_t              count_marketable;
+	InventoryIndexRange  *name_ranges;
+	uint64_t              count_name_ranges;
+	uint64_t              name_table_mask;
+	uint64_t             *name_table;
+	InventoryIndexRange  *class_ranges;
+	uint64_t              count_class_ranges;
+	uint64_t              class_table_mask;
+	uint64_t             *class_table;
+} InventoryIndex;
+
+InventoryIndex *build_inventory_index (SteamInventory *);
+void free_inventory_index (InventoryIndex *);
+
+InventoryIdList find_items_by_name (const InventoryIndex *, const char *);
+InventoryIdList find_items_by_name_prefix (const InventoryIndex *, const char *);
+InventoryIdList find_items_by_class (const InventoryIndex *, const char *,
+                                     const char *);
+InventoryIdList find_marketable_items (const InventoryIndex *);
+InventoryIdList find_marketable_items_by_name (const InventoryIndex *,
+                                               const char *);
+
+#endif
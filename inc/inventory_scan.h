@@ -0,0 +1,32 @@
+#ifndef __INVENTORY_SCAN_H__
+#define __INVENTORY_SCAN_H__
+
+#include "steamdef.h"
+
+typedef enum tInventoryScanStatus {
+	INVENTORY_SCAN_PUBLIC = 0,
+	INVENTORY_SCAN_EMPTY,
+	INVENTORY_SCAN_PRIVATE,
+	INVENTORY_SCAN_FAILED
+} InventoryScanStatus;
+
+/* Called for every page of a public inventory, and once with no items for
+ * an empty, private or failed one. Items are freed after the sink
+ * returns; FAILURE stops loading further pages of that profile */
+typedef int8_t (*InventoryScanSink) (const char *, InventoryScanStatus,
+                                     InventoryItem *, uint64_t, void *);
+
+typedef struct tInventoryScanStats {
+	uint64_t  count_public;
+	uint64_t  count_empty;
+	uint64_t  count_private;
+	uint64_t  count_failed;
+	uint64_t  count_items;
+	uint64_t  count_requests;
+} InventoryScanStats;
+
+int8_t scan_inventories (char **, size_t, uint32_t, InventoryScanSink, void *,
+                         InventoryScanStats *);
+const char *get_inventory_scan_status_name (InventoryScanStatus);
+
+#endif
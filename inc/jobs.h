@@ -0,0 +1,39 @@
+#ifndef __JOBS_H__
+#define __JOBS_H__
+
+#include <stdio.h>
+
+#include "steamdef.h"
+
+extern char *g_steam_id;
+
+/* One job per input line, one result line per job as soon as it is done:
+ *
+ *   {"id":1,"op":"sell","app_id":753,"context_id":6,"asset_id":"111",
+ *    "price":300}
+ *   {"id":1,"op":"sell","success":true,"status":"listed","message":""}
+ *
+ *   op                fields
+ *   sell              app_id, context_id, asset_id, price
+ *   create_buy_order  app_id, market_hash_name, price, quantity
+ *   cancel_buy_order  buy_order_id
+ *   remove_listing    listing_id
+ *   inventory         steam_id (optional, own inventory by default)
+ *   history           from, to (optional, unix time of days)
+ *
+ * Prices are in cents, the sell price is what the seller receives. id is
+ * echoed back as is. Jobs with the same "key" run one after another in
+ * input order, all other jobs run concurrently. */
+typedef enum tJobOperation {
+	JOB_UNKNOWN = 0,
+	JOB_SELL,
+	JOB_CREATE_BUY_ORDER,
+	JOB_CANCEL_BUY_ORDER,
+	JOB_REMOVE_LISTING,
+	JOB_INVENTORY,
+	JOB_HISTORY
+} JobOperation;
+
+int8_t run_steam_jobs (FILE *, FILE *, uint32_t, uint32_t);
+
+#endif
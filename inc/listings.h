@@ -0,0 +1,35 @@
+#ifndef __LISTINGS_H__
+#define __LISTINGS_H__
+
+#include "steamdef.h"
+#include "buy_order.h"
+
+/* Prices are in cents: price is what the seller receives, fee is added
+ * on top of it for the buyer */
+typedef struct tMyListing {
+	uint64_t  listing_id;
+	uint32_t  app_id;
+	uint64_t  context_id;
+	uint64_t  asset_id;
+	char     *market_hash_name;
+	uint32_t  price;
+	uint32_t  fee;
+	uint64_t  time_created;
+} MyListing;
+
+typedef struct tMyListings {
+	uint64_t    num_active_listings;
+	MyListing  *active;
+	size_t      count_active;
+	MyListing  *to_confirm;
+	size_t      count_to_confirm;
+	MyListing  *on_hold;
+	size_t      count_on_hold;
+	BuyOrder   *buy_orders;
+	size_t      count_buy_orders;
+} MyListings;
+
+MyListings *get_my_listings (uint32_t);
+void free_my_listings (MyListings *);
+
+#endif
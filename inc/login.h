@@ -1,9 +1,12 @@
 #ifndef __LOGIN_H__
 #define __LOGIN_H__
 
+#include "guard.h"
+
 extern char *g_steam_id;
 extern char g_session_id[128];
 
 int8_t steam_login (char *, char *, char *);
+int8_t steam_login_with_credentials (const SteamCredentials *);
 
 #endif
@@ -2,16 +2,38 @@
 #define __MARKET_H__
 
 #include "steamdef.h"
+#include "money.h"
 
 extern char *g_steam_id;
 extern char g_session_id[128];
 extern char g_rfc3986[256];
 extern char g_html5[256];
 
+typedef enum tSellStatus {
+	SELL_LISTED,
+	SELL_NEEDS_CONFIRMATION,
+	SELL_REJECTED,
+	SELL_RETRYABLE
+} SellStatus;
+
+typedef struct tSellRequest {
+	const InventoryItem  *inventory_item;
+	uint32_t              price;
+} SellRequest;
+
+typedef struct tSellResult {
+	SellStatus  status;
+	long        http_code;
+	char        message[STEAM_MESSAGE_SIZE];
+} SellResult;
+
 int8_t sell_item (InventoryItem, char *);
+int8_t sell_item_for (InventoryItem, Money);
+int8_t sell_items (const SellRequest *, size_t, SellResult *, uint32_t);
 int8_t create_buy_order (char *, double, uint32_t, char *, char *);
 int8_t cancel_buy_order (const char *);
 int8_t remove_sell_order (const char *);
+int8_t remove_sell_orders (const uint64_t *, size_t, int8_t *, uint32_t);
 char *load_my_listings (void);
 char *get_market_history (uint32_t, uint32_t);
 
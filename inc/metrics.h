@@ -0,0 +1,62 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stdio.h>
+#include <pthread.h>
+#include <curl/curl.h>
+
+#include "steamdef.h"
+
+/* Endpoint a request is accounted to, classified by url */
+typedef enum tMetricEndpoint {
+	METRIC_ENDPOINT_INVENTORY = 0,
+	METRIC_ENDPOINT_SELLITEM,
+	METRIC_ENDPOINT_CREATEBUYORDER,
+	METRIC_ENDPOINT_CANCELBUYORDER,
+	METRIC_ENDPOINT_REMOVELISTING,
+	METRIC_ENDPOINT_MYLISTINGS,
+	METRIC_ENDPOINT_MYHISTORY,
+	METRIC_ENDPOINT_LOGIN,
+	METRIC_ENDPOINT_OTHER,
+	METRIC_ENDPOINT_COUNT
+} MetricEndpoint;
+
+/* Upper bounds in microseconds, the last bucket is +Inf */
+#define METRIC_LATENCY_BUCKETS  { 10000, 25000, 50000, 100000, 250000, \
+                                  500000, 1000000, 2500000, 5000000, \
+                                  10000000, 30000000 }
+#define METRIC_PARSE_BUCKETS    { 100, 250, 500, 1000, 2500, 5000, 10000, \
+                                  25000, 100000, 500000, 1000000 }
+#define METRIC_COUNT_BUCKETS    12
+
+/* Every field is updated with atomic builtins only */
+typedef struct tMetricHistogram {
+	uint64_t  buckets[METRIC_COUNT_BUCKETS];
+	uint64_t  count;
+	uint64_t  sum_us;
+} MetricHistogram;
+
+typedef struct tEndpointMetrics {
+	uint64_t         requests;
+	uint64_t         errors;
+	uint64_t         retries;
+	uint64_t         bytes_in;
+	uint64_t         bytes_out;
+	int64_t          in_flight;
+	MetricHistogram  latency;
+} EndpointMetrics;
+
+MetricEndpoint classify_metric_endpoint (const char *);
+void begin_request_metrics (MetricEndpoint);
+void end_request_metrics (MetricEndpoint, CURL *, CURLcode);
+void count_retry_metrics (MetricEndpoint);
+void record_json_parse_metrics (uint64_t);
+void count_allocation_metrics (size_t);
+uint64_t get_metrics_time_us (void);
+void get_endpoint_metrics (MetricEndpoint, EndpointMetrics *);
+int8_t write_metrics (FILE *);
+int8_t save_metrics (const char *);
+int8_t start_metrics_listener (uint16_t);
+void stop_metrics_listener (void);
+
+#endif
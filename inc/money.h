@@ -0,0 +1,33 @@
+#ifndef __MONEY_H__
+#define __MONEY_H__
+
+#include "steamdef.h"
+
+/* Amount in cents (minor units of the wallet currency) */
+typedef int64_t Money;
+
+/* amount is what the buyer pays, received is what the seller gets */
+typedef struct tSteamFees {
+	Money  amount;
+	Money  received;
+	Money  steam_fee;
+	Money  publisher_fee;
+} SteamFees;
+
+typedef struct tRepriceRule {
+	int32_t   undercut;
+	int32_t   overbid;
+	int32_t   min_received;
+	int32_t   max_order_price;
+	uint32_t  publisher_fee_bp;
+} RepriceRule;
+
+Money money_from_double (double);
+int8_t parse_money (const char *, Money *);
+void format_money (Money, char *, size_t);
+SteamFees compute_fees_for_received (Money, uint32_t);
+SteamFees compute_fees_for_amount (Money, uint32_t);
+void reprice_items (const int32_t *, const int32_t *, size_t,
+                    const RepriceRule *, int32_t *, int32_t *);
+
+#endif
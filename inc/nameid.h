@@ -0,0 +1,37 @@
+#ifndef __NAMEID_H__
+#define __NAMEID_H__
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "steamdef.h"
+
+typedef struct tNameIdEntry {
+	uint32_t   app_id;
+	uint32_t   hash;
+	uint64_t   item_nameid;
+	char      *market_hash_name;
+} NameIdEntry;
+
+/* (app_id, market_hash_name) -> item_nameid. Ids never change, so every
+ * resolved id is appended to the cache file and kept forever */
+typedef struct tNameIdCache {
+	NameIdEntry      *entries;
+	uint32_t          count_entries;
+	uint32_t          capacity;
+	uint32_t         *buckets;
+	uint32_t          bucket_mask;
+	FILE             *file;
+	pthread_mutex_t   mutex;
+} NameIdCache;
+
+NameIdCache *open_nameid_cache (const char *);
+void close_nameid_cache (NameIdCache *);
+int8_t lookup_item_nameid (NameIdCache *, uint32_t, const char *, uint64_t *);
+int8_t insert_item_nameid (NameIdCache *, uint32_t, const char *, uint64_t);
+int8_t extract_item_nameid (const char *, uint64_t *);
+int8_t resolve_item_nameid (NameIdCache *, uint32_t, const char *, uint64_t *);
+int8_t resolve_item_nameids (NameIdCache *, uint32_t, const char *const *,
+                             size_t, uint64_t *, uint32_t);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __PRICE_H__
+#define __PRICE_H__
+
+#include "steamdef.h"
+
+/* All prices are in cents of the requested currency */
+typedef struct tPriceOverview {
+	uint32_t  lowest_price;
+	uint32_t  median_price;
+	uint64_t  volume;
+} PriceOverview;
+
+/* Columnar series ordered by time, point i is (timestamps[i], prices[i],
+ * volumes[i]) so kernels run over contiguous arrays */
+typedef struct tPriceSeries {
+	int64_t  *timestamps;
+	int32_t  *prices;
+	int32_t  *volumes;
+	size_t    count_points;
+	size_t    capacity;
+} PriceSeries;
+
+/* Points [begin, end) of a series */
+typedef struct tPriceRange {
+	size_t  begin;
+	size_t  end;
+} PriceRange;
+
+typedef struct tPriceStats {
+	int32_t   min_price;
+	int32_t   max_price;
+	int32_t   median_price;
+	int32_t   vwap;
+	int64_t   volume;
+	size_t    count_points;
+} PriceStats;
+
+PriceSeries *create_price_series (size_t);
+void free_price_series (PriceSeries *);
+int8_t append_price_point (PriceSeries *, int64_t, int32_t, int32_t);
+PriceRange find_price_range (const PriceSeries *, int64_t, int64_t);
+int32_t find_min_price (const int32_t *, size_t);
+int32_t find_max_price (const int32_t *, size_t);
+int8_t find_median_price (const int32_t *, size_t, int32_t *);
+int32_t compute_vwap (const int32_t *, const int32_t *, size_t);
+int8_t compute_price_stats (const PriceSeries *, int64_t, int64_t, PriceStats *);
+int8_t parse_price_history (const char *, PriceSeries *);
+int8_t get_price_overview (uint32_t, uint32_t, const char *, PriceOverview *);
+PriceSeries *get_price_history (uint32_t, const char *);
+int8_t get_price_histories (uint32_t, const char *const *, size_t,
+                            PriceSeries **, uint32_t);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef __SESSION_H__
+#define __SESSION_H__
+
+#include <pthread.h>
+
+#include "steamdef.h"
+#include "guard.h"
+
+extern char *g_steam_id;
+extern char g_session_id[128];
+
+int8_t set_steam_session (const char *, const char *);
+void get_steam_session (char *, size_t, char *, size_t);
+int8_t save_steam_session (const char *);
+int8_t load_steam_session (const char *);
+int8_t validate_steam_session (void);
+int8_t resume_steam_session (const char *);
+uint32_t get_session_generation (void);
+int8_t refresh_steam_session (uint32_t);
+int8_t start_session_keepalive (const SteamCredentials *, const char *, uint32_t);
+void stop_session_keepalive (void);
+
+#endif
@@ -6,8 +6,11 @@
 #include <stdint.h>
 #include <ctype.h>
 #include <string.h>
+#include <strings.h>
 #include <json-c/json.h>
 
+#include "allocator.h"
+
 extern char g_session_id[128];
 extern char g_rfc3986[256];
 extern char g_html5[256];
@@ -16,8 +19,24 @@ extern uint8_t g_debug_state;
 void print_debug_information (char *, int32_t );
 void init_encode_method (void);
 void url_encode (const char *, char *, char *);
+struct json_object *parse_json_response (const char *);
 int8_t get_json_object_as_string (char **, struct json_object *, char *);
+int8_t get_json_object_as_tagged_string (char **, struct json_object *, char *,
+                                         AllocationTag);
+int8_t get_json_object_as_uint64 (uint64_t *, struct json_object *, char *);
+int8_t get_json_object_as_view (StringView *, struct json_object *, char *);
+int8_t parse_string_view_as_uint64 (const StringView *, uint64_t *);
+char *copy_string_view (const StringView *, AllocationTag);
+int8_t parse_price_text (const char *, size_t, uint32_t *);
+int64_t days_from_civil (int32_t, uint8_t, uint8_t);
+uint8_t parse_month_name (const char *);
 char *curl_general_request (char *, char *, char *, int8_t);
+int8_t is_session_expired (const char *, long, const char *);
+uint32_t replace_session_id (char *);
+int8_t has_steam_cookie (const char *);
+int8_t get_steam_cookie (const char *, char *, size_t);
+int8_t save_steam_cookies (void);
 void base64_encode (const void *, size_t , char *, size_t *);
+int8_t base64_decode (const char *, uint8_t *, size_t, size_t *);
 
 #endif
@@ -0,0 +1,31 @@
+#ifndef __STEAMAPI_H__
+#define __STEAMAPI_H__
+
+/* Public API of libsteamapi */
+#include "steamdef.h"
+#include "steam.h"
+#include "allocator.h"
+#include "transport.h"
+#include "login.h"
+#include "guard.h"
+#include "session.h"
+#include "confirmation.h"
+#include "trade_offer.h"
+#include "inventory.h"
+#include "inventory_index.h"
+#include "inventory_scan.h"
+#include "description_cache.h"
+#include "export.h"
+#include "market.h"
+#include "buy_order.h"
+#include "listings.h"
+#include "history.h"
+#include "price.h"
+#include "money.h"
+#include "nameid.h"
+#include "watchlist.h"
+#include "metrics.h"
+#include "daemon.h"
+#include "jobs.h"
+
+#endif
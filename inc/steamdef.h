@@ -10,6 +10,7 @@
 
 #define TIMER_BUFFER_SIZE 26
 #define ERROR_MESSAGE_SIZE 64
+#define STEAM_MESSAGE_SIZE 256
 #define ENCODE_TABLE_SIZE 64
 #define POST_DATA_SIZE 1024
 #define MEMORY_CHUNK_SIZE 1024
@@ -18,6 +19,43 @@
 #define PASSWORD_SIZE 512
 #define ENCODE_PASSWORD_SIZE PASSWORD_SIZE * 3 + 1
 #define MAX_COUNT_LOAD_ITEMS  "5000"
+#define MAX_CONCURRENT_REQUESTS     8
+#define INVENTORY_SCAN_WINDOW       32
+#define MY_LISTINGS_PAGE_SIZE       100
+#define DESCRIPTION_CACHE_SIZE      65536
+#define DESCRIPTION_CACHE_MIN_SIZE  5000
+#define DESCRIPTION_LINE_SIZE       1024
+#define DESCRIPTION_CACHE_FILE      "descriptions.cache"
+#define EXPORT_BUFFER_SIZE          (1024 * 1024)
+#define EXPORT_BINARY_MAGIC         "SIB1"
+#define HISTORY_PAGE_SIZE           500
+#define HISTORY_NAME_SIZE           256
+#define HISTORY_INDEX_STRIDE        256
+#define HISTORY_LOG_MAGIC           "SMH1"
+#define HISTORY_STORE_FILE          "history.log"
+#define WATCHLIST_BATCH_SIZE        64
+#define SESSION_STORE_FILE          "session.txt"
+#define STEAM_ID_SIZE               32
+#define COOKIE_JAR_FILE             "cookie.txt"
+#define COOKIE_VALUE_SIZE           2048
+#define SESSION_KEEPALIVE_INTERVAL  300
+#define NAMEID_CACHE_FILE           "nameids.cache"
+#define STEAM_FEE_BASIS_POINTS      500
+#define PUBLISHER_FEE_BASIS_POINTS  1000
+#define MARKET_FEE_MINIMUM          1
+#define STEAM_GUARD_CODE_LENGTH     5
+#define STEAM_SECRET_SIZE           128
+#define STEAM_CREDENTIALS_FILE      "credentials.conf"
+#define CONFIRMATION_KEY_SIZE       32
+#define DEVICE_ID_SIZE              48
+#define CONFIRMATION_BATCH_SIZE     100
+#define DAEMON_SOCKET_FILE          "steam_api.sock"
+#define DAEMON_MAX_CLIENTS          64
+#define DAEMON_MAX_FRAME_SIZE       65536
+#define DAEMON_BUFFER_SIZE          4096
+#define DAEMON_MAX_INPUT_SIZE       (4 * DAEMON_MAX_FRAME_SIZE)
+#define TRADE_OFFER_MAX_PAGES       50
+#define STEAM_ID64_BASE             76561197960265728ULL
 
 #define SUCCESS  1
 #define FAILURE  0
@@ -29,6 +67,7 @@
 #define LOGIN_FAILURE  FAILURE
 
 #define URL_STEAM_COMMUNITY         "https://steamcommunity.com/"
+#define URL_STEAM_API               "https://api.steampowered.com/"
 #define URL_STEAM_MARKET            URL_STEAM_COMMUNITY "market/"
 #define URL_STEAM_GET_RSA_KEY       URL_STEAM_COMMUNITY "login/getrsakey?username="
 #define URL_STEAM_LOGIN             URL_STEAM_COMMUNITY "login/dologin/?"
@@ -53,6 +92,13 @@ typedef struct tMemory {
 	size_t  size;
 } Memory;
 
+/* String that is not NUL terminated, borrowed from a buffer owned by
+ * someone else, e.g. a parsed json object */
+typedef struct tStringView {
+	const char  *data;
+	size_t      length;
+} StringView;
+
 typedef struct tLoginResponse {
 	uint8_t   success;
 	char     *public_key_mod;
@@ -73,7 +119,7 @@ typedef struct tInventoryItem {
 
 typedef struct tSteamInventory {
 	char                    *app_id;
-	uint16_t                 count_items;
+	uint64_t                 count_items;
 	InventoryItem           *inventory_items;
 	struct tSteamInventory  *next_steam_inventory;
 } SteamInventory;
@@ -6,5 +6,6 @@ char g_session_id[128] = {0};
 char g_rfc3986[256] = {0};
 char g_html5[256] = {0};
 uint8_t g_debug_state = DEBUG_ENABLE;
+RequestBudget g_request_budget = REQUEST_BUDGET_UNLIMITED;
 
 #endif
@@ -0,0 +1,78 @@
+#ifndef __TRADE_OFFER_H__
+#define __TRADE_OFFER_H__
+
+#include "steamdef.h"
+
+extern char *g_steam_id;
+extern char g_session_id[128];
+
+/* trade_offer_state of IEconService */
+typedef enum tTradeOfferState {
+	TRADE_OFFER_STATE_INVALID = 1,
+	TRADE_OFFER_STATE_ACTIVE = 2,
+	TRADE_OFFER_STATE_ACCEPTED = 3,
+	TRADE_OFFER_STATE_COUNTERED = 4,
+	TRADE_OFFER_STATE_EXPIRED = 5,
+	TRADE_OFFER_STATE_CANCELED = 6,
+	TRADE_OFFER_STATE_DECLINED = 7,
+	TRADE_OFFER_STATE_INVALID_ITEMS = 8,
+	TRADE_OFFER_STATE_NEEDS_CONFIRMATION = 9,
+	TRADE_OFFER_STATE_CANCELED_BY_SECOND_FACTOR = 10,
+	TRADE_OFFER_STATE_IN_ESCROW = 11
+} TradeOfferState;
+
+typedef enum tTradeOfferAction {
+	TRADE_OFFER_ACCEPT = 0,
+	TRADE_OFFER_DECLINE,
+	TRADE_OFFER_CANCEL
+} TradeOfferAction;
+
+/* Items of each side are one inventory, every item has its own app_id */
+typedef struct tTradeOffer {
+	uint64_t          trade_offer_id;
+	uint64_t          partner_steam_id;
+	TradeOfferState   state;
+	int8_t            is_our_offer;
+	int64_t           time_created;
+	int64_t           time_updated;
+	int64_t           expiration_time;
+	int64_t           escrow_end_date;
+	char             *message;
+	SteamInventory   *items_to_give;
+	SteamInventory   *items_to_receive;
+} TradeOffer;
+
+typedef struct tTradeOfferList {
+	TradeOffer  *offers;
+	size_t       count_offers;
+} TradeOfferList;
+
+/* Zeroed cursor starts with the offers active now, every poll then
+ * returns only offers created or changed since the previous one */
+typedef struct tTradeOfferCursor {
+	int64_t  time_historical_cutoff;
+} TradeOfferCursor;
+
+typedef struct tTradeOfferResponse {
+	uint64_t          trade_offer_id;
+	uint64_t          partner_steam_id;
+	TradeOfferAction  action;
+} TradeOfferResponse;
+
+typedef struct tTradeOfferResult {
+	int8_t    success;
+	int8_t    needs_confirmation;
+	uint64_t  trade_id;
+	long      http_code;
+	char      message[STEAM_MESSAGE_SIZE];
+} TradeOfferResult;
+
+#define TRADE_OFFERS_SENT      0x01
+#define TRADE_OFFERS_RECEIVED  0x02
+
+TradeOfferList *poll_trade_offers (const char *, uint8_t, TradeOfferCursor *);
+void free_trade_offers (TradeOfferList *);
+int8_t respond_to_trade_offers (const TradeOfferResponse *, size_t,
+                                TradeOfferResult *, uint32_t);
+
+#endif
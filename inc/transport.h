@@ -0,0 +1,55 @@
+#ifndef __TRANSPORT_H__
+#define __TRANSPORT_H__
+
+#include <pthread.h>
+#include <time.h>
+#include <curl/curl.h>
+
+#include "steamdef.h"
+
+typedef struct tSteamRequest {
+	char      url[URL_SIZE];
+	char      url_referer[URL_SIZE];
+	char     *post_data;
+	Memory    response;
+	long      http_code;
+	CURLcode  curl_code;
+	/* Filled by curl, handles of a batch run at once so each has its own */
+	char      error_buffer[CURL_ERROR_SIZE];
+	uint32_t  session_generation;
+	uint8_t   count_replays;
+	/* Set when the caller reads a login answer itself, e.g. 401 of a
+	 * private inventory, the request is then never replayed */
+	uint8_t   no_session_replay;
+	void     *user_data;
+} SteamRequest;
+
+/* Called as soon as a request of a batch completes */
+typedef void (*SteamRequestCallback) (SteamRequest *, void *);
+
+/* Token bucket shared by every request of the process */
+typedef struct tRequestBudget {
+	double           rate;
+	double           burst;
+	double           tokens;
+	struct timespec  last_refill;
+	pthread_mutex_t  mutex;
+} RequestBudget;
+
+#define REQUEST_BUDGET_UNLIMITED  { 0.0, 0.0, 0.0, { 0, 0 }, \
+                                    PTHREAD_MUTEX_INITIALIZER }
+
+extern RequestBudget g_request_budget;
+
+void init_request_budget (RequestBudget *, double, double);
+uint32_t try_acquire_request_budget (RequestBudget *);
+void acquire_request_budget (RequestBudget *);
+
+struct curl_slist *create_steam_headers (void);
+void setup_curl_handle (CURL *, const char *, const char *, const char *,
+                        struct curl_slist *, Memory *, char *);
+int8_t curl_batch_request (SteamRequest *, size_t, uint32_t,
+                           SteamRequestCallback, void *);
+void free_steam_requests (SteamRequest *, size_t);
+
+#endif
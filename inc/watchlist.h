@@ -0,0 +1,64 @@
+#ifndef __WATCHLIST_H__
+#define __WATCHLIST_H__
+
+#include "steamdef.h"
+
+/* Price levels in cents with the quantity at each level (not cumulative) */
+typedef struct tOrderLadder {
+	int32_t   *prices;
+	uint32_t  *quantities;
+	size_t     count_levels;
+} OrderLadder;
+
+/* Buy ladder is ordered from the highest price, sell from the lowest */
+typedef struct tOrderBook {
+	OrderLadder  buy;
+	OrderLadder  sell;
+	int32_t      highest_buy_order;
+	int32_t      lowest_sell_order;
+} OrderBook;
+
+typedef void (*OrderBookSubscriber)(uint64_t, const OrderBook *,
+                                    const OrderBook *, void *);
+
+typedef struct tWatchedItem {
+	uint64_t   item_nameid;
+	OrderBook  book;
+	int8_t     has_book;
+	uint32_t   interval_ms;
+	int64_t    next_poll_ms;
+} WatchedItem;
+
+typedef struct tWatchSubscriber {
+	OrderBookSubscriber   callback;
+	void                 *user_data;
+} WatchSubscriber;
+
+/* Poll interval of an item is halved when its book changed and doubled
+ * when it did not, within [min_interval_ms, max_interval_ms] */
+typedef struct tWatchlist {
+	WatchedItem      *items;
+	size_t            count_items;
+	size_t            capacity;
+	WatchSubscriber  *subscribers;
+	size_t            count_subscribers;
+	uint32_t          currency;
+	uint32_t          min_interval_ms;
+	uint32_t          max_interval_ms;
+	uint32_t          max_concurrency;
+	int8_t            running;
+} Watchlist;
+
+Watchlist *create_watchlist (uint32_t, uint32_t, uint32_t, uint32_t);
+void free_watchlist (Watchlist *);
+int8_t watch_item (Watchlist *, uint64_t);
+int8_t unwatch_item (Watchlist *, uint64_t);
+int8_t subscribe_order_book (Watchlist *, OrderBookSubscriber, void *);
+int8_t parse_order_book (const char *, OrderBook *);
+void free_order_book (OrderBook *);
+int8_t order_books_equal (const OrderBook *, const OrderBook *);
+int8_t poll_watchlist (Watchlist *, uint32_t *);
+int8_t run_watchlist (Watchlist *);
+void stop_watchlist (Watchlist *);
+
+#endif
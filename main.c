@@ -1,10 +1,18 @@
 #include "inc/steam.h"
 #include "inc/steamdef.h"
 #include "inc/login.h"
+#include "inc/session.h"
 #include "inc/inventory.h"
 #include "inc/market.h"
+#include "inc/description_cache.h"
+#include "inc/metrics.h"
+#include "inc/daemon.h"
+#include "inc/jobs.h"
+
+#include <signal.h>
 
 int8_t steam_input_user_data (void);
+void handle_stop_signal (int);
 
 /*===========================================================================*
  * Function name    : steam_input_user_data                                  *
@@ -64,29 +72,158 @@ int8_t steam_input_user_data (void)
 	return SUCCESS;
 }
 
-int main (void)
+/*===========================================================================*
+ * Function name    : handle_stop_signal                                     *
+ *                                                                           *
+ * Description      : This function stop daemon on SIGINT/SIGTERM            *
+ *                                                                           *
+ * Input values(s)  : signal_number                                          *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void handle_stop_signal (int signal_number)
+{
+	(void)signal_number;
+
+	stop_steam_daemon ();
+}
+
+int main (int argc, char *argv[])
 {
 	SteamInventory *steam_inventory;
+	SteamCredentials credentials;
+	int8_t login_state = FAILURE;
+	int8_t has_credentials = FAILURE;
+	char steam_id[STEAM_ID_SIZE] = {0};
+	char *ptr_env = NULL;
 	g_debug_state = DEBUG_DISABLE;
 
+	/* Backend must be chosen before the library allocates anything, the
+	 * pool lives until exit */
+	if ((ptr_env = getenv ("STEAM_ALLOCATOR")) != NULL &&
+	    strcmp (ptr_env, "pool") == STRINGS_EQUAL)
+	{
+		set_steam_allocator (create_pool_allocator ());
+	}
+
 	init_encode_method ();
 
-	if (steam_input_user_data () != LOGIN_SUCCESS)
+	if ((ptr_env = getenv ("STEAM_METRICS_PORT")) != NULL)
+		start_metrics_listener ((uint16_t)atoi (ptr_env));
+
+	load_description_cache (DESCRIPTION_CACHE_FILE);
+
+	has_credentials = load_steam_credentials (&credentials, NULL);
+
+	/* Saved cookies skip the login handshake and Steam Guard code */
+	if (resume_steam_session (SESSION_STORE_FILE) == SUCCESS)
+	{
+		login_state = LOGIN_SUCCESS;
+	}
+	/* Unattended login when credentials file or environment has them */
+	else if (has_credentials == SUCCESS)
+	{
+		login_state = steam_login_with_credentials (&credentials);
+	}
+	else
+	{
+		login_state = steam_input_user_data ();
+	}
+
+	if (login_state != LOGIN_SUCCESS)
 	{
+		memset (&credentials, 0, sizeof (credentials));
+
 		return 0;
 	}
 
-	/* Examples */
-	steam_inventory = get_inventory_items (g_steam_id);
+	save_steam_session (SESSION_STORE_FILE);
+
+	/* Expired session is refreshed (with a new login when credentials are
+	 * known) and failed requests are replayed */
+	start_session_keepalive (has_credentials == SUCCESS ? &credentials : NULL,
+	                         SESSION_STORE_FILE, SESSION_KEEPALIVE_INTERVAL);
+
+	memset (&credentials, 0, sizeof (credentials));
+
+	/* steam_api --daemon [socket]: serve local clients until stopped */
+	if (argc > 1 && strcmp (argv[1], "--daemon") == STRINGS_EQUAL)
+	{
+		signal (SIGINT, handle_stop_signal);
+		signal (SIGTERM, handle_stop_signal);
+
+		ptr_env = getenv ("STEAM_CURRENCY");
 
-	if (steam_inventory != NULL)
+		run_steam_daemon (argc > 2 ? argv[2] : DAEMON_SOCKET_FILE,
+		                  ptr_env != NULL ? (uint32_t)atoi (ptr_env) : 1,
+		                  MAX_CONCURRENT_REQUESTS);
+	}
+	/* steam_api --jobs [input|-] [output]: run NDJSON jobs, stdin/stdout
+	 * by default */
+	else if (argc > 1 && strcmp (argv[1], "--jobs") == STRINGS_EQUAL)
+	{
+		FILE *jobs_input = stdin;
+		FILE *jobs_output = stdout;
+		uint32_t jobs_concurrency = MAX_CONCURRENT_REQUESTS;
+
+		if (argc > 2 && strcmp (argv[2], "-") != STRINGS_EQUAL)
+			jobs_input = fopen (argv[2], "r");
+
+		if (argc > 3)
+			jobs_output = fopen (argv[3], "w");
+
+		if ((ptr_env = getenv ("STEAM_JOBS_CONCURRENCY")) != NULL &&
+		    atoi (ptr_env) > 0)
+		{
+			jobs_concurrency = (uint32_t)atoi (ptr_env);
+		}
+
+		ptr_env = getenv ("STEAM_CURRENCY");
+
+		if (jobs_input != NULL && jobs_output != NULL)
+		{
+			run_steam_jobs (jobs_input, jobs_output, jobs_concurrency,
+			                ptr_env != NULL ? (uint32_t)atoi (ptr_env) : 1);
+		}
+		else
+		{
+			fprintf (stderr, "Can't open jobs input/output\n");
+		}
+
+		if (jobs_input != NULL && jobs_input != stdin)
+			fclose (jobs_input);
+
+		if (jobs_output != NULL && jobs_output != stdout)
+			fclose (jobs_output);
+	}
+	else
 	{
-		print_steam_inventory (steam_inventory);
-		//sell_item (steam_inventory->inventory_items[1], "300");
-		// We must free these steam_inventory when we're done
-		free_steam_inventory (steam_inventory);
+		/* Examples */
+		get_steam_session (steam_id, sizeof (steam_id), NULL, 0);
+		steam_inventory = get_inventory_items (steam_id);
+
+		if (steam_inventory != NULL)
+		{
+			print_steam_inventory (steam_inventory);
+			//sell_item (steam_inventory->inventory_items[1], "300");
+			// We must free these steam_inventory when we're done
+			free_steam_inventory (steam_inventory);
+		}
 	}
 
+	save_description_cache (DESCRIPTION_CACHE_FILE);
+
+	stop_session_keepalive ();
+
+	save_steam_cookies ();
+
+	if ((ptr_env = getenv ("STEAM_METRICS_FILE")) != NULL)
+		save_metrics (ptr_env);
+
+	stop_metrics_listener ();
+
 	/*
 	create_buy_order ("203770-The Khan", 0.25, 10, "753", "5");
 
@@ -0,0 +1,654 @@
+#include <pthread.h>
+
+#include "../inc/allocator.h"
+#include "../inc/steam.h"
+
+#define POOL_MIN_BLOCK      32
+#define POOL_MAX_BLOCK      4096
+#define POOL_COUNT_CLASSES  8
+#define POOL_SLAB_SIZE      (256 * 1024)
+
+/* Every block starts with its size and tag, so steam_free () needs neither
+ * and the backend gets sized deallocation. The union keeps the user part
+ * aligned like malloc () does */
+typedef union tAllocationHeader {
+	struct {
+		size_t    size;
+		uint32_t  tag;
+	} block;
+	long double  align;
+} AllocationHeader;
+
+/* Power of two size classes carved from slabs, a freed block goes to the
+ * free list of its class. Slabs are kept until the pool is freed */
+typedef struct tPoolAllocator {
+	SteamAllocator   allocator;
+	pthread_mutex_t  mutex;
+	void            *free_blocks[POOL_COUNT_CLASSES];
+	char            *slab_next;
+	size_t           slab_left;
+	void            *slabs;
+} PoolAllocator;
+
+static void *allocate_libc (size_t, void *);
+static void *reallocate_libc (void *, size_t, size_t, void *);
+static void release_libc (void *, size_t, void *);
+static int get_pool_class (size_t);
+static void *allocate_pool (size_t, void *);
+static void *reallocate_pool (void *, size_t, size_t, void *);
+static void release_pool (void *, size_t, void *);
+static void account_allocation (AllocationTag, size_t);
+static void account_release (AllocationTag, size_t);
+
+static SteamAllocator s_allocator = {
+	allocate_libc, reallocate_libc, release_libc, NULL
+};
+
+static AllocationStats s_allocation_stats[ALLOC_TAG_COUNT];
+
+static const char *s_tag_names[ALLOC_TAG_COUNT] = {
+	"transport", "json", "inventory", "market", "session", "trade", "other"
+};
+
+/*===========================================================================*
+ * Function name    : allocate_libc                                          *
+ *                                                                           *
+ * Description      : This function allocate block with malloc ()            *
+ *                                                                           *
+ * Input values(s)  : size                                                   *
+ *                    user_data - not used                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Block or NULL                                          *
+ *===========================================================================*/
+static void *allocate_libc (size_t size, void *user_data)
+{
+	(void)user_data;
+
+	return malloc (size);
+}
+
+/*===========================================================================*
+ * Function name    : reallocate_libc                                        *
+ *                                                                           *
+ * Description      : This function resize block with realloc ()             *
+ *                                                                           *
+ * Input values(s)  : ptr                                                    *
+ *                    old_size - not used                                    *
+ *                    size                                                   *
+ *                    user_data - not used                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Block or NULL, ptr is kept on failure                  *
+ *===========================================================================*/
+static void *reallocate_libc (void *ptr, size_t old_size, size_t size,
+                              void *user_data)
+{
+	(void)old_size;
+	(void)user_data;
+
+	return realloc (ptr, size);
+}
+
+/*===========================================================================*
+ * Function name    : release_libc                                           *
+ *                                                                           *
+ * Description      : This function free block with free ()                  *
+ *                                                                           *
+ * Input values(s)  : ptr                                                    *
+ *                    size - not used                                        *
+ *                    user_data - not used                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void release_libc (void *ptr, size_t size, void *user_data)
+{
+	(void)size;
+	(void)user_data;
+
+	free (ptr);
+}
+
+/*===========================================================================*
+ * Function name    : get_pool_class                                         *
+ *                                                                           *
+ * Description      : This function get size class of block                  *
+ *                                                                           *
+ * Input values(s)  : size                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Class, -1 when block is too big for the pool           *
+ *===========================================================================*/
+static int get_pool_class (size_t size)
+{
+	size_t block_size = POOL_MIN_BLOCK;
+
+	for (int pool_class = 0; pool_class < POOL_COUNT_CLASSES; pool_class++)
+	{
+		if (size <= block_size)
+			return pool_class;
+
+		block_size <<= 1;
+	}
+
+	return -1;
+}
+
+/*===========================================================================*
+ * Function name    : allocate_pool                                          *
+ *                                                                           *
+ * Description      : This function take block from free list of its class,  *
+ *                    or carve it from the current slab                      *
+ *                                                                           *
+ * Input values(s)  : size                                                   *
+ *                    user_data - pool                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Block or NULL                                          *
+ *===========================================================================*/
+static void *allocate_pool (size_t size, void *user_data)
+{
+	PoolAllocator *pool = user_data;
+	int pool_class = get_pool_class (size);
+	size_t block_size = 0;
+	char *slab = NULL;
+	void *block = NULL;
+
+	if (pool_class < 0)
+		return malloc (size);
+
+	block_size = (size_t)POOL_MIN_BLOCK << pool_class;
+
+	pthread_mutex_lock (&pool->mutex);
+
+	if (pool->free_blocks[pool_class] != NULL)
+	{
+		block = pool->free_blocks[pool_class];
+		pool->free_blocks[pool_class] = *(void **)block;
+	}
+	else
+	{
+		if (pool->slab_left < block_size)
+		{
+			slab = malloc (POOL_SLAB_SIZE);
+
+			if (slab != NULL)
+			{
+				/* First block of a slab links the slabs */
+				*(void **)slab = pool->slabs;
+				pool->slabs = slab;
+				pool->slab_next = slab + POOL_MIN_BLOCK;
+				pool->slab_left = POOL_SLAB_SIZE - POOL_MIN_BLOCK;
+			}
+		}
+
+		if (pool->slab_left >= block_size)
+		{
+			block = pool->slab_next;
+			pool->slab_next += block_size;
+			pool->slab_left -= block_size;
+		}
+	}
+
+	pthread_mutex_unlock (&pool->mutex);
+
+	return block;
+}
+
+/*===========================================================================*
+ * Function name    : reallocate_pool                                        *
+ *                                                                           *
+ * Description      : This function resize block, it stays in place while    *
+ *                    the size class is the same                             *
+ *                                                                           *
+ * Input values(s)  : ptr                                                    *
+ *                    old_size                                               *
+ *                    size                                                   *
+ *                    user_data - pool                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Block or NULL, ptr is kept on failure                  *
+ *===========================================================================*/
+static void *reallocate_pool (void *ptr, size_t old_size, size_t size,
+                              void *user_data)
+{
+	int old_class = get_pool_class (old_size);
+	int new_class = get_pool_class (size);
+	void *block = NULL;
+
+	if (old_class == new_class)
+		return old_class < 0 ? realloc (ptr, size) : ptr;
+
+	block = allocate_pool (size, user_data);
+
+	if (block == NULL)
+		return NULL;
+
+	memcpy (block, ptr, old_size < size ? old_size : size);
+
+	release_pool (ptr, old_size, user_data);
+
+	return block;
+}
+
+/*===========================================================================*
+ * Function name    : release_pool                                           *
+ *                                                                           *
+ * Description      : This function put block to free list of its class      *
+ *                                                                           *
+ * Input values(s)  : ptr                                                    *
+ *                    size                                                   *
+ *                    user_data - pool                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void release_pool (void *ptr, size_t size, void *user_data)
+{
+	PoolAllocator *pool = user_data;
+	int pool_class = get_pool_class (size);
+
+	if (pool_class < 0)
+	{
+		free (ptr);
+
+		return;
+	}
+
+	pthread_mutex_lock (&pool->mutex);
+
+	*(void **)ptr = pool->free_blocks[pool_class];
+	pool->free_blocks[pool_class] = ptr;
+
+	pthread_mutex_unlock (&pool->mutex);
+}
+
+/*===========================================================================*
+ * Function name    : account_allocation                                     *
+ *                                                                           *
+ * Description      : This function add block to stats of its tag            *
+ *                                                                           *
+ * Input values(s)  : tag                                                    *
+ *                    size                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void account_allocation (AllocationTag tag, size_t size)
+{
+	AllocationStats *stats = &s_allocation_stats[tag];
+	uint64_t live_bytes = 0;
+	uint64_t peak_bytes = 0;
+
+	__atomic_add_fetch (&stats->count_allocations, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch (&stats->live_blocks, 1, __ATOMIC_RELAXED);
+
+	live_bytes = __atomic_add_fetch (&stats->live_bytes, size, __ATOMIC_RELAXED);
+	peak_bytes = __atomic_load_n (&stats->peak_bytes, __ATOMIC_RELAXED);
+
+	while (live_bytes > peak_bytes &&
+	       __atomic_compare_exchange_n (&stats->peak_bytes, &peak_bytes,
+	                                    live_bytes, 1, __ATOMIC_RELAXED,
+	                                    __ATOMIC_RELAXED) == 0)
+	{
+	}
+}
+
+/*===========================================================================*
+ * Function name    : account_release                                        *
+ *                                                                           *
+ * Description      : This function remove block from stats of its tag       *
+ *                                                                           *
+ * Input values(s)  : tag                                                    *
+ *                    size                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void account_release (AllocationTag tag, size_t size)
+{
+	AllocationStats *stats = &s_allocation_stats[tag];
+
+	__atomic_sub_fetch (&stats->live_blocks, 1, __ATOMIC_RELAXED);
+	__atomic_sub_fetch (&stats->live_bytes, size, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*
+ * Function name    : set_steam_allocator                                    *
+ *                                                                           *
+ * Description      : This function replace backend of steam_malloc () and   *
+ *                    friends. Only possible while no block is live, so call *
+ *                    it before anything else of the library                 *
+ *                                                                           *
+ * Input values(s)  : allocator - copied, NULL restores malloc ()            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE when blocks are live                   *
+ *===========================================================================*/
+int8_t set_steam_allocator (const SteamAllocator *allocator)
+{
+	for (size_t index = 0; index < ALLOC_TAG_COUNT; index++)
+	{
+		if (__atomic_load_n (&s_allocation_stats[index].live_blocks,
+		                     __ATOMIC_RELAXED) != 0)
+		{
+			return FAILURE;
+		}
+	}
+
+	if (allocator != NULL)
+	{
+		s_allocator = *allocator;
+	}
+	else
+	{
+		s_allocator.allocate = allocate_libc;
+		s_allocator.reallocate = reallocate_libc;
+		s_allocator.release = release_libc;
+		s_allocator.user_data = NULL;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : create_pool_allocator                                  *
+ *                                                                           *
+ * Description      : This function create pool backend. Small blocks are    *
+ *                    carved from big slabs and reused by size class, which  *
+ *                    keeps item strings and request buffers off the libc    *
+ *                    heap                                                   *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Allocator for set_steam_allocator () or NULL           *
+ *===========================================================================*/
+SteamAllocator *create_pool_allocator (void)
+{
+	PoolAllocator *pool = NULL;
+
+	pool = calloc (1, sizeof (PoolAllocator));
+
+	if (pool == NULL)
+	{
+		return NULL;
+	}
+
+	pthread_mutex_init (&pool->mutex, NULL);
+
+	pool->allocator.allocate = allocate_pool;
+	pool->allocator.reallocate = reallocate_pool;
+	pool->allocator.release = release_pool;
+	pool->allocator.user_data = pool;
+
+	return &pool->allocator;
+}
+
+/*===========================================================================*
+ * Function name    : free_pool_allocator                                    *
+ *                                                                           *
+ * Description      : This function free pool and all its slabs              *
+ *                                                                           *
+ * Input values(s)  : allocator - from create_pool_allocator ()              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE when the pool is still in use          *
+ *===========================================================================*/
+int8_t free_pool_allocator (SteamAllocator *allocator)
+{
+	PoolAllocator *pool = NULL;
+	void *slab = NULL;
+
+	if (allocator == NULL)
+	{
+		return SUCCESS;
+	}
+
+	pool = allocator->user_data;
+
+	if (s_allocator.user_data == pool)
+	{
+		return FAILURE;
+	}
+
+	while (pool->slabs != NULL)
+	{
+		slab = pool->slabs;
+		pool->slabs = *(void **)slab;
+
+		free (slab);
+	}
+
+	pthread_mutex_destroy (&pool->mutex);
+
+	free (pool);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : steam_malloc                                           *
+ *                                                                           *
+ * Description      : This function allocate memory accounted to tag         *
+ *                                                                           *
+ * Input values(s)  : size                                                   *
+ *                    tag                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Memory, free by steam_free ()/NULL                     *
+ *===========================================================================*/
+void *steam_malloc (size_t size, AllocationTag tag)
+{
+	AllocationHeader *header = NULL;
+
+	if (size > SIZE_MAX - sizeof (AllocationHeader))
+	{
+		return NULL;
+	}
+
+	header = s_allocator.allocate (sizeof (AllocationHeader) + size,
+	                               s_allocator.user_data);
+
+	if (header == NULL)
+	{
+		return NULL;
+	}
+
+	header->block.size = size;
+	header->block.tag = tag;
+
+	account_allocation (tag, size);
+
+	return header + 1;
+}
+
+/*===========================================================================*
+ * Function name    : steam_calloc                                           *
+ *                                                                           *
+ * Description      : This function allocate zeroed memory accounted to tag  *
+ *                                                                           *
+ * Input values(s)  : count                                                  *
+ *                    size                                                   *
+ *                    tag                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Memory, free by steam_free ()/NULL                     *
+ *===========================================================================*/
+void *steam_calloc (size_t count, size_t size, AllocationTag tag)
+{
+	void *ptr = NULL;
+
+	if (size != 0 && count > SIZE_MAX / size)
+	{
+		return NULL;
+	}
+
+	ptr = steam_malloc (count * size, tag);
+
+	if (ptr != NULL)
+	{
+		memset (ptr, 0, count * size);
+	}
+
+	return ptr;
+}
+
+/*===========================================================================*
+ * Function name    : steam_realloc                                          *
+ *                                                                           *
+ * Description      : This function resize memory, the block is accounted to *
+ *                    tag from now on                                        *
+ *                                                                           *
+ * Input values(s)  : ptr - from steam_malloc ()/NULL                        *
+ *                    size                                                   *
+ *                    tag                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Memory or NULL, ptr is kept on failure                 *
+ *===========================================================================*/
+void *steam_realloc (void *ptr, size_t size, AllocationTag tag)
+{
+	AllocationHeader *header = NULL;
+	size_t old_size = 0;
+	AllocationTag old_tag = ALLOC_TAG_OTHER;
+
+	if (ptr == NULL)
+	{
+		return steam_malloc (size, tag);
+	}
+
+	if (size > SIZE_MAX - sizeof (AllocationHeader))
+	{
+		return NULL;
+	}
+
+	header = (AllocationHeader *)ptr - 1;
+	old_size = header->block.size;
+	old_tag = (AllocationTag)header->block.tag;
+
+	header = s_allocator.reallocate (header, sizeof (AllocationHeader) + old_size,
+	                                 sizeof (AllocationHeader) + size,
+	                                 s_allocator.user_data);
+
+	if (header == NULL)
+	{
+		return NULL;
+	}
+
+	header->block.size = size;
+	header->block.tag = tag;
+
+	account_release (old_tag, old_size);
+	account_allocation (tag, size);
+
+	return header + 1;
+}
+
+/*===========================================================================*
+ * Function name    : steam_strdup                                           *
+ *                                                                           *
+ * Description      : This function copy string to memory accounted to tag   *
+ *                                                                           *
+ * Input values(s)  : str                                                    *
+ *                    tag                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Copy, free by steam_free ()/NULL                       *
+ *===========================================================================*/
+char *steam_strdup (const char *str, AllocationTag tag)
+{
+	size_t length = strlen (str) + 1;
+	char *copy = steam_malloc (length, tag);
+
+	if (copy != NULL)
+	{
+		memcpy (copy, str, length);
+	}
+
+	return copy;
+}
+
+/*===========================================================================*
+ * Function name    : steam_free                                             *
+ *                                                                           *
+ * Description      : This function free memory of steam_malloc () and       *
+ *                    friends                                                *
+ *                                                                           *
+ * Input values(s)  : ptr - may be NULL                                      *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void steam_free (void *ptr)
+{
+	AllocationHeader *header = NULL;
+
+	if (ptr == NULL)
+	{
+		return;
+	}
+
+	header = (AllocationHeader *)ptr - 1;
+
+	account_release ((AllocationTag)header->block.tag, header->block.size);
+
+	s_allocator.release (header, sizeof (AllocationHeader) + header->block.size,
+	                     s_allocator.user_data);
+}
+
+/*===========================================================================*
+ * Function name    : get_allocation_stats                                   *
+ *                                                                           *
+ * Description      : This function get live and high-water bytes of tag     *
+ *                                                                           *
+ * Input values(s)  : tag                                                    *
+ *                                                                           *
+ * Output values(s) : stats                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void get_allocation_stats (AllocationTag tag, AllocationStats *stats)
+{
+	const AllocationStats *tag_stats = &s_allocation_stats[tag];
+
+	stats->live_bytes = __atomic_load_n (&tag_stats->live_bytes, __ATOMIC_RELAXED);
+	stats->peak_bytes = __atomic_load_n (&tag_stats->peak_bytes, __ATOMIC_RELAXED);
+	stats->live_blocks = __atomic_load_n (&tag_stats->live_blocks, __ATOMIC_RELAXED);
+	stats->count_allocations = __atomic_load_n (&tag_stats->count_allocations,
+	                                            __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*
+ * Function name    : get_allocation_tag_name                                *
+ *                                                                           *
+ * Description      : This function get name of tag                          *
+ *                                                                           *
+ * Input values(s)  : tag                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Name                                                   *
+ *===========================================================================*/
+const char *get_allocation_tag_name (AllocationTag tag)
+{
+	return tag < ALLOC_TAG_COUNT ? s_tag_names[tag] : "unknown";
+}
@@ -0,0 +1,652 @@
+#include "../inc/buy_order.h"
+#include "../inc/listings.h"
+#include "../inc/steam.h"
+#include "../inc/transport.h"
+#include "../inc/session.h"
+
+static int8_t add_buy_order (BuyOrderBook *, uint64_t, uint32_t, const char *,
+                             uint32_t, uint32_t, uint32_t);
+static void remove_buy_order (BuyOrderBook *, uint64_t);
+static void parse_buy_order_response (const SteamRequest *, BuyOrderResult *);
+static int8_t build_create_request (SteamRequest *, const BuyOrderSpec *,
+                                    uint32_t, char *);
+static void build_cancel_request (SteamRequest *, uint64_t, char *);
+
+/*===========================================================================*
+ * Function name    : add_buy_order                                          *
+ *                                                                           *
+ * Description      : This function add order to buy order book              *
+ *                                                                           *
+ * Input values(s)  : buy_order_book                                         *
+ *                    buy_order_id                                           *
+ *                    app_id                                                 *
+ *                    market_hash_name                                       *
+ *                    price - per item, in cents                             *
+ *                    quantity                                               *
+ *                    quantity_remaining                                     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t add_buy_order (BuyOrderBook *buy_order_book, uint64_t buy_order_id,
+                             uint32_t app_id, const char *market_hash_name,
+                             uint32_t price, uint32_t quantity,
+                             uint32_t quantity_remaining)
+{
+	BuyOrder *ptr_orders = NULL;
+	BuyOrder *buy_order = NULL;
+	size_t capacity = 0;
+
+	if (buy_order_book->count_orders == buy_order_book->capacity)
+	{
+		capacity = buy_order_book->capacity > 0 ? buy_order_book->capacity * 2 : 64;
+
+		ptr_orders = steam_realloc (buy_order_book->buy_orders,
+		                            capacity * sizeof (BuyOrder), ALLOC_TAG_MARKET);
+
+		if (ptr_orders == NULL)
+		{
+			return FAILURE;
+		}
+
+		buy_order_book->buy_orders = ptr_orders;
+		buy_order_book->capacity = capacity;
+	}
+
+	buy_order = &buy_order_book->buy_orders[buy_order_book->count_orders];
+
+	buy_order->market_hash_name = steam_strdup (market_hash_name != NULL ?
+	                                            market_hash_name : "",
+	                                            ALLOC_TAG_MARKET);
+
+	if (buy_order->market_hash_name == NULL)
+	{
+		return FAILURE;
+	}
+
+	buy_order->buy_order_id = buy_order_id;
+	buy_order->app_id = app_id;
+	buy_order->price = price;
+	buy_order->quantity = quantity;
+	buy_order->quantity_remaining = quantity_remaining;
+
+	buy_order_book->count_orders++;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : remove_buy_order                                       *
+ *                                                                           *
+ * Description      : This function remove order from buy order book         *
+ *                                                                           *
+ * Input values(s)  : buy_order_book                                         *
+ *                    buy_order_id                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void remove_buy_order (BuyOrderBook *buy_order_book, uint64_t buy_order_id)
+{
+	BuyOrder *buy_order = find_buy_order (buy_order_book, buy_order_id);
+
+	if (buy_order == NULL)
+		return;
+
+	steam_free (buy_order->market_hash_name);
+
+	/* Order of the book does not matter, move the last order here */
+	*buy_order = buy_order_book->buy_orders[--buy_order_book->count_orders];
+}
+
+/*===========================================================================*
+ * Function name    : parse_buy_order_response                               *
+ *                                                                           *
+ * Description      : This function get result of createbuyorder and         *
+ *                    cancelbuyorder requests                                *
+ *                                                                           *
+ * Input values(s)  : request                                                *
+ *                                                                           *
+ * Output values(s) : buy_order_result                                       *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void parse_buy_order_response (const SteamRequest *request,
+                                      BuyOrderResult *buy_order_result)
+{
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_message = NULL;
+	uint64_t success = 0;
+
+	buy_order_result->success = FAILURE;
+	buy_order_result->http_code = request->http_code;
+	buy_order_result->message[0] = '\0';
+
+	if (request->curl_code != CURLE_OK || request->response.memory == NULL)
+	{
+		snprintf (buy_order_result->message, sizeof (buy_order_result->message),
+		          "%s", curl_easy_strerror (request->curl_code));
+		return;
+	}
+
+	parsed_json = parse_json_response (request->response.memory);
+
+	if (parsed_json == NULL)
+	{
+		snprintf (buy_order_result->message, sizeof (buy_order_result->message),
+		          "unexpected response (http %ld)", request->http_code);
+		return;
+	}
+
+	get_json_object_as_uint64 (&success, parsed_json, "success");
+	get_json_object_as_uint64 (&buy_order_result->buy_order_id, parsed_json,
+	                           "buy_orderid");
+
+	if (json_object_object_get_ex (parsed_json, "message", &json_message))
+	{
+		snprintf (buy_order_result->message, sizeof (buy_order_result->message),
+		          "%s", json_object_get_string (json_message));
+	}
+
+	if (success == 1)
+	{
+		buy_order_result->success = SUCCESS;
+	}
+
+	json_object_put (parsed_json);
+}
+
+/*===========================================================================*
+ * Function name    : build_create_request                                   *
+ *                                                                           *
+ * Description      : This function build createbuyorder request             *
+ *                                                                           *
+ * Input values(s)  : buy_order_spec                                         *
+ *                    currency                                               *
+ *                    post_data - POST_DATA_SIZE bytes                       *
+ *                                                                           *
+ * Output values(s) : request                                                *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t build_create_request (SteamRequest *request,
+                                    const BuyOrderSpec *buy_order_spec,
+                                    uint32_t currency, char *post_data)
+{
+	char *ptr_hash_name_encode = NULL;
+	char session_id[sizeof (g_session_id)] = {0};
+
+	ptr_hash_name_encode = steam_calloc (strlen (buy_order_spec->market_hash_name) * 3 + 1,
+	                                     sizeof (char), ALLOC_TAG_MARKET);
+
+	if (ptr_hash_name_encode == NULL)
+	{
+		return FAILURE;
+	}
+
+	snprintf (request->url, sizeof (request->url), URL_STEAM_MARKET "createbuyorder/");
+
+	url_encode (buy_order_spec->market_hash_name, ptr_hash_name_encode, g_rfc3986);
+
+	snprintf (request->url_referer, sizeof (request->url_referer),
+	          URL_STEAM_REFERER_BUY_ITEM "%u/%s/", buy_order_spec->app_id,
+	          ptr_hash_name_encode);
+
+	ptr_hash_name_encode[0] = '\0';
+
+	get_steam_session (NULL, 0, session_id, sizeof (session_id));
+
+	url_encode (buy_order_spec->market_hash_name, ptr_hash_name_encode, g_html5);
+
+	snprintf (post_data, POST_DATA_SIZE,
+		      "sessionid=" "%s" "&"
+		      "currency=" "%u" "&"
+		      "appid=" "%u" "&"
+		      "market_hash_name=" "%s" "&"
+		      "price_total=" "%llu" "&"
+		      "quantity=" "%u",
+		      session_id, currency, buy_order_spec->app_id,
+		      ptr_hash_name_encode,
+		      (unsigned long long)buy_order_spec->price * buy_order_spec->quantity,
+		      buy_order_spec->quantity);
+
+	request->post_data = post_data;
+
+	steam_free (ptr_hash_name_encode);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : build_cancel_request                                   *
+ *                                                                           *
+ * Description      : This function build cancelbuyorder request             *
+ *                                                                           *
+ * Input values(s)  : buy_order_id                                           *
+ *                    post_data - POST_DATA_SIZE bytes                       *
+ *                                                                           *
+ * Output values(s) : request                                                *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void build_cancel_request (SteamRequest *request, uint64_t buy_order_id,
+                                  char *post_data)
+{
+	char session_id[sizeof (g_session_id)] = {0};
+
+	get_steam_session (NULL, 0, session_id, sizeof (session_id));
+
+	snprintf (request->url, sizeof (request->url), URL_STEAM_MARKET "cancelbuyorder/");
+	snprintf (request->url_referer, sizeof (request->url_referer), URL_STEAM_MARKET);
+
+	snprintf (post_data, POST_DATA_SIZE,
+		      "sessionid=" "%s" "&"
+		      "buy_orderid=" "%llu",
+		      session_id, (unsigned long long)buy_order_id);
+
+	request->post_data = post_data;
+}
+
+/*===========================================================================*
+ * Function name    : create_buy_order_book                                  *
+ *                                                                           *
+ * Description      : This function create empty buy order book              *
+ *                                                                           *
+ * Input values(s)  : currency - wallet currency of new orders               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Buy order book or NULL                                 *
+ *===========================================================================*/
+BuyOrderBook *create_buy_order_book (uint32_t currency)
+{
+	BuyOrderBook *buy_order_book = NULL;
+
+	buy_order_book = steam_calloc (1, sizeof (BuyOrderBook), ALLOC_TAG_MARKET);
+
+	if (buy_order_book != NULL)
+	{
+		buy_order_book->currency = currency;
+	}
+
+	return buy_order_book;
+}
+
+/*===========================================================================*
+ * Function name    : free_buy_order_book                                    *
+ *                                                                           *
+ * Description      : This function free memory for buy order book           *
+ *                                                                           *
+ * Input values(s)  : buy_order_book                                         *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_buy_order_book (BuyOrderBook *buy_order_book)
+{
+	if (buy_order_book == NULL)
+		return;
+
+	for (size_t index = 0; index < buy_order_book->count_orders; index++)
+	{
+		steam_free (buy_order_book->buy_orders[index].market_hash_name);
+	}
+
+	steam_free (buy_order_book->buy_orders);
+	steam_free (buy_order_book);
+}
+
+/*===========================================================================*
+ * Function name    : sync_buy_order_book                                    *
+ *                                                                           *
+ * Description      : This function replace book content with open buy       *
+ *                    orders from get_my_listings ()                         *
+ *                                                                           *
+ * Input values(s)  : buy_order_book                                         *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t sync_buy_order_book (BuyOrderBook *buy_order_book)
+{
+	MyListings *my_listings = NULL;
+
+	print_debug_information ("Entering the function to "
+	                         "sync_buy_order_book ()", __LINE__);
+
+	my_listings = get_my_listings (MAX_CONCURRENT_REQUESTS);
+
+	if (my_listings == NULL)
+	{
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < buy_order_book->count_orders; index++)
+	{
+		steam_free (buy_order_book->buy_orders[index].market_hash_name);
+	}
+
+	steam_free (buy_order_book->buy_orders);
+
+	/* Take the parsed orders over instead of copying them */
+	buy_order_book->buy_orders = my_listings->buy_orders;
+	buy_order_book->count_orders = my_listings->count_buy_orders;
+	/* Without open orders the array is NULL, the next add allocates it */
+	buy_order_book->capacity = my_listings->count_buy_orders;
+
+	my_listings->buy_orders = NULL;
+	my_listings->count_buy_orders = 0;
+
+	free_my_listings (my_listings);
+
+	print_debug_information ("Exiting the function to "
+	                         "sync_buy_order_book ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : find_buy_order                                         *
+ *                                                                           *
+ * Description      : This function find order by buy order id               *
+ *                                                                           *
+ * Input values(s)  : buy_order_book                                         *
+ *                    buy_order_id                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Buy order or NULL                                      *
+ *===========================================================================*/
+BuyOrder *find_buy_order (BuyOrderBook *buy_order_book, uint64_t buy_order_id)
+{
+	for (size_t index = 0; index < buy_order_book->count_orders; index++)
+	{
+		if (buy_order_book->buy_orders[index].buy_order_id == buy_order_id)
+			return &buy_order_book->buy_orders[index];
+	}
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : find_buy_order_by_name                                 *
+ *                                                                           *
+ * Description      : This function find order by item                       *
+ *                                                                           *
+ * Input values(s)  : buy_order_book                                         *
+ *                    app_id                                                 *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Buy order or NULL                                      *
+ *===========================================================================*/
+BuyOrder *find_buy_order_by_name (BuyOrderBook *buy_order_book, uint32_t app_id,
+                                  const char *market_hash_name)
+{
+	for (size_t index = 0; index < buy_order_book->count_orders; index++)
+	{
+		if (buy_order_book->buy_orders[index].app_id == app_id &&
+		    strcmp (buy_order_book->buy_orders[index].market_hash_name,
+		            market_hash_name) == STRINGS_EQUAL)
+			return &buy_order_book->buy_orders[index];
+	}
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : create_buy_orders                                      *
+ *                                                                           *
+ * Description      : This function create buy orders concurrently and       *
+ *                    record the created ones in the book                    *
+ *                                                                           *
+ * Input values(s)  : buy_order_book                                         *
+ *                    buy_order_specs                                        *
+ *                    count_orders                                           *
+ *                    max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : buy_order_results - in the same order                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if every order was created, otherwise FAILURE  *
+ *===========================================================================*/
+int8_t create_buy_orders (BuyOrderBook *buy_order_book,
+                          const BuyOrderSpec *buy_order_specs,
+                          size_t count_orders,
+                          BuyOrderResult *buy_order_results,
+                          uint32_t max_concurrency)
+{
+	SteamRequest *requests = NULL;
+	char *post_data = NULL;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "create_buy_orders ()", __LINE__);
+
+	requests = steam_calloc (count_orders + 1, sizeof (SteamRequest),
+	                         ALLOC_TAG_MARKET);
+	post_data = steam_calloc (count_orders + 1, POST_DATA_SIZE,
+	                          ALLOC_TAG_MARKET);
+
+	if (requests == NULL || post_data == NULL)
+	{
+		steam_free (requests);
+		steam_free (post_data);
+
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < count_orders; index++)
+	{
+		if (build_create_request (&requests[index], &buy_order_specs[index],
+		                          buy_order_book->currency,
+		                          post_data + index * POST_DATA_SIZE) != SUCCESS)
+		{
+			steam_free (requests);
+			steam_free (post_data);
+
+			return FAILURE;
+		}
+	}
+
+	curl_batch_request (requests, count_orders, max_concurrency, NULL, NULL);
+
+	for (size_t index = 0; index < count_orders; index++)
+	{
+		parse_buy_order_response (&requests[index], &buy_order_results[index]);
+
+		if (buy_order_results[index].success != SUCCESS)
+		{
+			return_value = FAILURE;
+		}
+		else if (add_buy_order (buy_order_book, buy_order_results[index].buy_order_id,
+		                        buy_order_specs[index].app_id,
+		                        buy_order_specs[index].market_hash_name,
+		                        buy_order_specs[index].price,
+		                        buy_order_specs[index].quantity,
+		                        buy_order_specs[index].quantity) != SUCCESS)
+		{
+			/* The order exists on Steam, buy_order_id is kept so it is not
+			 * placed twice; sync_buy_order_book () picks it up */
+			buy_order_results[index].success = FAILURE;
+			snprintf (buy_order_results[index].message,
+			          sizeof (buy_order_results[index].message),
+			          "created, but not added to the local book");
+
+			return_value = FAILURE;
+		}
+	}
+
+	free_steam_requests (requests, count_orders);
+	steam_free (requests);
+	steam_free (post_data);
+
+	print_debug_information ("Exiting the function to "
+	                         "create_buy_orders ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : cancel_buy_orders                                      *
+ *                                                                           *
+ * Description      : This function cancel buy orders concurrently and       *
+ *                    remove the cancelled ones from the book                *
+ *                                                                           *
+ * Input values(s)  : buy_order_book                                         *
+ *                    buy_order_ids                                          *
+ *                    count_orders                                           *
+ *                    max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : buy_order_results - in the same order                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if every order was cancelled, otherwise        *
+ *                    FAILURE                                                *
+ *===========================================================================*/
+int8_t cancel_buy_orders (BuyOrderBook *buy_order_book,
+                          const uint64_t *buy_order_ids, size_t count_orders,
+                          BuyOrderResult *buy_order_results,
+                          uint32_t max_concurrency)
+{
+	SteamRequest *requests = NULL;
+	char *post_data = NULL;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "cancel_buy_orders ()", __LINE__);
+
+	requests = steam_calloc (count_orders + 1, sizeof (SteamRequest),
+	                         ALLOC_TAG_MARKET);
+	post_data = steam_calloc (count_orders + 1, POST_DATA_SIZE,
+	                          ALLOC_TAG_MARKET);
+
+	if (requests == NULL || post_data == NULL)
+	{
+		steam_free (requests);
+		steam_free (post_data);
+
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < count_orders; index++)
+	{
+		build_cancel_request (&requests[index], buy_order_ids[index],
+		                      post_data + index * POST_DATA_SIZE);
+	}
+
+	curl_batch_request (requests, count_orders, max_concurrency, NULL, NULL);
+
+	for (size_t index = 0; index < count_orders; index++)
+	{
+		parse_buy_order_response (&requests[index], &buy_order_results[index]);
+
+		buy_order_results[index].buy_order_id = buy_order_ids[index];
+
+		if (buy_order_results[index].success == SUCCESS)
+		{
+			remove_buy_order (buy_order_book, buy_order_ids[index]);
+		}
+		else
+		{
+			return_value = FAILURE;
+		}
+	}
+
+	free_steam_requests (requests, count_orders);
+	steam_free (requests);
+	steam_free (post_data);
+
+	print_debug_information ("Exiting the function to "
+	                         "cancel_buy_orders ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : replace_buy_orders                                     *
+ *                                                                           *
+ * Description      : This function reprice buy orders: all cancels run      *
+ *                    concurrently, then new orders are created              *
+ *                    concurrently for the ones that were cancelled          *
+ *                                                                           *
+ * Input values(s)  : buy_order_book                                         *
+ *                    buy_order_ids - orders to replace                      *
+ *                    buy_order_specs - new orders                           *
+ *                    count_orders                                           *
+ *                    max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : buy_order_results - result of cancel if it failed,     *
+ *                                        otherwise result of create         *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if every order was replaced, otherwise FAILURE *
+ *===========================================================================*/
+int8_t replace_buy_orders (BuyOrderBook *buy_order_book,
+                           const uint64_t *buy_order_ids,
+                           const BuyOrderSpec *buy_order_specs,
+                           size_t count_orders,
+                           BuyOrderResult *buy_order_results,
+                           uint32_t max_concurrency)
+{
+	BuyOrderSpec *create_specs = NULL;
+	BuyOrderResult *create_results = NULL;
+	size_t *create_positions = NULL;
+	size_t count_create = 0;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "replace_buy_orders ()", __LINE__);
+
+	create_specs = steam_calloc (count_orders + 1, sizeof (BuyOrderSpec),
+	                             ALLOC_TAG_MARKET);
+	create_results = steam_calloc (count_orders + 1, sizeof (BuyOrderResult),
+	                               ALLOC_TAG_MARKET);
+	create_positions = steam_calloc (count_orders + 1, sizeof (size_t),
+	                                 ALLOC_TAG_MARKET);
+
+	if (create_specs == NULL || create_results == NULL || create_positions == NULL)
+	{
+		steam_free (create_specs);
+		steam_free (create_results);
+		steam_free (create_positions);
+
+		return FAILURE;
+	}
+
+	return_value = cancel_buy_orders (buy_order_book, buy_order_ids, count_orders,
+	                                  buy_order_results, max_concurrency);
+
+	for (size_t index = 0; index < count_orders; index++)
+	{
+		if (buy_order_results[index].success == SUCCESS)
+		{
+			create_specs[count_create] = buy_order_specs[index];
+			create_positions[count_create] = index;
+			count_create++;
+		}
+	}
+
+	if (count_create > 0 &&
+	    create_buy_orders (buy_order_book, create_specs, count_create,
+	                       create_results, max_concurrency) != SUCCESS)
+	{
+		return_value = FAILURE;
+	}
+
+	for (size_t index = 0; index < count_create; index++)
+	{
+		buy_order_results[create_positions[index]] = create_results[index];
+	}
+
+	steam_free (create_specs);
+	steam_free (create_results);
+	steam_free (create_positions);
+
+	print_debug_information ("Exiting the function to "
+	                         "replace_buy_orders ()", __LINE__);
+
+	return return_value;
+}
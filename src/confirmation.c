@@ -0,0 +1,349 @@
+#include "../inc/confirmation.h"
+#include "../inc/guard.h"
+#include "../inc/steam.h"
+#include "../inc/session.h"
+
+#define CONFIRMATION_QUERY_SIZE  256
+#define CONFIRMATION_PAIR_SIZE   64
+
+static int8_t build_confirmation_query (const char *, const char *, char *,
+                                        size_t);
+static int8_t respond_to_batch (const char *, const Confirmation *, size_t,
+                                int8_t);
+
+/*===========================================================================*
+ * Function name    : build_confirmation_query                               *
+ *                                                                           *
+ * Description      : This function build parameters every mobileconf        *
+ *                    request is signed with                                 *
+ *                                                                           *
+ * Input values(s)  : identity_secret                                        *
+ *                    tag - operation the key is generated for               *
+ *                    size_query                                             *
+ *                                                                           *
+ * Output values(s) : query - "p=...&a=...&k=...&t=...&m=react&tag=..."      *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t build_confirmation_query (const char *identity_secret,
+                                        const char *tag, char *query,
+                                        size_t size_query)
+{
+	char key[CONFIRMATION_KEY_SIZE] = {0};
+	char key_encode[CONFIRMATION_KEY_SIZE * 3] = {0};
+	char device_id[DEVICE_ID_SIZE] = {0};
+	char steam_id[STEAM_ID_SIZE] = {0};
+	int64_t steam_time = get_steam_time ();
+
+	get_steam_session (steam_id, sizeof (steam_id), NULL, 0);
+
+	if (steam_id[0] == '\0' ||
+	    generate_confirmation_key (identity_secret, steam_time, tag, key) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	url_encode (key, key_encode, g_rfc3986);
+	generate_device_id (steam_id, device_id);
+
+	snprintf (query, size_query, "p=%s&a=%s&k=%s&t=%lld&m=react&tag=%s",
+	          device_id, steam_id, key_encode, (long long)steam_time, tag);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : parse_confirmations                                    *
+ *                                                                           *
+ * Description      : This function parse response of mobileconf/getlist     *
+ *                                                                           *
+ * Input values(s)  : data - json                                            *
+ *                                                                           *
+ * Output values(s) : list - free by free_confirmations ()                   *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t parse_confirmations (const char *data, ConfirmationList *list)
+{
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_success = NULL;
+	struct json_object *json_conf = NULL;
+	struct json_object *json_entry = NULL;
+	Confirmation *confirmation = NULL;
+	size_t size_conf_table = 0;
+	uint64_t value = 0;
+
+	print_debug_information ("Entering the function to "
+	                         "parse_confirmations ()", __LINE__);
+
+	memset (list, 0, sizeof (ConfirmationList));
+
+	parsed_json = parse_json_response (data);
+
+	if (parsed_json == NULL ||
+	    json_object_object_get_ex (parsed_json, "success", &json_success) == 0 ||
+	    json_object_get_boolean (json_success) == 0)
+	{
+		if (parsed_json != NULL)
+			json_object_put (parsed_json);
+
+		print_debug_information ("Exiting the function to "
+		                         "parse_confirmations ()", __LINE__);
+
+		return FAILURE;
+	}
+
+	/* No "conf" array when there is nothing to confirm */
+	if (json_object_object_get_ex (parsed_json, "conf", &json_conf))
+	{
+		size_conf_table = json_object_array_length (json_conf);
+	}
+
+	if (size_conf_table > 0)
+	{
+		list->confirmations = steam_calloc (size_conf_table, sizeof (Confirmation),
+		                                    ALLOC_TAG_SESSION);
+
+		if (list->confirmations == NULL)
+		{
+			json_object_put (parsed_json);
+
+			return FAILURE;
+		}
+	}
+
+	for (size_t index = 0; index < size_conf_table; index++)
+	{
+		json_entry = json_object_array_get_idx (json_conf, index);
+		confirmation = &list->confirmations[list->count_confirmations++];
+
+		get_json_object_as_uint64 (&confirmation->id, json_entry, "id");
+		get_json_object_as_uint64 (&confirmation->nonce, json_entry, "nonce");
+		get_json_object_as_uint64 (&confirmation->creator_id, json_entry, "creator_id");
+		get_json_object_as_uint64 (&confirmation->creation_time, json_entry,
+		                           "creation_time");
+
+		if (get_json_object_as_uint64 (&value, json_entry, "type") == SUCCESS)
+			confirmation->type = (ConfirmationType)value;
+
+		get_json_object_as_string (&confirmation->headline, json_entry, "headline");
+	}
+
+	json_object_put (parsed_json);
+
+	print_debug_information ("Exiting the function to "
+	                         "parse_confirmations ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : get_confirmations                                      *
+ *                                                                           *
+ * Description      : This function get pending mobile confirmations         *
+ *                                                                           *
+ * Input values(s)  : identity_secret - base64                               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Confirmations, free by free_confirmations ()/NULL      *
+ *===========================================================================*/
+ConfirmationList *get_confirmations (const char *identity_secret)
+{
+	char query[CONFIRMATION_QUERY_SIZE] = {0};
+	char steam_url[URL_SIZE] = {0};
+	char *ptr_data = NULL;
+	ConfirmationList *list = NULL;
+
+	print_debug_information ("Entering the function to "
+	                         "get_confirmations ()", __LINE__);
+
+	if (build_confirmation_query (identity_secret, "conf", query,
+	                              CONFIRMATION_QUERY_SIZE) != SUCCESS)
+	{
+		return NULL;
+	}
+
+	snprintf (steam_url, URL_SIZE, URL_STEAM_COMMUNITY "mobileconf/getlist?%s",
+	          query);
+
+	ptr_data = curl_general_request (steam_url, NULL, NULL, 0);
+
+	if (ptr_data == NULL)
+	{
+		return NULL;
+	}
+
+	list = steam_calloc (1, sizeof (ConfirmationList), ALLOC_TAG_SESSION);
+
+	if (list != NULL && parse_confirmations (ptr_data, list) != SUCCESS)
+	{
+		steam_free (list);
+		list = NULL;
+	}
+
+	steam_free (ptr_data);
+
+	print_debug_information ("Exiting the function to "
+	                         "get_confirmations ()", __LINE__);
+
+	return list;
+}
+
+/*===========================================================================*
+ * Function name    : free_confirmations                                     *
+ *                                                                           *
+ * Description      : This function free memory of confirmations             *
+ *                                                                           *
+ * Input values(s)  : list                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_confirmations (ConfirmationList *list)
+{
+	if (list == NULL)
+		return;
+
+	for (size_t index = 0; index < list->count_confirmations; index++)
+	{
+		steam_free (list->confirmations[index].headline);
+	}
+
+	steam_free (list->confirmations);
+	steam_free (list);
+}
+
+/*===========================================================================*
+ * Function name    : respond_to_batch                                       *
+ *                                                                           *
+ * Description      : This function send one multiajaxop request             *
+ *                                                                           *
+ * Input values(s)  : identity_secret                                        *
+ *                    confirmations                                          *
+ *                    count_confirmations - at most CONFIRMATION_BATCH_SIZE  *
+ *                    accept - 1 to allow, 0 to cancel                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t respond_to_batch (const char *identity_secret,
+                                const Confirmation *confirmations,
+                                size_t count_confirmations, int8_t accept)
+{
+	const char *tag = accept != 0 ? "allow" : "cancel";
+	char query[CONFIRMATION_QUERY_SIZE] = {0};
+	char *post_data = NULL;
+	char *ptr_data = NULL;
+	size_t size_post_data = 0;
+	size_t length = 0;
+	int8_t return_value = FAILURE;
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_success = NULL;
+
+	if (build_confirmation_query (identity_secret, tag, query,
+	                              CONFIRMATION_QUERY_SIZE) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	size_post_data = CONFIRMATION_QUERY_SIZE +
+	                 count_confirmations * CONFIRMATION_PAIR_SIZE;
+	post_data = steam_malloc (size_post_data, ALLOC_TAG_SESSION);
+
+	if (post_data == NULL)
+	{
+		return FAILURE;
+	}
+
+	length = snprintf (post_data, size_post_data, "op=%s&%s", tag, query);
+
+	for (size_t index = 0; index < count_confirmations; index++)
+	{
+		length += snprintf (post_data + length, size_post_data - length,
+		                    "&cid%%5B%%5D=%llu&ck%%5B%%5D=%llu",
+		                    (unsigned long long)confirmations[index].id,
+		                    (unsigned long long)confirmations[index].nonce);
+	}
+
+	ptr_data = curl_general_request (URL_STEAM_COMMUNITY "mobileconf/multiajaxop",
+	                                 URL_STEAM_COMMUNITY "mobileconf/conf",
+	                                 post_data, 0);
+
+	steam_free (post_data);
+
+	if (ptr_data == NULL)
+	{
+		return FAILURE;
+	}
+
+	parsed_json = parse_json_response (ptr_data);
+
+	steam_free (ptr_data);
+
+	if (parsed_json != NULL &&
+	    json_object_object_get_ex (parsed_json, "success", &json_success) != 0 &&
+	    json_object_get_boolean (json_success) != 0)
+	{
+		return_value = SUCCESS;
+	}
+
+	if (parsed_json != NULL)
+		json_object_put (parsed_json);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : respond_to_confirmations                               *
+ *                                                                           *
+ * Description      : This function accept or deny confirmations in bulk,    *
+ *                    CONFIRMATION_BATCH_SIZE per request                    *
+ *                                                                           *
+ * Input values(s)  : identity_secret - base64                               *
+ *                    confirmations - from get_confirmations ()              *
+ *                    count_confirmations                                    *
+ *                    accept - 1 to allow, 0 to cancel                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS when every batch succeeded/FAILURE             *
+ *===========================================================================*/
+int8_t respond_to_confirmations (const char *identity_secret,
+                                 const Confirmation *confirmations,
+                                 size_t count_confirmations, int8_t accept)
+{
+	int8_t return_value = SUCCESS;
+	size_t count_batch = 0;
+	char error_message[ERROR_MESSAGE_SIZE] = {0};
+
+	print_debug_information ("Entering the function to "
+	                         "respond_to_confirmations ()", __LINE__);
+
+	for (size_t start = 0; start < count_confirmations; start += count_batch)
+	{
+		count_batch = count_confirmations - start;
+
+		if (count_batch > CONFIRMATION_BATCH_SIZE)
+			count_batch = CONFIRMATION_BATCH_SIZE;
+
+		/* A failed batch does not stop the rest, they are independent */
+		if (respond_to_batch (identity_secret, confirmations + start,
+		                      count_batch, accept) != SUCCESS)
+		{
+			snprintf (error_message, ERROR_MESSAGE_SIZE,
+			          "[ERROR %u] multiajaxop failed for %zu confirmations",
+			          __LINE__, count_batch);
+			printf ("%s\n", error_message);
+
+			return_value = FAILURE;
+		}
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "respond_to_confirmations ()", __LINE__);
+
+	return return_value;
+}
@@ -0,0 +1,1312 @@
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "../inc/daemon.h"
+#include "../inc/steam.h"
+#include "../inc/inventory.h"
+#include "../inc/export.h"
+#include "../inc/market.h"
+#include "../inc/buy_order.h"
+#include "../inc/listings.h"
+#include "../inc/session.h"
+
+#define DAEMON_LISTEN_BACKLOG  16
+#define DAEMON_LINE_SIZE       512
+
+typedef struct tDaemonClient {
+	int       fd;
+	uint64_t  id;
+	uint8_t  *input;
+	size_t    size_input;
+	size_t    capacity_input;
+	uint8_t  *output;
+	size_t    size_output;
+	size_t    capacity_output;
+	size_t    sent_output;
+	int8_t    read_closed;
+} DaemonClient;
+
+/* Request frame waiting for the next batch, args is a NULL-terminated copy */
+typedef struct tDaemonRequest {
+	uint64_t  client_id;
+	uint32_t  tag;
+	uint8_t   operation;
+	uint8_t  *args;
+	uint32_t  size_args;
+} DaemonRequest;
+
+/* Everything the daemon keeps warm between requests */
+typedef struct tSteamDaemon {
+	int              listen_fd;
+	DaemonClient     clients[DAEMON_MAX_CLIENTS];
+	size_t           count_clients;
+	uint64_t         next_client_id;
+	DaemonRequest   *requests;
+	size_t           count_requests;
+	size_t           capacity_requests;
+	SteamInventory  *steam_inventory;
+	BuyOrderBook    *buy_order_book;
+	uint32_t         max_concurrency;
+} SteamDaemon;
+
+/* Written by stop_steam_daemon (), possibly from a signal handler */
+static int s_stop_pipe[2] = { -1, -1 };
+
+static uint32_t read_u32 (const uint8_t *);
+static uint64_t read_u64 (const uint8_t *);
+static void write_u32 (uint8_t *, uint32_t);
+static void write_u64 (uint8_t *, uint64_t);
+static int8_t reserve_buffer (uint8_t **, size_t *, size_t);
+static int8_t set_nonblocking (int);
+static DaemonClient *find_daemon_client (SteamDaemon *, uint64_t);
+static void send_daemon_response (SteamDaemon *, const DaemonRequest *,
+                                  DaemonStatus, const void *, size_t,
+                                  const void *, size_t);
+static void close_daemon_client (SteamDaemon *, size_t);
+static void accept_daemon_clients (SteamDaemon *);
+static int8_t read_daemon_client (SteamDaemon *, DaemonClient *);
+static int8_t flush_daemon_client (DaemonClient *);
+static const InventoryItem *find_inventory_item (const SteamInventory *,
+                                                 uint64_t);
+static void run_sell_batch (SteamDaemon *);
+static void run_create_buy_batch (SteamDaemon *);
+static void run_cancel_buy_batch (SteamDaemon *);
+static void run_remove_listing_batch (SteamDaemon *);
+static void run_inventory_request (SteamDaemon *, const DaemonRequest *);
+static void run_listings_request (SteamDaemon *, const DaemonRequest *);
+static void run_daemon_requests (SteamDaemon *);
+static int open_daemon_socket (const char *);
+
+/*===========================================================================*
+ * Function name    : read_u32                                               *
+ *                                                                           *
+ * Description      : This function read big-endian 32 bit integer           *
+ *                                                                           *
+ * Input values(s)  : data                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Value                                                  *
+ *===========================================================================*/
+static uint32_t read_u32 (const uint8_t *data)
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+	       ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+/*===========================================================================*
+ * Function name    : read_u64                                               *
+ *                                                                           *
+ * Description      : This function read big-endian 64 bit integer           *
+ *                                                                           *
+ * Input values(s)  : data                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Value                                                  *
+ *===========================================================================*/
+static uint64_t read_u64 (const uint8_t *data)
+{
+	return ((uint64_t)read_u32 (data) << 32) | read_u32 (data + 4);
+}
+
+/*===========================================================================*
+ * Function name    : write_u32                                              *
+ *                                                                           *
+ * Description      : This function write big-endian 32 bit integer          *
+ *                                                                           *
+ * Input values(s)  : value                                                  *
+ *                                                                           *
+ * Output values(s) : data - 4 bytes                                         *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void write_u32 (uint8_t *data, uint32_t value)
+{
+	data[0] = (uint8_t)(value >> 24);
+	data[1] = (uint8_t)(value >> 16);
+	data[2] = (uint8_t)(value >> 8);
+	data[3] = (uint8_t)value;
+}
+
+/*===========================================================================*
+ * Function name    : write_u64                                              *
+ *                                                                           *
+ * Description      : This function write big-endian 64 bit integer          *
+ *                                                                           *
+ * Input values(s)  : value                                                  *
+ *                                                                           *
+ * Output values(s) : data - 8 bytes                                         *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void write_u64 (uint8_t *data, uint64_t value)
+{
+	write_u32 (data, (uint32_t)(value >> 32));
+	write_u32 (data + 4, (uint32_t)value);
+}
+
+/*===========================================================================*
+ * Function name    : reserve_buffer                                         *
+ *                                                                           *
+ * Description      : This function grow buffer to hold at least size bytes  *
+ *                                                                           *
+ * Input values(s)  : buffer                                                 *
+ *                    capacity                                               *
+ *                    size - bytes needed                                    *
+ *                                                                           *
+ * Output values(s) : buffer, capacity                                       *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t reserve_buffer (uint8_t **buffer, size_t *capacity, size_t size)
+{
+	uint8_t *ptr = NULL;
+	size_t new_capacity = *capacity != 0 ? *capacity : DAEMON_BUFFER_SIZE;
+
+	if (size <= *capacity)
+		return SUCCESS;
+
+	while (new_capacity < size)
+		new_capacity *= 2;
+
+	ptr = steam_realloc (*buffer, new_capacity, ALLOC_TAG_OTHER);
+
+	if (ptr == NULL)
+		return FAILURE;
+
+	*buffer = ptr;
+	*capacity = new_capacity;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : set_nonblocking                                        *
+ *                                                                           *
+ * Description      : This function make descriptor non-blocking and close   *
+ *                    it on exec                                             *
+ *                                                                           *
+ * Input values(s)  : fd                                                     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t set_nonblocking (int fd)
+{
+	int flags = fcntl (fd, F_GETFL);
+
+	if (flags < 0 || fcntl (fd, F_SETFL, flags | O_NONBLOCK) != 0 ||
+	    fcntl (fd, F_SETFD, FD_CLOEXEC) != 0)
+	{
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : find_daemon_client                                     *
+ *                                                                           *
+ * Description      : This function find connected client                    *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                    client_id                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Client or NULL when it is gone                         *
+ *===========================================================================*/
+static DaemonClient *find_daemon_client (SteamDaemon *daemon, uint64_t client_id)
+{
+	for (size_t index = 0; index < daemon->count_clients; index++)
+	{
+		if (daemon->clients[index].id == client_id)
+			return &daemon->clients[index];
+	}
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : send_daemon_response                                   *
+ *                                                                           *
+ * Description      : This function queue response frame, the body is given  *
+ *                    in two parts so fixed fields need no copy              *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                    request                                                *
+ *                    status                                                 *
+ *                    head - first part of body (may be NULL)                *
+ *                    size_head                                              *
+ *                    body - second part of body (may be NULL)               *
+ *                    size_body                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void send_daemon_response (SteamDaemon *daemon,
+                                  const DaemonRequest *request,
+                                  DaemonStatus status, const void *head,
+                                  size_t size_head, const void *body,
+                                  size_t size_body)
+{
+	DaemonClient *client = find_daemon_client (daemon, request->client_id);
+	uint8_t *frame = NULL;
+	size_t size_frame = DAEMON_HEADER_SIZE + size_head + size_body;
+
+	/* Client disconnected while its request was running */
+	if (client == NULL ||
+	    reserve_buffer (&client->output, &client->capacity_output,
+	                    client->size_output + size_frame) != SUCCESS)
+	{
+		return;
+	}
+
+	frame = client->output + client->size_output;
+
+	write_u32 (frame, (uint32_t)(size_frame - DAEMON_LENGTH_SIZE));
+	frame[DAEMON_LENGTH_SIZE] = (uint8_t)status;
+	write_u32 (frame + DAEMON_LENGTH_SIZE + 1, request->tag);
+
+	if (size_head != 0)
+		memcpy (frame + DAEMON_HEADER_SIZE, head, size_head);
+
+	if (size_body != 0)
+		memcpy (frame + DAEMON_HEADER_SIZE + size_head, body, size_body);
+
+	client->size_output += size_frame;
+}
+
+/*===========================================================================*
+ * Function name    : close_daemon_client                                    *
+ *                                                                           *
+ * Description      : This function disconnect client, the last client takes *
+ *                    its slot                                               *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                    index - slot of the client                             *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void close_daemon_client (SteamDaemon *daemon, size_t index)
+{
+	DaemonClient *client = &daemon->clients[index];
+
+	close (client->fd);
+	steam_free (client->input);
+	steam_free (client->output);
+
+	daemon->count_clients--;
+
+	if (index != daemon->count_clients)
+		*client = daemon->clients[daemon->count_clients];
+
+	memset (&daemon->clients[daemon->count_clients], 0, sizeof (DaemonClient));
+}
+
+/*===========================================================================*
+ * Function name    : accept_daemon_clients                                  *
+ *                                                                           *
+ * Description      : This function accept every pending connection          *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void accept_daemon_clients (SteamDaemon *daemon)
+{
+	DaemonClient *client = NULL;
+	int fd = -1;
+
+	while ((fd = accept (daemon->listen_fd, NULL, NULL)) >= 0)
+	{
+		if (daemon->count_clients == DAEMON_MAX_CLIENTS ||
+		    set_nonblocking (fd) != SUCCESS)
+		{
+			close (fd);
+			continue;
+		}
+
+		client = &daemon->clients[daemon->count_clients++];
+
+		memset (client, 0, sizeof (DaemonClient));
+		client->fd = fd;
+		client->id = ++daemon->next_client_id;
+	}
+}
+
+/*===========================================================================*
+ * Function name    : read_daemon_client                                     *
+ *                                                                           *
+ * Description      : This function read available data and queue every      *
+ *                    complete request frame. Reading pauses while           *
+ *                    DAEMON_MAX_INPUT_SIZE bytes are buffered               *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                    client                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE when the client must be closed         *
+ *===========================================================================*/
+static int8_t read_daemon_client (SteamDaemon *daemon, DaemonClient *client)
+{
+	DaemonRequest *request = NULL;
+	ssize_t count_read = 0;
+	size_t offset = 0;
+	uint32_t length = 0;
+
+	/* The rest stays in the socket until buffered frames are taken */
+	while (client->read_closed == 0 && client->size_input < DAEMON_MAX_INPUT_SIZE)
+	{
+		if (reserve_buffer (&client->input, &client->capacity_input,
+		                    client->size_input + DAEMON_BUFFER_SIZE) != SUCCESS)
+		{
+			return FAILURE;
+		}
+
+		count_read = recv (client->fd, client->input + client->size_input,
+		                   client->capacity_input - client->size_input, 0);
+
+		if (count_read > 0)
+		{
+			client->size_input += count_read;
+			continue;
+		}
+
+		/* Write side shut down, frames already sent are still answered */
+		if (count_read == 0)
+		{
+			client->read_closed = 1;
+			break;
+		}
+
+		if (errno == EINTR)
+			continue;
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+
+		return FAILURE;
+	}
+
+	while (client->size_input - offset >= DAEMON_LENGTH_SIZE)
+	{
+		length = read_u32 (client->input + offset);
+
+		if (length < DAEMON_HEADER_SIZE - DAEMON_LENGTH_SIZE ||
+		    length > DAEMON_MAX_FRAME_SIZE)
+		{
+			return FAILURE;
+		}
+
+		if (client->size_input - offset < DAEMON_LENGTH_SIZE + length)
+			break;
+
+		if (daemon->count_requests == daemon->capacity_requests)
+		{
+			size_t capacity = daemon->capacity_requests * 2 + DAEMON_MAX_CLIENTS;
+			DaemonRequest *ptr = steam_realloc (daemon->requests,
+			                                    capacity * sizeof (DaemonRequest),
+			                                    ALLOC_TAG_OTHER);
+
+			if (ptr == NULL)
+				return FAILURE;
+
+			daemon->requests = ptr;
+			daemon->capacity_requests = capacity;
+		}
+
+		request = &daemon->requests[daemon->count_requests];
+
+		request->client_id = client->id;
+		request->operation = client->input[offset + DAEMON_LENGTH_SIZE];
+		request->tag = read_u32 (client->input + offset + DAEMON_LENGTH_SIZE + 1);
+		request->size_args = length - (DAEMON_HEADER_SIZE - DAEMON_LENGTH_SIZE);
+		request->args = steam_malloc (request->size_args + 1, ALLOC_TAG_OTHER);
+
+		if (request->args == NULL)
+			return FAILURE;
+
+		memcpy (request->args, client->input + offset + DAEMON_HEADER_SIZE,
+		        request->size_args);
+		request->args[request->size_args] = '\0';
+
+		daemon->count_requests++;
+
+		offset += DAEMON_LENGTH_SIZE + length;
+	}
+
+	memmove (client->input, client->input + offset, client->size_input - offset);
+	client->size_input -= offset;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : flush_daemon_client                                    *
+ *                                                                           *
+ * Description      : This function write queued responses as far as the     *
+ *                    socket takes them                                      *
+ *                                                                           *
+ * Input values(s)  : client                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE when the client must be closed         *
+ *===========================================================================*/
+static int8_t flush_daemon_client (DaemonClient *client)
+{
+	ssize_t count_sent = 0;
+
+	while (client->sent_output < client->size_output)
+	{
+		count_sent = send (client->fd, client->output + client->sent_output,
+		                   client->size_output - client->sent_output,
+		                   MSG_NOSIGNAL);
+
+		if (count_sent > 0)
+		{
+			client->sent_output += count_sent;
+			continue;
+		}
+
+		if (count_sent < 0 && errno == EINTR)
+			continue;
+
+		if (count_sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return SUCCESS;
+
+		return FAILURE;
+	}
+
+	client->size_output = 0;
+	client->sent_output = 0;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : find_inventory_item                                    *
+ *                                                                           *
+ * Description      : This function find item of cached inventory by asset   *
+ *                                                                           *
+ * Input values(s)  : steam_inventory                                        *
+ *                    asset_id                                               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Item or NULL                                           *
+ *===========================================================================*/
+static const InventoryItem *find_inventory_item (const SteamInventory *steam_inventory,
+                                                 uint64_t asset_id)
+{
+	char str_asset_id[24] = {0};
+
+	snprintf (str_asset_id, sizeof (str_asset_id), "%llu",
+	          (unsigned long long)asset_id);
+
+	for (const SteamInventory *ptr_steam_inventory = steam_inventory;
+	     ptr_steam_inventory != NULL;
+	     ptr_steam_inventory = ptr_steam_inventory->next_steam_inventory)
+	{
+		for (uint64_t index = 0; index < ptr_steam_inventory->count_items; index++)
+		{
+			const InventoryItem *item = &ptr_steam_inventory->inventory_items[index];
+
+			if (item->asset_id != NULL &&
+			    strcmp (item->asset_id, str_asset_id) == STRINGS_EQUAL)
+			{
+				return item;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : run_sell_batch                                         *
+ *                                                                           *
+ * Description      : This function list items of every queued sell request  *
+ *                    in one sell_items () batch                             *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void run_sell_batch (SteamDaemon *daemon)
+{
+	SellRequest *sell_requests = NULL;
+	SellResult *sell_results = NULL;
+	size_t *request_index = NULL;
+	size_t count_sells = 0;
+	uint8_t status = 0;
+
+	sell_requests = steam_calloc (daemon->count_requests, sizeof (SellRequest),
+	                              ALLOC_TAG_OTHER);
+	sell_results = steam_calloc (daemon->count_requests, sizeof (SellResult),
+	                             ALLOC_TAG_OTHER);
+	request_index = steam_calloc (daemon->count_requests, sizeof (size_t),
+	                              ALLOC_TAG_OTHER);
+
+	if (sell_requests == NULL || sell_results == NULL || request_index == NULL)
+	{
+		steam_free (sell_requests);
+		steam_free (sell_results);
+		steam_free (request_index);
+
+		/* Clients still wait for an answer to every frame */
+		for (size_t index = 0; index < daemon->count_requests; index++)
+		{
+			if (daemon->requests[index].operation == DAEMON_OP_SELL)
+			{
+				send_daemon_response (daemon, &daemon->requests[index],
+				                      DAEMON_STATUS_FAILED, NULL, 0, NULL, 0);
+			}
+		}
+
+		return;
+	}
+
+	for (size_t index = 0; index < daemon->count_requests; index++)
+	{
+		const DaemonRequest *request = &daemon->requests[index];
+		const InventoryItem *item = NULL;
+
+		if (request->operation != DAEMON_OP_SELL)
+			continue;
+
+		if (request->size_args != 12)
+		{
+			send_daemon_response (daemon, request, DAEMON_STATUS_BAD_REQUEST,
+			                      NULL, 0, NULL, 0);
+			continue;
+		}
+
+		item = find_inventory_item (daemon->steam_inventory,
+		                            read_u64 (request->args));
+
+		if (item == NULL)
+		{
+			send_daemon_response (daemon, request, DAEMON_STATUS_NOT_FOUND,
+			                      NULL, 0, NULL, 0);
+			continue;
+		}
+
+		sell_requests[count_sells].inventory_item = item;
+		sell_requests[count_sells].price = read_u32 (request->args + 8);
+
+		/* Kept when sell_items () fails before sending anything */
+		sell_results[count_sells].status = SELL_RETRYABLE;
+		snprintf (sell_results[count_sells].message,
+		          sizeof (sell_results[count_sells].message), "request was not sent");
+
+		request_index[count_sells++] = index;
+	}
+
+	if (count_sells != 0)
+	{
+		sell_items (sell_requests, count_sells, sell_results,
+		            daemon->max_concurrency);
+	}
+
+	for (size_t index = 0; index < count_sells; index++)
+	{
+		const SellResult *result = &sell_results[index];
+
+		status = (uint8_t)result->status;
+
+		send_daemon_response (daemon, &daemon->requests[request_index[index]],
+		                      (result->status == SELL_LISTED ||
+		                       result->status == SELL_NEEDS_CONFIRMATION) ?
+		                      DAEMON_STATUS_OK : DAEMON_STATUS_FAILED,
+		                      &status, 1, result->message, strlen (result->message));
+	}
+
+	steam_free (sell_requests);
+	steam_free (sell_results);
+	steam_free (request_index);
+}
+
+/*===========================================================================*
+ * Function name    : run_create_buy_batch                                   *
+ *                                                                           *
+ * Description      : This function create buy orders of every queued        *
+ *                    request in one create_buy_orders () batch              *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void run_create_buy_batch (SteamDaemon *daemon)
+{
+	BuyOrderSpec *buy_order_specs = NULL;
+	BuyOrderResult *buy_order_results = NULL;
+	size_t *request_index = NULL;
+	size_t count_orders = 0;
+	uint8_t buy_order_id[8] = {0};
+
+	buy_order_specs = steam_calloc (daemon->count_requests, sizeof (BuyOrderSpec),
+	                                ALLOC_TAG_OTHER);
+	buy_order_results = steam_calloc (daemon->count_requests, sizeof (BuyOrderResult),
+	                                  ALLOC_TAG_OTHER);
+	request_index = steam_calloc (daemon->count_requests, sizeof (size_t),
+	                              ALLOC_TAG_OTHER);
+
+	if (buy_order_specs == NULL || buy_order_results == NULL ||
+	    request_index == NULL)
+	{
+		steam_free (buy_order_specs);
+		steam_free (buy_order_results);
+		steam_free (request_index);
+
+		return;
+	}
+
+	for (size_t index = 0; index < daemon->count_requests; index++)
+	{
+		const DaemonRequest *request = &daemon->requests[index];
+
+		if (request->operation != DAEMON_OP_CREATE_BUY)
+			continue;
+
+		/* args is NULL-terminated, so the name can be used in place */
+		if (request->size_args <= 12 || request->args[12] == '\0')
+		{
+			send_daemon_response (daemon, request, DAEMON_STATUS_BAD_REQUEST,
+			                      NULL, 0, NULL, 0);
+			continue;
+		}
+
+		buy_order_specs[count_orders].app_id = read_u32 (request->args);
+		buy_order_specs[count_orders].price = read_u32 (request->args + 4);
+		buy_order_specs[count_orders].quantity = read_u32 (request->args + 8);
+		buy_order_specs[count_orders].market_hash_name = (char *)request->args + 12;
+		request_index[count_orders++] = index;
+	}
+
+	if (count_orders != 0)
+	{
+		create_buy_orders (daemon->buy_order_book, buy_order_specs, count_orders,
+		                   buy_order_results, daemon->max_concurrency);
+	}
+
+	for (size_t index = 0; index < count_orders; index++)
+	{
+		const BuyOrderResult *result = &buy_order_results[index];
+
+		write_u64 (buy_order_id, result->buy_order_id);
+
+		send_daemon_response (daemon, &daemon->requests[request_index[index]],
+		                      result->success == SUCCESS ?
+		                      DAEMON_STATUS_OK : DAEMON_STATUS_FAILED,
+		                      buy_order_id, sizeof (buy_order_id),
+		                      result->message, strlen (result->message));
+	}
+
+	steam_free (buy_order_specs);
+	steam_free (buy_order_results);
+	steam_free (request_index);
+}
+
+/*===========================================================================*
+ * Function name    : run_cancel_buy_batch                                   *
+ *                                                                           *
+ * Description      : This function cancel buy orders of every queued        *
+ *                    request in one cancel_buy_orders () batch              *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void run_cancel_buy_batch (SteamDaemon *daemon)
+{
+	uint64_t *buy_order_ids = NULL;
+	BuyOrderResult *buy_order_results = NULL;
+	size_t *request_index = NULL;
+	size_t count_orders = 0;
+
+	buy_order_ids = steam_calloc (daemon->count_requests, sizeof (uint64_t),
+	                              ALLOC_TAG_OTHER);
+	buy_order_results = steam_calloc (daemon->count_requests, sizeof (BuyOrderResult),
+	                                  ALLOC_TAG_OTHER);
+	request_index = steam_calloc (daemon->count_requests, sizeof (size_t),
+	                              ALLOC_TAG_OTHER);
+
+	if (buy_order_ids == NULL || buy_order_results == NULL ||
+	    request_index == NULL)
+	{
+		steam_free (buy_order_ids);
+		steam_free (buy_order_results);
+		steam_free (request_index);
+
+		return;
+	}
+
+	for (size_t index = 0; index < daemon->count_requests; index++)
+	{
+		const DaemonRequest *request = &daemon->requests[index];
+
+		if (request->operation != DAEMON_OP_CANCEL_BUY)
+			continue;
+
+		if (request->size_args != 8)
+		{
+			send_daemon_response (daemon, request, DAEMON_STATUS_BAD_REQUEST,
+			                      NULL, 0, NULL, 0);
+			continue;
+		}
+
+		buy_order_ids[count_orders] = read_u64 (request->args);
+		request_index[count_orders++] = index;
+	}
+
+	if (count_orders != 0)
+	{
+		cancel_buy_orders (daemon->buy_order_book, buy_order_ids, count_orders,
+		                   buy_order_results, daemon->max_concurrency);
+	}
+
+	for (size_t index = 0; index < count_orders; index++)
+	{
+		const BuyOrderResult *result = &buy_order_results[index];
+
+		send_daemon_response (daemon, &daemon->requests[request_index[index]],
+		                      result->success == SUCCESS ?
+		                      DAEMON_STATUS_OK : DAEMON_STATUS_FAILED,
+		                      result->message, strlen (result->message), NULL, 0);
+	}
+
+	steam_free (buy_order_ids);
+	steam_free (buy_order_results);
+	steam_free (request_index);
+}
+
+/*===========================================================================*
+ * Function name    : run_remove_listing_batch                               *
+ *                                                                           *
+ * Description      : This function remove listings of every queued request  *
+ *                    in one remove_sell_orders () batch                     *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void run_remove_listing_batch (SteamDaemon *daemon)
+{
+	uint64_t *listing_ids = NULL;
+	int8_t *results = NULL;
+	size_t *request_index = NULL;
+	size_t count_listings = 0;
+
+	listing_ids = steam_calloc (daemon->count_requests, sizeof (uint64_t),
+	                            ALLOC_TAG_OTHER);
+	results = steam_calloc (daemon->count_requests, sizeof (int8_t),
+	                        ALLOC_TAG_OTHER);
+	request_index = steam_calloc (daemon->count_requests, sizeof (size_t),
+	                              ALLOC_TAG_OTHER);
+
+	if (listing_ids == NULL || results == NULL || request_index == NULL)
+	{
+		steam_free (listing_ids);
+		steam_free (results);
+		steam_free (request_index);
+
+		return;
+	}
+
+	for (size_t index = 0; index < daemon->count_requests; index++)
+	{
+		const DaemonRequest *request = &daemon->requests[index];
+
+		if (request->operation != DAEMON_OP_REMOVE_LISTING)
+			continue;
+
+		if (request->size_args != 8)
+		{
+			send_daemon_response (daemon, request, DAEMON_STATUS_BAD_REQUEST,
+			                      NULL, 0, NULL, 0);
+			continue;
+		}
+
+		listing_ids[count_listings] = read_u64 (request->args);
+		request_index[count_listings++] = index;
+	}
+
+	if (count_listings != 0)
+	{
+		remove_sell_orders (listing_ids, count_listings, results,
+		                    daemon->max_concurrency);
+	}
+
+	for (size_t index = 0; index < count_listings; index++)
+	{
+		send_daemon_response (daemon, &daemon->requests[request_index[index]],
+		                      results[index] == SUCCESS ?
+		                      DAEMON_STATUS_OK : DAEMON_STATUS_FAILED,
+		                      NULL, 0, NULL, 0);
+	}
+
+	steam_free (listing_ids);
+	steam_free (results);
+	steam_free (request_index);
+}
+
+/*===========================================================================*
+ * Function name    : run_inventory_request                                  *
+ *                                                                           *
+ * Description      : This function answer with cached inventory, loading it *
+ *                    again when asked to                                    *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                    request                                                *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void run_inventory_request (SteamDaemon *daemon,
+                                   const DaemonRequest *request)
+{
+	ExportSink *sink = NULL;
+	SteamInventory *steam_inventory = NULL;
+	char steam_id[STEAM_ID_SIZE] = {0};
+
+	if (request->size_args != 2 || request->args[0] > EXPORT_FORMAT_BINARY)
+	{
+		send_daemon_response (daemon, request, DAEMON_STATUS_BAD_REQUEST,
+		                      NULL, 0, NULL, 0);
+		return;
+	}
+
+	if (request->args[1] != 0 || daemon->steam_inventory == NULL)
+	{
+		get_steam_session (steam_id, sizeof (steam_id), NULL, 0);
+		steam_inventory = get_inventory_items (steam_id);
+
+		/* Keep the old copy when Steam is not available */
+		if (steam_inventory != NULL)
+		{
+			free_steam_inventory (daemon->steam_inventory);
+			daemon->steam_inventory = steam_inventory;
+		}
+	}
+
+	if (daemon->steam_inventory == NULL)
+	{
+		send_daemon_response (daemon, request, DAEMON_STATUS_FAILED,
+		                      NULL, 0, NULL, 0);
+		return;
+	}
+
+	sink = open_export_sink_memory ((ExportFormat)request->args[0]);
+
+	if (sink != NULL &&
+	    export_steam_inventory (sink, daemon->steam_inventory) == SUCCESS)
+	{
+		send_daemon_response (daemon, request, DAEMON_STATUS_OK,
+		                      sink->buffer, sink->size, NULL, 0);
+	}
+	else
+	{
+		send_daemon_response (daemon, request, DAEMON_STATUS_FAILED,
+		                      NULL, 0, NULL, 0);
+	}
+
+	close_export_sink (sink);
+}
+
+/*===========================================================================*
+ * Function name    : run_listings_request                                   *
+ *                                                                           *
+ * Description      : This function answer with active listings             *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                    request                                                *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void run_listings_request (SteamDaemon *daemon,
+                                  const DaemonRequest *request)
+{
+	MyListings *my_listings = NULL;
+	uint8_t *body = NULL;
+	size_t size_body = 0;
+	size_t capacity_body = 0;
+	int length = 0;
+
+	my_listings = get_my_listings (daemon->max_concurrency);
+
+	if (my_listings == NULL)
+	{
+		send_daemon_response (daemon, request, DAEMON_STATUS_FAILED,
+		                      NULL, 0, NULL, 0);
+		return;
+	}
+
+	for (size_t index = 0; index < my_listings->count_active; index++)
+	{
+		const MyListing *listing = &my_listings->active[index];
+
+		if (reserve_buffer (&body, &capacity_body,
+		                    size_body + DAEMON_LINE_SIZE) != SUCCESS)
+		{
+			break;
+		}
+
+		length = snprintf ((char *)body + size_body, DAEMON_LINE_SIZE,
+		                   "%llu\t%u\t%llu\t%u\t%u\t%s\n",
+		                   (unsigned long long)listing->listing_id,
+		                   listing->app_id,
+		                   (unsigned long long)listing->asset_id,
+		                   listing->price, listing->fee,
+		                   listing->market_hash_name != NULL ?
+		                   listing->market_hash_name : "");
+
+		/* Names longer than the line are cut, the line still ends */
+		if (length >= DAEMON_LINE_SIZE)
+		{
+			length = DAEMON_LINE_SIZE - 1;
+			body[size_body + length - 1] = '\n';
+		}
+
+		size_body += length;
+	}
+
+	send_daemon_response (daemon, request, DAEMON_STATUS_OK,
+	                      body, size_body, NULL, 0);
+
+	steam_free (body);
+	free_my_listings (my_listings);
+}
+
+/*===========================================================================*
+ * Function name    : run_daemon_requests                                    *
+ *                                                                           *
+ * Description      : This function run every queued request. Requests of    *
+ *                    one kind from all clients go to Steam as one           *
+ *                    concurrent batch over the shared connections           *
+ *                                                                           *
+ * Input values(s)  : daemon                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void run_daemon_requests (SteamDaemon *daemon)
+{
+	run_sell_batch (daemon);
+	run_create_buy_batch (daemon);
+	run_cancel_buy_batch (daemon);
+	run_remove_listing_batch (daemon);
+
+	/* Inventory is reloaded only after sells stopped using its items */
+	for (size_t index = 0; index < daemon->count_requests; index++)
+	{
+		const DaemonRequest *request = &daemon->requests[index];
+
+		switch (request->operation)
+		{
+			case DAEMON_OP_PING:
+				send_daemon_response (daemon, request, DAEMON_STATUS_OK,
+				                      NULL, 0, NULL, 0);
+				break;
+
+			case DAEMON_OP_INVENTORY:
+				run_inventory_request (daemon, request);
+				break;
+
+			case DAEMON_OP_LISTINGS:
+				run_listings_request (daemon, request);
+				break;
+
+			case DAEMON_OP_SELL:
+			case DAEMON_OP_CREATE_BUY:
+			case DAEMON_OP_CANCEL_BUY:
+			case DAEMON_OP_REMOVE_LISTING:
+				break;
+
+			default:
+				send_daemon_response (daemon, request, DAEMON_STATUS_BAD_REQUEST,
+				                      NULL, 0, NULL, 0);
+				break;
+		}
+	}
+
+	for (size_t index = 0; index < daemon->count_requests; index++)
+	{
+		steam_free (daemon->requests[index].args);
+	}
+
+	daemon->count_requests = 0;
+}
+
+/*===========================================================================*
+ * Function name    : open_daemon_socket                                     *
+ *                                                                           *
+ * Description      : This function create listening unix socket usable by   *
+ *                    the owner only                                         *
+ *                                                                           *
+ * Input values(s)  : socket_path                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : File descriptor or -1                                  *
+ *===========================================================================*/
+static int open_daemon_socket (const char *socket_path)
+{
+	struct sockaddr_un address;
+	int fd = -1;
+	mode_t old_mask = 0;
+
+	if (strlen (socket_path) >= sizeof (address.sun_path))
+		return -1;
+
+	memset (&address, 0, sizeof (address));
+	address.sun_family = AF_UNIX;
+	strcpy (address.sun_path, socket_path);
+
+	fd = socket (AF_UNIX, SOCK_STREAM, 0);
+
+	if (fd < 0)
+		return -1;
+
+	if (set_nonblocking (fd) != SUCCESS)
+	{
+		close (fd);
+
+		return -1;
+	}
+
+	/* Left over by a daemon that did not exit cleanly */
+	unlink (socket_path);
+
+	old_mask = umask (0077);
+
+	if (bind (fd, (struct sockaddr *)&address, sizeof (address)) != 0 ||
+	    listen (fd, DAEMON_LISTEN_BACKLOG) != 0)
+	{
+		close (fd);
+		fd = -1;
+	}
+
+	umask (old_mask);
+
+	return fd;
+}
+
+/*===========================================================================*
+ * Function name    : run_steam_daemon                                       *
+ *                                                                           *
+ * Description      : This function serve requests of local clients over     *
+ *                    unix socket until stop_steam_daemon (). The session,   *
+ *                    connections, inventory and buy order book stay warm,   *
+ *                    so a request costs one Steam round trip                *
+ *                                                                           *
+ * Input values(s)  : socket_path                                            *
+ *                    currency - wallet currency of buy orders               *
+ *                    max_concurrency - max requests in flight per batch     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t run_steam_daemon (const char *socket_path, uint32_t currency,
+                         uint32_t max_concurrency)
+{
+	SteamDaemon *daemon = NULL;
+	struct pollfd poll_fds[DAEMON_MAX_CLIENTS + 2];
+	char error_message[ERROR_MESSAGE_SIZE] = {0};
+	char stop_byte = 0;
+	char steam_id[STEAM_ID_SIZE] = {0};
+	size_t count_clients = 0;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "run_steam_daemon ()", __LINE__);
+
+	daemon = steam_calloc (1, sizeof (SteamDaemon), ALLOC_TAG_OTHER);
+
+	if (daemon == NULL || pipe (s_stop_pipe) != 0)
+	{
+		steam_free (daemon);
+
+		return FAILURE;
+	}
+
+	set_nonblocking (s_stop_pipe[0]);
+	set_nonblocking (s_stop_pipe[1]);
+
+	daemon->max_concurrency = max_concurrency != 0 ? max_concurrency :
+	                          MAX_CONCURRENT_REQUESTS;
+	daemon->listen_fd = open_daemon_socket (socket_path);
+	daemon->buy_order_book = create_buy_order_book (currency);
+
+	if (daemon->listen_fd < 0 || daemon->buy_order_book == NULL)
+	{
+		snprintf (error_message, ERROR_MESSAGE_SIZE, "[ERROR %u] ", __LINE__);
+		perror (error_message);
+
+		return_value = FAILURE;
+	}
+	else
+	{
+		/* Warm up before the first client, both are refreshed on demand */
+		get_steam_session (steam_id, sizeof (steam_id), NULL, 0);
+		daemon->steam_inventory = get_inventory_items (steam_id);
+		sync_buy_order_book (daemon->buy_order_book);
+	}
+
+	while (return_value == SUCCESS)
+	{
+		poll_fds[0].fd = s_stop_pipe[0];
+		poll_fds[0].events = POLLIN;
+		poll_fds[1].fd = daemon->listen_fd;
+		poll_fds[1].events = POLLIN;
+
+		count_clients = daemon->count_clients;
+
+		for (size_t index = 0; index < count_clients; index++)
+		{
+			poll_fds[index + 2].fd = daemon->clients[index].fd;
+			poll_fds[index + 2].events = daemon->clients[index].read_closed == 0 ?
+			                             POLLIN : 0;
+
+			if (daemon->clients[index].size_output != 0)
+				poll_fds[index + 2].events |= POLLOUT;
+		}
+
+		if (poll (poll_fds, count_clients + 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return_value = FAILURE;
+			break;
+		}
+
+		if (poll_fds[0].revents != 0)
+			break;
+
+		/* Backwards, so closing a client only moves already handled ones */
+		for (size_t index = count_clients; index-- > 0; )
+		{
+			DaemonClient *client = &daemon->clients[index];
+			short revents = poll_fds[index + 2].revents;
+
+			if (revents == 0)
+				continue;
+
+			if (((revents & (POLLIN | POLLHUP | POLLERR)) != 0 &&
+			     read_daemon_client (daemon, client) != SUCCESS) ||
+			    ((revents & POLLOUT) != 0 &&
+			     flush_daemon_client (client) != SUCCESS))
+			{
+				close_daemon_client (daemon, index);
+			}
+		}
+
+		if (poll_fds[1].revents != 0)
+			accept_daemon_clients (daemon);
+
+		if (daemon->count_requests != 0)
+		{
+			run_daemon_requests (daemon);
+
+			for (size_t index = daemon->count_clients; index-- > 0; )
+			{
+				if (daemon->clients[index].size_output != 0 &&
+				    flush_daemon_client (&daemon->clients[index]) != SUCCESS)
+				{
+					close_daemon_client (daemon, index);
+				}
+			}
+		}
+
+		/* Clients that shut down writing go once all answers are sent */
+		for (size_t index = daemon->count_clients; index-- > 0; )
+		{
+			if (daemon->clients[index].read_closed != 0 &&
+			    daemon->clients[index].size_output == 0)
+			{
+				close_daemon_client (daemon, index);
+			}
+		}
+	}
+
+	while (read (s_stop_pipe[0], &stop_byte, 1) > 0);
+
+	while (daemon->count_clients != 0)
+		close_daemon_client (daemon, daemon->count_clients - 1);
+
+	for (size_t index = 0; index < daemon->count_requests; index++)
+	{
+		steam_free (daemon->requests[index].args);
+	}
+
+	if (daemon->listen_fd >= 0)
+	{
+		close (daemon->listen_fd);
+		unlink (socket_path);
+	}
+
+	close (s_stop_pipe[0]);
+	close (s_stop_pipe[1]);
+	s_stop_pipe[0] = s_stop_pipe[1] = -1;
+
+	steam_free (daemon->requests);
+	free_steam_inventory (daemon->steam_inventory);
+	free_buy_order_book (daemon->buy_order_book);
+	steam_free (daemon);
+
+	print_debug_information ("Exiting the function to "
+	                         "run_steam_daemon ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : stop_steam_daemon                                      *
+ *                                                                           *
+ * Description      : This function make run_steam_daemon () return, safe    *
+ *                    to call from a signal handler                          *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void stop_steam_daemon (void)
+{
+	char stop_byte = 1;
+	int fd = s_stop_pipe[1];
+
+	if (fd >= 0 && write (fd, &stop_byte, 1) < 0)
+	{
+		/* The pipe is full, a stop is already pending */
+	}
+}
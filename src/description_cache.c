@@ -0,0 +1,693 @@
+#include <pthread.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "../inc/description_cache.h"
+#include "../inc/steam.h"
+
+#define NO_ENTRY            UINT32_MAX
+#define TMP_FILE_NAME_SIZE  1024
+
+/* market_hash_name strings are shared between the cache and every
+ * InventoryItem that refers to them, so an evicted entry never leaves
+ * a dangling name behind */
+typedef struct tSharedName {
+	uint32_t  ref_count;
+	char      name[];
+} SharedName;
+
+typedef struct tDescriptionEntry {
+	uint32_t  app_id;
+	uint64_t  class_id;
+	uint64_t  instance_id;
+	int8_t    marketable;
+	char     *market_hash_name;
+	uint32_t  next_in_bucket;
+	uint32_t  prev_used;
+	uint32_t  next_used;
+} DescriptionEntry;
+
+typedef struct tDescriptionCache {
+	DescriptionEntry  *entries;
+	uint32_t          *buckets;
+	uint32_t           bucket_mask;
+	uint32_t           capacity;
+	uint32_t           count_entries;
+	uint32_t           most_recent;
+	uint32_t           least_recent;
+} DescriptionCache;
+
+static DescriptionCache s_description_cache;
+static pthread_mutex_t s_description_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hash_description_key (uint32_t, uint64_t, uint64_t);
+static uint32_t find_entry (uint32_t, uint64_t, uint64_t);
+static void unlink_used (uint32_t);
+static void push_most_recent (uint32_t);
+static void unlink_bucket (uint32_t);
+static int8_t lazy_init_description_cache (void);
+
+/*===========================================================================*
+ * Function name    : hash_description_key                                   *
+ *                                                                           *
+ * Description      : This function hash appid/classid/instanceid            *
+ *                                                                           *
+ * Input values(s)  : app_id                                                 *
+ *                    class_id                                               *
+ *                    instance_id                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Bucket index                                           *
+ *===========================================================================*/
+static uint32_t hash_description_key (uint32_t app_id, uint64_t class_id,
+                                      uint64_t instance_id)
+{
+	uint64_t hash = class_id * 0x9E3779B97F4A7C15ULL;
+
+	hash ^= (instance_id + app_id) * 0xC2B2AE3D27D4EB4FULL;
+	hash ^= hash >> 29;
+
+	return (uint32_t)hash & s_description_cache.bucket_mask;
+}
+
+/*===========================================================================*
+ * Function name    : find_entry                                             *
+ *                                                                           *
+ * Description      : This function find cache entry (mutex must be held)    *
+ *                                                                           *
+ * Input values(s)  : app_id                                                 *
+ *                    class_id                                               *
+ *                    instance_id                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Entry index or NO_ENTRY                                *
+ *===========================================================================*/
+static uint32_t find_entry (uint32_t app_id, uint64_t class_id,
+                            uint64_t instance_id)
+{
+	DescriptionEntry *entry = NULL;
+	uint32_t index = 0;
+
+	index = s_description_cache.buckets[hash_description_key (app_id, class_id,
+	                                                          instance_id)];
+
+	for (; index != NO_ENTRY; index = entry->next_in_bucket)
+	{
+		entry = &s_description_cache.entries[index];
+
+		if (entry->class_id == class_id && entry->instance_id == instance_id &&
+		    entry->app_id == app_id)
+		{
+			return index;
+		}
+	}
+
+	return NO_ENTRY;
+}
+
+/*===========================================================================*
+ * Function name    : unlink_used                                            *
+ *                                                                           *
+ * Description      : This function remove entry from LRU list               *
+ *                                                                           *
+ * Input values(s)  : index                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void unlink_used (uint32_t index)
+{
+	DescriptionEntry *entry = &s_description_cache.entries[index];
+
+	if (entry->prev_used != NO_ENTRY)
+		s_description_cache.entries[entry->prev_used].next_used = entry->next_used;
+	else
+		s_description_cache.most_recent = entry->next_used;
+
+	if (entry->next_used != NO_ENTRY)
+		s_description_cache.entries[entry->next_used].prev_used = entry->prev_used;
+	else
+		s_description_cache.least_recent = entry->prev_used;
+}
+
+/*===========================================================================*
+ * Function name    : push_most_recent                                       *
+ *                                                                           *
+ * Description      : This function insert entry at head of LRU list         *
+ *                                                                           *
+ * Input values(s)  : index                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void push_most_recent (uint32_t index)
+{
+	DescriptionEntry *entry = &s_description_cache.entries[index];
+
+	entry->prev_used = NO_ENTRY;
+	entry->next_used = s_description_cache.most_recent;
+
+	if (s_description_cache.most_recent != NO_ENTRY)
+		s_description_cache.entries[s_description_cache.most_recent].prev_used = index;
+	else
+		s_description_cache.least_recent = index;
+
+	s_description_cache.most_recent = index;
+}
+
+/*===========================================================================*
+ * Function name    : unlink_bucket                                          *
+ *                                                                           *
+ * Description      : This function remove entry from its hash bucket        *
+ *                                                                           *
+ * Input values(s)  : index                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void unlink_bucket (uint32_t index)
+{
+	DescriptionEntry *entry = &s_description_cache.entries[index];
+	uint32_t *link = NULL;
+
+	link = &s_description_cache.buckets[hash_description_key (entry->app_id,
+	                                                          entry->class_id,
+	                                                          entry->instance_id)];
+
+	while (*link != index)
+		link = &s_description_cache.entries[*link].next_in_bucket;
+
+	*link = entry->next_in_bucket;
+}
+
+/*===========================================================================*
+ * Function name    : lazy_init_description_cache                            *
+ *                                                                           *
+ * Description      : This function init cache with default size on first    *
+ *                    use (mutex must be held)                               *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t lazy_init_description_cache (void)
+{
+	uint32_t bucket_count = 16;
+	uint32_t capacity = DESCRIPTION_CACHE_SIZE;
+
+	if (s_description_cache.entries != NULL)
+		return SUCCESS;
+
+	if (s_description_cache.capacity != 0)
+		capacity = s_description_cache.capacity;
+
+	while (bucket_count < capacity)
+		bucket_count <<= 1;
+
+	s_description_cache.entries = steam_calloc (capacity, sizeof (DescriptionEntry),
+	                                            ALLOC_TAG_INVENTORY);
+	s_description_cache.buckets = steam_malloc (bucket_count * sizeof (uint32_t),
+	                                            ALLOC_TAG_INVENTORY);
+
+	if (s_description_cache.entries == NULL || s_description_cache.buckets == NULL)
+	{
+		steam_free (s_description_cache.entries);
+		steam_free (s_description_cache.buckets);
+		s_description_cache.entries = NULL;
+		s_description_cache.buckets = NULL;
+
+		return FAILURE;
+	}
+
+	memset (s_description_cache.buckets, 0xFF, bucket_count * sizeof (uint32_t));
+
+	s_description_cache.bucket_mask = bucket_count - 1;
+	s_description_cache.capacity = capacity;
+	s_description_cache.count_entries = 0;
+	s_description_cache.most_recent = NO_ENTRY;
+	s_description_cache.least_recent = NO_ENTRY;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : init_description_cache                                 *
+ *                                                                           *
+ * Description      : This function set description cache size. The cache    *
+ *                    is process-wide and shared by all inventories and      *
+ *                    accounts. Must hold at least one inventory page        *
+ *                                                                           *
+ * Input values(s)  : capacity - max count of descriptions                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t init_description_cache (uint32_t capacity)
+{
+	int8_t return_value = FAILURE;
+
+	print_debug_information ("Entering the function to "
+	                         "init_description_cache ()", __LINE__);
+
+	free_description_cache ();
+
+	if (capacity < DESCRIPTION_CACHE_MIN_SIZE)
+		capacity = DESCRIPTION_CACHE_MIN_SIZE;
+
+	pthread_mutex_lock (&s_description_cache_mutex);
+
+	s_description_cache.capacity = capacity;
+	return_value = lazy_init_description_cache ();
+
+	pthread_mutex_unlock (&s_description_cache_mutex);
+
+	print_debug_information ("Exiting the function to "
+	                         "init_description_cache ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : free_description_cache                                 *
+ *                                                                           *
+ * Description      : This function free memory for description cache.       *
+ *                    Names still held by inventories stay valid             *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_description_cache (void)
+{
+	pthread_mutex_lock (&s_description_cache_mutex);
+
+	for (uint32_t index = 0; index < s_description_cache.count_entries; index++)
+	{
+		release_description_name (s_description_cache.entries[index].market_hash_name);
+	}
+
+	steam_free (s_description_cache.entries);
+	steam_free (s_description_cache.buckets);
+
+	memset (&s_description_cache, 0, sizeof (s_description_cache));
+
+	pthread_mutex_unlock (&s_description_cache_mutex);
+}
+
+/*===========================================================================*
+ * Function name    : description_cache_contains                             *
+ *                                                                           *
+ * Description      : This function check description in cache               *
+ *                                                                           *
+ * Input values(s)  : app_id                                                 *
+ *                    class_id                                               *
+ *                    instance_id                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : STR_FOUND/STR_NOT_FOUND                                *
+ *===========================================================================*/
+int8_t description_cache_contains (uint32_t app_id, uint64_t class_id,
+                                   uint64_t instance_id)
+{
+	uint32_t index = NO_ENTRY;
+
+	pthread_mutex_lock (&s_description_cache_mutex);
+
+	if (s_description_cache.entries != NULL)
+	{
+		index = find_entry (app_id, class_id, instance_id);
+
+		if (index != NO_ENTRY)
+		{
+			unlink_used (index);
+			push_most_recent (index);
+		}
+	}
+
+	pthread_mutex_unlock (&s_description_cache_mutex);
+
+	return index != NO_ENTRY ? STR_FOUND : STR_NOT_FOUND;
+}
+
+/*===========================================================================*
+ * Function name    : description_cache_insert                               *
+ *                                                                           *
+ * Description      : This function add description to cache, the least      *
+ *                    recently used entry is evicted when cache is full      *
+ *                                                                           *
+ * Input values(s)  : app_id                                                 *
+ *                    class_id                                               *
+ *                    instance_id                                            *
+ *                    market_hash_name                                       *
+ *                    marketable                                             *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t description_cache_insert (uint32_t app_id, uint64_t class_id,
+                                 uint64_t instance_id,
+                                 const char *market_hash_name,
+                                 int8_t marketable)
+{
+	DescriptionEntry *entry = NULL;
+	SharedName *shared_name = NULL;
+	size_t name_length = 0;
+	uint32_t index = 0;
+	uint32_t bucket = 0;
+
+	if (market_hash_name == NULL)
+	{
+		return FAILURE;
+	}
+
+	name_length = strlen (market_hash_name) + 1;
+
+	shared_name = steam_malloc (sizeof (SharedName) + name_length,
+	                            ALLOC_TAG_INVENTORY);
+
+	if (shared_name == NULL)
+	{
+		return FAILURE;
+	}
+
+	shared_name->ref_count = 1;
+	memcpy (shared_name->name, market_hash_name, name_length);
+
+	pthread_mutex_lock (&s_description_cache_mutex);
+
+	if (lazy_init_description_cache () != SUCCESS)
+	{
+		pthread_mutex_unlock (&s_description_cache_mutex);
+		steam_free (shared_name);
+
+		return FAILURE;
+	}
+
+	index = find_entry (app_id, class_id, instance_id);
+
+	if (index != NO_ENTRY)
+	{
+		unlink_used (index);
+	}
+	else if (s_description_cache.count_entries < s_description_cache.capacity)
+	{
+		index = s_description_cache.count_entries++;
+		s_description_cache.entries[index].market_hash_name = NULL;
+	}
+	else
+	{
+		index = s_description_cache.least_recent;
+
+		unlink_used (index);
+		unlink_bucket (index);
+	}
+
+	entry = &s_description_cache.entries[index];
+
+	if (entry->market_hash_name == NULL || entry->class_id != class_id ||
+	    entry->instance_id != instance_id || entry->app_id != app_id)
+	{
+		entry->app_id = app_id;
+		entry->class_id = class_id;
+		entry->instance_id = instance_id;
+
+		bucket = hash_description_key (app_id, class_id, instance_id);
+		entry->next_in_bucket = s_description_cache.buckets[bucket];
+		s_description_cache.buckets[bucket] = index;
+	}
+
+	release_description_name (entry->market_hash_name);
+
+	entry->market_hash_name = shared_name->name;
+	entry->marketable = marketable;
+
+	push_most_recent (index);
+
+	pthread_mutex_unlock (&s_description_cache_mutex);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : description_cache_lookup                               *
+ *                                                                           *
+ * Description      : This function get description from cache               *
+ *                                                                           *
+ * Input values(s)  : app_id                                                 *
+ *                    class_id                                               *
+ *                    instance_id                                            *
+ *                                                                           *
+ * Output values(s) : market_hash_name - shared name, must be released by    *
+ *                                       release_description_name ()         *
+ *                    marketable                                             *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t description_cache_lookup (uint32_t app_id, uint64_t class_id,
+                                 uint64_t instance_id, char **market_hash_name,
+                                 int8_t *marketable)
+{
+	DescriptionEntry *entry = NULL;
+	uint32_t index = NO_ENTRY;
+
+	pthread_mutex_lock (&s_description_cache_mutex);
+
+	if (s_description_cache.entries != NULL)
+	{
+		index = find_entry (app_id, class_id, instance_id);
+	}
+
+	if (index == NO_ENTRY)
+	{
+		pthread_mutex_unlock (&s_description_cache_mutex);
+
+		return FAILURE;
+	}
+
+	unlink_used (index);
+	push_most_recent (index);
+
+	entry = &s_description_cache.entries[index];
+
+	*market_hash_name = acquire_description_name (entry->market_hash_name);
+	*marketable = entry->marketable;
+
+	pthread_mutex_unlock (&s_description_cache_mutex);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : acquire_description_name                               *
+ *                                                                           *
+ * Description      : This function take one more reference to shared name   *
+ *                                                                           *
+ * Input values(s)  : market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : market_hash_name                                       *
+ *===========================================================================*/
+char *acquire_description_name (char *market_hash_name)
+{
+	SharedName *shared_name = NULL;
+
+	if (market_hash_name != NULL)
+	{
+		shared_name = (SharedName *)(market_hash_name - offsetof (SharedName, name));
+
+		__atomic_add_fetch (&shared_name->ref_count, 1, __ATOMIC_RELAXED);
+	}
+
+	return market_hash_name;
+}
+
+/*===========================================================================*
+ * Function name    : release_description_name                               *
+ *                                                                           *
+ * Description      : This function drop reference to shared name           *
+ *                                                                           *
+ * Input values(s)  : market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void release_description_name (char *market_hash_name)
+{
+	SharedName *shared_name = NULL;
+
+	if (market_hash_name == NULL)
+		return;
+
+	shared_name = (SharedName *)(market_hash_name - offsetof (SharedName, name));
+
+	if (__atomic_sub_fetch (&shared_name->ref_count, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		steam_free (shared_name);
+	}
+}
+
+/*===========================================================================*
+ * Function name    : load_description_cache                                 *
+ *                                                                           *
+ * Description      : This function load descriptions saved by               *
+ *                    save_description_cache ()                              *
+ *                                                                           *
+ * Input values(s)  : file_name                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t load_description_cache (const char *file_name)
+{
+	FILE *file = NULL;
+	char line[DESCRIPTION_LINE_SIZE] = {0};
+	char *ptr_name = NULL;
+	char *ptr_end = NULL;
+	unsigned int app_id = 0;
+	unsigned long long class_id = 0;
+	unsigned long long instance_id = 0;
+	int marketable = 0;
+	int name_offset = 0;
+
+	print_debug_information ("Entering the function to "
+	                         "load_description_cache ()", __LINE__);
+
+	file = fopen (file_name, "r");
+
+	if (file == NULL)
+	{
+		return FAILURE;
+	}
+
+	/* appid \t classid \t instanceid \t marketable \t market_hash_name */
+	while (fgets (line, sizeof (line), file) != NULL)
+	{
+		if (sscanf (line, "%u\t%llu\t%llu\t%d\t%n", &app_id, &class_id,
+		            &instance_id, &marketable, &name_offset) != 4)
+		{
+			continue;
+		}
+
+		ptr_name = line + name_offset;
+		ptr_end = strchr (ptr_name, '\n');
+
+		if (ptr_end != NULL)
+			*ptr_end = '\0';
+
+		description_cache_insert (app_id, class_id, instance_id, ptr_name,
+		                          marketable == MARKETABLE_TRUE ?
+		                          MARKETABLE_TRUE : MARKETABLE_FALSE);
+	}
+
+	fclose (file);
+
+	print_debug_information ("Exiting the function to "
+	                         "load_description_cache ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : save_description_cache                                 *
+ *                                                                           *
+ * Description      : This function save descriptions to file, least         *
+ *                    recently used first. Written to a temporary file and   *
+ *                    renamed, names the loader cannot split are skipped     *
+ *                                                                           *
+ * Input values(s)  : file_name                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t save_description_cache (const char *file_name)
+{
+	FILE *file = NULL;
+	DescriptionEntry *entry = NULL;
+	char tmp_file_name[TMP_FILE_NAME_SIZE] = {0};
+	char error_message[ERROR_MESSAGE_SIZE] = {0};
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "save_description_cache ()", __LINE__);
+
+	if (snprintf (tmp_file_name, sizeof (tmp_file_name), "%s.tmp",
+	              file_name) >= (int)sizeof (tmp_file_name))
+	{
+		return FAILURE;
+	}
+
+	/* Old cache stays in place until the new one is complete */
+	file = fopen (tmp_file_name, "w");
+
+	if (file == NULL)
+	{
+		snprintf (error_message, ERROR_MESSAGE_SIZE, "[ERROR %u] ", __LINE__);
+		perror (error_message);
+
+		return FAILURE;
+	}
+
+	pthread_mutex_lock (&s_description_cache_mutex);
+
+	if (s_description_cache.entries != NULL)
+	{
+		for (uint32_t index = s_description_cache.least_recent; index != NO_ENTRY;
+		     index = entry->prev_used)
+		{
+			entry = &s_description_cache.entries[index];
+
+			/* One entry per line, tab separated */
+			if (entry->market_hash_name == NULL ||
+			    strpbrk (entry->market_hash_name, "\t\r\n") != NULL)
+			{
+				continue;
+			}
+
+			if (fprintf (file, "%u\t%llu\t%llu\t%d\t%s\n", entry->app_id,
+			             (unsigned long long)entry->class_id,
+			             (unsigned long long)entry->instance_id,
+			             entry->marketable, entry->market_hash_name) < 0)
+			{
+				return_value = FAILURE;
+				break;
+			}
+		}
+	}
+
+	pthread_mutex_unlock (&s_description_cache_mutex);
+
+	if (fclose (file) != 0)
+		return_value = FAILURE;
+
+	if (return_value == SUCCESS && rename (tmp_file_name, file_name) != 0)
+	{
+		snprintf (error_message, ERROR_MESSAGE_SIZE, "[ERROR %u] ", __LINE__);
+		perror (error_message);
+
+		return_value = FAILURE;
+	}
+
+	if (return_value != SUCCESS)
+		unlink (tmp_file_name);
+
+	print_debug_information ("Exiting the function to "
+	                         "save_description_cache ()", __LINE__);
+
+	return return_value;
+}
@@ -0,0 +1,621 @@
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "../inc/export.h"
+#include "../inc/steam.h"
+
+#define CSV_HEADER  "market_hash_name,class_id,app_id,context_id," \
+                    "asset_id,instance_id,marketable\n"
+
+static int8_t reserve_export_buffer (ExportSink *, size_t);
+static void append_bytes (ExportSink *, const char *, size_t);
+static void append_string (ExportSink *, const char *);
+static void append_uint (ExportSink *, uint64_t);
+static void append_json_string (ExportSink *, const char *);
+static void append_csv_field (ExportSink *, const char *);
+static void append_binary_field (ExportSink *, const char *);
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/*===========================================================================*
+ * Function name    : reserve_export_buffer                                  *
+ *                                                                           *
+ * Description      : This function make room in write buffer, flushing it   *
+ *                    to the file when full (growing it for memory sink)     *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                    length - bytes to be appended                          *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t reserve_export_buffer (ExportSink *sink, size_t length)
+{
+	char *ptr = NULL;
+
+	if (sink->size + length <= sink->capacity)
+		return SUCCESS;
+
+	/* Memory sink keeps everything, the buffer is doubled */
+	if (sink->fd < 0)
+	{
+		size_t capacity = sink->capacity * 2;
+
+		if (capacity < sink->size + length)
+			capacity = sink->size + length;
+
+		ptr = steam_realloc (sink->buffer, capacity, ALLOC_TAG_INVENTORY);
+
+		if (ptr == NULL)
+		{
+			sink->error = 1;
+
+			return FAILURE;
+		}
+
+		sink->buffer = ptr;
+		sink->capacity = capacity;
+
+		return SUCCESS;
+	}
+
+	if (flush_export_sink (sink) != SUCCESS)
+		return FAILURE;
+
+	/* A single field larger than the whole buffer */
+	if (length > sink->capacity)
+	{
+		ptr = steam_realloc (sink->buffer, length, ALLOC_TAG_INVENTORY);
+
+		if (ptr == NULL)
+		{
+			sink->error = 1;
+
+			return FAILURE;
+		}
+
+		sink->buffer = ptr;
+		sink->capacity = length;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : append_bytes                                           *
+ *                                                                           *
+ * Description      : This function append bytes to write buffer             *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                    data                                                   *
+ *                    length                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void append_bytes (ExportSink *sink, const char *data, size_t length)
+{
+	if (reserve_export_buffer (sink, length) != SUCCESS)
+		return;
+
+	memcpy (sink->buffer + sink->size, data, length);
+	sink->size += length;
+}
+
+/*===========================================================================*
+ * Function name    : append_string                                          *
+ *                                                                           *
+ * Description      : This function append NULL-terminated string            *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                    str - string, NULL is written as empty                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void append_string (ExportSink *sink, const char *str)
+{
+	if (str != NULL)
+		append_bytes (sink, str, strlen (str));
+}
+
+/*===========================================================================*
+ * Function name    : append_uint                                            *
+ *                                                                           *
+ * Description      : This function append unsigned number as decimal        *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                    value                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void append_uint (ExportSink *sink, uint64_t value)
+{
+	char digits[20];
+	size_t position = sizeof (digits);
+
+	do
+	{
+		digits[--position] = '0' + value % 10;
+		value /= 10;
+	} while (value != 0);
+
+	append_bytes (sink, digits + position, sizeof (digits) - position);
+}
+
+/*===========================================================================*
+ * Function name    : append_json_string                                     *
+ *                                                                           *
+ * Description      : This function append quoted and escaped JSON string    *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                    str - string, NULL is written as null                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void append_json_string (ExportSink *sink, const char *str)
+{
+	const char *run = NULL;
+	char escape[6] = {'\\', 'u', '0', '0', 0, 0};
+
+	if (str == NULL)
+	{
+		append_bytes (sink, "null", 4);
+
+		return;
+	}
+
+	append_bytes (sink, "\"", 1);
+
+	for (run = str; *str; str++)
+	{
+		if (*str != '"' && *str != '\\' && (uint8_t)*str >= 0x20)
+			continue;
+
+		append_bytes (sink, run, str - run);
+		run = str + 1;
+
+		if (*str == '"' || *str == '\\')
+		{
+			escape[1] = *str;
+			append_bytes (sink, escape, 2);
+			escape[1] = 'u';
+		}
+		else
+		{
+			escape[4] = hex_digits[(uint8_t)*str >> 4];
+			escape[5] = hex_digits[(uint8_t)*str & 0x0F];
+			append_bytes (sink, escape, 6);
+		}
+	}
+
+	append_bytes (sink, run, str - run);
+	append_bytes (sink, "\"", 1);
+}
+
+/*===========================================================================*
+ * Function name    : append_csv_field                                       *
+ *                                                                           *
+ * Description      : This function append RFC 4180 CSV field                *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                    str                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void append_csv_field (ExportSink *sink, const char *str)
+{
+	const char *run = NULL;
+
+	if (str == NULL)
+		return;
+
+	if (strpbrk (str, ",\"\r\n") == NULL)
+	{
+		append_string (sink, str);
+
+		return;
+	}
+
+	append_bytes (sink, "\"", 1);
+
+	for (run = str; *str; str++)
+	{
+		if (*str == '"')
+		{
+			append_bytes (sink, run, str - run + 1);
+			run = str;
+		}
+	}
+
+	append_bytes (sink, run, str - run);
+	append_bytes (sink, "\"", 1);
+}
+
+/*===========================================================================*
+ * Function name    : append_binary_field                                    *
+ *                                                                           *
+ * Description      : This function append string with 16-bit little-endian  *
+ *                    length prefix                                          *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                    str                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void append_binary_field (ExportSink *sink, const char *str)
+{
+	size_t length = str != NULL ? strlen (str) : 0;
+	char prefix[2];
+
+	if (length > UINT16_MAX)
+		length = UINT16_MAX;
+
+	prefix[0] = length & 0xFF;
+	prefix[1] = (length >> 8) & 0xFF;
+
+	append_bytes (sink, prefix, sizeof (prefix));
+
+	if (length > 0)
+		append_bytes (sink, str, length);
+}
+
+/*===========================================================================*
+ * Function name    : open_export_sink_fd                                    *
+ *                                                                           *
+ * Description      : This function create buffered export sink over an      *
+ *                    open file descriptor (not closed by the sink)          *
+ *                                                                           *
+ * Input values(s)  : fd                                                     *
+ *                    format                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Export sink or NULL                                    *
+ *===========================================================================*/
+ExportSink *open_export_sink_fd (int fd, ExportFormat format)
+{
+	ExportSink *sink = NULL;
+
+	print_debug_information ("Entering the function to "
+	                         "open_export_sink_fd ()", __LINE__);
+
+	sink = steam_calloc (1, sizeof (ExportSink), ALLOC_TAG_INVENTORY);
+
+	if (sink == NULL)
+	{
+		return NULL;
+	}
+
+	sink->buffer = steam_malloc (EXPORT_BUFFER_SIZE, ALLOC_TAG_INVENTORY);
+
+	if (sink->buffer == NULL)
+	{
+		steam_free (sink);
+
+		return NULL;
+	}
+
+	sink->fd = fd;
+	sink->format = format;
+	sink->capacity = EXPORT_BUFFER_SIZE;
+
+	if (format == EXPORT_FORMAT_CSV)
+	{
+		append_bytes (sink, CSV_HEADER, strlen (CSV_HEADER));
+	}
+	else if (format == EXPORT_FORMAT_BINARY)
+	{
+		append_bytes (sink, EXPORT_BINARY_MAGIC, strlen (EXPORT_BINARY_MAGIC));
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "open_export_sink_fd ()", __LINE__);
+
+	return sink;
+}
+
+/*===========================================================================*
+ * Function name    : open_export_sink                                       *
+ *                                                                           *
+ * Description      : This function create buffered export sink to file      *
+ *                                                                           *
+ * Input values(s)  : file_name - file name, NULL or "-" for stdout          *
+ *                    format                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Export sink or NULL                                    *
+ *===========================================================================*/
+ExportSink *open_export_sink (const char *file_name, ExportFormat format)
+{
+	ExportSink *sink = NULL;
+	char error_message[ERROR_MESSAGE_SIZE] = {0};
+	int fd = STDOUT_FILENO;
+
+	if (file_name != NULL && strcmp (file_name, "-") != STRINGS_EQUAL)
+	{
+		fd = open (file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+		if (fd < 0)
+		{
+			snprintf (error_message, ERROR_MESSAGE_SIZE, "[ERROR %u] ", __LINE__);
+			perror (error_message);
+
+			return NULL;
+		}
+	}
+	else
+	{
+		/* Keep order with anything already printed through stdio */
+		fflush (stdout);
+	}
+
+	sink = open_export_sink_fd (fd, format);
+
+	if (sink == NULL)
+	{
+		if (fd != STDOUT_FILENO)
+			close (fd);
+
+		return NULL;
+	}
+
+	sink->owns_fd = (fd != STDOUT_FILENO);
+
+	return sink;
+}
+
+/*===========================================================================*
+ * Function name    : open_export_sink_memory                                *
+ *                                                                           *
+ * Description      : This function create export sink collecting everything *
+ *                    in sink->buffer (sink->size bytes), nothing is written *
+ *                    until close_export_sink () frees it                    *
+ *                                                                           *
+ * Input values(s)  : format                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Export sink or NULL                                    *
+ *===========================================================================*/
+ExportSink *open_export_sink_memory (ExportFormat format)
+{
+	return open_export_sink_fd (-1, format);
+}
+
+/*===========================================================================*
+ * Function name    : export_inventory_item                                  *
+ *                                                                           *
+ * Description      : This function write one item to export sink            *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                    item                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t export_inventory_item (ExportSink *sink, const InventoryItem *item)
+{
+	const char *fields[6] = {item->market_hash_name, item->class_id,
+	                         item->app_id, item->context_id,
+	                         item->asset_id, item->instance_id};
+	size_t record_start = 0;
+	size_t record_length = 0;
+
+	switch (sink->format)
+	{
+	case EXPORT_FORMAT_TEXT:
+		append_string (sink, "\nmarket_hash_name: ");
+		append_string (sink, item->market_hash_name);
+		append_string (sink, "\nclass_id: ");
+		append_string (sink, item->class_id);
+		append_string (sink, "\napp_id: ");
+		append_string (sink, item->app_id);
+		append_string (sink, "\ncontext_id: ");
+		append_string (sink, item->context_id);
+		append_string (sink, "\nasset_id: ");
+		append_string (sink, item->asset_id);
+		append_string (sink, "\ninstance_id: ");
+		append_string (sink, item->instance_id);
+		append_string (sink, "\nmarketable: ");
+		append_bytes (sink, item->marketable == MARKETABLE_TRUE ? "1\n" : "0\n", 2);
+		break;
+
+	case EXPORT_FORMAT_NDJSON:
+		append_string (sink, "{\"market_hash_name\":");
+		append_json_string (sink, item->market_hash_name);
+		append_string (sink, ",\"class_id\":");
+		append_json_string (sink, item->class_id);
+		append_string (sink, ",\"app_id\":");
+		append_json_string (sink, item->app_id);
+		append_string (sink, ",\"context_id\":");
+		append_json_string (sink, item->context_id);
+		append_string (sink, ",\"asset_id\":");
+		append_json_string (sink, item->asset_id);
+		append_string (sink, ",\"instance_id\":");
+		append_json_string (sink, item->instance_id);
+		append_string (sink, item->marketable == MARKETABLE_TRUE ?
+		               ",\"marketable\":true}\n" : ",\"marketable\":false}\n");
+		break;
+
+	case EXPORT_FORMAT_CSV:
+		for (uint8_t index = 0; index < 6; index++)
+		{
+			append_csv_field (sink, fields[index]);
+			append_bytes (sink, ",", 1);
+		}
+
+		append_bytes (sink, item->marketable == MARKETABLE_TRUE ? "1\n" : "0\n", 2);
+		break;
+
+	case EXPORT_FORMAT_BINARY:
+		/* u32 record length, then six u16-prefixed strings and a flag byte.
+		 * The record is kept whole in the buffer to patch its length */
+		record_length = 4 + 1;
+
+		for (uint8_t index = 0; index < 6; index++)
+		{
+			record_length += 2 + (fields[index] != NULL ?
+			                      strlen (fields[index]) : 0);
+		}
+
+		if (reserve_export_buffer (sink, record_length) != SUCCESS)
+			break;
+
+		record_start = sink->size;
+		append_bytes (sink, "\0\0\0\0", 4);
+
+		for (uint8_t index = 0; index < 6; index++)
+		{
+			append_binary_field (sink, fields[index]);
+		}
+
+		append_bytes (sink, item->marketable == MARKETABLE_TRUE ? "\1" : "\0", 1);
+
+		record_length = sink->size - record_start - 4;
+		sink->buffer[record_start] = record_length & 0xFF;
+		sink->buffer[record_start + 1] = (record_length >> 8) & 0xFF;
+		sink->buffer[record_start + 2] = (record_length >> 16) & 0xFF;
+		sink->buffer[record_start + 3] = (record_length >> 24) & 0xFF;
+		break;
+	}
+
+	sink->count_items++;
+
+	return sink->error == 0 ? SUCCESS : FAILURE;
+}
+
+/*===========================================================================*
+ * Function name    : export_steam_inventory                                 *
+ *                                                                           *
+ * Description      : This function write all inventory items to sink        *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                    steam_inventory                                        *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t export_steam_inventory (ExportSink *sink,
+                               const SteamInventory *steam_inventory)
+{
+	print_debug_information ("Entering the function to "
+	                         "export_steam_inventory ()", __LINE__);
+
+	for (const SteamInventory *ptr_steam_inventory = steam_inventory;
+	     ptr_steam_inventory != NULL;
+	     ptr_steam_inventory = ptr_steam_inventory->next_steam_inventory)
+	{
+		for (uint64_t index = 0; index < ptr_steam_inventory->count_items; index++)
+		{
+			export_inventory_item (sink, &ptr_steam_inventory->inventory_items[index]);
+		}
+
+		if (sink->format == EXPORT_FORMAT_TEXT)
+		{
+			append_string (sink, "\ncount_items: ");
+			append_uint (sink, ptr_steam_inventory->count_items);
+			append_bytes (sink, "\n", 1);
+		}
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "export_steam_inventory ()", __LINE__);
+
+	return sink->error == 0 ? SUCCESS : FAILURE;
+}
+
+/*===========================================================================*
+ * Function name    : flush_export_sink                                      *
+ *                                                                           *
+ * Description      : This function write buffered data to the file          *
+ *                    (nothing for memory sink)                              *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t flush_export_sink (ExportSink *sink)
+{
+	char error_message[ERROR_MESSAGE_SIZE] = {0};
+	size_t offset = 0;
+	ssize_t written = 0;
+
+	if (sink->error != 0)
+		return FAILURE;
+
+	if (sink->fd < 0)
+		return SUCCESS;
+
+	while (offset < sink->size)
+	{
+		written = write (sink->fd, sink->buffer + offset, sink->size - offset);
+
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			snprintf (error_message, ERROR_MESSAGE_SIZE, "[ERROR %u] ", __LINE__);
+			perror (error_message);
+
+			sink->error = 1;
+
+			return FAILURE;
+		}
+
+		offset += written;
+	}
+
+	sink->size = 0;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : close_export_sink                                      *
+ *                                                                           *
+ * Description      : This function flush and free export sink               *
+ *                                                                           *
+ * Input values(s)  : sink                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t close_export_sink (ExportSink *sink)
+{
+	int8_t return_value = SUCCESS;
+
+	if (sink == NULL)
+		return FAILURE;
+
+	return_value = flush_export_sink (sink);
+
+	if (sink->owns_fd && close (sink->fd) != 0)
+	{
+		return_value = FAILURE;
+	}
+
+	steam_free (sink->buffer);
+	steam_free (sink);
+
+	return return_value;
+}
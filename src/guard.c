@@ -0,0 +1,416 @@
+#include <openssl/hmac.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#include "../inc/guard.h"
+#include "../inc/steam.h"
+
+#define STEAM_GUARD_PERIOD  30
+#define HMAC_SHA1_SIZE      20
+#define CONFIRMATION_TAG_SIZE  32
+
+static const char steam_guard_alphabet[] = "23456789BCDFGHJKMNPQRTVWXY";
+
+/* Seconds to add to the local clock to get the steam server time */
+static int64_t s_time_offset = 0;
+
+static int8_t compute_guard_hmac (const char *, int64_t, const char *, size_t,
+                                  uint8_t *);
+static void copy_credential (char *, size_t, const char *);
+static void trim_credential_line (char *);
+
+/*===========================================================================*
+ * Function name    : sync_steam_time                                        *
+ *                                                                           *
+ * Description      : This function query the steam server time and store    *
+ *                    the offset to the local clock. Codes of a wrong clock  *
+ *                    are rejected by steam                                  *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE, offset is kept on failure             *
+ *===========================================================================*/
+int8_t sync_steam_time (void)
+{
+	char *ptr_data = NULL;
+	int8_t return_value = FAILURE;
+	int64_t local_time = 0;
+	uint64_t server_time = 0;
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_response = NULL;
+
+	print_debug_information ("Entering the function to "
+	                         "sync_steam_time ()", __LINE__);
+
+	local_time = (int64_t)time (NULL);
+
+	ptr_data = curl_general_request (URL_STEAM_API "ITwoFactorService/QueryTime/v0001",
+	                                 NULL, "steamid=0", 0);
+
+	if (ptr_data == NULL)
+	{
+		print_debug_information ("Exiting the function to "
+		                         "sync_steam_time ()", __LINE__);
+
+		return FAILURE;
+	}
+
+	parsed_json = parse_json_response (ptr_data);
+
+	steam_free (ptr_data);
+
+	if (parsed_json != NULL &&
+	    json_object_object_get_ex (parsed_json, "response", &json_response) != 0 &&
+	    get_json_object_as_uint64 (&server_time, json_response, "server_time") == SUCCESS)
+	{
+		/* Round trip is under a second, far below the 30 second period */
+		__atomic_store_n (&s_time_offset, (int64_t)server_time - local_time,
+		                  __ATOMIC_RELAXED);
+
+		return_value = SUCCESS;
+	}
+
+	if (parsed_json != NULL)
+		json_object_put (parsed_json);
+
+	print_debug_information ("Exiting the function to "
+	                         "sync_steam_time ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : get_steam_time                                         *
+ *                                                                           *
+ * Description      : This function return the local time corrected by the   *
+ *                    last sync_steam_time ()                                *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Unix time                                              *
+ *===========================================================================*/
+int64_t get_steam_time (void)
+{
+	return (int64_t)time (NULL) + __atomic_load_n (&s_time_offset, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*
+ * Function name    : compute_guard_hmac                                     *
+ *                                                                           *
+ * Description      : This function compute HMAC-SHA1 keyed by base64        *
+ *                    secret of big endian time followed by data             *
+ *                                                                           *
+ * Input values(s)  : secret - base64                                        *
+ *                    time_value - 30 second period for codes, unix time     *
+ *                                 for confirmation keys                     *
+ *                    data - bytes after the time (optional parameter)       *
+ *                    size_data - at most CONFIRMATION_TAG_SIZE              *
+ *                                                                           *
+ * Output values(s) : hmac - HMAC_SHA1_SIZE bytes                            *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t compute_guard_hmac (const char *secret, int64_t time_value,
+                                  const char *data, size_t size_data,
+                                  uint8_t *hmac)
+{
+	uint8_t key[STEAM_SECRET_SIZE] = {0};
+	uint8_t message[8 + CONFIRMATION_TAG_SIZE] = {0};
+	size_t key_length = 0;
+	unsigned int hmac_length = 0;
+	uint64_t value = (uint64_t)time_value;
+
+	if (base64_decode (secret, key, sizeof (key), &key_length) != SUCCESS ||
+	    key_length == 0)
+	{
+		return FAILURE;
+	}
+
+	for (int8_t index = 7; index >= 0; index--)
+	{
+		message[index] = (uint8_t)value;
+		value >>= 8;
+	}
+
+	if (size_data > CONFIRMATION_TAG_SIZE)
+		size_data = CONFIRMATION_TAG_SIZE;
+
+	if (size_data > 0)
+		memcpy (message + 8, data, size_data);
+
+	if (HMAC (EVP_sha1 (), key, (int)key_length, message, 8 + size_data,
+	          hmac, &hmac_length) == NULL || hmac_length != HMAC_SHA1_SIZE)
+	{
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : generate_steam_guard_code                              *
+ *                                                                           *
+ * Description      : This function generate Steam Guard code: HMAC-SHA1 of  *
+ *                    the 30 second period keyed by shared secret, truncated *
+ *                    as in RFC 4226 and written in steam alphabet           *
+ *                                                                           *
+ * Input values(s)  : shared_secret - base64                                 *
+ *                    steam_time - unix time, get_steam_time () for current  *
+ *                                 code                                      *
+ *                                                                           *
+ * Output values(s) : code - STEAM_GUARD_CODE_LENGTH + 1 bytes               *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t generate_steam_guard_code (const char *shared_secret, int64_t steam_time,
+                                  char *code)
+{
+	uint8_t hmac[HMAC_SHA1_SIZE] = {0};
+	uint32_t full_code = 0;
+	uint8_t offset = 0;
+
+	print_debug_information ("Entering the function to "
+	                         "generate_steam_guard_code ()", __LINE__);
+
+	if (compute_guard_hmac (shared_secret, steam_time / STEAM_GUARD_PERIOD,
+	                        NULL, 0, hmac) != SUCCESS)
+	{
+		print_debug_information ("Exiting the function to "
+		                         "generate_steam_guard_code ()", __LINE__);
+
+		return FAILURE;
+	}
+
+	offset = hmac[HMAC_SHA1_SIZE - 1] & 0x0F;
+	full_code = ((uint32_t)(hmac[offset] & 0x7F) << 24) |
+	            ((uint32_t)hmac[offset + 1] << 16) |
+	            ((uint32_t)hmac[offset + 2] << 8) |
+	            (uint32_t)hmac[offset + 3];
+
+	for (uint8_t index = 0; index < STEAM_GUARD_CODE_LENGTH; index++)
+	{
+		code[index] = steam_guard_alphabet[full_code % (sizeof (steam_guard_alphabet) - 1)];
+		full_code /= sizeof (steam_guard_alphabet) - 1;
+	}
+
+	code[STEAM_GUARD_CODE_LENGTH] = '\0';
+
+	print_debug_information ("Exiting the function to "
+	                         "generate_steam_guard_code ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : generate_confirmation_key                              *
+ *                                                                           *
+ * Description      : This function generate key of mobile confirmation      *
+ *                    request: base64 HMAC-SHA1 of time and tag keyed by     *
+ *                    identity secret                                        *
+ *                                                                           *
+ * Input values(s)  : identity_secret - base64                               *
+ *                    steam_time - unix time sent along with the key         *
+ *                    tag - "conf", "details", "allow" or "cancel"           *
+ *                                                                           *
+ * Output values(s) : key - CONFIRMATION_KEY_SIZE bytes, not url encoded     *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t generate_confirmation_key (const char *identity_secret, int64_t steam_time,
+                                  const char *tag, char *key)
+{
+	uint8_t hmac[HMAC_SHA1_SIZE] = {0};
+
+	if (compute_guard_hmac (identity_secret, steam_time, tag, strlen (tag),
+	                        hmac) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	base64_encode (hmac, HMAC_SHA1_SIZE, key, NULL);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : generate_device_id                                     *
+ *                                                                           *
+ * Description      : This function generate device id of the mobile         *
+ *                    authenticator as the steam app does:                   *
+ *                    "android:" and SHA-1 of steam id formatted as uuid     *
+ *                                                                           *
+ * Input values(s)  : steam_id                                               *
+ *                                                                           *
+ * Output values(s) : device_id - DEVICE_ID_SIZE bytes                       *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void generate_device_id (const char *steam_id, char *device_id)
+{
+	static const uint8_t groups[] = { 4, 2, 2, 2, 6 };
+	uint8_t digest[SHA_DIGEST_LENGTH] = {0};
+	char *ptr_id = device_id;
+	uint8_t index_byte = 0;
+
+	SHA1 ((const uint8_t *)steam_id, strlen (steam_id), digest);
+
+	ptr_id += sprintf (ptr_id, "android:");
+
+	for (uint8_t group = 0; group < sizeof (groups); group++)
+	{
+		for (uint8_t index = 0; index < groups[group]; index++)
+		{
+			ptr_id += sprintf (ptr_id, "%02x", digest[index_byte++]);
+		}
+
+		if (group + 1 < sizeof (groups))
+			*ptr_id++ = '-';
+	}
+
+	*ptr_id = '\0';
+}
+
+/*===========================================================================*
+ * Function name    : copy_credential                                        *
+ *                                                                           *
+ * Description      : This function copy value, truncating it to the field   *
+ *                                                                           *
+ * Input values(s)  : size_field                                             *
+ *                    value                                                  *
+ *                                                                           *
+ * Output values(s) : field                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void copy_credential (char *field, size_t size_field, const char *value)
+{
+	snprintf (field, size_field, "%s", value);
+}
+
+/*===========================================================================*
+ * Function name    : trim_credential_line                                   *
+ *                                                                           *
+ * Description      : This function remove trailing whitespace and newline   *
+ *                                                                           *
+ * Input values(s)  : line                                                   *
+ *                                                                           *
+ * Output values(s) : line                                                   *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void trim_credential_line (char *line)
+{
+	size_t length = strlen (line);
+
+	while (length > 0 && isspace ((uint8_t)line[length - 1]))
+	{
+		line[--length] = '\0';
+	}
+}
+
+/*===========================================================================*
+ * Function name    : load_steam_credentials                                 *
+ *                                                                           *
+ * Description      : This function read "key=value" lines (login, password, *
+ *                    shared_secret, identity_secret, '#' comments) from the *
+ *                    file, then STEAM_LOGIN, STEAM_PASSWORD,                *
+ *                    STEAM_SHARED_SECRET and STEAM_IDENTITY_SECRET          *
+ *                    environment variables override them                    *
+ *                                                                           *
+ * Input values(s)  : file_name - NULL for STEAM_CREDENTIALS_FILE            *
+ *                                environment variable or default file       *
+ *                                                                           *
+ * Output values(s) : credentials                                            *
+ *                                                                           *
+ * Return value(s)  : SUCCESS when login and password are known/FAILURE      *
+ *===========================================================================*/
+int8_t load_steam_credentials (SteamCredentials *credentials,
+                               const char *file_name)
+{
+	FILE *file = NULL;
+	char line[LOGIN_LENGTH + PASSWORD_LENGTH + STEAM_SECRET_SIZE] = {0};
+	char *ptr_value = NULL;
+	char *ptr_key = NULL;
+	const char *ptr_env = NULL;
+
+	print_debug_information ("Entering the function to "
+	                         "load_steam_credentials ()", __LINE__);
+
+	memset (credentials, 0, sizeof (SteamCredentials));
+
+	if (file_name == NULL)
+	{
+		file_name = getenv ("STEAM_CREDENTIALS_FILE");
+	}
+
+	if (file_name == NULL)
+	{
+		file_name = STEAM_CREDENTIALS_FILE;
+	}
+
+	/* A missing file is fine, everything may come from the environment */
+	file = fopen (file_name, "r");
+
+	while (file != NULL && fgets (line, sizeof (line), file) != NULL)
+	{
+		trim_credential_line (line);
+
+		ptr_key = line;
+
+		while (isspace ((uint8_t)*ptr_key))
+			ptr_key++;
+
+		ptr_value = strchr (ptr_key, '=');
+
+		if (*ptr_key == '#' || ptr_value == NULL)
+			continue;
+
+		*ptr_value++ = '\0';
+		trim_credential_line (ptr_key);
+
+		while (isspace ((uint8_t)*ptr_value))
+			ptr_value++;
+
+		if (strcmp (ptr_key, "login") == 0)
+			copy_credential (credentials->login, LOGIN_LENGTH, ptr_value);
+		else if (strcmp (ptr_key, "password") == 0)
+			copy_credential (credentials->password, PASSWORD_LENGTH, ptr_value);
+		else if (strcmp (ptr_key, "shared_secret") == 0)
+			copy_credential (credentials->shared_secret, STEAM_SECRET_SIZE, ptr_value);
+		else if (strcmp (ptr_key, "identity_secret") == 0)
+			copy_credential (credentials->identity_secret, STEAM_SECRET_SIZE, ptr_value);
+	}
+
+	if (file != NULL)
+	{
+		fclose (file);
+	}
+
+	memset (line, 0, sizeof (line));
+
+	if ((ptr_env = getenv ("STEAM_LOGIN")) != NULL)
+		copy_credential (credentials->login, LOGIN_LENGTH, ptr_env);
+
+	if ((ptr_env = getenv ("STEAM_PASSWORD")) != NULL)
+		copy_credential (credentials->password, PASSWORD_LENGTH, ptr_env);
+
+	if ((ptr_env = getenv ("STEAM_SHARED_SECRET")) != NULL)
+		copy_credential (credentials->shared_secret, STEAM_SECRET_SIZE, ptr_env);
+
+	if ((ptr_env = getenv ("STEAM_IDENTITY_SECRET")) != NULL)
+		copy_credential (credentials->identity_secret, STEAM_SECRET_SIZE, ptr_env);
+
+	print_debug_information ("Exiting the function to "
+	                         "load_steam_credentials ()", __LINE__);
+
+	if (credentials->login[0] == '\0' || credentials->password[0] == '\0')
+	{
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
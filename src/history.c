@@ -0,0 +1,1181 @@
+#include <time.h>
+#include <unistd.h>
+
+#include "../inc/history.h"
+#include "../inc/market.h"
+#include "../inc/steam.h"
+
+/* length, type, row_id, row_sub_id, time_acted, app_id, context_id,
+ * asset_id, price, name length */
+#define RECORD_FIXED_SIZE  (2 + 1 + 8 + 8 + 8 + 4 + 8 + 8 + 4 + 2)
+#define RECORD_MAX_SIZE    (RECORD_FIXED_SIZE + HISTORY_NAME_SIZE)
+#define INDEX_ENTRY_SIZE   (8 + 8)
+#define MAGIC_SIZE         (sizeof (HISTORY_LOG_MAGIC) - 1)
+
+/* Year of rows is not shown by steam, it is carried from newer rows */
+typedef struct tHistoryDate {
+	int32_t  year;
+	uint8_t  month;
+	uint8_t  day;
+} HistoryDate;
+
+typedef struct tHistorySync {
+	HistoryEvent  *events;
+	size_t         count_events;
+	size_t         capacity;
+	size_t         page_begin;
+	size_t         prev_page_begin;
+	HistoryDate    date;
+	int8_t         reached_stored;
+} HistorySync;
+
+static void put_le (uint8_t *, uint64_t, uint8_t);
+static uint64_t get_le (const uint8_t *, uint8_t);
+static size_t encode_history_event (const HistoryEvent *, uint8_t *);
+static size_t read_history_record (FILE *, uint8_t *, HistoryEvent *);
+static int8_t add_history_index_entry (HistoryStore *, int64_t, uint64_t);
+static int8_t load_history_index (HistoryStore *);
+static int8_t scan_history_log (HistoryStore *);
+static int8_t parse_history_date (const char *, size_t, HistoryDate *);
+static const char *find_marker (const char *, const char *, const char *);
+static size_t get_cell_text (const char *, const char *, const char **);
+static const char *find_history_row (const char *, uint64_t *, uint64_t *);
+static void extract_history_row (const char *, const char *, HistoryEvent *,
+                                 HistoryDate *);
+static void apply_history_hovers (HistorySync *, const char *,
+                                  struct json_object *);
+static int8_t parse_history_page (HistorySync *, const HistoryStore *,
+                                  const char *, const char *,
+                                  struct json_object *, size_t *);
+
+/*===========================================================================*
+ * Function name    : put_le                                                 *
+ *                                                                           *
+ * Description      : This function write little-endian integer              *
+ *                                                                           *
+ * Input values(s)  : value                                                  *
+ *                    size - bytes                                           *
+ *                                                                           *
+ * Output values(s) : dst                                                    *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void put_le (uint8_t *dst, uint64_t value, uint8_t size)
+{
+	for (uint8_t index = 0; index < size; index++)
+	{
+		dst[index] = (uint8_t)(value >> (index * 8));
+	}
+}
+
+/*===========================================================================*
+ * Function name    : get_le                                                 *
+ *                                                                           *
+ * Description      : This function read little-endian integer               *
+ *                                                                           *
+ * Input values(s)  : src                                                    *
+ *                    size - bytes                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Value                                                  *
+ *===========================================================================*/
+static uint64_t get_le (const uint8_t *src, uint8_t size)
+{
+	uint64_t value = 0;
+
+	for (uint8_t index = 0; index < size; index++)
+	{
+		value |= (uint64_t)src[index] << (index * 8);
+	}
+
+	return value;
+}
+
+/*===========================================================================*
+ * Function name    : encode_history_event                                   *
+ *                                                                           *
+ * Description      : This function encode event as log record               *
+ *                                                                           *
+ * Input values(s)  : event                                                  *
+ *                                                                           *
+ * Output values(s) : record - at least RECORD_MAX_SIZE bytes                *
+ *                                                                           *
+ * Return value(s)  : Record length                                          *
+ *===========================================================================*/
+static size_t encode_history_event (const HistoryEvent *event, uint8_t *record)
+{
+	size_t name_length = strnlen (event->market_hash_name, HISTORY_NAME_SIZE - 1);
+	size_t length = RECORD_FIXED_SIZE + name_length;
+
+	put_le (record, length, 2);
+	put_le (record + 2, event->event_type, 1);
+	put_le (record + 3, event->row_id, 8);
+	put_le (record + 11, event->row_sub_id, 8);
+	put_le (record + 19, (uint64_t)event->time_acted, 8);
+	put_le (record + 27, event->app_id, 4);
+	put_le (record + 31, event->context_id, 8);
+	put_le (record + 39, event->asset_id, 8);
+	put_le (record + 47, event->price, 4);
+	put_le (record + 51, name_length, 2);
+
+	memcpy (record + RECORD_FIXED_SIZE, event->market_hash_name, name_length);
+
+	return length;
+}
+
+/*===========================================================================*
+ * Function name    : read_history_record                                    *
+ *                                                                           *
+ * Description      : This function read and decode next log record          *
+ *                                                                           *
+ * Input values(s)  : log_file                                               *
+ *                                                                           *
+ * Output values(s) : record - at least RECORD_MAX_SIZE bytes                *
+ *                    event                                                  *
+ *                                                                           *
+ * Return value(s)  : Record length, 0 at the end or on a torn record        *
+ *===========================================================================*/
+static size_t read_history_record (FILE *log_file, uint8_t *record,
+                                   HistoryEvent *event)
+{
+	size_t length = 0;
+	size_t name_length = 0;
+
+	if (fread (record, 1, 2, log_file) != 2)
+	{
+		return 0;
+	}
+
+	length = get_le (record, 2);
+
+	if (length < RECORD_FIXED_SIZE || length >= RECORD_MAX_SIZE ||
+	    fread (record + 2, 1, length - 2, log_file) != length - 2)
+	{
+		return 0;
+	}
+
+	name_length = get_le (record + 51, 2);
+
+	if (RECORD_FIXED_SIZE + name_length != length)
+	{
+		return 0;
+	}
+
+	event->event_type = get_le (record + 2, 1);
+	event->row_id = get_le (record + 3, 8);
+	event->row_sub_id = get_le (record + 11, 8);
+	event->time_acted = (int64_t)get_le (record + 19, 8);
+	event->app_id = get_le (record + 27, 4);
+	event->context_id = get_le (record + 31, 8);
+	event->asset_id = get_le (record + 39, 8);
+	event->price = get_le (record + 47, 4);
+
+	memcpy (event->market_hash_name, record + RECORD_FIXED_SIZE, name_length);
+	event->market_hash_name[name_length] = '\0';
+
+	return length;
+}
+
+/*===========================================================================*
+ * Function name    : add_history_index_entry                                *
+ *                                                                           *
+ * Description      : This function add entry to time index and index file   *
+ *                                                                           *
+ * Input values(s)  : store                                                  *
+ *                    time_acted - time of the event at offset               *
+ *                    offset - log offset of the event                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t add_history_index_entry (HistoryStore *store, int64_t time_acted,
+                                       uint64_t offset)
+{
+	HistoryIndexEntry *ptr_index = NULL;
+	uint8_t entry[INDEX_ENTRY_SIZE];
+
+	if (store->count_index == store->capacity_index)
+	{
+		size_t capacity = store->capacity_index ? store->capacity_index * 2 : 64;
+
+		ptr_index = steam_realloc (store->index, capacity * sizeof (HistoryIndexEntry),
+		                           ALLOC_TAG_MARKET);
+
+		if (ptr_index == NULL)
+		{
+			return FAILURE;
+		}
+
+		store->index = ptr_index;
+		store->capacity_index = capacity;
+	}
+
+	store->index[store->count_index].time_acted = time_acted;
+	store->index[store->count_index].offset = offset;
+	store->count_index++;
+
+	put_le (entry, (uint64_t)time_acted, 8);
+	put_le (entry + 8, offset, 8);
+
+	fseek (store->index_file, 0, SEEK_END);
+
+	if (fwrite (entry, 1, INDEX_ENTRY_SIZE, store->index_file) != INDEX_ENTRY_SIZE)
+	{
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : load_history_index                                     *
+ *                                                                           *
+ * Description      : This function load time index, entries that do not     *
+ *                    match the log are dropped and rebuilt by scan          *
+ *                                                                           *
+ * Input values(s)  : store                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t load_history_index (HistoryStore *store)
+{
+	uint8_t entry[INDEX_ENTRY_SIZE];
+	HistoryIndexEntry *ptr_index = NULL;
+	uint64_t offset = 0;
+	int64_t time_acted = 0;
+
+	rewind (store->index_file);
+
+	while (fread (entry, 1, INDEX_ENTRY_SIZE, store->index_file) == INDEX_ENTRY_SIZE)
+	{
+		time_acted = (int64_t)get_le (entry, 8);
+		offset = get_le (entry + 8, 8);
+
+		if (offset >= store->log_size || offset < MAGIC_SIZE ||
+		    (store->count_index > 0 &&
+		     offset <= store->index[store->count_index - 1].offset))
+		{
+			break;
+		}
+
+		if (store->count_index == store->capacity_index)
+		{
+			size_t capacity = store->capacity_index ? store->capacity_index * 2 : 64;
+
+			ptr_index = steam_realloc (store->index, capacity * sizeof (HistoryIndexEntry),
+			                           ALLOC_TAG_MARKET);
+
+			if (ptr_index == NULL)
+			{
+				return FAILURE;
+			}
+
+			store->index = ptr_index;
+			store->capacity_index = capacity;
+		}
+
+		store->index[store->count_index].time_acted = time_acted;
+		store->index[store->count_index].offset = offset;
+		store->count_index++;
+	}
+
+	fflush (store->index_file);
+
+	if (ftruncate (fileno (store->index_file),
+	               (off_t)(store->count_index * INDEX_ENTRY_SIZE)) != 0)
+	{
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : scan_history_log                                       *
+ *                                                                           *
+ * Description      : This function read log after the last index entry to   *
+ *                    count events and find the newest one. A record torn    *
+ *                    by an interrupted append is cut off                    *
+ *                                                                           *
+ * Input values(s)  : store                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t scan_history_log (HistoryStore *store)
+{
+	uint8_t record[RECORD_MAX_SIZE];
+	HistoryEvent event;
+	uint64_t offset = MAGIC_SIZE;
+	uint64_t number = 0;
+	size_t length = 0;
+
+	if (store->count_index > 0)
+	{
+		offset = store->index[store->count_index - 1].offset;
+		number = (uint64_t)(store->count_index - 1) * HISTORY_INDEX_STRIDE;
+	}
+
+	fseek (store->log_file, (long)offset, SEEK_SET);
+
+	while ((length = read_history_record (store->log_file, record, &event)) != 0)
+	{
+		if (number % HISTORY_INDEX_STRIDE == 0 &&
+		    number / HISTORY_INDEX_STRIDE == store->count_index)
+		{
+			if (add_history_index_entry (store, event.time_acted, offset) != SUCCESS)
+			{
+				return FAILURE;
+			}
+		}
+
+		store->newest_row_id = event.row_id;
+		store->newest_row_sub_id = event.row_sub_id;
+		store->newest_time = event.time_acted;
+
+		offset += length;
+		number++;
+	}
+
+	if (offset < store->log_size)
+	{
+		fflush (store->log_file);
+
+		if (ftruncate (fileno (store->log_file), (off_t)offset) != 0)
+		{
+			return FAILURE;
+		}
+	}
+
+	store->log_size = offset;
+	store->count_events = number;
+
+	fflush (store->index_file);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : open_history_store                                     *
+ *                                                                           *
+ * Description      : This function open (or create) history log and its     *
+ *                    time index                                             *
+ *                                                                           *
+ * Input values(s)  : file_name - log file, index is "<file_name>.idx"       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : History store or NULL                                  *
+ *===========================================================================*/
+HistoryStore *open_history_store (const char *file_name)
+{
+	HistoryStore *store = NULL;
+	char *index_name = NULL;
+	char magic[MAGIC_SIZE];
+	long size = 0;
+
+	print_debug_information ("Entering the function to "
+	                         "open_history_store ()", __LINE__);
+
+	store = steam_calloc (1, sizeof (HistoryStore), ALLOC_TAG_MARKET);
+	index_name = steam_malloc (strlen (file_name) + sizeof (".idx"),
+	                           ALLOC_TAG_MARKET);
+
+	if (store == NULL || index_name == NULL)
+	{
+		steam_free (store);
+		steam_free (index_name);
+
+		return NULL;
+	}
+
+	sprintf (index_name, "%s.idx", file_name);
+
+	store->log_file = fopen (file_name, "a+b");
+	store->index_file = fopen (index_name, "a+b");
+
+	steam_free (index_name);
+
+	if (store->log_file == NULL || store->index_file == NULL)
+	{
+		close_history_store (store);
+
+		return NULL;
+	}
+
+	fseek (store->log_file, 0, SEEK_END);
+	size = ftell (store->log_file);
+
+	if (size == 0)
+	{
+		fwrite (HISTORY_LOG_MAGIC, 1, MAGIC_SIZE, store->log_file);
+
+		if (fflush (store->log_file) != 0)
+		{
+			close_history_store (store);
+
+			return NULL;
+		}
+
+		size = MAGIC_SIZE;
+	}
+	else
+	{
+		rewind (store->log_file);
+
+		if (fread (magic, 1, MAGIC_SIZE, store->log_file) != MAGIC_SIZE ||
+		    memcmp (magic, HISTORY_LOG_MAGIC, MAGIC_SIZE) != 0)
+		{
+			close_history_store (store);
+
+			return NULL;
+		}
+	}
+
+	store->log_size = size;
+
+	if (load_history_index (store) != SUCCESS || scan_history_log (store) != SUCCESS)
+	{
+		close_history_store (store);
+
+		return NULL;
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "open_history_store ()", __LINE__);
+
+	return store;
+}
+
+/*===========================================================================*
+ * Function name    : close_history_store                                    *
+ *                                                                           *
+ * Description      : This function close history store                      *
+ *                                                                           *
+ * Input values(s)  : store                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void close_history_store (HistoryStore *store)
+{
+	if (store == NULL)
+		return;
+
+	if (store->log_file != NULL)
+		fclose (store->log_file);
+
+	if (store->index_file != NULL)
+		fclose (store->index_file);
+
+	steam_free (store->index);
+	steam_free (store);
+}
+
+/*===========================================================================*
+ * Function name    : append_history_events                                  *
+ *                                                                           *
+ * Description      : This function append events to the end of the log,     *
+ *                    events must be ordered from oldest to newest           *
+ *                                                                           *
+ * Input values(s)  : store                                                  *
+ *                    events                                                 *
+ *                    count_events                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t append_history_events (HistoryStore *store, const HistoryEvent *events,
+                              size_t count_events)
+{
+	uint8_t record[RECORD_MAX_SIZE];
+	size_t length = 0;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "append_history_events ()", __LINE__);
+
+	for (size_t index = 0; index < count_events && return_value == SUCCESS; index++)
+	{
+		if (store->count_events % HISTORY_INDEX_STRIDE == 0)
+		{
+			return_value = add_history_index_entry (store, events[index].time_acted,
+			                                        store->log_size);
+		}
+
+		length = encode_history_event (&events[index], record);
+
+		fseek (store->log_file, 0, SEEK_END);
+
+		if (fwrite (record, 1, length, store->log_file) != length)
+		{
+			return_value = FAILURE;
+			break;
+		}
+
+		store->log_size += length;
+		store->count_events++;
+		store->newest_row_id = events[index].row_id;
+		store->newest_row_sub_id = events[index].row_sub_id;
+		store->newest_time = events[index].time_acted;
+	}
+
+	if (fflush (store->log_file) != 0 || fflush (store->index_file) != 0)
+	{
+		return_value = FAILURE;
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "append_history_events ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : visit_history_events                                   *
+ *                                                                           *
+ * Description      : This function call visitor for stored events within    *
+ *                    time range, the index gives where to start reading     *
+ *                                                                           *
+ * Input values(s)  : store                                                  *
+ *                    time_from - first day (inclusive)                      *
+ *                    time_to - last day (inclusive)                         *
+ *                    visitor - FAILURE stops visiting                       *
+ *                    user_data                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t visit_history_events (HistoryStore *store, int64_t time_from,
+                             int64_t time_to, HistoryEventVisitor visitor,
+                             void *user_data)
+{
+	uint8_t record[RECORD_MAX_SIZE];
+	HistoryEvent event;
+	uint64_t offset = MAGIC_SIZE;
+	size_t low = 0;
+	size_t high = store->count_index;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "visit_history_events ()", __LINE__);
+
+	/* Last index entry strictly before time_from, events of the same day
+	 * may precede an entry */
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+
+		if (store->index[middle].time_acted < time_from)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	if (low > 0)
+		offset = store->index[low - 1].offset;
+
+	fflush (store->log_file);
+	fseek (store->log_file, (long)offset, SEEK_SET);
+
+	while (read_history_record (store->log_file, record, &event) != 0)
+	{
+		if (event.time_acted > time_to)
+			break;
+
+		if (event.time_acted < time_from)
+			continue;
+
+		if (visitor (&event, user_data) != SUCCESS)
+		{
+			return_value = FAILURE;
+			break;
+		}
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "visit_history_events ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : parse_history_date                                     *
+ *                                                                           *
+ * Description      : This function parse "18 Oct", "Oct 18" or              *
+ *                    "18 Oct, 2019". Without a year, a date after the       *
+ *                    previous (newer) row belongs to the year before        *
+ *                                                                           *
+ * Input values(s)  : text                                                   *
+ *                    length                                                 *
+ *                    date - date of the previous row                        *
+ *                                                                           *
+ * Output values(s) : date                                                   *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t parse_history_date (const char *text, size_t length,
+                                  HistoryDate *date)
+{
+	const char *end = text + length;
+	uint32_t number = 0;
+	uint32_t year = 0;
+	uint8_t month = 0;
+	uint8_t day = 0;
+
+	while (text < end)
+	{
+		if (isdigit ((uint8_t)*text))
+		{
+			for (number = 0; text < end && isdigit ((uint8_t)*text); text++)
+				number = number * 10 + (*text - '0');
+
+			if (number > 31)
+				year = number;
+			else
+				day = number;
+		}
+		else if (isalpha ((uint8_t)*text))
+		{
+			if (month == 0 && end - text >= 3)
+				month = parse_month_name (text);
+
+			while (text < end && isalpha ((uint8_t)*text))
+				text++;
+		}
+		else
+		{
+			text++;
+		}
+	}
+
+	if (day == 0 || month == 0)
+	{
+		return FAILURE;
+	}
+
+	if (year != 0)
+	{
+		date->year = year;
+	}
+	else if (month > date->month || (month == date->month && day > date->day))
+	{
+		date->year--;
+	}
+
+	date->month = month;
+	date->day = day;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : find_marker                                            *
+ *                                                                           *
+ * Description      : This function find marker within [start, end)          *
+ *                                                                           *
+ * Input values(s)  : start                                                  *
+ *                    end                                                    *
+ *                    marker                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Pointer after marker or NULL                           *
+ *===========================================================================*/
+static const char *find_marker (const char *start, const char *end,
+                                const char *marker)
+{
+	size_t marker_length = strlen (marker);
+
+	if (start == NULL)
+	{
+		return NULL;
+	}
+
+	while (start + marker_length <= end &&
+	       (start = memchr (start, *marker, end - start - marker_length + 1)) != NULL)
+	{
+		if (memcmp (start, marker, marker_length) == STRINGS_EQUAL)
+			return start + marker_length;
+
+		start++;
+	}
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : get_cell_text                                          *
+ *                                                                           *
+ * Description      : This function get trimmed text after the end of the    *
+ *                    tag containing start                                   *
+ *                                                                           *
+ * Input values(s)  : start                                                  *
+ *                    end                                                    *
+ *                                                                           *
+ * Output values(s) : text                                                   *
+ *                                                                           *
+ * Return value(s)  : Text length                                            *
+ *===========================================================================*/
+static size_t get_cell_text (const char *start, const char *end,
+                             const char **text)
+{
+	const char *text_end = NULL;
+
+	start = find_marker (start, end, ">");
+
+	if (start == NULL)
+	{
+		return 0;
+	}
+
+	while (start < end && isspace ((uint8_t)*start))
+		start++;
+
+	for (text_end = start; text_end < end && *text_end != '<'; text_end++);
+
+	while (text_end > start && isspace ((uint8_t)text_end[-1]))
+		text_end--;
+
+	*text = start;
+
+	return text_end - start;
+}
+
+/*===========================================================================*
+ * Function name    : find_history_row                                       *
+ *                                                                           *
+ * Description      : This function find next id="history_row_<id>_<id>"     *
+ *                    (ids of row children have a suffix and are skipped)    *
+ *                                                                           *
+ * Input values(s)  : html                                                   *
+ *                                                                           *
+ * Output values(s) : row_id                                                 *
+ *                    row_sub_id                                             *
+ *                                                                           *
+ * Return value(s)  : Start of row or NULL                                   *
+ *===========================================================================*/
+static const char *find_history_row (const char *html, uint64_t *row_id,
+                                     uint64_t *row_sub_id)
+{
+	static const char marker[] = "id=\"history_row_";
+	const char *row = html;
+	char *end = NULL;
+
+	while ((row = strstr (row, marker)) != NULL)
+	{
+		const char *ids = row + sizeof (marker) - 1;
+
+		*row_id = strtoull (ids, &end, 10);
+
+		if (end != ids && *end == '_')
+		{
+			ids = end + 1;
+			*row_sub_id = strtoull (ids, &end, 10);
+
+			if (end != ids && *end == '"')
+			{
+				return row;
+			}
+		}
+
+		row = ids;
+	}
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : extract_history_row                                    *
+ *                                                                           *
+ * Description      : This function extract event fields shown in html row   *
+ *                                                                           *
+ * Input values(s)  : row                                                    *
+ *                    row_end                                                *
+ *                    date - date of the previous row                        *
+ *                                                                           *
+ * Output values(s) : event                                                  *
+ *                    date                                                   *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void extract_history_row (const char *row, const char *row_end,
+                                 HistoryEvent *event, HistoryDate *date)
+{
+	const char *cell = NULL;
+	const char *text = NULL;
+	size_t length = 0;
+	char gain_or_loss = '\0';
+
+	cell = find_marker (row, row_end, "market_listing_gainorloss");
+
+	if (cell != NULL && get_cell_text (cell, row_end, &text) > 0)
+		gain_or_loss = *text;
+
+	cell = find_marker (row, row_end, "market_listing_price");
+
+	if (cell != NULL && (length = get_cell_text (cell, row_end, &text)) > 0)
+		parse_price_text (text, length, &event->price);
+
+	/* The first date is when the event happened, the second when listed */
+	cell = find_marker (row, row_end, "market_listing_listed_date");
+
+	if (cell != NULL && (length = get_cell_text (cell, row_end, &text)) > 0 &&
+	    parse_history_date (text, length, date) == SUCCESS)
+	{
+		event->time_acted = days_from_civil (date->year, date->month,
+		                                     date->day) * 86400;
+	}
+
+	cell = find_marker (row, row_end, "market_listing_item_name\"");
+
+	if (cell != NULL && (length = get_cell_text (cell, row_end, &text)) > 0)
+	{
+		if (length >= HISTORY_NAME_SIZE)
+			length = HISTORY_NAME_SIZE - 1;
+
+		memcpy (event->market_hash_name, text, length);
+		event->market_hash_name[length] = '\0';
+	}
+
+	cell = find_marker (row, row_end, "market_listing_whoactedwith");
+
+	if (find_marker (cell, row_end, "Listing created") != NULL)
+		event->event_type = HISTORY_EVENT_LISTED;
+	else if (find_marker (cell, row_end, "Listing cancel") != NULL)
+		event->event_type = HISTORY_EVENT_CANCELED;
+	else if (find_marker (cell, row_end, "Buyer:") != NULL || gain_or_loss == '+')
+		event->event_type = HISTORY_EVENT_SOLD;
+	else if (find_marker (cell, row_end, "Seller:") != NULL || gain_or_loss == '-')
+		event->event_type = HISTORY_EVENT_PURCHASED;
+	else
+		event->event_type = HISTORY_EVENT_UNKNOWN;
+}
+
+/*===========================================================================*
+ * Function name    : apply_history_hovers                                   *
+ *                                                                           *
+ * Description      : This function link events of page to their assets      *
+ *                    through CreateItemHoverFromContainer() calls of        *
+ *                    hovers script and take market_hash_name from assets    *
+ *                                                                           *
+ * Input values(s)  : sync                                                   *
+ *                    hovers                                                 *
+ *                    json_assets - assets[app_id][context_id][asset_id]     *
+ *                                                                           *
+ * Output values(s) : sync                                                   *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void apply_history_hovers (HistorySync *sync, const char *hovers,
+                                  struct json_object *json_assets)
+{
+	static const char marker[] = "'history_row_";
+	struct json_object *json_app = NULL;
+	struct json_object *json_context = NULL;
+	struct json_object *json_asset = NULL;
+	struct json_object *json_name = NULL;
+	HistoryEvent *event = NULL;
+	const char *hover = hovers;
+	char *end = NULL;
+	char key[32] = {0};
+	unsigned long long context_id = 0;
+	unsigned long long asset_id = 0;
+	unsigned int app_id = 0;
+	uint64_t row_id = 0;
+	uint64_t row_sub_id = 0;
+	size_t count_page = sync->count_events - sync->page_begin;
+	size_t cursor = 0;
+
+	if (hovers == NULL || count_page == 0)
+	{
+		return;
+	}
+
+	while ((hover = strstr (hover, marker)) != NULL)
+	{
+		hover += sizeof (marker) - 1;
+
+		row_id = strtoull (hover, &end, 10);
+
+		if (*end != '_')
+			continue;
+
+		row_sub_id = strtoull (end + 1, &end, 10);
+
+		if (strncmp (end, "_name'", 6) != STRINGS_EQUAL ||
+		    sscanf (end + 6, " , %u , '%llu' , '%llu'", &app_id, &context_id,
+		            &asset_id) != 3)
+		{
+			continue;
+		}
+
+		/* Hovers follow the order of rows, so the search rarely wraps */
+		event = NULL;
+
+		for (size_t step = 0; step < count_page; step++)
+		{
+			HistoryEvent *candidate = &sync->events[sync->page_begin +
+			                                        (cursor + step) % count_page];
+
+			if (candidate->row_id == row_id && candidate->row_sub_id == row_sub_id)
+			{
+				event = candidate;
+				cursor = (cursor + step + 1) % count_page;
+				break;
+			}
+		}
+
+		if (event == NULL)
+			continue;
+
+		event->app_id = app_id;
+		event->context_id = context_id;
+		event->asset_id = asset_id;
+
+		snprintf (key, sizeof (key), "%u", app_id);
+
+		if (json_assets == NULL ||
+		    json_object_object_get_ex (json_assets, key, &json_app) == 0)
+			continue;
+
+		snprintf (key, sizeof (key), "%llu", context_id);
+
+		if (json_object_object_get_ex (json_app, key, &json_context) == 0)
+			continue;
+
+		snprintf (key, sizeof (key), "%llu", asset_id);
+
+		if (json_object_object_get_ex (json_context, key, &json_asset) &&
+		    json_object_object_get_ex (json_asset, "market_hash_name", &json_name))
+		{
+			snprintf (event->market_hash_name, sizeof (event->market_hash_name),
+			          "%s", json_object_get_string (json_name));
+		}
+	}
+}
+
+/*===========================================================================*
+ * Function name    : parse_history_page                                     *
+ *                                                                           *
+ * Description      : This function collect events of one page (newest       *
+ *                    first) until the newest stored event is reached        *
+ *                                                                           *
+ * Input values(s)  : sync                                                   *
+ *                    store                                                  *
+ *                    results_html                                           *
+ *                    hovers                                                 *
+ *                    json_assets                                            *
+ *                                                                           *
+ * Output values(s) : sync                                                   *
+ *                    count_rows - rows on the page                          *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t parse_history_page (HistorySync *sync, const HistoryStore *store,
+                                  const char *results_html, const char *hovers,
+                                  struct json_object *json_assets,
+                                  size_t *count_rows)
+{
+	HistoryEvent *ptr_events = NULL;
+	HistoryEvent *event = NULL;
+	const char *row = NULL;
+	const char *next_row = NULL;
+	uint64_t row_id = 0;
+	uint64_t row_sub_id = 0;
+	uint64_t next_row_id = 0;
+	uint64_t next_row_sub_id = 0;
+	int8_t duplicate = 0;
+
+	*count_rows = 0;
+
+	sync->prev_page_begin = sync->page_begin;
+	sync->page_begin = sync->count_events;
+
+	row = find_history_row (results_html, &row_id, &row_sub_id);
+
+	for (; row != NULL; row = next_row, row_id = next_row_id,
+	                    row_sub_id = next_row_sub_id)
+	{
+		next_row = find_history_row (row + 1, &next_row_id, &next_row_sub_id);
+
+		(*count_rows)++;
+
+		if (store->count_events > 0 && row_id == store->newest_row_id &&
+		    row_sub_id == store->newest_row_sub_id)
+		{
+			sync->reached_stored = 1;
+			break;
+		}
+
+		if (sync->count_events == sync->capacity)
+		{
+			size_t capacity = sync->capacity ? sync->capacity * 2 : HISTORY_PAGE_SIZE;
+
+			ptr_events = steam_realloc (sync->events, capacity * sizeof (HistoryEvent),
+			                            ALLOC_TAG_MARKET);
+
+			if (ptr_events == NULL)
+			{
+				return FAILURE;
+			}
+
+			sync->events = ptr_events;
+			sync->capacity = capacity;
+		}
+
+		event = &sync->events[sync->count_events];
+
+		memset (event, 0, sizeof (HistoryEvent));
+
+		event->row_id = row_id;
+		event->row_sub_id = row_sub_id;
+
+		extract_history_row (row, next_row != NULL ? next_row : row + strlen (row),
+		                     event, &sync->date);
+
+		/* New events shift rows down while paging, the tail of the previous
+		 * page shows up again */
+		duplicate = 0;
+
+		for (size_t index = sync->prev_page_begin; index < sync->page_begin; index++)
+		{
+			if (sync->events[index].row_id == row_id &&
+			    sync->events[index].row_sub_id == row_sub_id)
+			{
+				duplicate = 1;
+				break;
+			}
+		}
+
+		if (duplicate == 0)
+			sync->count_events++;
+	}
+
+	apply_history_hovers (sync, hovers, json_assets);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : sync_market_history                                    *
+ *                                                                           *
+ * Description      : This function page market history from the newest      *
+ *                    event back to the newest stored one and append the     *
+ *                    new events. Nothing is appended unless that point (or  *
+ *                    the end of history) was reached, so a failed sync      *
+ *                    never leaves a gap behind the stored events            *
+ *                                                                           *
+ * Input values(s)  : store                                                  *
+ *                                                                           *
+ * Output values(s) : count_new_events (optional parameter)                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t sync_market_history (HistoryStore *store, uint64_t *count_new_events)
+{
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_html = NULL;
+	struct json_object *json_hovers = NULL;
+	struct json_object *json_assets = NULL;
+	HistorySync sync;
+	HistoryEvent swap_event;
+	struct tm now_tm;
+	time_t now = time (NULL);
+	char *ptr_data = NULL;
+	uint64_t total_count = 0;
+	uint32_t start = 0;
+	size_t count_rows = 0;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "sync_market_history ()", __LINE__);
+
+	memset (&sync, 0, sizeof (sync));
+
+	gmtime_r (&now, &now_tm);
+
+	sync.date.year = now_tm.tm_year + 1900;
+	sync.date.month = now_tm.tm_mon + 1;
+	sync.date.day = now_tm.tm_mday;
+
+	if (count_new_events != NULL)
+		*count_new_events = 0;
+
+	while (sync.reached_stored == 0)
+	{
+		ptr_data = get_market_history (HISTORY_PAGE_SIZE, start);
+
+		if (ptr_data == NULL)
+		{
+			return_value = FAILURE;
+			break;
+		}
+
+		parsed_json = parse_json_response (ptr_data);
+
+		steam_free (ptr_data);
+
+		if (parsed_json == NULL ||
+		    json_object_object_get_ex (parsed_json, "results_html", &json_html) == 0)
+		{
+			json_object_put (parsed_json);
+			return_value = FAILURE;
+			break;
+		}
+
+		get_json_object_as_uint64 (&total_count, parsed_json, "total_count");
+
+		if (json_object_object_get_ex (parsed_json, "hovers", &json_hovers) == 0)
+			json_hovers = NULL;
+
+		if (json_object_object_get_ex (parsed_json, "assets", &json_assets) == 0)
+			json_assets = NULL;
+
+		return_value = parse_history_page (&sync, store,
+		                                   json_object_get_string (json_html),
+		                                   json_hovers != NULL ?
+		                                   json_object_get_string (json_hovers) : NULL,
+		                                   json_assets, &count_rows);
+
+		json_object_put (parsed_json);
+
+		if (return_value != SUCCESS)
+			break;
+
+		start += HISTORY_PAGE_SIZE;
+
+		if (count_rows == 0 || start >= total_count)
+			break;
+	}
+
+	if (return_value == SUCCESS && sync.count_events > 0)
+	{
+		for (size_t index = 0; index < sync.count_events / 2; index++)
+		{
+			swap_event = sync.events[index];
+			sync.events[index] = sync.events[sync.count_events - 1 - index];
+			sync.events[sync.count_events - 1 - index] = swap_event;
+		}
+
+		return_value = append_history_events (store, sync.events, sync.count_events);
+
+		if (return_value == SUCCESS && count_new_events != NULL)
+			*count_new_events = sync.count_events;
+	}
+
+	steam_free (sync.events);
+
+	print_debug_information ("Exiting the function to "
+	                         "sync_market_history ()", __LINE__);
+
+	return return_value;
+}
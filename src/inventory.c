@@ -1,7 +1,17 @@
 #include "../inc/inventory.h"
+#include "../inc/description_cache.h"
 #include "../inc/steam.h"
 
+/* Inventory being loaded by get_inventory_items () */
+typedef struct tInventoryCollector {
+	SteamInventory  *steam_inventory;
+	uint64_t         capacity;
+} InventoryCollector;
+
 static char *get_inventory (char *, char *, char *);
+static uint64_t parse_inventory_page (struct json_object *, InventoryItem *);
+static int8_t collect_inventory_page (InventoryItem *, uint64_t, void *);
+static int8_t export_inventory_page (InventoryItem *, uint64_t, void *);
 
 /*===========================================================================*
  * Function name    : get_inventory                                          *
@@ -29,8 +39,9 @@ static char *get_inventory (char *inventory_id, char *count_items,
 	          "inventory/%s/753/6?l=russian&count=%s&start_assetid=%s",
 	          inventory_id, count_items, last_asset_id);
 
+	/* Browser opens the inventory from the owner's profile page */
 	snprintf (steam_url_referer, sizeof (steam_url_referer),
-	          URL_STEAM_COMMUNITY "profiles/%s/inventory/", g_steam_id);
+	          URL_STEAM_COMMUNITY "profiles/%s/inventory/", inventory_id);
 
 	print_debug_information ("Exiting the function to "
 	                         "get_inventory ()", __LINE__);
@@ -38,6 +49,30 @@ static char *get_inventory (char *inventory_id, char *count_items,
 	return curl_general_request (steam_url, steam_url_referer, NULL, 0);
 }
 
+/*===========================================================================*
+ * Function name    : free_inventory_items                                   *
+ *                                                                           *
+ * Description      : This function free memory owned by inventory items,    *
+ *                    the array itself is not freed                          *
+ *                                                                           *
+ * Input values(s)  : inventory_items                                        *
+ *                    count_items                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_inventory_items (InventoryItem *inventory_items, uint64_t count_items)
+{
+	for (uint64_t index = 0; index < count_items; index++)
+	{
+		release_description_name (inventory_items[index].market_hash_name);
+
+		/* Ids share the block of app_id, see parse_inventory_item () */
+		steam_free (inventory_items[index].app_id);
+	}
+}
+
 /*===========================================================================*
  * Function name    : free_steam_inventory                                   *
  *                                                                           *
@@ -55,20 +90,13 @@ void free_steam_inventory (SteamInventory *steam_inventory)
 	     ptr_steam_inventory != NULL;
 	     ptr_steam_inventory = ptr_steam_inventory->next_steam_inventory)
 	{
-		for (uint16_t index = 0; index < steam_inventory->count_items; index++)
-		{
-			free (ptr_steam_inventory->inventory_items[index].market_hash_name);
-			free (ptr_steam_inventory->inventory_items[index].class_id);
-			free (ptr_steam_inventory->inventory_items[index].app_id);
-			free (ptr_steam_inventory->inventory_items[index].context_id);
-			free (ptr_steam_inventory->inventory_items[index].asset_id);
-			free (ptr_steam_inventory->inventory_items[index].instance_id);
-		}
+		free_inventory_items (ptr_steam_inventory->inventory_items,
+		                      ptr_steam_inventory->count_items);
 
-		free (ptr_steam_inventory->inventory_items);
+		steam_free (ptr_steam_inventory->inventory_items);
 	}
 
-	free (steam_inventory);
+	steam_free (steam_inventory);
 }
 
 /*===========================================================================*
@@ -84,193 +112,469 @@ void free_steam_inventory (SteamInventory *steam_inventory)
  *===========================================================================*/
 void print_steam_inventory (SteamInventory *steam_inventory)
 {
-	for (SteamInventory *ptr_steam_inventory = steam_inventory;
-	     ptr_steam_inventory != NULL;
-	     ptr_steam_inventory = ptr_steam_inventory->next_steam_inventory)
-	{
-		for (uint16_t index = 0; index < steam_inventory->count_items; index++)
-		{
-			printf ("\nmarket_hash_name: %s\n",
-			        ptr_steam_inventory->inventory_items[index].market_hash_name);
-			printf ("class_id: %s\n",
-			        ptr_steam_inventory->inventory_items[index].class_id);
-			printf ("app_id: %s\n",
-			        ptr_steam_inventory->inventory_items[index].app_id);
-			printf ("context_id: %s\n",
-			        ptr_steam_inventory->inventory_items[index].context_id);
-			printf ("asset_id: %s\n",
-			        ptr_steam_inventory->inventory_items[index].asset_id);
-			printf ("instance_id: %s\n",
-			        ptr_steam_inventory->inventory_items[index].instance_id);
-			printf ("marketable: %d\n",
-			         ptr_steam_inventory->inventory_items[index].marketable);
-		}
+	ExportSink *sink = NULL;
 
-		printf ("\ncount_items: %d\n", ptr_steam_inventory->count_items);
+	sink = open_export_sink (NULL, EXPORT_FORMAT_TEXT);
+
+	if (sink == NULL)
+	{
+		return;
 	}
+
+	export_steam_inventory (sink, steam_inventory);
+	close_export_sink (sink);
 }
 
 /*===========================================================================*
- * Function name    : get_inventory_items                                    *
+ * Function name    : cache_item_descriptions                                *
  *                                                                           *
- * Description      : This function get inventory items                      *
+ * Description      : This function add item descriptions to the shared      *
+ *                    cache. Descriptions are resent with every page and     *
+ *                    every call, only the ones missing from the cache are   *
+ *                    parsed                                                 *
  *                                                                           *
- * Input values(s)  : inventory_id                                           *
+ * Input values(s)  : json_descriptions - array of descriptions              *
  *                                                                           *
  * Output values(s) : None.                                                  *
  *                                                                           *
  * Return value(s)  : None.                                                  *
  *===========================================================================*/
-SteamInventory *get_inventory_items (char *inventory_id)
+void cache_item_descriptions (struct json_object *json_descriptions)
 {
-	struct json_object *parsed_json = NULL;
-	struct json_object *json_assets = NULL;
-	struct json_object *json_descriptions = NULL;
 	struct json_object *json_marketable = NULL;
-	struct json_object *json_asset_entry = NULL;
 	struct json_object *json_descriptions_entry = NULL;
 	struct json_object *json_class_id = NULL;
 	struct json_object *json_instance_id = NULL;
-	char *ptr_class_id = NULL;
-	char *ptr_instance_id = NULL;
+	struct json_object *json_app_id = NULL;
+	struct json_object *json_market_hash_name = NULL;
 	char *ptr_marketable = NULL;
-	char *ptr_data = NULL;
-	char *ptr_last_asset_id = NULL;
-	char *ptr_total_inventory_count = NULL;
-	char  last_asset_id[32] = {0};
-	int8_t return_value = FAILURE;
-	uint32_t size_assets_table = 0;
-	uint32_t start_assets_index = 0;
-	uint32_t count_all_items = 0;
-	uint32_t size_descriptions_table = 0;
-	uint32_t tmp_index = 0;
-	uint32_t total_inventory_count = 0;
-	InventoryItem *inventory_items = NULL;
-	SteamInventory *steam_inventory = NULL;
+	uint64_t size_descriptions_table = 0;
+	uint32_t app_id = 0;
+	uint64_t class_id = 0;
+	uint64_t instance_id = 0;
 
-	print_debug_information ("Entering the function to "
-	                         "get_inventory_items ()", __LINE__);
+	size_descriptions_table = json_object_array_length (json_descriptions);
 
-	snprintf (last_asset_id, sizeof (last_asset_id), "0");
+	for (uint64_t index_item = 0; index_item < size_descriptions_table; index_item++)
+	{
+		json_descriptions_entry = json_object_array_get_idx (json_descriptions, index_item);
 
-	ptr_data = get_inventory (inventory_id, MAX_COUNT_LOAD_ITEMS, last_asset_id);
+		json_object_object_get_ex (json_descriptions_entry, "appid", &json_app_id);
+		json_object_object_get_ex (json_descriptions_entry, "classid", &json_class_id);
+		json_object_object_get_ex (json_descriptions_entry, "instanceid", &json_instance_id);
 
-	parsed_json = json_tokener_parse (ptr_data);
+		if (json_app_id == NULL || json_class_id == NULL || json_instance_id == NULL)
+		{
+			continue;
+		}
 
-	free (ptr_data);
+		app_id = strtoul (json_object_get_string (json_app_id), NULL, 10);
+		class_id = strtoull (json_object_get_string (json_class_id), NULL, 10);
+		instance_id = strtoull (json_object_get_string (json_instance_id), NULL, 10);
 
-	get_json_object_as_string (&ptr_total_inventory_count,
-	                           parsed_json,
-	                           "total_inventory_count");
+		if (description_cache_contains (app_id, class_id, instance_id) == STR_FOUND)
+		{
+			continue;
+		}
 
-	total_inventory_count = atoi (ptr_total_inventory_count);
+		json_object_object_get_ex (json_descriptions_entry, "marketable", &json_marketable);
+		json_object_object_get_ex (json_descriptions_entry, "market_hash_name",
+		                           &json_market_hash_name);
 
-	free (ptr_total_inventory_count);
+		ptr_marketable = (char *)json_object_get_string (json_marketable);
 
-	inventory_items = calloc (total_inventory_count, sizeof (InventoryItem));
-	steam_inventory = calloc (1, sizeof (SteamInventory));
+		description_cache_insert (app_id, class_id, instance_id,
+		                          json_object_get_string (json_market_hash_name),
+		                          (ptr_marketable != NULL &&
+		                           strcmp (ptr_marketable, "1") == STRINGS_EQUAL) ?
+		                          MARKETABLE_TRUE : MARKETABLE_FALSE);
+	}
+}
 
-	do
+/*===========================================================================*
+ * Function name    : parse_inventory_item                                   *
+ *                                                                           *
+ * Description      : This function fill inventory item from asset, name and *
+ *                    marketable flag come from the description cache. Ids   *
+ *                    are read as views of the parsed json and copied into   *
+ *                    one block starting at app_id                           *
+ *                                                                           *
+ * Input values(s)  : json_asset                                             *
+ *                                                                           *
+ * Output values(s) : inventory_item - free by free_inventory_items ()       *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE when ids are missing                   *
+ *===========================================================================*/
+int8_t parse_inventory_item (struct json_object *json_asset,
+                             InventoryItem *inventory_item)
+{
+	static const char *id_names[] = { "appid", "contextid", "assetid",
+	                                  "classid", "instanceid" };
+	StringView ids[5];
+	char **ptr_ids[5] = { &inventory_item->app_id, &inventory_item->context_id,
+	                      &inventory_item->asset_id, &inventory_item->class_id,
+	                      &inventory_item->instance_id };
+	char *ptr_block = NULL;
+	size_t size_block = 0;
+	uint64_t app_id = 0;
+	uint64_t class_id = 0;
+	uint64_t instance_id = 0;
+
+	for (size_t index = 0; index < 5; index++)
 	{
-		if (start_assets_index > 0)
+		if (get_json_object_as_view (&ids[index], json_asset,
+		                             (char *)id_names[index]) != SUCCESS)
 		{
-			ptr_data = get_inventory (inventory_id, MAX_COUNT_LOAD_ITEMS, last_asset_id);
-			parsed_json = json_tokener_parse (ptr_data);
-			free (ptr_data);
+			ids[index].data = NULL;
+			ids[index].length = 0;
 		}
 
-		json_object_object_get_ex (parsed_json, "assets", &json_assets);
-		json_object_object_get_ex (parsed_json, "descriptions", &json_descriptions);
+		size_block += ids[index].length + 1;
+	}
+
+	if (parse_string_view_as_uint64 (&ids[0], &app_id) != SUCCESS ||
+	    parse_string_view_as_uint64 (&ids[3], &class_id) != SUCCESS ||
+	    parse_string_view_as_uint64 (&ids[4], &instance_id) != SUCCESS)
+	{
+		return FAILURE;
+	}
 
-		return_value = get_json_object_as_string (&ptr_last_asset_id,
-		                                          parsed_json,
-		                                          "last_assetid");
+	ptr_block = steam_malloc (size_block, ALLOC_TAG_INVENTORY);
+
+	if (ptr_block == NULL)
+	{
+		return FAILURE;
+	}
+
+	/* One allocation per item instead of one per id */
+	for (size_t index = 0; index < 5; index++)
+	{
+		if (ids[index].data != NULL)
+			memcpy (ptr_block, ids[index].data, ids[index].length);
+
+		ptr_block[ids[index].length] = '\0';
+		*ptr_ids[index] = ptr_block;
+		ptr_block += ids[index].length + 1;
+	}
 
-		if (ptr_last_asset_id != NULL && return_value == SUCCESS)
+	description_cache_lookup ((uint32_t)app_id, class_id, instance_id,
+	                          &inventory_item->market_hash_name,
+	                          &inventory_item->marketable);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : parse_inventory_page                                   *
+ *                                                                           *
+ * Description      : This function parse one inventory page: descriptions   *
+ *                    go to the shared cache, assets to inventory items      *
+ *                                                                           *
+ * Input values(s)  : parsed_json                                            *
+ *                    inventory_items - room for all assets of the page      *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Count items                                            *
+ *===========================================================================*/
+static uint64_t parse_inventory_page (struct json_object *parsed_json,
+                                      InventoryItem *inventory_items)
+{
+	struct json_object *json_assets = NULL;
+	struct json_object *json_descriptions = NULL;
+	uint64_t size_assets_table = 0;
+	uint64_t count_items = 0;
+
+	json_object_object_get_ex (parsed_json, "assets", &json_assets);
+	json_object_object_get_ex (parsed_json, "descriptions", &json_descriptions);
+
+	size_assets_table = json_object_array_length (json_assets);
+
+	cache_item_descriptions (json_descriptions);
+
+	for (uint64_t index_item = 0; index_item < size_assets_table; index_item++)
+	{
+		/* Assets without ids are dropped, the rest move up */
+		if (parse_inventory_item (json_object_array_get_idx (json_assets, index_item),
+		                          &inventory_items[count_items]) == SUCCESS)
+		{
+			count_items++;
+		}
+		else
 		{
-			memset (last_asset_id, 0, 32);
-			strncpy (last_asset_id, ptr_last_asset_id, 32);
-			free (ptr_last_asset_id);
+			memset (&inventory_items[count_items], 0, sizeof (InventoryItem));
 		}
+	}
 
-		size_assets_table = json_object_array_length (json_assets);
+	return count_items;
+}
 
-		count_all_items += size_assets_table;
+/*===========================================================================*
+ * Function name    : visit_inventory_items                                  *
+ *                                                                           *
+ * Description      : This function get inventory page by page and pass      *
+ *                    every page to visitor. Only one page is kept in        *
+ *                    memory. Items still owned by the page are freed after  *
+ *                    visitor returns; a visitor keeps an item by copying    *
+ *                    it and zeroing the page entry                          *
+ *                                                                           *
+ * Input values(s)  : inventory_id                                           *
+ *                    visitor - return FAILURE to stop loading               *
+ *                    user_data                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t visit_inventory_items (char *inventory_id, InventoryPageVisitor visitor,
+                              void *user_data)
+{
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_assets = NULL;
+	char *ptr_data = NULL;
+	StringView last_asset_view;
+	char  last_asset_id[32] = {0};
+	int8_t more_items = FAILURE;
+	int8_t return_value = SUCCESS;
+	uint64_t size_assets_table = 0;
+	uint64_t page_capacity = 0;
+	uint64_t count_pages = 0;
+	InventoryItem *page_items = NULL;
+	InventoryItem *ptr_items = NULL;
 
-		size_descriptions_table = json_object_array_length (json_descriptions);
+	print_debug_information ("Entering the function to "
+	                         "visit_inventory_items ()", __LINE__);
 
-		if (size_assets_table <= 0 || size_descriptions_table <= 0)
-		{
-			json_object_put (parsed_json);
+	snprintf (last_asset_id, sizeof (last_asset_id), "0");
+
+	do
+	{
+		ptr_data = get_inventory (inventory_id, MAX_COUNT_LOAD_ITEMS, last_asset_id);
 
-			return NULL;
+		if (ptr_data == NULL)
+		{
+			return_value = FAILURE;
+			break;
 		}
 
-		for (uint16_t index_item = start_assets_index; index_item < count_all_items; index_item++)
+		parsed_json = parse_json_response (ptr_data);
+
+		steam_free (ptr_data);
+
+		/* Private inventories answer with "null" */
+		if (parsed_json == NULL)
 		{
-			tmp_index = index_item - start_assets_index;
-
-			json_asset_entry = json_object_array_get_idx (json_assets, tmp_index);
-
-			get_json_object_as_string (&inventory_items[index_item].app_id,
-			                           json_asset_entry, "appid");
-			get_json_object_as_string (&inventory_items[index_item].context_id,
-			                           json_asset_entry, "contextid");
-			get_json_object_as_string (&inventory_items[index_item].asset_id,
-			                           json_asset_entry, "assetid");
-			get_json_object_as_string (&inventory_items[index_item].class_id,
-			                           json_asset_entry, "classid");
-			get_json_object_as_string (&inventory_items[index_item].instance_id,
-			                           json_asset_entry, "instanceid");
+			return_value = FAILURE;
+			break;
 		}
 
-		for (uint16_t index_item = 0; index_item < size_descriptions_table; index_item++)
+		json_object_object_get_ex (parsed_json, "assets", &json_assets);
+
+		size_assets_table = json_object_array_length (json_assets);
+
+		if (size_assets_table == 0)
 		{
-			json_descriptions_entry = json_object_array_get_idx (json_descriptions, index_item);
+			json_object_put (parsed_json);
+			break;
+		}
 
-			json_object_object_get_ex (json_descriptions_entry, "classid", &json_class_id);
-			json_object_object_get_ex (json_descriptions_entry, "instanceid", &json_instance_id);
-			json_object_object_get_ex (json_descriptions_entry, "marketable", &json_marketable);
-		
-			ptr_class_id = (char *)json_object_get_string (json_class_id);
+		more_items = get_json_object_as_view (&last_asset_view, parsed_json,
+		                                      "last_assetid");
 
-			ptr_instance_id = (char *)json_object_get_string (json_instance_id);
+		if (more_items == SUCCESS)
+		{
+			snprintf (last_asset_id, sizeof (last_asset_id), "%.*s",
+			          (int)last_asset_view.length, last_asset_view.data);
+		}
 
-			ptr_marketable = NULL;
+		if (size_assets_table > page_capacity)
+		{
+			ptr_items = steam_realloc (page_items,
+			                           size_assets_table * sizeof (InventoryItem),
+			                           ALLOC_TAG_INVENTORY);
 
-			for (uint16_t index_asset = start_assets_index; index_asset < count_all_items; index_asset++)
+			if (ptr_items == NULL)
 			{
-				if ((strcmp (ptr_class_id, inventory_items[index_asset].class_id) == STRINGS_EQUAL) &&
-					(strcmp (ptr_instance_id, inventory_items[index_asset].instance_id) == STRINGS_EQUAL))
-				{
-					ptr_marketable = (char *)json_object_get_string (json_marketable);
-
-					get_json_object_as_string (&inventory_items[index_asset].market_hash_name,
-					                           json_descriptions_entry, "market_hash_name");
-
-					if (strcmp (ptr_marketable, "1") == STRINGS_EQUAL)
-					{
-						inventory_items[index_asset].marketable = MARKETABLE_TRUE;
-					}
-					else
-					{
-						inventory_items[index_asset].marketable = MARKETABLE_FALSE;
-					}
-				}
+				json_object_put (parsed_json);
+				return_value = FAILURE;
+				break;
 			}
+
+			page_items = ptr_items;
+			page_capacity = size_assets_table;
 		}
 
-		start_assets_index = count_all_items;
+		memset (page_items, 0, size_assets_table * sizeof (InventoryItem));
+
+		size_assets_table = parse_inventory_page (parsed_json, page_items);
 
 		json_object_put (parsed_json);
 
-	} while (return_value == SUCCESS);
+		count_pages++;
+
+		return_value = visitor (page_items, size_assets_table, user_data);
+
+		free_inventory_items (page_items, size_assets_table);
+
+	} while (more_items == SUCCESS && return_value == SUCCESS);
 
-	steam_inventory->count_items = count_all_items;
-	steam_inventory->inventory_items = inventory_items;
+	steam_free (page_items);
+
+	print_debug_information ("Exiting the function to "
+	                         "visit_inventory_items ()", __LINE__);
+
+	return count_pages > 0 ? return_value : FAILURE;
+}
+
+/*===========================================================================*
+ * Function name    : collect_inventory_page                                 *
+ *                                                                           *
+ * Description      : This function move page items into steam inventory     *
+ *                                                                           *
+ * Input values(s)  : inventory_items                                        *
+ *                    count_items                                            *
+ *                    user_data - inventory collector                        *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t collect_inventory_page (InventoryItem *inventory_items,
+                                      uint64_t count_items, void *user_data)
+{
+	InventoryCollector *collector = user_data;
+	SteamInventory *steam_inventory = collector->steam_inventory;
+	InventoryItem *ptr_items = NULL;
+	uint64_t capacity = 0;
+
+	/* Grow by doubling, the array is trimmed when loading is done */
+	if (steam_inventory->count_items + count_items > collector->capacity)
+	{
+		capacity = steam_inventory->count_items + count_items;
+
+		if (collector->capacity * 2 > capacity)
+			capacity = collector->capacity * 2;
+
+		ptr_items = steam_realloc (steam_inventory->inventory_items,
+		                           capacity * sizeof (InventoryItem),
+		                           ALLOC_TAG_INVENTORY);
+
+		if (ptr_items == NULL)
+		{
+			return FAILURE;
+		}
+
+		steam_inventory->inventory_items = ptr_items;
+		collector->capacity = capacity;
+	}
+
+	memcpy (&steam_inventory->inventory_items[steam_inventory->count_items],
+	        inventory_items, count_items * sizeof (InventoryItem));
+
+	steam_inventory->count_items += count_items;
+
+	/* Ownership moved, nothing left for the page to free */
+	memset (inventory_items, 0, count_items * sizeof (InventoryItem));
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : export_inventory_page                                  *
+ *                                                                           *
+ * Description      : This function write page items to export sink          *
+ *                                                                           *
+ * Input values(s)  : inventory_items                                        *
+ *                    count_items                                            *
+ *                    user_data - export sink                                *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t export_inventory_page (InventoryItem *inventory_items,
+                                     uint64_t count_items, void *user_data)
+{
+	ExportSink *sink = user_data;
+
+	for (uint64_t index = 0; index < count_items; index++)
+	{
+		export_inventory_item (sink, &inventory_items[index]);
+	}
+
+	return flush_export_sink (sink);
+}
+
+/*===========================================================================*
+ * Function name    : get_inventory_items                                    *
+ *                                                                           *
+ * Description      : This function get inventory items                      *
+ *                                                                           *
+ * Input values(s)  : inventory_id                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Steam inventory or NULL                                *
+ *===========================================================================*/
+SteamInventory *get_inventory_items (char *inventory_id)
+{
+	SteamInventory *steam_inventory = NULL;
+	InventoryItem *ptr_items = NULL;
+	InventoryCollector collector;
+
+	print_debug_information ("Entering the function to "
+	                         "get_inventory_items ()", __LINE__);
+
+	steam_inventory = steam_calloc (1, sizeof (SteamInventory),
+	                                ALLOC_TAG_INVENTORY);
+
+	if (steam_inventory == NULL)
+	{
+		return NULL;
+	}
+
+	collector.steam_inventory = steam_inventory;
+	collector.capacity = 0;
+
+	if (visit_inventory_items (inventory_id, collect_inventory_page,
+	                           &collector) != SUCCESS ||
+	    steam_inventory->count_items == 0)
+	{
+		free_steam_inventory (steam_inventory);
+
+		return NULL;
+	}
+
+	ptr_items = steam_realloc (steam_inventory->inventory_items,
+	                           steam_inventory->count_items * sizeof (InventoryItem),
+	                           ALLOC_TAG_INVENTORY);
+
+	if (ptr_items != NULL)
+	{
+		steam_inventory->inventory_items = ptr_items;
+	}
 
 	print_debug_information ("Exiting the function to "
 	                         "get_inventory_items ()", __LINE__);
 
 	return steam_inventory;
 }
+
+/*===========================================================================*
+ * Function name    : export_inventory_items                                 *
+ *                                                                           *
+ * Description      : This function stream inventory items to export sink    *
+ *                    while next pages are still being fetched, without      *
+ *                    keeping the whole inventory in memory                  *
+ *                                                                           *
+ * Input values(s)  : inventory_id                                           *
+ *                    sink                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t export_inventory_items (char *inventory_id, ExportSink *sink)
+{
+	return visit_inventory_items (inventory_id, export_inventory_page, sink);
+}
@@ -0,0 +1,553 @@
+#include "../inc/inventory_index.h"
+#include "../inc/steam.h"
+
+#define EMPTY_SLOT  0
+
+typedef struct tIndexSortKey {
+	const char  *first;
+	const char  *second;
+	int8_t       marketable;
+	uint64_t     item_index;
+} IndexSortKey;
+
+static uint64_t hash_string (uint64_t, const char *);
+static int compare_sort_keys (const void *, const void *);
+static uint64_t build_ranges (IndexSortKey *, uint64_t, uint64_t *,
+                              InventoryIndexRange **, uint64_t **, uint64_t *);
+static const InventoryIndexRange *find_range (const InventoryIndexRange *,
+                                              const uint64_t *, uint64_t,
+                                              const uint64_t *,
+                                              const InventoryItem *,
+                                              const char *, const char *);
+
+/*===========================================================================*
+ * Function name    : hash_string                                            *
+ *                                                                           *
+ * Description      : This function FNV-1a hash of string                    *
+ *                                                                           *
+ * Input values(s)  : hash - initial hash value                              *
+ *                    str - NULL-terminated string                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Hash value                                             *
+ *===========================================================================*/
+static uint64_t hash_string (uint64_t hash, const char *str)
+{
+	for (; *str; str++)
+	{
+		hash ^= (uint8_t)*str;
+		hash *= 0x100000001B3ULL;
+	}
+
+	/* Separator so that ("ab", "c") and ("a", "bc") do not collide */
+	hash ^= 0xFF;
+	hash *= 0x100000001B3ULL;
+
+	return hash;
+}
+
+/*===========================================================================*
+ * Function name    : compare_sort_keys                                      *
+ *                                                                           *
+ * Description      : This function compare sort keys: first, second,        *
+ *                    marketable items first, then inventory order           *
+ *                                                                           *
+ * Input values(s)  : left                                                   *
+ *                    right                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : <0, 0, >0                                              *
+ *===========================================================================*/
+static int compare_sort_keys (const void *left, const void *right)
+{
+	const IndexSortKey *key_left = left;
+	const IndexSortKey *key_right = right;
+	int result = 0;
+
+	result = strcmp (key_left->first, key_right->first);
+
+	if (result != STRINGS_EQUAL)
+		return result;
+
+	result = strcmp (key_left->second, key_right->second);
+
+	if (result != STRINGS_EQUAL)
+		return result;
+
+	if (key_left->marketable != key_right->marketable)
+		return key_left->marketable == MARKETABLE_TRUE ? -1 : 1;
+
+	return (key_left->item_index > key_right->item_index) -
+	       (key_left->item_index < key_right->item_index);
+}
+
+/*===========================================================================*
+ * Function name    : build_ranges                                           *
+ *                                                                           *
+ * Description      : This function sort keys, fill the sorted item list     *
+ *                    and build hash table of equal key ranges               *
+ *                                                                           *
+ * Input values(s)  : keys                                                   *
+ *                    count_keys                                             *
+ *                                                                           *
+ * Output values(s) : sorted_items                                           *
+ *                    ranges                                                 *
+ *                    table                                                  *
+ *                    table_mask                                             *
+ *                                                                           *
+ * Return value(s)  : Count ranges                                           *
+ *===========================================================================*/
+static uint64_t build_ranges (IndexSortKey *keys, uint64_t count_keys,
+                              uint64_t *sorted_items,
+                              InventoryIndexRange **ranges,
+                              uint64_t **table, uint64_t *table_mask)
+{
+	uint64_t count_ranges = 0;
+	uint64_t table_size = 16;
+	uint64_t slot = 0;
+	InventoryIndexRange *range = NULL;
+
+	qsort (keys, count_keys, sizeof (IndexSortKey), compare_sort_keys);
+
+	*ranges = steam_calloc (count_keys + 1, sizeof (InventoryIndexRange),
+	                        ALLOC_TAG_INVENTORY);
+
+	if (*ranges == NULL)
+		return 0;
+
+	for (uint64_t index = 0; index < count_keys; index++)
+	{
+		sorted_items[index] = keys[index].item_index;
+
+		if (index == 0 ||
+		    strcmp (keys[index].first, keys[index - 1].first) != STRINGS_EQUAL ||
+		    strcmp (keys[index].second, keys[index - 1].second) != STRINGS_EQUAL)
+		{
+			range = &(*ranges)[count_ranges++];
+			range->hash = hash_string (hash_string (0xCBF29CE484222325ULL,
+			                                        keys[index].first),
+			                           keys[index].second);
+			range->start = index;
+		}
+
+		range->count++;
+
+		if (keys[index].marketable == MARKETABLE_TRUE)
+			range->count_marketable++;
+	}
+
+	/* Open addressing, load factor is kept below one half */
+	while (table_size < count_ranges * 2)
+		table_size <<= 1;
+
+	*table = steam_calloc (table_size, sizeof (uint64_t), ALLOC_TAG_INVENTORY);
+	*table_mask = table_size - 1;
+
+	if (*table == NULL)
+		return count_ranges;
+
+	for (uint64_t index = 0; index < count_ranges; index++)
+	{
+		slot = (*ranges)[index].hash & *table_mask;
+
+		while ((*table)[slot] != EMPTY_SLOT)
+			slot = (slot + 1) & *table_mask;
+
+		(*table)[slot] = index + 1;
+	}
+
+	return count_ranges;
+}
+
+/*===========================================================================*
+ * Function name    : find_range                                             *
+ *                                                                           *
+ * Description      : This function find range of equal keys in hash table   *
+ *                                                                           *
+ * Input values(s)  : ranges                                                 *
+ *                    table                                                  *
+ *                    table_mask                                             *
+ *                    sorted_items                                           *
+ *                    items                                                  *
+ *                    first                                                  *
+ *                    second - NULL to compare market_hash_name only         *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Range or NULL                                          *
+ *===========================================================================*/
+static const InventoryIndexRange *find_range (const InventoryIndexRange *ranges,
+                                              const uint64_t *table,
+                                              uint64_t table_mask,
+                                              const uint64_t *sorted_items,
+                                              const InventoryItem *items,
+                                              const char *first,
+                                              const char *second)
+{
+	const InventoryIndexRange *range = NULL;
+	const InventoryItem *item = NULL;
+	uint64_t hash = 0;
+	uint64_t slot = 0;
+
+	hash = hash_string (0xCBF29CE484222325ULL, first);
+	hash = hash_string (hash, second != NULL ? second : "");
+
+	for (slot = hash & table_mask; table[slot] != EMPTY_SLOT;
+	     slot = (slot + 1) & table_mask)
+	{
+		range = &ranges[table[slot] - 1];
+
+		if (range->hash != hash)
+			continue;
+
+		item = &items[sorted_items[range->start]];
+
+		if (second == NULL)
+		{
+			if (strcmp (item->market_hash_name != NULL ?
+			            item->market_hash_name : "", first) == STRINGS_EQUAL)
+				return range;
+		}
+		else if (strcmp (item->class_id != NULL ? item->class_id : "",
+		                 first) == STRINGS_EQUAL &&
+		         strcmp (item->instance_id != NULL ? item->instance_id : "",
+		                 second) == STRINGS_EQUAL)
+		{
+			return range;
+		}
+	}
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : build_inventory_index                                  *
+ *                                                                           *
+ * Description      : This function build secondary indexes over a loaded    *
+ *                    inventory: market_hash_name (exact and prefix),        *
+ *                    classid/instanceid and marketable flag                 *
+ *                                                                           *
+ * Input values(s)  : steam_inventory                                        *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Inventory index or NULL                                *
+ *===========================================================================*/
+InventoryIndex *build_inventory_index (SteamInventory *steam_inventory)
+{
+	InventoryIndex *inventory_index = NULL;
+	InventoryItem *item = NULL;
+	IndexSortKey *keys = NULL;
+	uint64_t count_items = 0;
+
+	print_debug_information ("Entering the function to "
+	                         "build_inventory_index ()", __LINE__);
+
+	if (steam_inventory == NULL)
+	{
+		return NULL;
+	}
+
+	count_items = steam_inventory->count_items;
+
+	inventory_index = steam_calloc (1, sizeof (InventoryIndex),
+	                                ALLOC_TAG_INVENTORY);
+	keys = steam_calloc (count_items + 1, sizeof (IndexSortKey),
+	                     ALLOC_TAG_INVENTORY);
+
+	if (inventory_index == NULL || keys == NULL)
+	{
+		steam_free (inventory_index);
+		steam_free (keys);
+
+		return NULL;
+	}
+
+	inventory_index->steam_inventory = steam_inventory;
+	inventory_index->by_name = steam_calloc (count_items + 1, sizeof (uint64_t),
+	                                         ALLOC_TAG_INVENTORY);
+	inventory_index->by_class = steam_calloc (count_items + 1, sizeof (uint64_t),
+	                                          ALLOC_TAG_INVENTORY);
+	inventory_index->marketable_items = steam_calloc (count_items + 1, sizeof (uint64_t),
+	                                                  ALLOC_TAG_INVENTORY);
+
+	if (inventory_index->by_name == NULL ||
+	    inventory_index->by_class == NULL ||
+	    inventory_index->marketable_items == NULL)
+	{
+		steam_free (keys);
+		free_inventory_index (inventory_index);
+
+		return NULL;
+	}
+
+	for (uint64_t index = 0; index < count_items; index++)
+	{
+		item = &steam_inventory->inventory_items[index];
+
+		keys[index].first = item->market_hash_name != NULL ?
+		                    item->market_hash_name : "";
+		keys[index].second = "";
+		keys[index].marketable = item->marketable;
+		keys[index].item_index = index;
+
+		if (item->marketable == MARKETABLE_TRUE)
+		{
+			inventory_index->marketable_items[inventory_index->count_marketable++] = index;
+		}
+	}
+
+	inventory_index->count_name_ranges =
+		build_ranges (keys, count_items, inventory_index->by_name,
+		              &inventory_index->name_ranges,
+		              &inventory_index->name_table,
+		              &inventory_index->name_table_mask);
+
+	for (uint64_t index = 0; index < count_items; index++)
+	{
+		item = &steam_inventory->inventory_items[index];
+
+		keys[index].first = item->class_id != NULL ? item->class_id : "";
+		keys[index].second = item->instance_id != NULL ? item->instance_id : "";
+		keys[index].marketable = item->marketable;
+		keys[index].item_index = index;
+	}
+
+	inventory_index->count_class_ranges =
+		build_ranges (keys, count_items, inventory_index->by_class,
+		              &inventory_index->class_ranges,
+		              &inventory_index->class_table,
+		              &inventory_index->class_table_mask);
+
+	steam_free (keys);
+
+	if (inventory_index->name_ranges == NULL || inventory_index->name_table == NULL ||
+	    inventory_index->class_ranges == NULL || inventory_index->class_table == NULL)
+	{
+		free_inventory_index (inventory_index);
+
+		return NULL;
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "build_inventory_index ()", __LINE__);
+
+	return inventory_index;
+}
+
+/*===========================================================================*
+ * Function name    : free_inventory_index                                   *
+ *                                                                           *
+ * Description      : This function free memory for inventory index. The     *
+ *                    indexed inventory is not freed                         *
+ *                                                                           *
+ * Input values(s)  : inventory_index                                        *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_inventory_index (InventoryIndex *inventory_index)
+{
+	if (inventory_index == NULL)
+		return;
+
+	steam_free (inventory_index->by_name);
+	steam_free (inventory_index->by_class);
+	steam_free (inventory_index->marketable_items);
+	steam_free (inventory_index->name_ranges);
+	steam_free (inventory_index->name_table);
+	steam_free (inventory_index->class_ranges);
+	steam_free (inventory_index->class_table);
+	steam_free (inventory_index);
+}
+
+/*===========================================================================*
+ * Function name    : find_items_by_name                                     *
+ *                                                                           *
+ * Description      : This function find all items with market_hash_name.    *
+ *                    Marketable copies come first                           *
+ *                                                                           *
+ * Input values(s)  : inventory_index                                        *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Id list (empty if not found)                           *
+ *===========================================================================*/
+InventoryIdList find_items_by_name (const InventoryIndex *inventory_index,
+                                    const char *market_hash_name)
+{
+	InventoryIdList id_list = {NULL, 0};
+	const InventoryIndexRange *range = NULL;
+
+	range = find_range (inventory_index->name_ranges,
+	                    inventory_index->name_table,
+	                    inventory_index->name_table_mask,
+	                    inventory_index->by_name,
+	                    inventory_index->steam_inventory->inventory_items,
+	                    market_hash_name, NULL);
+
+	if (range != NULL)
+	{
+		id_list.ids = &inventory_index->by_name[range->start];
+		id_list.count = range->count;
+	}
+
+	return id_list;
+}
+
+/*===========================================================================*
+ * Function name    : find_items_by_name_prefix                              *
+ *                                                                           *
+ * Description      : This function find all items whose market_hash_name    *
+ *                    starts with prefix. Items are ordered by name          *
+ *                                                                           *
+ * Input values(s)  : inventory_index                                        *
+ *                    prefix                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Id list (empty if not found)                           *
+ *===========================================================================*/
+InventoryIdList find_items_by_name_prefix (const InventoryIndex *inventory_index,
+                                           const char *prefix)
+{
+	InventoryIdList id_list = {NULL, 0};
+	const InventoryItem *items = inventory_index->steam_inventory->inventory_items;
+	const char *name = NULL;
+	size_t prefix_length = strlen (prefix);
+	uint64_t low = 0;
+	uint64_t high = inventory_index->steam_inventory->count_items;
+	uint64_t middle = 0;
+	uint64_t first = 0;
+
+	/* First name not less than prefix */
+	while (low < high)
+	{
+		middle = low + (high - low) / 2;
+		name = items[inventory_index->by_name[middle]].market_hash_name;
+
+		if (strcmp (name != NULL ? name : "", prefix) < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	first = low;
+	high = inventory_index->steam_inventory->count_items;
+
+	/* First name past the block of names starting with prefix */
+	while (low < high)
+	{
+		middle = low + (high - low) / 2;
+		name = items[inventory_index->by_name[middle]].market_hash_name;
+
+		if (strncmp (name != NULL ? name : "", prefix, prefix_length) == STRINGS_EQUAL)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	if (low > first)
+	{
+		id_list.ids = &inventory_index->by_name[first];
+		id_list.count = low - first;
+	}
+
+	return id_list;
+}
+
+/*===========================================================================*
+ * Function name    : find_items_by_class                                    *
+ *                                                                           *
+ * Description      : This function find all items with classid/instanceid   *
+ *                                                                           *
+ * Input values(s)  : inventory_index                                        *
+ *                    class_id                                               *
+ *                    instance_id                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Id list (empty if not found)                           *
+ *===========================================================================*/
+InventoryIdList find_items_by_class (const InventoryIndex *inventory_index,
+                                     const char *class_id,
+                                     const char *instance_id)
+{
+	InventoryIdList id_list = {NULL, 0};
+	const InventoryIndexRange *range = NULL;
+
+	range = find_range (inventory_index->class_ranges,
+	                    inventory_index->class_table,
+	                    inventory_index->class_table_mask,
+	                    inventory_index->by_class,
+	                    inventory_index->steam_inventory->inventory_items,
+	                    class_id, instance_id);
+
+	if (range != NULL)
+	{
+		id_list.ids = &inventory_index->by_class[range->start];
+		id_list.count = range->count;
+	}
+
+	return id_list;
+}
+
+/*===========================================================================*
+ * Function name    : find_marketable_items                                  *
+ *                                                                           *
+ * Description      : This function find all marketable items                *
+ *                                                                           *
+ * Input values(s)  : inventory_index                                        *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Id list in inventory order                             *
+ *===========================================================================*/
+InventoryIdList find_marketable_items (const InventoryIndex *inventory_index)
+{
+	InventoryIdList id_list = {NULL, 0};
+
+	id_list.ids = inventory_index->marketable_items;
+	id_list.count = inventory_index->count_marketable;
+
+	return id_list;
+}
+
+/*===========================================================================*
+ * Function name    : find_marketable_items_by_name                          *
+ *                                                                           *
+ * Description      : This function find all marketable copies of item       *
+ *                                                                           *
+ * Input values(s)  : inventory_index                                        *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Id list (empty if not found)                           *
+ *===========================================================================*/
+InventoryIdList find_marketable_items_by_name (const InventoryIndex *inventory_index,
+                                               const char *market_hash_name)
+{
+	InventoryIdList id_list = {NULL, 0};
+	const InventoryIndexRange *range = NULL;
+
+	range = find_range (inventory_index->name_ranges,
+	                    inventory_index->name_table,
+	                    inventory_index->name_table_mask,
+	                    inventory_index->by_name,
+	                    inventory_index->steam_inventory->inventory_items,
+	                    market_hash_name, NULL);
+
+	/* Marketable copies are sorted to the start of the range */
+	if (range != NULL && range->count_marketable > 0)
+	{
+		id_list.ids = &inventory_index->by_name[range->start];
+		id_list.count = range->count_marketable;
+	}
+
+	return id_list;
+}
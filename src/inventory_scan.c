@@ -0,0 +1,404 @@
+#include "../inc/inventory_scan.h"
+#include "../inc/inventory.h"
+#include "../inc/steam.h"
+#include "../inc/transport.h"
+
+/* Scan state of one profile, request user_data */
+typedef struct tInventoryScan {
+	const char  *steam_id;
+	char         last_asset_id[32];
+	uint64_t     count_pages;
+	int8_t       more_pages;
+} InventoryScan;
+
+typedef struct tInventoryScanContext {
+	InventoryScanSink    sink;
+	void                *user_data;
+	InventoryItem       *page_items;
+	uint64_t             page_capacity;
+	InventoryScanStats  *stats;
+} InventoryScanContext;
+
+static void finish_inventory_scan (InventoryScanContext *, InventoryScan *,
+                                   InventoryScanStatus);
+static InventoryScanStatus deliver_inventory_page (InventoryScanContext *,
+                                                   InventoryScan *,
+                                                   struct json_object *);
+static void scan_inventory_page (SteamRequest *, void *);
+static size_t build_inventory_scan_requests (SteamRequest *, InventoryScan *,
+                                             size_t);
+
+/*===========================================================================*
+ * Function name    : finish_inventory_scan                                  *
+ *                                                                           *
+ * Description      : This function end scan of profile, sink gets the       *
+ *                    status unless pages were already delivered             *
+ *                                                                           *
+ * Input values(s)  : context                                                *
+ *                    scan                                                   *
+ *                    status                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void finish_inventory_scan (InventoryScanContext *context,
+                                   InventoryScan *scan,
+                                   InventoryScanStatus status)
+{
+	scan->more_pages = 0;
+
+	if (scan->count_pages > 0 && status == INVENTORY_SCAN_EMPTY)
+	{
+		/* Past the last page of a public inventory */
+		return;
+	}
+
+	switch (status)
+	{
+		case INVENTORY_SCAN_PUBLIC:
+			context->stats->count_public++;
+			return;
+		case INVENTORY_SCAN_EMPTY:
+			context->stats->count_empty++;
+			break;
+		case INVENTORY_SCAN_PRIVATE:
+			context->stats->count_private++;
+			break;
+		default:
+			context->stats->count_failed++;
+			break;
+	}
+
+	context->sink (scan->steam_id, status, NULL, 0, context->user_data);
+}
+
+/*===========================================================================*
+ * Function name    : deliver_inventory_page                                 *
+ *                                                                           *
+ * Description      : This function parse inventory page and pass the items  *
+ *                    to sink                                                *
+ *                                                                           *
+ * Input values(s)  : context                                                *
+ *                    scan                                                   *
+ *                    parsed_json                                            *
+ *                                                                           *
+ * Output values(s) : scan - next page to load                               *
+ *                                                                           *
+ * Return value(s)  : Status of the page                                     *
+ *===========================================================================*/
+static InventoryScanStatus deliver_inventory_page (InventoryScanContext *context,
+                                                   InventoryScan *scan,
+                                                   struct json_object *parsed_json)
+{
+	struct json_object *json_assets = NULL;
+	struct json_object *json_descriptions = NULL;
+	InventoryItem *ptr_items = NULL;
+	StringView last_asset_view;
+	uint64_t size_assets_table = 0;
+	uint64_t count_items = 0;
+
+	json_object_object_get_ex (parsed_json, "assets", &json_assets);
+
+	if (json_object_is_type (json_assets, json_type_array) == 0 ||
+	    (size_assets_table = json_object_array_length (json_assets)) == 0)
+	{
+		return INVENTORY_SCAN_EMPTY;
+	}
+
+	if (size_assets_table > context->page_capacity)
+	{
+		ptr_items = steam_realloc (context->page_items,
+		                           size_assets_table * sizeof (InventoryItem),
+		                           ALLOC_TAG_INVENTORY);
+
+		if (ptr_items == NULL)
+		{
+			return INVENTORY_SCAN_FAILED;
+		}
+
+		context->page_items = ptr_items;
+		context->page_capacity = size_assets_table;
+	}
+
+	memset (context->page_items, 0, size_assets_table * sizeof (InventoryItem));
+
+	json_object_object_get_ex (parsed_json, "descriptions", &json_descriptions);
+
+	cache_item_descriptions (json_descriptions);
+
+	for (uint64_t index = 0; index < size_assets_table; index++)
+	{
+		/* Assets without ids are dropped, the rest move up */
+		if (parse_inventory_item (json_object_array_get_idx (json_assets, index),
+		                          &context->page_items[count_items]) == SUCCESS)
+		{
+			count_items++;
+		}
+		else
+		{
+			memset (&context->page_items[count_items], 0, sizeof (InventoryItem));
+		}
+	}
+
+	scan->count_pages++;
+	scan->more_pages = get_json_object_as_view (&last_asset_view, parsed_json,
+	                                            "last_assetid") == SUCCESS;
+
+	if (scan->more_pages != 0)
+	{
+		snprintf (scan->last_asset_id, sizeof (scan->last_asset_id), "%.*s",
+		          (int)last_asset_view.length, last_asset_view.data);
+	}
+
+	context->stats->count_items += count_items;
+
+	if (context->sink (scan->steam_id, INVENTORY_SCAN_PUBLIC, context->page_items,
+	                   count_items, context->user_data) != SUCCESS)
+	{
+		scan->more_pages = 0;
+	}
+
+	free_inventory_items (context->page_items, count_items);
+
+	return INVENTORY_SCAN_PUBLIC;
+}
+
+/*===========================================================================*
+ * Function name    : scan_inventory_page                                    *
+ *                                                                           *
+ * Description      : This function handle completed inventory request.      *
+ *                    Private and failed profiles are told apart by status   *
+ *                    before any parsing, the response is freed right away   *
+ *                                                                           *
+ * Input values(s)  : request                                                *
+ *                    user_data - scan context                               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void scan_inventory_page (SteamRequest *request, void *user_data)
+{
+	InventoryScanContext *context = user_data;
+	InventoryScan *scan = request->user_data;
+	InventoryScanStatus status = INVENTORY_SCAN_FAILED;
+	struct json_object *parsed_json = NULL;
+
+	if (request->curl_code != CURLE_OK || request->response.memory == NULL)
+	{
+		status = INVENTORY_SCAN_FAILED;
+	}
+	else if (request->http_code == 401 || request->http_code == 403)
+	{
+		status = INVENTORY_SCAN_PRIVATE;
+	}
+	else if (request->http_code != 200)
+	{
+		status = INVENTORY_SCAN_FAILED;
+	}
+	else if ((parsed_json = parse_json_response (request->response.memory)) == NULL)
+	{
+		/* Private inventories may also answer with "null" */
+		status = strcmp (request->response.memory, "null") == STRINGS_EQUAL ?
+		         INVENTORY_SCAN_PRIVATE : INVENTORY_SCAN_FAILED;
+	}
+	else
+	{
+		status = deliver_inventory_page (context, scan, parsed_json);
+
+		json_object_put (parsed_json);
+	}
+
+	steam_free (request->response.memory);
+	request->response.memory = NULL;
+	request->response.size = 0;
+
+	if (status != INVENTORY_SCAN_PUBLIC || scan->more_pages == 0)
+		finish_inventory_scan (context, scan, status);
+}
+
+/*===========================================================================*
+ * Function name    : build_inventory_scan_requests                          *
+ *                                                                           *
+ * Description      : This function build next page request of every         *
+ *                    profile that has more pages                            *
+ *                                                                           *
+ * Input values(s)  : scans                                                  *
+ *                    count_scans                                            *
+ *                                                                           *
+ * Output values(s) : requests - room for count_scans requests               *
+ *                                                                           *
+ * Return value(s)  : Count requests                                         *
+ *===========================================================================*/
+static size_t build_inventory_scan_requests (SteamRequest *requests,
+                                             InventoryScan *scans,
+                                             size_t count_scans)
+{
+	size_t count_requests = 0;
+	SteamRequest *request = NULL;
+
+	for (size_t index = 0; index < count_scans; index++)
+	{
+		if (scans[index].more_pages == 0)
+			continue;
+
+		request = &requests[count_requests++];
+
+		memset (request, 0, sizeof (SteamRequest));
+
+		snprintf (request->url, sizeof (request->url), URL_STEAM_COMMUNITY
+		          "inventory/%s/753/6?l=russian&count=%s&start_assetid=%s",
+		          scans[index].steam_id, MAX_COUNT_LOAD_ITEMS,
+		          scans[index].last_asset_id);
+
+		snprintf (request->url_referer, sizeof (request->url_referer),
+		          URL_STEAM_COMMUNITY "profiles/%s/inventory/",
+		          scans[index].steam_id);
+
+		/* 401 and 403 are private profiles here, not an expired session */
+		request->no_session_replay = 1;
+		request->user_data = &scans[index];
+	}
+
+	return count_requests;
+}
+
+/*===========================================================================*
+ * Function name    : scan_inventories                                       *
+ *                                                                           *
+ * Description      : This function load inventories of many profiles with   *
+ *                    concurrent requests within g_request_budget. Up to     *
+ *                    INVENTORY_SCAN_WINDOW profiles per allowed request are *
+ *                    scanned at a time; every batch sends the next page of  *
+ *                    each of them, and a finished profile is replaced by    *
+ *                    the next steam id before the following batch           *
+ *                                                                           *
+ * Input values(s)  : steam_ids                                              *
+ *                    count_ids                                              *
+ *                    max_concurrency - max requests in flight               *
+ *                    sink - called from this thread only                    *
+ *                    user_data                                              *
+ *                                                                           *
+ * Output values(s) : stats - (optional parameter)                           *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t scan_inventories (char **steam_ids, size_t count_ids,
+                         uint32_t max_concurrency, InventoryScanSink sink,
+                         void *user_data, InventoryScanStats *stats)
+{
+	InventoryScanContext context;
+	InventoryScanStats scan_stats;
+	InventoryScan *scans = NULL;
+	SteamRequest *requests = NULL;
+	size_t size_window = 0;
+	size_t next_id = 0;
+	size_t count_requests = 0;
+
+	print_debug_information ("Entering the function to "
+	                         "scan_inventories ()", __LINE__);
+
+	if (sink == NULL)
+	{
+		return FAILURE;
+	}
+
+	if (max_concurrency == 0)
+		max_concurrency = MAX_CONCURRENT_REQUESTS;
+
+	size_window = (size_t)max_concurrency * INVENTORY_SCAN_WINDOW;
+
+	if (size_window > count_ids)
+		size_window = count_ids;
+
+	memset (&scan_stats, 0, sizeof (InventoryScanStats));
+	memset (&context, 0, sizeof (InventoryScanContext));
+
+	context.sink = sink;
+	context.user_data = user_data;
+	context.stats = &scan_stats;
+
+	scans = steam_calloc (size_window + 1, sizeof (InventoryScan),
+	                      ALLOC_TAG_INVENTORY);
+	requests = steam_calloc (size_window + 1, sizeof (SteamRequest),
+	                         ALLOC_TAG_INVENTORY);
+
+	if (scans == NULL || requests == NULL)
+	{
+		steam_free (scans);
+		steam_free (requests);
+
+		return FAILURE;
+	}
+
+	do
+	{
+		/* Slots of finished profiles take the next ones, so a long
+		 * inventory holds only its own slot, not the whole window */
+		for (size_t index = 0; index < size_window && next_id < count_ids; index++)
+		{
+			if (scans[index].more_pages != 0)
+				continue;
+
+			memset (&scans[index], 0, sizeof (InventoryScan));
+
+			scans[index].steam_id = steam_ids[next_id++];
+			scans[index].more_pages = 1;
+			snprintf (scans[index].last_asset_id,
+			          sizeof (scans[index].last_asset_id), "0");
+		}
+
+		count_requests = build_inventory_scan_requests (requests, scans,
+		                                                size_window);
+
+		if (count_requests > 0)
+		{
+			scan_stats.count_requests += count_requests;
+
+			curl_batch_request (requests, count_requests, max_concurrency,
+			                    scan_inventory_page, &context);
+
+			free_steam_requests (requests, count_requests);
+		}
+	}
+	while (count_requests > 0);
+
+	steam_free (context.page_items);
+	steam_free (requests);
+	steam_free (scans);
+
+	if (stats != NULL)
+		*stats = scan_stats;
+
+	print_debug_information ("Exiting the function to "
+	                         "scan_inventories ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : get_inventory_scan_status_name                         *
+ *                                                                           *
+ * Description      : This function get name of scan status                  *
+ *                                                                           *
+ * Input values(s)  : status                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Status name                                            *
+ *===========================================================================*/
+const char *get_inventory_scan_status_name (InventoryScanStatus status)
+{
+	switch (status)
+	{
+		case INVENTORY_SCAN_PUBLIC:
+			return "public";
+		case INVENTORY_SCAN_EMPTY:
+			return "empty";
+		case INVENTORY_SCAN_PRIVATE:
+			return "private";
+		default:
+			return "failed";
+	}
+}
@@ -0,0 +1,1058 @@
+#include <pthread.h>
+
+#include "../inc/jobs.h"
+#include "../inc/steam.h"
+#include "../inc/inventory.h"
+#include "../inc/market.h"
+#include "../inc/buy_order.h"
+#include "../inc/history.h"
+#include "../inc/session.h"
+
+#define JOB_KEY_BUCKETS      1024
+#define JOB_PENDING_PER_THREAD  64
+
+typedef struct tSteamJob {
+	uint64_t             line;
+	JobOperation         operation;
+	struct json_object  *request;
+	struct tJobKey      *key;
+	struct tSteamJob    *next_same_key;
+	struct tSteamJob    *next_ready;
+} SteamJob;
+
+/* tail is the last unfinished job of the key, the next job with the same
+ * key waits for it */
+typedef struct tJobKey {
+	char            *name;
+	SteamJob        *tail;
+	struct tJobKey  *next;
+} JobKey;
+
+typedef struct tJobRunner {
+	FILE             *output;
+	uint32_t          currency;
+	size_t            max_pending;
+	size_t            count_pending;
+	uint8_t           input_done;
+	uint64_t          count_failed;
+	SteamJob         *ready_head;
+	SteamJob         *ready_tail;
+	JobKey           *keys[JOB_KEY_BUCKETS];
+	HistoryStore     *history_store;
+	pthread_mutex_t   mutex;
+	pthread_cond_t    ready_cond;
+	pthread_cond_t    space_cond;
+	pthread_mutex_t   output_mutex;
+	pthread_mutex_t   history_mutex;
+} JobRunner;
+
+typedef struct tJobOperationName {
+	const char    *name;
+	JobOperation   operation;
+} JobOperationName;
+
+static const JobOperationName s_operation_names[] = {
+	{ "sell",             JOB_SELL },
+	{ "create_buy_order", JOB_CREATE_BUY_ORDER },
+	{ "cancel_buy_order", JOB_CANCEL_BUY_ORDER },
+	{ "remove_listing",   JOB_REMOVE_LISTING },
+	{ "inventory",        JOB_INVENTORY },
+	{ "history",          JOB_HISTORY }
+};
+
+static JobOperation get_job_operation (const char *);
+static const char *get_job_string (struct json_object *, const char *);
+static int8_t get_job_uint64 (struct json_object *, const char *, uint64_t *);
+static void set_job_error (struct json_object *, const char *);
+static void add_job_string (struct json_object *, const char *, const char *);
+static void add_job_id (struct json_object *, const char *, uint64_t);
+static int8_t run_sell_job (JobRunner *, struct json_object *,
+                            struct json_object *);
+static int8_t run_create_buy_order_job (JobRunner *, struct json_object *,
+                                        struct json_object *);
+static int8_t run_cancel_buy_order_job (JobRunner *, struct json_object *,
+                                        struct json_object *);
+static int8_t run_remove_listing_job (JobRunner *, struct json_object *,
+                                      struct json_object *);
+static int8_t run_inventory_job (JobRunner *, struct json_object *,
+                                 struct json_object *);
+static int8_t add_history_event (const HistoryEvent *, void *);
+static int8_t run_history_job (JobRunner *, struct json_object *,
+                               struct json_object *);
+static void write_job_result (JobRunner *, struct json_object *);
+static void run_steam_job (JobRunner *, SteamJob *);
+static JobKey *find_job_key (JobRunner *, const char *);
+static void push_ready_job (JobRunner *, SteamJob *);
+static void finish_steam_job (JobRunner *, SteamJob *);
+static void *run_job_worker (void *);
+static int8_t queue_steam_job (JobRunner *, const char *, uint64_t);
+
+/*===========================================================================*
+ * Function name    : get_job_operation                                      *
+ *                                                                           *
+ * Description      : This function get operation by its name                *
+ *                                                                           *
+ * Input values(s)  : name (may be NULL)                                     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Operation, JOB_UNKNOWN when unknown                    *
+ *===========================================================================*/
+static JobOperation get_job_operation (const char *name)
+{
+	size_t count_names = sizeof (s_operation_names) / sizeof (s_operation_names[0]);
+
+	if (name == NULL)
+		return JOB_UNKNOWN;
+
+	for (size_t index = 0; index < count_names; index++)
+	{
+		if (strcmp (name, s_operation_names[index].name) == STRINGS_EQUAL)
+			return s_operation_names[index].operation;
+	}
+
+	return JOB_UNKNOWN;
+}
+
+/*===========================================================================*
+ * Function name    : get_job_string                                         *
+ *                                                                           *
+ * Description      : This function get field of job as string, numbers are  *
+ *                    converted                                              *
+ *                                                                           *
+ * Input values(s)  : request - job                                          *
+ *                    field                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : String owned by request or NULL                        *
+ *===========================================================================*/
+static const char *get_job_string (struct json_object *request, const char *field)
+{
+	struct json_object *json_value = NULL;
+
+	if (json_object_object_get_ex (request, field, &json_value) == 0 ||
+	    json_value == NULL)
+	{
+		return NULL;
+	}
+
+	return json_object_get_string (json_value);
+}
+
+/*===========================================================================*
+ * Function name    : get_job_uint64                                         *
+ *                                                                           *
+ * Description      : This function get field of job as number               *
+ *                                                                           *
+ * Input values(s)  : request - job                                          *
+ *                    field                                                  *
+ *                                                                           *
+ * Output values(s) : value                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t get_job_uint64 (struct json_object *request, const char *field,
+                              uint64_t *value)
+{
+	return get_json_object_as_uint64 (value, request, (char *)field);
+}
+
+/*===========================================================================*
+ * Function name    : set_job_error                                          *
+ *                                                                           *
+ * Description      : This function mark result as failed                    *
+ *                                                                           *
+ * Input values(s)  : result                                                 *
+ *                    message                                                *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void set_job_error (struct json_object *result, const char *message)
+{
+	json_object_object_add (result, "error", json_object_new_string (message));
+}
+
+/*===========================================================================*
+ * Function name    : add_job_string                                         *
+ *                                                                           *
+ * Description      : This function add string field to result               *
+ *                                                                           *
+ * Input values(s)  : result                                                 *
+ *                    field                                                  *
+ *                    value (NULL is written as empty)                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void add_job_string (struct json_object *result, const char *field,
+                            const char *value)
+{
+	json_object_object_add (result, field,
+	                        json_object_new_string (value != NULL ? value : ""));
+}
+
+/*===========================================================================*
+ * Function name    : add_job_id                                             *
+ *                                                                           *
+ * Description      : This function add 64 bit id to result, as string so    *
+ *                    readers with double numbers keep every digit           *
+ *                                                                           *
+ * Input values(s)  : result                                                 *
+ *                    field                                                  *
+ *                    value                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void add_job_id (struct json_object *result, const char *field,
+                        uint64_t value)
+{
+	char str_value[24] = {0};
+
+	snprintf (str_value, sizeof (str_value), "%llu", (unsigned long long)value);
+
+	add_job_string (result, field, str_value);
+}
+
+/*===========================================================================*
+ * Function name    : run_sell_job                                           *
+ *                                                                           *
+ * Description      : This function list one item                            *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    request - job                                          *
+ *                                                                           *
+ * Output values(s) : result                                                 *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t run_sell_job (JobRunner *runner, struct json_object *request,
+                            struct json_object *result)
+{
+	static const char *status_names[] = {
+		"listed", "needs_confirmation", "rejected", "retryable"
+	};
+	InventoryItem inventory_item;
+	SellRequest sell_request;
+	SellResult sell_result;
+	uint64_t price = 0;
+
+	(void)runner;
+
+	memset (&inventory_item, 0, sizeof (InventoryItem));
+
+	/* Only ids are needed to sell, no inventory has to be loaded */
+	inventory_item.app_id = (char *)get_job_string (request, "app_id");
+	inventory_item.context_id = (char *)get_job_string (request, "context_id");
+	inventory_item.asset_id = (char *)get_job_string (request, "asset_id");
+
+	if (inventory_item.app_id == NULL || inventory_item.context_id == NULL ||
+	    inventory_item.asset_id == NULL ||
+	    get_job_uint64 (request, "price", &price) != SUCCESS ||
+	    price == 0 || price > UINT32_MAX)
+	{
+		set_job_error (result, "app_id, context_id, asset_id and price are required");
+
+		return FAILURE;
+	}
+
+	sell_request.inventory_item = &inventory_item;
+	sell_request.price = (uint32_t)price;
+
+	/* sell_items () leaves the result untouched when it fails before
+	 * sending anything */
+	memset (&sell_result, 0, sizeof (SellResult));
+	sell_result.status = SELL_RETRYABLE;
+	snprintf (sell_result.message, sizeof (sell_result.message),
+	          "request was not sent");
+
+	sell_items (&sell_request, 1, &sell_result, 1);
+
+	add_job_string (result, "status", status_names[sell_result.status]);
+	add_job_string (result, "message", sell_result.message);
+
+	return (sell_result.status == SELL_LISTED ||
+	        sell_result.status == SELL_NEEDS_CONFIRMATION) ? SUCCESS : FAILURE;
+}
+
+/*===========================================================================*
+ * Function name    : run_create_buy_order_job                               *
+ *                                                                           *
+ * Description      : This function create one buy order                     *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    request - job                                          *
+ *                                                                           *
+ * Output values(s) : result                                                 *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t run_create_buy_order_job (JobRunner *runner,
+                                        struct json_object *request,
+                                        struct json_object *result)
+{
+	BuyOrderBook *buy_order_book = NULL;
+	BuyOrderSpec buy_order_spec;
+	BuyOrderResult buy_order_result;
+	uint64_t app_id = 0;
+	uint64_t price = 0;
+	uint64_t quantity = 0;
+
+	buy_order_spec.market_hash_name = get_job_string (request, "market_hash_name");
+
+	if (buy_order_spec.market_hash_name == NULL ||
+	    get_job_uint64 (request, "app_id", &app_id) != SUCCESS ||
+	    get_job_uint64 (request, "price", &price) != SUCCESS ||
+	    get_job_uint64 (request, "quantity", &quantity) != SUCCESS ||
+	    price == 0 || quantity == 0 || price > UINT32_MAX || quantity > UINT32_MAX)
+	{
+		set_job_error (result, "app_id, market_hash_name, price and quantity "
+		                       "are required");
+
+		return FAILURE;
+	}
+
+	buy_order_spec.app_id = (uint32_t)app_id;
+	buy_order_spec.price = (uint32_t)price;
+	buy_order_spec.quantity = (uint32_t)quantity;
+
+	/* Jobs run concurrently, each one records its order in its own book */
+	buy_order_book = create_buy_order_book (runner->currency);
+
+	if (buy_order_book == NULL)
+	{
+		set_job_error (result, "out of memory");
+
+		return FAILURE;
+	}
+
+	create_buy_orders (buy_order_book, &buy_order_spec, 1, &buy_order_result, 1);
+
+	free_buy_order_book (buy_order_book);
+
+	if (buy_order_result.success == SUCCESS)
+		add_job_id (result, "buy_order_id", buy_order_result.buy_order_id);
+
+	add_job_string (result, "message", buy_order_result.message);
+
+	return buy_order_result.success;
+}
+
+/*===========================================================================*
+ * Function name    : run_cancel_buy_order_job                               *
+ *                                                                           *
+ * Description      : This function cancel one buy order                     *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    request - job                                          *
+ *                                                                           *
+ * Output values(s) : result                                                 *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t run_cancel_buy_order_job (JobRunner *runner,
+                                        struct json_object *request,
+                                        struct json_object *result)
+{
+	BuyOrderBook *buy_order_book = NULL;
+	BuyOrderResult buy_order_result;
+	uint64_t buy_order_id = 0;
+
+	if (get_job_uint64 (request, "buy_order_id", &buy_order_id) != SUCCESS)
+	{
+		set_job_error (result, "buy_order_id is required");
+
+		return FAILURE;
+	}
+
+	buy_order_book = create_buy_order_book (runner->currency);
+
+	if (buy_order_book == NULL)
+	{
+		set_job_error (result, "out of memory");
+
+		return FAILURE;
+	}
+
+	cancel_buy_orders (buy_order_book, &buy_order_id, 1, &buy_order_result, 1);
+
+	free_buy_order_book (buy_order_book);
+
+	add_job_string (result, "message", buy_order_result.message);
+
+	return buy_order_result.success;
+}
+
+/*===========================================================================*
+ * Function name    : run_remove_listing_job                                 *
+ *                                                                           *
+ * Description      : This function remove one listing                       *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    request - job                                          *
+ *                                                                           *
+ * Output values(s) : result                                                 *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t run_remove_listing_job (JobRunner *runner,
+                                      struct json_object *request,
+                                      struct json_object *result)
+{
+	uint64_t listing_id = 0;
+	int8_t removed = FAILURE;
+
+	(void)runner;
+
+	if (get_job_uint64 (request, "listing_id", &listing_id) != SUCCESS)
+	{
+		set_job_error (result, "listing_id is required");
+
+		return FAILURE;
+	}
+
+	remove_sell_orders (&listing_id, 1, &removed, 1);
+
+	return removed;
+}
+
+/*===========================================================================*
+ * Function name    : run_inventory_job                                      *
+ *                                                                           *
+ * Description      : This function load inventory                           *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    request - job                                          *
+ *                                                                           *
+ * Output values(s) : result - count_items and items                         *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t run_inventory_job (JobRunner *runner, struct json_object *request,
+                                 struct json_object *result)
+{
+	SteamInventory *steam_inventory = NULL;
+	struct json_object *json_items = NULL;
+	struct json_object *json_item = NULL;
+	const char *steam_id = get_job_string (request, "steam_id");
+	char session_steam_id[STEAM_ID_SIZE] = {0};
+	uint64_t count_items = 0;
+
+	(void)runner;
+
+	get_steam_session (session_steam_id, sizeof (session_steam_id), NULL, 0);
+
+	steam_inventory = get_inventory_items ((char *)(steam_id != NULL ?
+	                                                steam_id : session_steam_id));
+
+	if (steam_inventory == NULL)
+	{
+		set_job_error (result, "inventory is not available");
+
+		return FAILURE;
+	}
+
+	json_items = json_object_new_array ();
+
+	for (SteamInventory *ptr_steam_inventory = steam_inventory;
+	     ptr_steam_inventory != NULL;
+	     ptr_steam_inventory = ptr_steam_inventory->next_steam_inventory)
+	{
+		for (uint64_t index = 0; index < ptr_steam_inventory->count_items; index++)
+		{
+			const InventoryItem *item = &ptr_steam_inventory->inventory_items[index];
+
+			json_item = json_object_new_object ();
+
+			add_job_string (json_item, "app_id", item->app_id);
+			add_job_string (json_item, "context_id", item->context_id);
+			add_job_string (json_item, "asset_id", item->asset_id);
+			add_job_string (json_item, "class_id", item->class_id);
+			add_job_string (json_item, "instance_id", item->instance_id);
+			add_job_string (json_item, "market_hash_name", item->market_hash_name);
+			json_object_object_add (json_item, "marketable",
+			                        json_object_new_boolean (item->marketable ==
+			                                                 MARKETABLE_TRUE));
+
+			json_object_array_add (json_items, json_item);
+		}
+
+		count_items += ptr_steam_inventory->count_items;
+	}
+
+	free_steam_inventory (steam_inventory);
+
+	json_object_object_add (result, "count_items",
+	                        json_object_new_int64 ((int64_t)count_items));
+	json_object_object_add (result, "items", json_items);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : add_history_event                                      *
+ *                                                                           *
+ * Description      : This function add event to json array, visitor of      *
+ *                    visit_history_events ()                                *
+ *                                                                           *
+ * Input values(s)  : event                                                  *
+ *                    user_data - json array                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS                                                *
+ *===========================================================================*/
+static int8_t add_history_event (const HistoryEvent *event, void *user_data)
+{
+	static const char *type_names[] = {
+		"unknown", "listed", "canceled", "sold", "purchased"
+	};
+	struct json_object *json_events = user_data;
+	struct json_object *json_event = json_object_new_object ();
+
+	add_job_id (json_event, "row_id", event->row_id);
+	add_job_id (json_event, "row_sub_id", event->row_sub_id);
+	json_object_object_add (json_event, "time",
+	                        json_object_new_int64 (event->time_acted));
+	add_job_string (json_event, "type", type_names[event->event_type]);
+	json_object_object_add (json_event, "app_id",
+	                        json_object_new_int64 (event->app_id));
+	add_job_id (json_event, "asset_id", event->asset_id);
+	json_object_object_add (json_event, "price",
+	                        json_object_new_int64 (event->price));
+	add_job_string (json_event, "market_hash_name", event->market_hash_name);
+
+	json_object_array_add (json_events, json_event);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : run_history_job                                        *
+ *                                                                           *
+ * Description      : This function sync market history to HISTORY_STORE_FILE *
+ *                    and get stored events within time range                *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    request - job                                          *
+ *                                                                           *
+ * Output values(s) : result - count_events and events                       *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t run_history_job (JobRunner *runner, struct json_object *request,
+                               struct json_object *result)
+{
+	struct json_object *json_events = NULL;
+	uint64_t time_from = 0;
+	uint64_t time_to = INT64_MAX;
+	int8_t return_value = FAILURE;
+
+	get_job_uint64 (request, "from", &time_from);
+	get_job_uint64 (request, "to", &time_to);
+
+	/* The store is a single file, history jobs take turns */
+	pthread_mutex_lock (&runner->history_mutex);
+
+	if (runner->history_store == NULL)
+		runner->history_store = open_history_store (HISTORY_STORE_FILE);
+
+	if (runner->history_store == NULL ||
+	    sync_market_history (runner->history_store, NULL) != SUCCESS)
+	{
+		set_job_error (result, "market history is not available");
+	}
+	else
+	{
+		json_events = json_object_new_array ();
+
+		visit_history_events (runner->history_store, (int64_t)time_from,
+		                      (int64_t)time_to, add_history_event, json_events);
+
+		json_object_object_add (result, "count_events",
+		                        json_object_new_int64 ((int64_t)
+		                        json_object_array_length (json_events)));
+		json_object_object_add (result, "events", json_events);
+
+		return_value = SUCCESS;
+	}
+
+	pthread_mutex_unlock (&runner->history_mutex);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : write_job_result                                       *
+ *                                                                           *
+ * Description      : This function write result as one line and flush it    *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    result                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void write_job_result (JobRunner *runner, struct json_object *result)
+{
+	const char *line = json_object_to_json_string_ext (result,
+	                                                   JSON_C_TO_STRING_PLAIN);
+
+	pthread_mutex_lock (&runner->output_mutex);
+
+	fputs (line, runner->output);
+	fputc ('\n', runner->output);
+	fflush (runner->output);
+
+	pthread_mutex_unlock (&runner->output_mutex);
+}
+
+/*===========================================================================*
+ * Function name    : run_steam_job                                          *
+ *                                                                           *
+ * Description      : This function run job and write its result             *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    job                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void run_steam_job (JobRunner *runner, SteamJob *job)
+{
+	struct json_object *result = json_object_new_object ();
+	struct json_object *json_id = NULL;
+	const char *operation = get_job_string (job->request, "op");
+	int8_t return_value = FAILURE;
+
+	if (json_object_object_get_ex (job->request, "id", &json_id) != 0)
+		json_object_object_add (result, "id", json_object_get (json_id));
+	else
+		json_object_object_add (result, "line", json_object_new_int64 ((int64_t)job->line));
+
+	add_job_string (result, "op", operation);
+
+	switch (job->operation)
+	{
+		case JOB_SELL:
+			return_value = run_sell_job (runner, job->request, result);
+			break;
+
+		case JOB_CREATE_BUY_ORDER:
+			return_value = run_create_buy_order_job (runner, job->request, result);
+			break;
+
+		case JOB_CANCEL_BUY_ORDER:
+			return_value = run_cancel_buy_order_job (runner, job->request, result);
+			break;
+
+		case JOB_REMOVE_LISTING:
+			return_value = run_remove_listing_job (runner, job->request, result);
+			break;
+
+		case JOB_INVENTORY:
+			return_value = run_inventory_job (runner, job->request, result);
+			break;
+
+		case JOB_HISTORY:
+			return_value = run_history_job (runner, job->request, result);
+			break;
+
+		default:
+			set_job_error (result, "unknown op");
+			break;
+	}
+
+	json_object_object_add (result, "success",
+	                        json_object_new_boolean (return_value == SUCCESS));
+
+	write_job_result (runner, result);
+
+	json_object_put (result);
+
+	if (return_value != SUCCESS)
+		__atomic_fetch_add (&runner->count_failed, 1, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*
+ * Function name    : find_job_key                                           *
+ *                                                                           *
+ * Description      : This function find ordering key, adding it when new    *
+ *                    (mutex must be held)                                   *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    name                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Key or NULL                                            *
+ *===========================================================================*/
+static JobKey *find_job_key (JobRunner *runner, const char *name)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	JobKey **bucket = NULL;
+	JobKey *key = NULL;
+
+	for (const char *ptr = name; *ptr != '\0'; ptr++)
+	{
+		hash = (hash ^ (uint8_t)*ptr) * 1099511628211ULL;
+	}
+
+	bucket = &runner->keys[hash % JOB_KEY_BUCKETS];
+
+	for (key = *bucket; key != NULL; key = key->next)
+	{
+		if (strcmp (key->name, name) == STRINGS_EQUAL)
+			return key;
+	}
+
+	key = steam_calloc (1, sizeof (JobKey), ALLOC_TAG_OTHER);
+
+	if (key == NULL)
+		return NULL;
+
+	key->name = steam_strdup (name, ALLOC_TAG_OTHER);
+
+	if (key->name == NULL)
+	{
+		steam_free (key);
+
+		return NULL;
+	}
+
+	key->next = *bucket;
+	*bucket = key;
+
+	return key;
+}
+
+/*===========================================================================*
+ * Function name    : push_ready_job                                         *
+ *                                                                           *
+ * Description      : This function hand job to workers (mutex must be held) *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    job                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void push_ready_job (JobRunner *runner, SteamJob *job)
+{
+	job->next_ready = NULL;
+
+	if (runner->ready_tail != NULL)
+		runner->ready_tail->next_ready = job;
+	else
+		runner->ready_head = job;
+
+	runner->ready_tail = job;
+
+	pthread_cond_signal (&runner->ready_cond);
+}
+
+/*===========================================================================*
+ * Function name    : finish_steam_job                                       *
+ *                                                                           *
+ * Description      : This function release next job of the same key and     *
+ *                    free the job                                           *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    job                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void finish_steam_job (JobRunner *runner, SteamJob *job)
+{
+	pthread_mutex_lock (&runner->mutex);
+
+	if (job->key != NULL && job->key->tail == job)
+		job->key->tail = NULL;
+
+	if (job->next_same_key != NULL)
+		push_ready_job (runner, job->next_same_key);
+
+	runner->count_pending--;
+
+	pthread_cond_signal (&runner->space_cond);
+
+	if (runner->count_pending == 0 && runner->input_done != 0)
+		pthread_cond_broadcast (&runner->ready_cond);
+
+	pthread_mutex_unlock (&runner->mutex);
+
+	json_object_put (job->request);
+	steam_free (job);
+}
+
+/*===========================================================================*
+ * Function name    : run_job_worker                                         *
+ *                                                                           *
+ * Description      : This function run ready jobs until input is done and   *
+ *                    nothing is pending                                     *
+ *                                                                           *
+ * Input values(s)  : arg - runner                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : NULL                                                   *
+ *===========================================================================*/
+static void *run_job_worker (void *arg)
+{
+	JobRunner *runner = arg;
+	SteamJob *job = NULL;
+
+	for (;;)
+	{
+		pthread_mutex_lock (&runner->mutex);
+
+		while (runner->ready_head == NULL &&
+		       (runner->input_done == 0 || runner->count_pending != 0))
+		{
+			pthread_cond_wait (&runner->ready_cond, &runner->mutex);
+		}
+
+		job = runner->ready_head;
+
+		if (job != NULL)
+		{
+			runner->ready_head = job->next_ready;
+
+			if (runner->ready_head == NULL)
+				runner->ready_tail = NULL;
+		}
+
+		pthread_mutex_unlock (&runner->mutex);
+
+		if (job == NULL)
+			break;
+
+		run_steam_job (runner, job);
+		finish_steam_job (runner, job);
+	}
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : queue_steam_job                                        *
+ *                                                                           *
+ * Description      : This function parse input line and queue the job       *
+ *                    behind unfinished jobs of the same key, waiting while  *
+ *                    too many jobs are pending                              *
+ *                                                                           *
+ * Input values(s)  : runner                                                 *
+ *                    line - NULL-terminated json                            *
+ *                    line_number                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE when the line is not a job             *
+ *===========================================================================*/
+static int8_t queue_steam_job (JobRunner *runner, const char *line,
+                               uint64_t line_number)
+{
+	SteamJob *job = NULL;
+	const char *key_name = NULL;
+
+	job = steam_calloc (1, sizeof (SteamJob), ALLOC_TAG_OTHER);
+
+	if (job == NULL)
+		return FAILURE;
+
+	job->line = line_number;
+	job->request = parse_json_response (line);
+
+	if (job->request == NULL ||
+	    json_object_is_type (job->request, json_type_object) == 0)
+	{
+		if (job->request != NULL)
+			json_object_put (job->request);
+
+		steam_free (job);
+
+		return FAILURE;
+	}
+
+	job->operation = get_job_operation (get_job_string (job->request, "op"));
+	key_name = get_job_string (job->request, "key");
+
+	pthread_mutex_lock (&runner->mutex);
+
+	while (runner->count_pending >= runner->max_pending)
+		pthread_cond_wait (&runner->space_cond, &runner->mutex);
+
+	runner->count_pending++;
+
+	if (key_name != NULL)
+		job->key = find_job_key (runner, key_name);
+
+	if (job->key != NULL && job->key->tail != NULL)
+	{
+		job->key->tail->next_same_key = job;
+		job->key->tail = job;
+	}
+	else
+	{
+		if (job->key != NULL)
+			job->key->tail = job;
+
+		push_ready_job (runner, job);
+	}
+
+	pthread_mutex_unlock (&runner->mutex);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : run_steam_jobs                                         *
+ *                                                                           *
+ * Description      : This function run NDJSON jobs from input with bounded  *
+ *                    concurrency, streaming one result line per job to      *
+ *                    output in order of completion                          *
+ *                                                                           *
+ * Input values(s)  : input - one job per line                               *
+ *                    output                                                 *
+ *                    max_concurrency - jobs running at once                 *
+ *                    currency - wallet currency of buy orders               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS when every job succeeded/FAILURE               *
+ *===========================================================================*/
+int8_t run_steam_jobs (FILE *input, FILE *output, uint32_t max_concurrency,
+                       uint32_t currency)
+{
+	JobRunner *runner = NULL;
+	pthread_t *workers = NULL;
+	uint32_t count_workers = 0;
+	char *line = NULL;
+	size_t size_line = 0;
+	ssize_t length = 0;
+	uint64_t line_number = 0;
+	struct json_object *result = NULL;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "run_steam_jobs ()", __LINE__);
+
+	if (max_concurrency == 0)
+		max_concurrency = 1;
+
+	runner = steam_calloc (1, sizeof (JobRunner), ALLOC_TAG_OTHER);
+	workers = steam_calloc (max_concurrency, sizeof (pthread_t),
+	                        ALLOC_TAG_OTHER);
+
+	if (runner == NULL || workers == NULL)
+	{
+		steam_free (runner);
+		steam_free (workers);
+
+		return FAILURE;
+	}
+
+	runner->output = output;
+	runner->currency = currency;
+	runner->max_pending = (size_t)max_concurrency * JOB_PENDING_PER_THREAD;
+
+	pthread_mutex_init (&runner->mutex, NULL);
+	pthread_cond_init (&runner->ready_cond, NULL);
+	pthread_cond_init (&runner->space_cond, NULL);
+	pthread_mutex_init (&runner->output_mutex, NULL);
+	pthread_mutex_init (&runner->history_mutex, NULL);
+
+	for (count_workers = 0; count_workers < max_concurrency; count_workers++)
+	{
+		if (pthread_create (&workers[count_workers], NULL, run_job_worker,
+		                    runner) != 0)
+		{
+			break;
+		}
+	}
+
+	while (count_workers != 0 && (length = getline (&line, &size_line, input)) >= 0)
+	{
+		line_number++;
+
+		while (length > 0 && isspace ((unsigned char)line[length - 1]))
+			line[--length] = '\0';
+
+		if (length == 0)
+			continue;
+
+		if (queue_steam_job (runner, line, line_number) != SUCCESS)
+		{
+			result = json_object_new_object ();
+
+			json_object_object_add (result, "line",
+			                        json_object_new_int64 ((int64_t)line_number));
+			json_object_object_add (result, "success",
+			                        json_object_new_boolean (0));
+			set_job_error (result, "invalid json");
+
+			write_job_result (runner, result);
+
+			json_object_put (result);
+
+			return_value = FAILURE;
+		}
+	}
+
+	pthread_mutex_lock (&runner->mutex);
+	runner->input_done = 1;
+	pthread_cond_broadcast (&runner->ready_cond);
+	pthread_mutex_unlock (&runner->mutex);
+
+	for (uint32_t index = 0; index < count_workers; index++)
+	{
+		pthread_join (workers[index], NULL);
+	}
+
+	if (count_workers == 0 || runner->count_failed != 0)
+		return_value = FAILURE;
+
+	for (size_t index = 0; index < JOB_KEY_BUCKETS; index++)
+	{
+		JobKey *key = runner->keys[index];
+
+		while (key != NULL)
+		{
+			JobKey *next = key->next;
+
+			steam_free (key->name);
+			steam_free (key);
+
+			key = next;
+		}
+	}
+
+	if (runner->history_store != NULL)
+		close_history_store (runner->history_store);
+
+	pthread_mutex_destroy (&runner->mutex);
+	pthread_cond_destroy (&runner->ready_cond);
+	pthread_cond_destroy (&runner->space_cond);
+	pthread_mutex_destroy (&runner->output_mutex);
+	pthread_mutex_destroy (&runner->history_mutex);
+
+	/* getline () grows the line with libc realloc () */
+	free (line);
+	steam_free (workers);
+	steam_free (runner);
+
+	print_debug_information ("Exiting the function to "
+	                         "run_steam_jobs ()", __LINE__);
+
+	return return_value;
+}
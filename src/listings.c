@@ -0,0 +1,346 @@
+#include "../inc/listings.h"
+#include "../inc/steam.h"
+#include "../inc/transport.h"
+
+static void build_listings_request (SteamRequest *, uint64_t);
+static int8_t parse_listing_array (struct json_object *, MyListing **, size_t *);
+static int8_t parse_buy_order_array (struct json_object *, BuyOrder **, size_t *);
+static void free_listing_array (MyListing *, size_t);
+
+/*===========================================================================*
+ * Function name    : build_listings_request                                 *
+ *                                                                           *
+ * Description      : This function build request of one mylistings page     *
+ *                                                                           *
+ * Input values(s)  : start - offset of active listings                      *
+ *                                                                           *
+ * Output values(s) : request                                                *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void build_listings_request (SteamRequest *request, uint64_t start)
+{
+	snprintf (request->url, sizeof (request->url), URL_STEAM_MARKET
+	          "mylistings?start=%llu&count=%u&norender=1",
+	          (unsigned long long)start, MY_LISTINGS_PAGE_SIZE);
+
+	snprintf (request->url_referer, sizeof (request->url_referer),
+	          URL_STEAM_MARKET);
+}
+
+/*===========================================================================*
+ * Function name    : parse_listing_array                                    *
+ *                                                                           *
+ * Description      : This function append listings of json array            *
+ *                                                                           *
+ * Input values(s)  : json_listings                                          *
+ *                                                                           *
+ * Output values(s) : listings                                               *
+ *                    count_listings                                         *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t parse_listing_array (struct json_object *json_listings,
+                                   MyListing **listings, size_t *count_listings)
+{
+	struct json_object *json_entry = NULL;
+	struct json_object *json_asset = NULL;
+	MyListing *ptr_listings = NULL;
+	MyListing *listing = NULL;
+	size_t size_listings_table = 0;
+	uint64_t value = 0;
+
+	size_listings_table = json_object_array_length (json_listings);
+
+	if (size_listings_table == 0)
+	{
+		return SUCCESS;
+	}
+
+	ptr_listings = steam_realloc (*listings, (*count_listings + size_listings_table) *
+	                              sizeof (MyListing), ALLOC_TAG_MARKET);
+
+	if (ptr_listings == NULL)
+	{
+		return FAILURE;
+	}
+
+	*listings = ptr_listings;
+
+	for (size_t index = 0; index < size_listings_table; index++)
+	{
+		json_entry = json_object_array_get_idx (json_listings, index);
+		listing = &(*listings)[(*count_listings)++];
+
+		memset (listing, 0, sizeof (MyListing));
+
+		get_json_object_as_uint64 (&listing->listing_id, json_entry, "listingid");
+		get_json_object_as_uint64 (&listing->time_created, json_entry, "time_created");
+
+		if (get_json_object_as_uint64 (&value, json_entry, "price") == SUCCESS)
+			listing->price = value;
+
+		if (get_json_object_as_uint64 (&value, json_entry, "fee") == SUCCESS)
+			listing->fee = value;
+
+		if (json_object_object_get_ex (json_entry, "asset", &json_asset))
+		{
+			if (get_json_object_as_uint64 (&value, json_asset, "appid") == SUCCESS)
+				listing->app_id = value;
+
+			get_json_object_as_uint64 (&listing->context_id, json_asset, "contextid");
+			get_json_object_as_uint64 (&listing->asset_id, json_asset, "id");
+			get_json_object_as_tagged_string (&listing->market_hash_name,
+			                                  json_asset, "market_hash_name",
+			                                  ALLOC_TAG_MARKET);
+		}
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : parse_buy_order_array                                  *
+ *                                                                           *
+ * Description      : This function parse buy orders of json array           *
+ *                                                                           *
+ * Input values(s)  : json_buy_orders                                        *
+ *                                                                           *
+ * Output values(s) : buy_orders                                             *
+ *                    count_buy_orders                                       *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t parse_buy_order_array (struct json_object *json_buy_orders,
+                                     BuyOrder **buy_orders,
+                                     size_t *count_buy_orders)
+{
+	struct json_object *json_entry = NULL;
+	BuyOrder *buy_order = NULL;
+	size_t size_orders_table = 0;
+	uint64_t value = 0;
+
+	size_orders_table = json_object_array_length (json_buy_orders);
+
+	*buy_orders = steam_calloc (size_orders_table + 1, sizeof (BuyOrder),
+	                            ALLOC_TAG_MARKET);
+
+	if (*buy_orders == NULL)
+	{
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < size_orders_table; index++)
+	{
+		json_entry = json_object_array_get_idx (json_buy_orders, index);
+		buy_order = &(*buy_orders)[(*count_buy_orders)++];
+
+		get_json_object_as_uint64 (&buy_order->buy_order_id, json_entry, "buy_orderid");
+		get_json_object_as_tagged_string (&buy_order->market_hash_name, json_entry,
+		                                  "hash_name", ALLOC_TAG_MARKET);
+
+		if (get_json_object_as_uint64 (&value, json_entry, "appid") == SUCCESS)
+			buy_order->app_id = value;
+
+		if (get_json_object_as_uint64 (&value, json_entry, "price") == SUCCESS)
+			buy_order->price = value;
+
+		if (get_json_object_as_uint64 (&value, json_entry, "quantity") == SUCCESS)
+			buy_order->quantity = value;
+
+		if (get_json_object_as_uint64 (&value, json_entry, "quantity_remaining") == SUCCESS)
+			buy_order->quantity_remaining = value;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : free_listing_array                                     *
+ *                                                                           *
+ * Description      : This function free memory for listings                 *
+ *                                                                           *
+ * Input values(s)  : listings                                               *
+ *                    count_listings                                         *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void free_listing_array (MyListing *listings, size_t count_listings)
+{
+	for (size_t index = 0; index < count_listings; index++)
+	{
+		steam_free (listings[index].market_hash_name);
+	}
+
+	steam_free (listings);
+}
+
+/*===========================================================================*
+ * Function name    : get_my_listings                                        *
+ *                                                                           *
+ * Description      : This function get all own listings and buy orders.     *
+ *                    The first page gives num_active_listings, the other    *
+ *                    pages are fetched concurrently                         *
+ *                                                                           *
+ * Input values(s)  : max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : My listings or NULL                                    *
+ *===========================================================================*/
+MyListings *get_my_listings (uint32_t max_concurrency)
+{
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_array = NULL;
+	SteamRequest first_request;
+	SteamRequest *requests = NULL;
+	MyListings *my_listings = NULL;
+	char *ptr_data = NULL;
+	size_t count_pages = 0;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "get_my_listings ()", __LINE__);
+
+	memset (&first_request, 0, sizeof (first_request));
+
+	build_listings_request (&first_request, 0);
+
+	ptr_data = curl_general_request (first_request.url, first_request.url_referer,
+	                                 NULL, 0);
+
+	if (ptr_data == NULL)
+	{
+		return NULL;
+	}
+
+	parsed_json = parse_json_response (ptr_data);
+
+	steam_free (ptr_data);
+
+	my_listings = steam_calloc (1, sizeof (MyListings), ALLOC_TAG_MARKET);
+
+	if (parsed_json == NULL || my_listings == NULL)
+	{
+		json_object_put (parsed_json);
+		steam_free (my_listings);
+
+		return NULL;
+	}
+
+	get_json_object_as_uint64 (&my_listings->num_active_listings, parsed_json,
+	                           "num_active_listings");
+
+	/* Listings awaiting confirmation, on hold and buy orders are not paged */
+	if (json_object_object_get_ex (parsed_json, "listings", &json_array))
+		return_value &= parse_listing_array (json_array, &my_listings->active,
+		                                     &my_listings->count_active);
+
+	if (json_object_object_get_ex (parsed_json, "listings_to_confirm", &json_array))
+		return_value &= parse_listing_array (json_array, &my_listings->to_confirm,
+		                                     &my_listings->count_to_confirm);
+
+	if (json_object_object_get_ex (parsed_json, "listings_on_hold", &json_array))
+		return_value &= parse_listing_array (json_array, &my_listings->on_hold,
+		                                     &my_listings->count_on_hold);
+
+	if (json_object_object_get_ex (parsed_json, "buy_orders", &json_array))
+		return_value &= parse_buy_order_array (json_array, &my_listings->buy_orders,
+		                                       &my_listings->count_buy_orders);
+
+	json_object_put (parsed_json);
+
+	if (my_listings->num_active_listings > MY_LISTINGS_PAGE_SIZE)
+	{
+		count_pages = (my_listings->num_active_listings - 1) / MY_LISTINGS_PAGE_SIZE;
+
+		requests = steam_calloc (count_pages, sizeof (SteamRequest),
+		                         ALLOC_TAG_MARKET);
+
+		if (requests == NULL)
+		{
+			free_my_listings (my_listings);
+
+			return NULL;
+		}
+
+		for (size_t index = 0; index < count_pages; index++)
+		{
+			build_listings_request (&requests[index],
+			                        (index + 1) * MY_LISTINGS_PAGE_SIZE);
+		}
+
+		/* Offsets are known up front, so the whole refresh costs one more
+		 * round trip instead of one per page */
+		curl_batch_request (requests, count_pages, max_concurrency, NULL, NULL);
+
+		for (size_t index = 0; index < count_pages; index++)
+		{
+			parsed_json = NULL;
+
+			if (requests[index].response.memory != NULL)
+			{
+				parsed_json = parse_json_response (requests[index].response.memory);
+			}
+
+			if (parsed_json == NULL ||
+			    json_object_object_get_ex (parsed_json, "listings", &json_array) == 0)
+			{
+				json_object_put (parsed_json);
+				return_value = FAILURE;
+				continue;
+			}
+
+			return_value &= parse_listing_array (json_array, &my_listings->active,
+			                                     &my_listings->count_active);
+
+			json_object_put (parsed_json);
+		}
+
+		free_steam_requests (requests, count_pages);
+		steam_free (requests);
+	}
+
+	if (return_value != SUCCESS)
+	{
+		free_my_listings (my_listings);
+
+		return NULL;
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "get_my_listings ()", __LINE__);
+
+	return my_listings;
+}
+
+/*===========================================================================*
+ * Function name    : free_my_listings                                       *
+ *                                                                           *
+ * Description      : This function free memory for my listings              *
+ *                                                                           *
+ * Input values(s)  : my_listings                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_my_listings (MyListings *my_listings)
+{
+	if (my_listings == NULL)
+		return;
+
+	free_listing_array (my_listings->active, my_listings->count_active);
+	free_listing_array (my_listings->to_confirm, my_listings->count_to_confirm);
+	free_listing_array (my_listings->on_hold, my_listings->count_on_hold);
+
+	for (size_t index = 0; index < my_listings->count_buy_orders; index++)
+	{
+		steam_free (my_listings->buy_orders[index].market_hash_name);
+	}
+
+	steam_free (my_listings->buy_orders);
+	steam_free (my_listings);
+}
@@ -3,7 +3,9 @@
 #include <openssl/err.h>
 
 #include "../inc/login.h"
+#include "../inc/guard.h"
 #include "../inc/steam.h"
+#include "../inc/session.h"
 #include "../inc/steamdef.h"
 
 static char *get_rsa_key (char *);
@@ -26,16 +28,16 @@ static void free_login_response (LoginResponse *loginResponse)
 	                         "free_login_response ()", __LINE__);
 
 	if (loginResponse->public_key_mod != NULL)
-		free (loginResponse->public_key_mod);
+		steam_free (loginResponse->public_key_mod);
 	
 	if (loginResponse->public_key_exp != NULL)
-		free (loginResponse->public_key_exp);
+		steam_free (loginResponse->public_key_exp);
 
 	if (loginResponse->time_stamp != NULL)
-		free (loginResponse->time_stamp);
+		steam_free (loginResponse->time_stamp);
 
 	if (loginResponse->token_gid != NULL)
-		free (loginResponse->token_gid);
+		steam_free (loginResponse->token_gid);
 
 	print_debug_information ("Entering the function to "
 	                         "free_login_response ()", __LINE__);
@@ -101,20 +103,20 @@ static char *encode_steam_password (char *password, char *ptr_rsa_key_data,
 	print_debug_information ("Entering the function to "
 	                         "encode_steam_password ()", __LINE__);
 
-	parsed_json = json_tokener_parse (ptr_rsa_key_data);
+	parsed_json = parse_json_response (ptr_rsa_key_data);
 
-	free (ptr_rsa_key_data);
+	steam_free (ptr_rsa_key_data);
 
 	if (parsed_json == NULL)
 	{
 		snprintf (error_message, ERROR_MESSAGE_SIZE,
-		          "[ERROR %u] json_tokener_parse ()", __LINE__);
+		          "[ERROR %u] parse_json_response ()", __LINE__);
 		printf ("%s\n", error_message);
 
 		return NULL;
 	}
 
-	print_debug_information ("json_tokener_parse ()", __LINE__);
+	print_debug_information ("parse_json_response ()", __LINE__);
 
 	json_object_object_get_ex (parsed_json, "success", &json_success);
 
@@ -138,10 +140,14 @@ static char *encode_steam_password (char *password, char *ptr_rsa_key_data,
 
 	print_debug_information ("strcmp () for json_success", __LINE__);
 
-	get_json_object_as_string (&loginResponse->public_key_mod, parsed_json, "publickey_mod");
-	get_json_object_as_string (&loginResponse->public_key_exp, parsed_json, "publickey_exp");
-	get_json_object_as_string (&loginResponse->time_stamp, parsed_json, "timestamp");
-	get_json_object_as_string (&loginResponse->token_gid, parsed_json, "token_gid");
+	get_json_object_as_tagged_string (&loginResponse->public_key_mod, parsed_json,
+	                                  "publickey_mod", ALLOC_TAG_SESSION);
+	get_json_object_as_tagged_string (&loginResponse->public_key_exp, parsed_json,
+	                                  "publickey_exp", ALLOC_TAG_SESSION);
+	get_json_object_as_tagged_string (&loginResponse->time_stamp, parsed_json,
+	                                  "timestamp", ALLOC_TAG_SESSION);
+	get_json_object_as_tagged_string (&loginResponse->token_gid, parsed_json,
+	                                  "token_gid", ALLOC_TAG_SESSION);
 
 	json_object_put (parsed_json);
 
@@ -214,7 +220,8 @@ static char *encode_steam_password (char *password, char *ptr_rsa_key_data,
 
 		print_debug_information ("base64_encode ()", __LINE__);
 
-		ptr_encode_password = calloc (ENCODE_PASSWORD_SIZE, sizeof (char));
+		ptr_encode_password = steam_calloc (ENCODE_PASSWORD_SIZE, sizeof (char),
+		                                    ALLOC_TAG_SESSION);
 
 		url_encode (base64_password, ptr_encode_password, g_rfc3986);
 
@@ -257,6 +264,7 @@ int8_t steam_login (char *login, char *password, char *two_factor_code)
 	struct json_object *json_transfer_parameters= NULL;
 	LoginResponse loginResponse;
 	char *responce_success = NULL;
+	char *ptr_steam_id = NULL;
 	int8_t return_value = LOGIN_SUCCESS;
 
 	memset (&loginResponse, 0, sizeof (loginResponse));
@@ -302,19 +310,19 @@ int8_t steam_login (char *login, char *password, char *two_factor_code)
 			 loginResponse.time_stamp, curr_time_str);
 
 	free_login_response (&loginResponse);
-	free (ptr_encode_password);
+	steam_free (ptr_encode_password);
 
 	snprintf (steam_url, sizeof (steam_url), URL_STEAM_LOGIN "%s", login);
 	snprintf (url_referer, sizeof (url_referer), URL_STEAM_REFERER_LOGIN);
 
 	ptr_data = curl_general_request (steam_url, url_referer, post_data, GET_COOKIE);
 
-	parsed_json = json_tokener_parse (ptr_data);
+	parsed_json = parse_json_response (ptr_data);
 
 	printf ("Steam Login\n");
 	printf ("Response: %s\n", ptr_data);
 
-	free (ptr_data);
+	steam_free (ptr_data);
 
 	get_json_object_as_string (&responce_success, parsed_json, "success");
 
@@ -322,7 +330,18 @@ int8_t steam_login (char *login, char *password, char *two_factor_code)
 	{
 		json_object_object_get_ex (parsed_json, "transfer_parameters", &json_transfer_parameters);
 
-		get_json_object_as_string (&g_steam_id, json_transfer_parameters, "steamid");
+		/* Other threads may be reading the old id, it is swapped, not
+		 * overwritten */
+		if (get_json_object_as_tagged_string (&ptr_steam_id, json_transfer_parameters,
+		                                      "steamid", ALLOC_TAG_SESSION) != SUCCESS ||
+		    set_steam_session (ptr_steam_id, NULL) != SUCCESS)
+		{
+			return_value = LOGIN_FAILURE;
+		}
+
+		steam_free (ptr_steam_id);
+
+		save_steam_cookies ();
 	}
 	else
 	{
@@ -330,10 +349,62 @@ int8_t steam_login (char *login, char *password, char *two_factor_code)
 	}
 
 	json_object_put (parsed_json);
-	free (responce_success);
+	steam_free (responce_success);
 
 	print_debug_information ("Exiting the function to "
 	                         "steam_login ()", __LINE__);
 
 	return return_value;
 }
+
+/*===========================================================================*
+ * Function name    : steam_login_with_credentials                           *
+ *                                                                           *
+ * Description      : This function log in without user input: the Steam     *
+ *                    Guard code is generated from shared secret after       *
+ *                    syncing with the server time                           *
+ *                                                                           *
+ * Input values(s)  : credentials - see load_steam_credentials ()            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : LOGIN_SUCCESS/FAILURE                                  *
+ *===========================================================================*/
+int8_t steam_login_with_credentials (const SteamCredentials *credentials)
+{
+	char login[LOGIN_LENGTH] = {0};
+	char password[PASSWORD_LENGTH] = {0};
+	char two_factor_code[TWO_FACTOR_CODE_LENGTH] = {0};
+	int8_t return_value = FAILURE;
+
+	print_debug_information ("Entering the function to "
+	                         "steam_login_with_credentials ()", __LINE__);
+
+	if (credentials->shared_secret[0] != '\0')
+	{
+		/* Local clock is used as is when the sync fails */
+		sync_steam_time ();
+
+		if (generate_steam_guard_code (credentials->shared_secret,
+		                               get_steam_time (),
+		                               two_factor_code) != SUCCESS)
+		{
+			print_debug_information ("Exiting the function to "
+			                         "steam_login_with_credentials ()", __LINE__);
+
+			return FAILURE;
+		}
+	}
+
+	snprintf (login, LOGIN_LENGTH, "%s", credentials->login);
+	snprintf (password, PASSWORD_LENGTH, "%s", credentials->password);
+
+	return_value = steam_login (login, password, two_factor_code);
+
+	memset (password, 0, PASSWORD_LENGTH);
+
+	print_debug_information ("Exiting the function to "
+	                         "steam_login_with_credentials ()", __LINE__);
+
+	return return_value;
+}
@@ -1,5 +1,126 @@
 #include "../inc/market.h"
 #include "../inc/steam.h"
+#include "../inc/transport.h"
+#include "../inc/session.h"
+
+static void classify_sell_response (const char *, long, SellResult *);
+static void build_sell_post_data (char *, size_t, const char *,
+                                  const InventoryItem *, const char *);
+
+/*===========================================================================*
+ * Function name    : classify_sell_response                                 *
+ *                                                                           *
+ * Description      : This function get result of sellitem request          *
+ *                                                                           *
+ * Input values(s)  : ptr_data - response data (NULL if request failed)      *
+ *                    http_code                                              *
+ *                                                                           *
+ * Output values(s) : sell_result                                            *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void classify_sell_response (const char *ptr_data, long http_code,
+                                    SellResult *sell_result)
+{
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_success = NULL;
+	struct json_object *json_value = NULL;
+	const char *ptr_message = NULL;
+
+	memset (sell_result, 0, sizeof (SellResult));
+
+	sell_result->http_code = http_code;
+	sell_result->status = SELL_RETRYABLE;
+
+	if (ptr_data == NULL)
+	{
+		snprintf (sell_result->message, sizeof (sell_result->message),
+		          "request failed");
+		return;
+	}
+
+	/* Rate limited or Steam side error, the same request may pass later */
+	if (http_code == 429 || http_code >= 500)
+	{
+		snprintf (sell_result->message, sizeof (sell_result->message),
+		          "http %ld", http_code);
+		return;
+	}
+
+	parsed_json = parse_json_response (ptr_data);
+
+	if (parsed_json == NULL ||
+	    json_object_object_get_ex (parsed_json, "success", &json_success) == 0)
+	{
+		snprintf (sell_result->message, sizeof (sell_result->message),
+		          "unexpected response (http %ld)", http_code);
+		json_object_put (parsed_json);
+		return;
+	}
+
+	if (json_object_get_boolean (json_success))
+	{
+		sell_result->status = SELL_LISTED;
+
+		if ((json_object_object_get_ex (parsed_json, "requires_confirmation", &json_value) &&
+		     json_object_get_int (json_value) != 0) ||
+		    (json_object_object_get_ex (parsed_json, "needs_mobile_confirmation", &json_value) &&
+		     json_object_get_boolean (json_value)) ||
+		    (json_object_object_get_ex (parsed_json, "needs_email_confirmation", &json_value) &&
+		     json_object_get_boolean (json_value)))
+		{
+			sell_result->status = SELL_NEEDS_CONFIRMATION;
+		}
+	}
+	else
+	{
+		if (json_object_object_get_ex (parsed_json, "message", &json_value))
+		{
+			ptr_message = json_object_get_string (json_value);
+		}
+
+		snprintf (sell_result->message, sizeof (sell_result->message), "%s",
+		          ptr_message != NULL ? ptr_message : "");
+
+		/* "There was a problem listing your item. Refresh the page and
+		 * try again." is Steam's answer to transient failures */
+		sell_result->status = (ptr_message != NULL &&
+		                       strstr (ptr_message, "try again") != NULL) ?
+		                      SELL_RETRYABLE : SELL_REJECTED;
+	}
+
+	json_object_put (parsed_json);
+}
+
+/*===========================================================================*
+ * Function name    : build_sell_post_data                                   *
+ *                                                                           *
+ * Description      : This function build post data of sellitem request      *
+ *                                                                           *
+ * Input values(s)  : size_post_data                                         *
+ *                    session_id                                             *
+ *                    inventory_item                                         *
+ *                    price_item                                             *
+ *                                                                           *
+ * Output values(s) : post_data                                              *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void build_sell_post_data (char *post_data, size_t size_post_data,
+                                  const char *session_id,
+                                  const InventoryItem *inventory_item,
+                                  const char *price_item)
+{
+	snprintf (post_data, size_post_data,
+		      "sessionid=" "%s" "&"
+		      "appid=" "%s" "&"
+		      "contextid=" "%s" "&"
+		      "assetid=" "%s" "&"
+		      "amount=" "1" "&"
+		      "price=" "%s",
+		      session_id, inventory_item->app_id, inventory_item->context_id,
+		      inventory_item->asset_id, price_item);
+}
 
 /*===========================================================================*
  * Function name    : sell_item                                              *
@@ -15,41 +136,157 @@
  *===========================================================================*/
 int8_t sell_item (InventoryItem inventory_item, char *price_item)
 {
-	char steam_sell_url[URL_SIZE] = {0};
-	char steam_url_referer[URL_SIZE] = {0};
+	SteamRequest request;
 	char post_data[POST_DATA_SIZE] = {0};
-	char *ptr_data = NULL;
+	char steam_id[STEAM_ID_SIZE] = {0};
+	char session_id[sizeof (g_session_id)] = {0};
+	SellResult sell_result;
 
 	print_debug_information ("Entering the function to "
 	                         "sell_item ()", __LINE__);
 
-	snprintf (steam_sell_url, sizeof (steam_sell_url), URL_STEAM_COMMUNITY
+	get_steam_session (steam_id, sizeof (steam_id), session_id, sizeof (session_id));
+
+	memset (&request, 0, sizeof (SteamRequest));
+
+	snprintf (request.url, sizeof (request.url), URL_STEAM_COMMUNITY
 	          "market/sellitem/");
 
-	snprintf (steam_url_referer, sizeof (steam_url_referer),
-	          URL_STEAM_COMMUNITY "profiles/%s/inventory/", g_steam_id);
+	snprintf (request.url_referer, sizeof (request.url_referer),
+	          URL_STEAM_COMMUNITY "profiles/%s/inventory/", steam_id);
 
-	snprintf (post_data, sizeof (post_data),
-		      "sessionid=" "%s" "&"
-		      "appid=" "%s" "&"
-		      "contextid=" "%s" "&"
-		      "assetid=" "%s" "&"
-		      "amount=" "1" "&"
-		      "price=" "%s",
-		      g_session_id, inventory_item.app_id, inventory_item.context_id,
-		      inventory_item.asset_id, price_item);
+	build_sell_post_data (post_data, sizeof (post_data), session_id,
+	                      &inventory_item, price_item);
+
+	request.post_data = post_data;
 
-	ptr_data = curl_general_request (steam_sell_url, steam_url_referer, post_data, 0);
+	/* A batch of one, for the http status that tells retryable errors */
+	curl_batch_request (&request, 1, 1, NULL, NULL);
 
 	printf ("Sell item\n");
-	printf ("Response: %s\n", ptr_data);
-	
-	free (ptr_data);
+	printf ("Response: %s\n", request.response.memory);
+
+	classify_sell_response (request.curl_code == CURLE_OK ?
+	                        request.response.memory : NULL,
+	                        request.http_code, &sell_result);
+
+	free_steam_requests (&request, 1);
 
 	print_debug_information ("Exiting the function to "
 	                         "sell_item ()", __LINE__);
 
-	return SUCCESS;
+	return (sell_result.status == SELL_LISTED ||
+	        sell_result.status == SELL_NEEDS_CONFIRMATION) ? SUCCESS : FAILURE;
+}
+
+/*===========================================================================*
+ * Function name    : sell_item_for                                          *
+ *                                                                           *
+ * Description      : This function sell item for amount the seller          *
+ *                    receives (see compute_fees_for_amount ())              *
+ *                                                                           *
+ * Input values(s)  : inventory_item                                         *
+ *                    received - in cents                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t sell_item_for (InventoryItem inventory_item, Money received)
+{
+	char price_item[24] = {0};
+
+	if (received <= 0)
+	{
+		return FAILURE;
+	}
+
+	snprintf (price_item, sizeof (price_item), "%lld", (long long)received);
+
+	return sell_item (inventory_item, price_item);
+}
+
+/*===========================================================================*
+ * Function name    : sell_items                                             *
+ *                                                                           *
+ * Description      : This function list many items concurrently within      *
+ *                    the global request budget                              *
+ *                                                                           *
+ * Input values(s)  : sell_requests - item and price (the amount the seller  *
+ *                                    receives, in cents)                    *
+ *                    count_requests                                         *
+ *                    max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : sell_results - result of every request, in the same    *
+ *                                   order                                   *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if every item was listed, otherwise FAILURE    *
+ *===========================================================================*/
+int8_t sell_items (const SellRequest *sell_requests, size_t count_requests,
+                   SellResult *sell_results, uint32_t max_concurrency)
+{
+	SteamRequest *requests = NULL;
+	char *post_data = NULL;
+	char price_item[16] = {0};
+	char steam_id[STEAM_ID_SIZE] = {0};
+	char session_id[sizeof (g_session_id)] = {0};
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "sell_items ()", __LINE__);
+
+	get_steam_session (steam_id, sizeof (steam_id), session_id, sizeof (session_id));
+
+	requests = steam_calloc (count_requests + 1, sizeof (SteamRequest),
+	                         ALLOC_TAG_MARKET);
+	post_data = steam_calloc (count_requests + 1, POST_DATA_SIZE, ALLOC_TAG_MARKET);
+
+	if (requests == NULL || post_data == NULL)
+	{
+		steam_free (requests);
+		steam_free (post_data);
+
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < count_requests; index++)
+	{
+		snprintf (requests[index].url, sizeof (requests[index].url),
+		          URL_STEAM_MARKET "sellitem/");
+		snprintf (requests[index].url_referer, sizeof (requests[index].url_referer),
+		          URL_STEAM_COMMUNITY "profiles/%s/inventory/", steam_id);
+
+		snprintf (price_item, sizeof (price_item), "%u", sell_requests[index].price);
+
+		requests[index].post_data = post_data + index * POST_DATA_SIZE;
+
+		build_sell_post_data (requests[index].post_data, POST_DATA_SIZE, session_id,
+		                      sell_requests[index].inventory_item, price_item);
+	}
+
+	curl_batch_request (requests, count_requests, max_concurrency, NULL, NULL);
+
+	for (size_t index = 0; index < count_requests; index++)
+	{
+		classify_sell_response (requests[index].curl_code == CURLE_OK ?
+		                        requests[index].response.memory : NULL,
+		                        requests[index].http_code, &sell_results[index]);
+
+		if (sell_results[index].status != SELL_LISTED &&
+		    sell_results[index].status != SELL_NEEDS_CONFIRMATION)
+		{
+			return_value = FAILURE;
+		}
+	}
+
+	free_steam_requests (requests, count_requests);
+	steam_free (requests);
+	steam_free (post_data);
+
+	print_debug_information ("Exiting the function to "
+	                         "sell_items ()", __LINE__);
+
+	return return_value;
 }
 
 /*===========================================================================*
@@ -74,21 +311,26 @@ int8_t create_buy_order (char *market_hash_name, double price_item,
 	char steam_url_referer[URL_SIZE] = {0};
 	char post_data[POST_DATA_SIZE] = {0};
 	char *ptr_data = NULL;
-	uint32_t price_total = 0.0;
+	Money price_total = 0;
 	char str_price_total[20] = {0};
 	char str_quantity[16] = {0};
+	char session_id[sizeof (g_session_id)] = {0};
 	char *ptr_hash_name_encode = NULL;
 
 	print_debug_information ("Entering the function to "
 	                         "create_buy_order ()", __LINE__);
 
-	price_total = price_item * quantity * 100;
+	get_steam_session (NULL, 0, session_id, sizeof (session_id));
+
+	/* Round the item price to cents first, 0.29 * 100 is 28.999... */
+	price_total = money_from_double (price_item) * quantity;
 
-	snprintf (str_price_total, sizeof (str_price_total), "%u", price_total);
+	snprintf (str_price_total, sizeof (str_price_total), "%lld",
+	          (long long)price_total);
 	snprintf (str_quantity, sizeof (str_quantity), "%u", quantity);
 
-	ptr_hash_name_encode = calloc (strlen (market_hash_name) * 3 + 1,
-	                               sizeof (char));
+	ptr_hash_name_encode = steam_calloc (strlen (market_hash_name) * 3 + 1,
+	                                     sizeof (char), ALLOC_TAG_MARKET);
 
 	if (ptr_hash_name_encode == NULL)
 	{
@@ -115,7 +357,7 @@ int8_t create_buy_order (char *market_hash_name, double price_item,
 		      "market_hash_name=" "%s" "&"
 		      "price_total=" "%s" "&"
 		      "quantity=" "%s",
-		      g_session_id, currency, appid, ptr_hash_name_encode,
+		      session_id, currency, appid, ptr_hash_name_encode,
 		      str_price_total, str_quantity);
 
 	ptr_data = curl_general_request (steam_buy_url, steam_url_referer,
@@ -124,8 +366,8 @@ int8_t create_buy_order (char *market_hash_name, double price_item,
 	printf ("Buy item\n");
 	printf ("Response: %s\n", ptr_data);
 	
-	free (ptr_data);
-	free (ptr_hash_name_encode);
+	steam_free (ptr_data);
+	steam_free (ptr_hash_name_encode);
 
 	print_debug_information ("Exiting the function to "
 	                         "create_buy_order ()", __LINE__);
@@ -149,11 +391,14 @@ int8_t cancel_buy_order (const char *buy_order_id)
 	char steam_cancel_buy_order_url[URL_SIZE] = {0};
 	char steam_url_referer[URL_SIZE] = {0};
 	char post_data[POST_DATA_SIZE] = {0};
+	char session_id[sizeof (g_session_id)] = {0};
 	char *ptr_data = NULL;
 
 	print_debug_information ("Entering the function to "
 	                         "cancel_buy_order ()", __LINE__);
 
+	get_steam_session (NULL, 0, session_id, sizeof (session_id));
+
 	snprintf (steam_cancel_buy_order_url, sizeof (steam_cancel_buy_order_url),
 	          URL_STEAM_MARKET "cancelbuyorder/");
 
@@ -162,14 +407,14 @@ int8_t cancel_buy_order (const char *buy_order_id)
 	snprintf (post_data, sizeof (post_data),
 		      "sessionid=" "%s" "&"
 		      "buy_orderid=" "%s",
-		      g_session_id, buy_order_id);
+		      session_id, buy_order_id);
 
 	ptr_data = curl_general_request (steam_cancel_buy_order_url,
 	                                 steam_url_referer, post_data, 0);
 
 	if (ptr_data != NULL)
 	{
-		free (ptr_data);
+		steam_free (ptr_data);
 	}
 
 	print_debug_information ("Exiting the function to "
@@ -195,23 +440,26 @@ int8_t remove_sell_order (const char *sell_order_id)
 	char steam_url_referer[URL_SIZE] = {0};
 	char *ptr_data = NULL;
 	char post_data[POST_DATA_SIZE] = {0};
+	char session_id[sizeof (g_session_id)] = {0};
 
 	print_debug_information ("Entering the function to "
 	                         "remove_sell_order ()", __LINE__);
 
+	get_steam_session (NULL, 0, session_id, sizeof (session_id));
+
 	snprintf (steam_url, sizeof (steam_url), URL_STEAM_MARKET
 	          "removelisting/%s", sell_order_id);
 
 	snprintf (steam_url_referer, sizeof (steam_url_referer),
 	          URL_STEAM_MARKET);
 
-	snprintf (post_data, sizeof (post_data), "sessionid=" "%s", g_session_id);
+	snprintf (post_data, sizeof (post_data), "sessionid=" "%s", session_id);
 
 	ptr_data = curl_general_request (steam_url, steam_url_referer, post_data, 0);
 
 	if (ptr_data != NULL)
 	{
-		free (ptr_data);
+		steam_free (ptr_data);
 	}
 
 	print_debug_information ("Exiting the function to "
@@ -220,6 +468,82 @@ int8_t remove_sell_order (const char *sell_order_id)
 	return SUCCESS;
 }
 
+/*===========================================================================*
+ * Function name    : remove_sell_orders                                     *
+ *                                                                           *
+ * Description      : This function remove many listings concurrently        *
+ *                    within the global request budget                       *
+ *                                                                           *
+ * Input values(s)  : listing_ids                                            *
+ *                    count_listings                                         *
+ *                    max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : results - SUCCESS/FAILURE of every listing, in the     *
+ *                              same order                                   *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if every listing was removed, otherwise        *
+ *                    FAILURE                                                *
+ *===========================================================================*/
+int8_t remove_sell_orders (const uint64_t *listing_ids, size_t count_listings,
+                           int8_t *results, uint32_t max_concurrency)
+{
+	SteamRequest *requests = NULL;
+	char *post_data = NULL;
+	char session_id[sizeof (g_session_id)] = {0};
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "remove_sell_orders ()", __LINE__);
+
+	get_steam_session (NULL, 0, session_id, sizeof (session_id));
+
+	requests = steam_calloc (count_listings + 1, sizeof (SteamRequest),
+	                         ALLOC_TAG_MARKET);
+	post_data = steam_calloc (count_listings + 1, POST_DATA_SIZE, ALLOC_TAG_MARKET);
+
+	if (requests == NULL || post_data == NULL)
+	{
+		steam_free (requests);
+		steam_free (post_data);
+
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < count_listings; index++)
+	{
+		snprintf (requests[index].url, sizeof (requests[index].url),
+		          URL_STEAM_MARKET "removelisting/%llu",
+		          (unsigned long long)listing_ids[index]);
+		snprintf (requests[index].url_referer, sizeof (requests[index].url_referer),
+		          URL_STEAM_MARKET);
+
+		requests[index].post_data = post_data + index * POST_DATA_SIZE;
+
+		snprintf (requests[index].post_data, POST_DATA_SIZE,
+		          "sessionid=" "%s", session_id);
+	}
+
+	curl_batch_request (requests, count_listings, max_concurrency, NULL, NULL);
+
+	for (size_t index = 0; index < count_listings; index++)
+	{
+		results[index] = (requests[index].curl_code == CURLE_OK &&
+		                  requests[index].http_code == 200) ? SUCCESS : FAILURE;
+
+		if (results[index] != SUCCESS)
+			return_value = FAILURE;
+	}
+
+	free_steam_requests (requests, count_listings);
+	steam_free (requests);
+	steam_free (post_data);
+
+	print_debug_information ("Exiting the function to "
+	                         "remove_sell_orders ()", __LINE__);
+
+	return return_value;
+}
+
 /*===========================================================================*
  * Function name    : load_my_listings                                       *
  *                                                                           *
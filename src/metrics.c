@@ -0,0 +1,776 @@
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "../inc/metrics.h"
+#include "../inc/steam.h"
+#include "../inc/allocator.h"
+
+#define METRICS_REQUEST_SIZE   1024
+#define METRICS_HEADER_SIZE    256
+#define METRICS_LABEL_SIZE     64
+#define METRICS_POLL_MS        200
+#define METRICS_RECV_TIMEOUT   2
+#define METRICS_LISTEN_BACKLOG 8
+
+/* Registry is a set of plain counters, writers and the exporter only use
+ * atomic builtins so requests never wait for each other or for a scrape */
+typedef struct tMetricsRegistry {
+	EndpointMetrics  endpoints[METRIC_ENDPOINT_COUNT];
+	MetricHistogram  json_parse;
+	uint64_t         allocations;
+	uint64_t         allocated_bytes;
+} MetricsRegistry;
+
+typedef struct tMetricsListener {
+	int              fd;
+	uint8_t          running;
+	pthread_t        thread;
+	pthread_mutex_t  mutex;
+} MetricsListener;
+
+/* Url fragment of every endpoint, the first match wins */
+typedef struct tEndpointPattern {
+	const char      *pattern;
+	MetricEndpoint   endpoint;
+} EndpointPattern;
+
+static MetricsRegistry s_metrics;
+
+static MetricsListener s_listener = {
+	.fd = -1,
+	.mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static const uint64_t s_latency_bounds[METRIC_COUNT_BUCKETS - 1] =
+	METRIC_LATENCY_BUCKETS;
+static const uint64_t s_parse_bounds[METRIC_COUNT_BUCKETS - 1] =
+	METRIC_PARSE_BUCKETS;
+
+static const char *s_endpoint_names[METRIC_ENDPOINT_COUNT] = {
+	"inventory", "sellitem", "createbuyorder", "cancelbuyorder",
+	"removelisting", "mylistings", "myhistory", "login", "other"
+};
+
+static const EndpointPattern s_endpoint_patterns[] = {
+	{ "market/sellitem",      METRIC_ENDPOINT_SELLITEM },
+	{ "market/createbuyorder", METRIC_ENDPOINT_CREATEBUYORDER },
+	{ "market/cancelbuyorder", METRIC_ENDPOINT_CANCELBUYORDER },
+	{ "market/removelisting", METRIC_ENDPOINT_REMOVELISTING },
+	{ "market/mylistings",    METRIC_ENDPOINT_MYLISTINGS },
+	{ "market/myhistory",     METRIC_ENDPOINT_MYHISTORY },
+	{ "inventory/",           METRIC_ENDPOINT_INVENTORY },
+	{ "login/",               METRIC_ENDPOINT_LOGIN }
+};
+
+static void observe_histogram (MetricHistogram *, const uint64_t *, uint64_t);
+static void write_histogram (FILE *, const char *, const char *,
+                             const MetricHistogram *, const uint64_t *);
+static void write_endpoint_counter (FILE *, const char *, const char *,
+                                    const char *, size_t);
+static void write_memory_metric (FILE *, const char *, const char *,
+                                 const char *, size_t);
+static void serve_metrics_client (int);
+static void *run_metrics_listener (void *);
+
+/*===========================================================================*
+ * Function name    : classify_metric_endpoint                               *
+ *                                                                           *
+ * Description      : This function get endpoint a request is accounted to   *
+ *                                                                           *
+ * Input values(s)  : url                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Endpoint, METRIC_ENDPOINT_OTHER when unknown           *
+ *===========================================================================*/
+MetricEndpoint classify_metric_endpoint (const char *url)
+{
+	size_t count_patterns = sizeof (s_endpoint_patterns) /
+	                        sizeof (s_endpoint_patterns[0]);
+
+	if (url == NULL)
+		return METRIC_ENDPOINT_OTHER;
+
+	for (size_t index = 0; index < count_patterns; index++)
+	{
+		if (strstr (url, s_endpoint_patterns[index].pattern) != NULL)
+			return s_endpoint_patterns[index].endpoint;
+	}
+
+	return METRIC_ENDPOINT_OTHER;
+}
+
+/*===========================================================================*
+ * Function name    : get_metrics_time_us                                    *
+ *                                                                           *
+ * Description      : This function get monotonic time                       *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Microseconds                                           *
+ *===========================================================================*/
+uint64_t get_metrics_time_us (void)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+/*===========================================================================*
+ * Function name    : observe_histogram                                      *
+ *                                                                           *
+ * Description      : This function add value to its bucket                  *
+ *                                                                           *
+ * Input values(s)  : histogram                                              *
+ *                    bounds - METRIC_COUNT_BUCKETS - 1 upper bounds         *
+ *                    value_us                                               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void observe_histogram (MetricHistogram *histogram,
+                               const uint64_t *bounds, uint64_t value_us)
+{
+	size_t index = 0;
+
+	while (index < METRIC_COUNT_BUCKETS - 1 && value_us > bounds[index])
+		index++;
+
+	__atomic_fetch_add (&histogram->buckets[index], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add (&histogram->count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add (&histogram->sum_us, value_us, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*
+ * Function name    : begin_request_metrics                                  *
+ *                                                                           *
+ * Description      : This function count request going in flight            *
+ *                                                                           *
+ * Input values(s)  : endpoint                                               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void begin_request_metrics (MetricEndpoint endpoint)
+{
+	__atomic_fetch_add (&s_metrics.endpoints[endpoint].in_flight, 1,
+	                    __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*
+ * Function name    : end_request_metrics                                    *
+ *                                                                           *
+ * Description      : This function record completed request: latency,       *
+ *                    bytes in and out and errors (curl error or http 4xx/   *
+ *                    5xx)                                                   *
+ *                                                                           *
+ * Input values(s)  : endpoint                                               *
+ *                    curl - completed easy handle, before cleanup           *
+ *                    curl_code - result of the transfer                     *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void end_request_metrics (MetricEndpoint endpoint, CURL *curl,
+                          CURLcode curl_code)
+{
+	EndpointMetrics *metrics = &s_metrics.endpoints[endpoint];
+	curl_off_t total_time_us = 0;
+	curl_off_t bytes_in = 0;
+	curl_off_t bytes_out = 0;
+	long http_code = 0;
+
+	curl_easy_getinfo (curl, CURLINFO_TOTAL_TIME_T, &total_time_us);
+	curl_easy_getinfo (curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes_in);
+	curl_easy_getinfo (curl, CURLINFO_SIZE_UPLOAD_T, &bytes_out);
+	curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_code);
+
+	__atomic_fetch_sub (&metrics->in_flight, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add (&metrics->requests, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add (&metrics->bytes_in, (uint64_t)bytes_in, __ATOMIC_RELAXED);
+	__atomic_fetch_add (&metrics->bytes_out, (uint64_t)bytes_out, __ATOMIC_RELAXED);
+
+	if (curl_code != CURLE_OK || http_code >= 400)
+		__atomic_fetch_add (&metrics->errors, 1, __ATOMIC_RELAXED);
+
+	observe_histogram (&metrics->latency, s_latency_bounds,
+	                   (uint64_t)total_time_us);
+}
+
+/*===========================================================================*
+ * Function name    : count_retry_metrics                                    *
+ *                                                                           *
+ * Description      : This function count request sent again                 *
+ *                                                                           *
+ * Input values(s)  : endpoint                                               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void count_retry_metrics (MetricEndpoint endpoint)
+{
+	__atomic_fetch_add (&s_metrics.endpoints[endpoint].retries, 1,
+	                    __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*
+ * Function name    : record_json_parse_metrics                              *
+ *                                                                           *
+ * Description      : This function record time of one json parse            *
+ *                                                                           *
+ * Input values(s)  : duration_us                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void record_json_parse_metrics (uint64_t duration_us)
+{
+	observe_histogram (&s_metrics.json_parse, s_parse_bounds, duration_us);
+}
+
+/*===========================================================================*
+ * Function name    : count_allocation_metrics                               *
+ *                                                                           *
+ * Description      : This function count allocation of response buffers     *
+ *                                                                           *
+ * Input values(s)  : size - bytes                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void count_allocation_metrics (size_t size)
+{
+	__atomic_fetch_add (&s_metrics.allocations, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add (&s_metrics.allocated_bytes, (uint64_t)size,
+	                    __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*
+ * Function name    : get_endpoint_metrics                                   *
+ *                                                                           *
+ * Description      : This function copy metrics of one endpoint             *
+ *                                                                           *
+ * Input values(s)  : endpoint                                               *
+ *                                                                           *
+ * Output values(s) : metrics - every field is read atomically, the copy as  *
+ *                              a whole is not a snapshot                    *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void get_endpoint_metrics (MetricEndpoint endpoint, EndpointMetrics *metrics)
+{
+	const EndpointMetrics *source = &s_metrics.endpoints[endpoint];
+
+	metrics->requests = __atomic_load_n (&source->requests, __ATOMIC_RELAXED);
+	metrics->errors = __atomic_load_n (&source->errors, __ATOMIC_RELAXED);
+	metrics->retries = __atomic_load_n (&source->retries, __ATOMIC_RELAXED);
+	metrics->bytes_in = __atomic_load_n (&source->bytes_in, __ATOMIC_RELAXED);
+	metrics->bytes_out = __atomic_load_n (&source->bytes_out, __ATOMIC_RELAXED);
+	metrics->in_flight = __atomic_load_n (&source->in_flight, __ATOMIC_RELAXED);
+
+	for (size_t index = 0; index < METRIC_COUNT_BUCKETS; index++)
+	{
+		metrics->latency.buckets[index] =
+			__atomic_load_n (&source->latency.buckets[index], __ATOMIC_RELAXED);
+	}
+
+	metrics->latency.count = __atomic_load_n (&source->latency.count,
+	                                          __ATOMIC_RELAXED);
+	metrics->latency.sum_us = __atomic_load_n (&source->latency.sum_us,
+	                                           __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*
+ * Function name    : write_endpoint_counter                                 *
+ *                                                                           *
+ * Description      : This function write one value per endpoint             *
+ *                                                                           *
+ * Input values(s)  : file                                                   *
+ *                    name - metric name                                     *
+ *                    type - counter/gauge                                   *
+ *                    help                                                   *
+ *                    offset - offset of the field in EndpointMetrics        *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void write_endpoint_counter (FILE *file, const char *name,
+                                    const char *type, const char *help,
+                                    size_t offset)
+{
+	fprintf (file, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+
+	for (size_t index = 0; index < METRIC_ENDPOINT_COUNT; index++)
+	{
+		const char *field = (const char *)&s_metrics.endpoints[index] + offset;
+
+		/* in_flight is the only signed field */
+		if (offset == offsetof (EndpointMetrics, in_flight))
+		{
+			fprintf (file, "%s{endpoint=\"%s\"} %lld\n", name,
+			         s_endpoint_names[index],
+			         (long long)__atomic_load_n ((const int64_t *)field,
+			                                     __ATOMIC_RELAXED));
+		}
+		else
+		{
+			fprintf (file, "%s{endpoint=\"%s\"} %llu\n", name,
+			         s_endpoint_names[index],
+			         (unsigned long long)__atomic_load_n ((const uint64_t *)field,
+			                                              __ATOMIC_RELAXED));
+		}
+	}
+}
+
+/*===========================================================================*
+ * Function name    : write_histogram                                        *
+ *                                                                           *
+ * Description      : This function write histogram with cumulative buckets  *
+ *                    in seconds                                             *
+ *                                                                           *
+ * Input values(s)  : file                                                   *
+ *                    name - metric name                                     *
+ *                    endpoint - endpoint label (NULL for none)              *
+ *                    histogram                                              *
+ *                    bounds - METRIC_COUNT_BUCKETS - 1 upper bounds         *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void write_histogram (FILE *file, const char *name, const char *endpoint,
+                             const MetricHistogram *histogram,
+                             const uint64_t *bounds)
+{
+	char labels[METRICS_LABEL_SIZE] = {0};
+	char le_labels[METRICS_LABEL_SIZE] = {0};
+	uint64_t cumulative = 0;
+
+	if (endpoint != NULL)
+	{
+		snprintf (labels, sizeof (labels), "{endpoint=\"%s\"}", endpoint);
+		snprintf (le_labels, sizeof (le_labels), "endpoint=\"%s\",", endpoint);
+	}
+
+	for (size_t index = 0; index < METRIC_COUNT_BUCKETS; index++)
+	{
+		cumulative += __atomic_load_n (&histogram->buckets[index],
+		                               __ATOMIC_RELAXED);
+
+		if (index < METRIC_COUNT_BUCKETS - 1)
+		{
+			fprintf (file, "%s_bucket{%sle=\"%g\"} %llu\n", name, le_labels,
+			         (double)bounds[index] / 1e6, (unsigned long long)cumulative);
+		}
+		else
+		{
+			fprintf (file, "%s_bucket{%sle=\"+Inf\"} %llu\n", name, le_labels,
+			         (unsigned long long)cumulative);
+		}
+	}
+
+	fprintf (file, "%s_sum%s %.6f\n", name, labels,
+	         (double)__atomic_load_n (&histogram->sum_us, __ATOMIC_RELAXED) / 1e6);
+	fprintf (file, "%s_count%s %llu\n", name, labels,
+	         (unsigned long long)cumulative);
+}
+
+/*===========================================================================*
+ * Function name    : write_memory_metric                                    *
+ *                                                                           *
+ * Description      : This function write one value per allocation tag       *
+ *                                                                           *
+ * Input values(s)  : file                                                   *
+ *                    name - metric name                                     *
+ *                    type - counter/gauge                                   *
+ *                    help                                                   *
+ *                    offset - offset of the field in AllocationStats        *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void write_memory_metric (FILE *file, const char *name,
+                                 const char *type, const char *help,
+                                 size_t offset)
+{
+	AllocationStats stats;
+
+	fprintf (file, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+
+	for (size_t index = 0; index < ALLOC_TAG_COUNT; index++)
+	{
+		get_allocation_stats ((AllocationTag)index, &stats);
+
+		fprintf (file, "%s{subsystem=\"%s\"} %llu\n", name,
+		         get_allocation_tag_name ((AllocationTag)index),
+		         (unsigned long long)*(const uint64_t *)((const char *)&stats +
+		                                                 offset));
+	}
+}
+
+/*===========================================================================*
+ * Function name    : write_metrics                                          *
+ *                                                                           *
+ * Description      : This function write registry in Prometheus text        *
+ *                    format (version 0.0.4)                                 *
+ *                                                                           *
+ * Input values(s)  : file                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t write_metrics (FILE *file)
+{
+	write_endpoint_counter (file, "steam_requests_total", "counter",
+	                        "Completed requests to Steam.",
+	                        offsetof (EndpointMetrics, requests));
+	write_endpoint_counter (file, "steam_request_errors_total", "counter",
+	                        "Requests failed by curl or with http status >= 400.",
+	                        offsetof (EndpointMetrics, errors));
+	write_endpoint_counter (file, "steam_request_retries_total", "counter",
+	                        "Requests sent again after session refresh.",
+	                        offsetof (EndpointMetrics, retries));
+	write_endpoint_counter (file, "steam_received_bytes_total", "counter",
+	                        "Response body bytes.",
+	                        offsetof (EndpointMetrics, bytes_in));
+	write_endpoint_counter (file, "steam_sent_bytes_total", "counter",
+	                        "Request body bytes.",
+	                        offsetof (EndpointMetrics, bytes_out));
+	write_endpoint_counter (file, "steam_requests_in_flight", "gauge",
+	                        "Requests being sent.",
+	                        offsetof (EndpointMetrics, in_flight));
+
+	fprintf (file, "# HELP steam_request_duration_seconds Request latency.\n"
+	               "# TYPE steam_request_duration_seconds histogram\n");
+
+	for (size_t index = 0; index < METRIC_ENDPOINT_COUNT; index++)
+	{
+		write_histogram (file, "steam_request_duration_seconds",
+		                 s_endpoint_names[index],
+		                 &s_metrics.endpoints[index].latency, s_latency_bounds);
+	}
+
+	fprintf (file, "# HELP steam_json_parse_duration_seconds Time to parse "
+	               "json responses.\n"
+	               "# TYPE steam_json_parse_duration_seconds histogram\n");
+	write_histogram (file, "steam_json_parse_duration_seconds", NULL,
+	                 &s_metrics.json_parse, s_parse_bounds);
+
+	fprintf (file, "# HELP steam_allocations_total Response buffer allocations.\n"
+	               "# TYPE steam_allocations_total counter\n"
+	               "steam_allocations_total %llu\n"
+	               "# HELP steam_allocated_bytes_total Response buffer bytes "
+	               "allocated.\n"
+	               "# TYPE steam_allocated_bytes_total counter\n"
+	               "steam_allocated_bytes_total %llu\n",
+	         (unsigned long long)__atomic_load_n (&s_metrics.allocations,
+	                                              __ATOMIC_RELAXED),
+	         (unsigned long long)__atomic_load_n (&s_metrics.allocated_bytes,
+	                                              __ATOMIC_RELAXED));
+
+	write_memory_metric (file, "steam_memory_live_bytes", "gauge",
+	                     "Bytes allocated by the library and not freed yet.",
+	                     offsetof (AllocationStats, live_bytes));
+	write_memory_metric (file, "steam_memory_peak_bytes", "gauge",
+	                     "High-water mark of live bytes.",
+	                     offsetof (AllocationStats, peak_bytes));
+	write_memory_metric (file, "steam_memory_live_blocks", "gauge",
+	                     "Blocks allocated by the library and not freed yet.",
+	                     offsetof (AllocationStats, live_blocks));
+
+	return ferror (file) ? FAILURE : SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : save_metrics                                           *
+ *                                                                           *
+ * Description      : This function write registry to file, replaced with    *
+ *                    rename so a collector never reads it half written      *
+ *                                                                           *
+ * Input values(s)  : file_name                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t save_metrics (const char *file_name)
+{
+	char tmp_file_name[METRICS_HEADER_SIZE] = {0};
+	char error_message[ERROR_MESSAGE_SIZE] = {0};
+	FILE *file = NULL;
+	int8_t return_value = FAILURE;
+
+	print_debug_information ("Entering the function to "
+	                         "save_metrics ()", __LINE__);
+
+	snprintf (tmp_file_name, sizeof (tmp_file_name), "%s.tmp", file_name);
+
+	file = fopen (tmp_file_name, "w");
+
+	if (file == NULL)
+	{
+		snprintf (error_message, ERROR_MESSAGE_SIZE, "[ERROR %u] ", __LINE__);
+		perror (error_message);
+
+		return FAILURE;
+	}
+
+	return_value = write_metrics (file);
+
+	if (fclose (file) != 0)
+		return_value = FAILURE;
+
+	if (return_value == SUCCESS && rename (tmp_file_name, file_name) != 0)
+	{
+		snprintf (error_message, ERROR_MESSAGE_SIZE, "[ERROR %u] ", __LINE__);
+		perror (error_message);
+
+		return_value = FAILURE;
+	}
+
+	if (return_value != SUCCESS)
+		unlink (tmp_file_name);
+
+	print_debug_information ("Exiting the function to "
+	                         "save_metrics ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : serve_metrics_client                                   *
+ *                                                                           *
+ * Description      : This function answer one http request, GET /metrics    *
+ *                    gets the registry, anything else 404                   *
+ *                                                                           *
+ * Input values(s)  : fd - accepted connection                               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void serve_metrics_client (int fd)
+{
+	char request[METRICS_REQUEST_SIZE] = {0};
+	char header[METRICS_HEADER_SIZE] = {0};
+	char *body = NULL;
+	size_t size_body = 0;
+	size_t length_header = 0;
+	ssize_t count_read = 0;
+	FILE *file = NULL;
+	struct timeval timeout = { METRICS_RECV_TIMEOUT, 0 };
+
+	setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+
+	count_read = recv (fd, request, sizeof (request) - 1, 0);
+
+	if (count_read <= 0)
+		return;
+
+	if (strncmp (request, "GET /metrics ", strlen ("GET /metrics ")) != 0 &&
+	    strncmp (request, "GET / ", strlen ("GET / ")) != 0)
+	{
+		length_header = snprintf (header, sizeof (header),
+		                          "HTTP/1.0 404 Not Found\r\n"
+		                          "Content-Length: 0\r\n"
+		                          "Connection: close\r\n\r\n");
+		send (fd, header, length_header, MSG_NOSIGNAL);
+
+		return;
+	}
+
+	file = open_memstream (&body, &size_body);
+
+	if (file == NULL)
+		return;
+
+	write_metrics (file);
+	fclose (file);
+
+	length_header = snprintf (header, sizeof (header),
+	                          "HTTP/1.0 200 OK\r\n"
+	                          "Content-Type: text/plain; version=0.0.4\r\n"
+	                          "Content-Length: %zu\r\n"
+	                          "Connection: close\r\n\r\n", size_body);
+
+	if (send (fd, header, length_header, MSG_NOSIGNAL) == (ssize_t)length_header)
+	{
+		for (size_t sent = 0; sent < size_body; )
+		{
+			ssize_t count_sent = send (fd, body + sent, size_body - sent,
+			                           MSG_NOSIGNAL);
+
+			if (count_sent <= 0)
+				break;
+
+			sent += count_sent;
+		}
+	}
+
+	/* Buffer of open_memstream () is libc memory */
+	free (body);
+}
+
+/*===========================================================================*
+ * Function name    : run_metrics_listener                                   *
+ *                                                                           *
+ * Description      : This function accept scrapes until                     *
+ *                    stop_metrics_listener ()                               *
+ *                                                                           *
+ * Input values(s)  : arg - unused                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : NULL                                                   *
+ *===========================================================================*/
+static void *run_metrics_listener (void *arg)
+{
+	struct pollfd listen_poll;
+	int client_fd = -1;
+
+	(void)arg;
+
+	listen_poll.fd = s_listener.fd;
+	listen_poll.events = POLLIN;
+
+	/* Short poll timeout lets the thread notice stop without closing the
+	 * socket under it */
+	while (__atomic_load_n (&s_listener.running, __ATOMIC_ACQUIRE) != 0)
+	{
+		if (poll (&listen_poll, 1, METRICS_POLL_MS) <= 0)
+			continue;
+
+		client_fd = accept (s_listener.fd, NULL, NULL);
+
+		if (client_fd < 0)
+			continue;
+
+		serve_metrics_client (client_fd);
+		close (client_fd);
+	}
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : start_metrics_listener                                 *
+ *                                                                           *
+ * Description      : This function start thread serving the registry over   *
+ *                    http on 127.0.0.1                                      *
+ *                                                                           *
+ * Input values(s)  : port                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t start_metrics_listener (uint16_t port)
+{
+	struct sockaddr_in address;
+	char error_message[ERROR_MESSAGE_SIZE] = {0};
+	int option = 1;
+	int8_t return_value = FAILURE;
+
+	print_debug_information ("Entering the function to "
+	                         "start_metrics_listener ()", __LINE__);
+
+	pthread_mutex_lock (&s_listener.mutex);
+
+	if (s_listener.running != 0)
+	{
+		pthread_mutex_unlock (&s_listener.mutex);
+
+		return FAILURE;
+	}
+
+	memset (&address, 0, sizeof (address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons (port);
+	address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+	s_listener.fd = socket (AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+	if (s_listener.fd >= 0 &&
+	    setsockopt (s_listener.fd, SOL_SOCKET, SO_REUSEADDR, &option,
+	                sizeof (option)) == 0 &&
+	    bind (s_listener.fd, (struct sockaddr *)&address, sizeof (address)) == 0 &&
+	    listen (s_listener.fd, METRICS_LISTEN_BACKLOG) == 0)
+	{
+		__atomic_store_n (&s_listener.running, 1, __ATOMIC_RELEASE);
+
+		if (pthread_create (&s_listener.thread, NULL, run_metrics_listener,
+		                    NULL) == 0)
+		{
+			return_value = SUCCESS;
+		}
+		else
+		{
+			__atomic_store_n (&s_listener.running, 0, __ATOMIC_RELEASE);
+		}
+	}
+
+	if (return_value != SUCCESS)
+	{
+		snprintf (error_message, ERROR_MESSAGE_SIZE, "[ERROR %u] ", __LINE__);
+		perror (error_message);
+
+		if (s_listener.fd >= 0)
+			close (s_listener.fd);
+
+		s_listener.fd = -1;
+	}
+
+	pthread_mutex_unlock (&s_listener.mutex);
+
+	print_debug_information ("Exiting the function to "
+	                         "start_metrics_listener ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : stop_metrics_listener                                  *
+ *                                                                           *
+ * Description      : This function stop thread started by                   *
+ *                    start_metrics_listener ()                              *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void stop_metrics_listener (void)
+{
+	pthread_mutex_lock (&s_listener.mutex);
+
+	if (s_listener.running != 0)
+	{
+		__atomic_store_n (&s_listener.running, 0, __ATOMIC_RELEASE);
+
+		pthread_join (s_listener.thread, NULL);
+
+		close (s_listener.fd);
+		s_listener.fd = -1;
+	}
+
+	pthread_mutex_unlock (&s_listener.mutex);
+}
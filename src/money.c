@@ -0,0 +1,238 @@
+#include "../inc/money.h"
+#include "../inc/steam.h"
+
+#define BASIS_POINTS  10000
+
+static Money compute_fee (Money, uint32_t);
+
+/*===========================================================================*
+ * Function name    : money_from_double                                      *
+ *                                                                           *
+ * Description      : This function convert amount in currency units to      *
+ *                    cents, rounding to the nearest cent                    *
+ *                                                                           *
+ * Input values(s)  : value                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Money                                                  *
+ *===========================================================================*/
+Money money_from_double (double value)
+{
+	return (Money)(value * 100.0 + (value < 0.0 ? -0.5 : 0.5));
+}
+
+/*===========================================================================*
+ * Function name    : parse_money                                            *
+ *                                                                           *
+ * Description      : This function parse "0.25", "$1,234.56", "0,35 pуб."   *
+ *                                                                           *
+ * Input values(s)  : text                                                   *
+ *                                                                           *
+ * Output values(s) : money                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t parse_money (const char *text, Money *money)
+{
+	uint32_t cents = 0;
+
+	if (parse_price_text (text, strlen (text), &cents) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	*money = cents;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : format_money                                           *
+ *                                                                           *
+ * Description      : This function format money as "12.34"                  *
+ *                                                                           *
+ * Input values(s)  : money                                                  *
+ *                    size_str                                               *
+ *                                                                           *
+ * Output values(s) : str                                                    *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void format_money (Money money, char *str, size_t size_str)
+{
+	uint64_t cents = money < 0 ? -(uint64_t)money : (uint64_t)money;
+
+	snprintf (str, size_str, "%s%llu.%02llu", money < 0 ? "-" : "",
+	          (unsigned long long)(cents / 100), (unsigned long long)(cents % 100));
+}
+
+/*===========================================================================*
+ * Function name    : compute_fee                                            *
+ *                                                                           *
+ * Description      : This function compute one fee of received amount,      *
+ *                    rounded down but at least MARKET_FEE_MINIMUM           *
+ *                                                                           *
+ * Input values(s)  : received                                               *
+ *                    fee_bp - fee in basis points, 0 for no fee             *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Fee                                                    *
+ *===========================================================================*/
+static Money compute_fee (Money received, uint32_t fee_bp)
+{
+	Money fee = received * fee_bp / BASIS_POINTS;
+
+	if (fee_bp == 0)
+	{
+		return 0;
+	}
+
+	return fee < MARKET_FEE_MINIMUM ? MARKET_FEE_MINIMUM : fee;
+}
+
+/*===========================================================================*
+ * Function name    : compute_fees_for_received                              *
+ *                                                                           *
+ * Description      : This function compute what buyer pays for amount the   *
+ *                    seller receives (steam fee 5%, publisher fee, each at  *
+ *                    least one cent)                                        *
+ *                                                                           *
+ * Input values(s)  : received                                               *
+ *                    publisher_fee_bp - PUBLISHER_FEE_BASIS_POINTS for      *
+ *                                       most games                          *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Fees                                                   *
+ *===========================================================================*/
+SteamFees compute_fees_for_received (Money received, uint32_t publisher_fee_bp)
+{
+	SteamFees fees;
+
+	fees.received = received;
+	fees.steam_fee = compute_fee (received, STEAM_FEE_BASIS_POINTS);
+	fees.publisher_fee = compute_fee (received, publisher_fee_bp);
+	fees.amount = received + fees.steam_fee + fees.publisher_fee;
+
+	return fees;
+}
+
+/*===========================================================================*
+ * Function name    : compute_fees_for_amount                                *
+ *                                                                           *
+ * Description      : This function compute what seller receives for amount  *
+ *                    the buyer pays: the largest received amount that does  *
+ *                    not cost more, the rest goes to steam fee (as steam    *
+ *                    does it)                                               *
+ *                                                                           *
+ * Input values(s)  : amount                                                 *
+ *                    publisher_fee_bp                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Fees, received is 0 when amount is too small           *
+ *===========================================================================*/
+SteamFees compute_fees_for_amount (Money amount, uint32_t publisher_fee_bp)
+{
+	SteamFees fees;
+	SteamFees candidate;
+	Money estimate = 0;
+
+	memset (&fees, 0, sizeof (fees));
+
+	fees.amount = amount;
+
+	/* Rounding of the fees moves the answer at most 3 cents away */
+	estimate = amount * BASIS_POINTS / (BASIS_POINTS + STEAM_FEE_BASIS_POINTS +
+	                                    publisher_fee_bp);
+
+	for (Money received = estimate + 3; received >= estimate - 3; received--)
+	{
+		if (received < 1)
+			break;
+
+		candidate = compute_fees_for_received (received, publisher_fee_bp);
+
+		if (candidate.amount <= amount)
+		{
+			fees.received = received;
+			fees.publisher_fee = candidate.publisher_fee;
+			fees.steam_fee = amount - received - candidate.publisher_fee;
+			break;
+		}
+	}
+
+	return fees;
+}
+
+/*===========================================================================*
+ * Function name    : reprice_items                                          *
+ *                                                                           *
+ * Description      : This function compute list and buy order prices of     *
+ *                    many items at once. Lists undercut the lowest sell     *
+ *                    order, orders overbid the highest buy order without    *
+ *                    crossing the lowest sell order. The loop has no        *
+ *                    branches or calls so the compiler vectorizes it        *
+ *                    (prices up to 1000000 cents)                           *
+ *                                                                           *
+ * Input values(s)  : lowest_sell - cents buyers pay, 0 for no listings      *
+ *                    highest_buy - cents, 0 for no buy orders               *
+ *                    count_items                                            *
+ *                    rule                                                   *
+ *                                                                           *
+ * Output values(s) : list_received - what the seller receives (the price    *
+ *                                    of sellitem), 0 for do not list        *
+ *                    order_price - per item, 0 for do not order             *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void reprice_items (const int32_t *restrict lowest_sell,
+                    const int32_t *restrict highest_buy, size_t count_items,
+                    const RepriceRule *rule, int32_t *restrict list_received,
+                    int32_t *restrict order_price)
+{
+	const int32_t undercut = rule->undercut;
+	const int32_t overbid = rule->overbid;
+	const int32_t min_received = rule->min_received;
+	const int32_t max_order_price = rule->max_order_price > 0 ?
+	                                rule->max_order_price : INT32_MAX;
+	const int32_t publisher_fee_bp = rule->publisher_fee_bp;
+	const int32_t publisher_fee_minimum = publisher_fee_bp > 0 ? MARKET_FEE_MINIMUM : 0;
+	const float inverse_fee = (float)BASIS_POINTS / (BASIS_POINTS + STEAM_FEE_BASIS_POINTS +
+	                                                 publisher_fee_bp);
+
+	for (size_t index = 0; index < count_items; index++)
+	{
+		int32_t amount = lowest_sell[index] - undercut;
+		int32_t estimate = (int32_t)((float)amount * inverse_fee);
+		int32_t received = 0;
+		int32_t order = highest_buy[index] + overbid;
+
+		/* The float estimate adds one more cent of error to the three
+		 * of compute_fees_for_amount () */
+		for (int32_t step = -4; step <= 4; step++)
+		{
+			int32_t candidate = estimate + step;
+			int32_t steam_fee = candidate * STEAM_FEE_BASIS_POINTS / BASIS_POINTS;
+			int32_t publisher_fee = candidate * publisher_fee_bp / BASIS_POINTS;
+
+			steam_fee = steam_fee < MARKET_FEE_MINIMUM ? MARKET_FEE_MINIMUM : steam_fee;
+			publisher_fee = publisher_fee < publisher_fee_minimum ?
+			                publisher_fee_minimum : publisher_fee;
+
+			received = (candidate >= 1 &&
+			            candidate + steam_fee + publisher_fee <= amount) ?
+			           candidate : received;
+		}
+
+		received = received < min_received ? min_received : received;
+		list_received[index] = lowest_sell[index] > 0 ? received : 0;
+
+		order = order > max_order_price ? max_order_price : order;
+		order = (lowest_sell[index] > 0 && order >= lowest_sell[index]) ?
+		        lowest_sell[index] - 1 : order;
+		order_price[index] = (highest_buy[index] > 0 && order > 0) ? order : 0;
+	}
+}
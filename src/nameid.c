@@ -0,0 +1,646 @@
+#include "../inc/nameid.h"
+#include "../inc/steam.h"
+#include "../inc/transport.h"
+
+#define NO_ENTRY          UINT32_MAX
+#define NAMEID_LINE_SIZE  1024
+
+typedef struct tNameIdBatch {
+	NameIdCache  *cache;
+	uint32_t      app_id;
+} NameIdBatch;
+
+typedef struct tNameIdJob {
+	const char  *market_hash_name;
+	uint64_t    *item_nameid;
+} NameIdJob;
+
+static uint32_t hash_nameid_key (uint32_t, const char *);
+static uint32_t find_nameid_entry (const NameIdCache *, uint32_t, const char *,
+                                   uint32_t);
+static int8_t grow_nameid_buckets (NameIdCache *);
+static int8_t add_nameid_entry (NameIdCache *, uint32_t, const char *, uint64_t,
+                                uint32_t);
+static int8_t build_listing_url (char *, size_t, uint32_t, const char *);
+static void extract_batch_item_nameid (SteamRequest *, void *);
+
+/*===========================================================================*
+ * Function name    : hash_nameid_key                                        *
+ *                                                                           *
+ * Description      : This function hash app id and market_hash_name         *
+ *                    (FNV-1a)                                               *
+ *                                                                           *
+ * Input values(s)  : app_id                                                 *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Hash                                                   *
+ *===========================================================================*/
+static uint32_t hash_nameid_key (uint32_t app_id, const char *market_hash_name)
+{
+	uint32_t hash = 2166136261u ^ app_id;
+
+	for (; *market_hash_name != '\0'; market_hash_name++)
+	{
+		hash ^= (uint8_t)*market_hash_name;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/*===========================================================================*
+ * Function name    : find_nameid_entry                                      *
+ *                                                                           *
+ * Description      : This function find bucket of key (mutex must be held)  *
+ *                                                                           *
+ * Input values(s)  : cache                                                  *
+ *                    app_id                                                 *
+ *                    market_hash_name                                       *
+ *                    hash                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Bucket holding the key or the empty bucket for it      *
+ *===========================================================================*/
+static uint32_t find_nameid_entry (const NameIdCache *cache, uint32_t app_id,
+                                   const char *market_hash_name, uint32_t hash)
+{
+	const NameIdEntry *entry = NULL;
+	uint32_t bucket = hash & cache->bucket_mask;
+
+	while (cache->buckets[bucket] != NO_ENTRY)
+	{
+		entry = &cache->entries[cache->buckets[bucket]];
+
+		if (entry->hash == hash && entry->app_id == app_id &&
+		    strcmp (entry->market_hash_name, market_hash_name) == STRINGS_EQUAL)
+		{
+			break;
+		}
+
+		bucket = (bucket + 1) & cache->bucket_mask;
+	}
+
+	return bucket;
+}
+
+/*===========================================================================*
+ * Function name    : grow_nameid_buckets                                    *
+ *                                                                           *
+ * Description      : This function double hash table and rehash entries     *
+ *                                                                           *
+ * Input values(s)  : cache                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t grow_nameid_buckets (NameIdCache *cache)
+{
+	uint32_t count_buckets = cache->buckets ? (cache->bucket_mask + 1) * 2 : 1024;
+	uint32_t *buckets = steam_malloc (count_buckets * sizeof (uint32_t),
+	                                  ALLOC_TAG_MARKET);
+	uint32_t bucket = 0;
+
+	if (buckets == NULL)
+	{
+		return FAILURE;
+	}
+
+	memset (buckets, 0xFF, count_buckets * sizeof (uint32_t));
+
+	for (uint32_t index = 0; index < cache->count_entries; index++)
+	{
+		bucket = cache->entries[index].hash & (count_buckets - 1);
+
+		while (buckets[bucket] != NO_ENTRY)
+			bucket = (bucket + 1) & (count_buckets - 1);
+
+		buckets[bucket] = index;
+	}
+
+	steam_free (cache->buckets);
+
+	cache->buckets = buckets;
+	cache->bucket_mask = count_buckets - 1;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : add_nameid_entry                                       *
+ *                                                                           *
+ * Description      : This function add entry to memory (mutex must be held) *
+ *                                                                           *
+ * Input values(s)  : cache                                                  *
+ *                    app_id                                                 *
+ *                    market_hash_name                                       *
+ *                    item_nameid                                            *
+ *                    hash                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t add_nameid_entry (NameIdCache *cache, uint32_t app_id,
+                                const char *market_hash_name,
+                                uint64_t item_nameid, uint32_t hash)
+{
+	NameIdEntry *ptr_entries = NULL;
+	NameIdEntry *entry = NULL;
+	uint32_t bucket = 0;
+
+	/* Load factor stays at most one half */
+	if (cache->buckets == NULL || (cache->count_entries + 1) * 2 > cache->bucket_mask + 1)
+	{
+		if (grow_nameid_buckets (cache) != SUCCESS)
+		{
+			return FAILURE;
+		}
+	}
+
+	if (cache->count_entries == cache->capacity)
+	{
+		uint32_t capacity = cache->capacity ? cache->capacity * 2 : 256;
+
+		ptr_entries = steam_realloc (cache->entries, capacity * sizeof (NameIdEntry),
+		                             ALLOC_TAG_MARKET);
+
+		if (ptr_entries == NULL)
+		{
+			return FAILURE;
+		}
+
+		cache->entries = ptr_entries;
+		cache->capacity = capacity;
+	}
+
+	bucket = find_nameid_entry (cache, app_id, market_hash_name, hash);
+
+	if (cache->buckets[bucket] != NO_ENTRY)
+	{
+		cache->entries[cache->buckets[bucket]].item_nameid = item_nameid;
+
+		return SUCCESS;
+	}
+
+	entry = &cache->entries[cache->count_entries];
+
+	entry->market_hash_name = steam_strdup (market_hash_name, ALLOC_TAG_MARKET);
+
+	if (entry->market_hash_name == NULL)
+	{
+		return FAILURE;
+	}
+
+	entry->app_id = app_id;
+	entry->hash = hash;
+	entry->item_nameid = item_nameid;
+
+	cache->buckets[bucket] = cache->count_entries++;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : open_nameid_cache                                      *
+ *                                                                           *
+ * Description      : This function load cache file and keep it open to      *
+ *                    append new ids                                         *
+ *                                                                           *
+ * Input values(s)  : file_name                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Cache or NULL                                          *
+ *===========================================================================*/
+NameIdCache *open_nameid_cache (const char *file_name)
+{
+	NameIdCache *cache = NULL;
+	char line[NAMEID_LINE_SIZE] = {0};
+	char *ptr_name = NULL;
+	char *ptr_end = NULL;
+	unsigned int app_id = 0;
+	unsigned long long item_nameid = 0;
+	int name_offset = 0;
+	int8_t torn_line = 0;
+
+	print_debug_information ("Entering the function to "
+	                         "open_nameid_cache ()", __LINE__);
+
+	cache = steam_calloc (1, sizeof (NameIdCache), ALLOC_TAG_MARKET);
+
+	if (cache == NULL)
+	{
+		return NULL;
+	}
+
+	pthread_mutex_init (&cache->mutex, NULL);
+
+	cache->file = fopen (file_name, "a+");
+
+	if (cache->file == NULL || grow_nameid_buckets (cache) != SUCCESS)
+	{
+		close_nameid_cache (cache);
+
+		return NULL;
+	}
+
+	rewind (cache->file);
+
+	/* appid \t item_nameid \t market_hash_name */
+	while (fgets (line, sizeof (line), cache->file) != NULL)
+	{
+		ptr_end = strchr (line, '\n');
+		torn_line = ptr_end == NULL;
+
+		if (torn_line || sscanf (line, "%u\t%llu\t%n", &app_id, &item_nameid,
+		                         &name_offset) != 2)
+		{
+			continue;
+		}
+
+		*ptr_end = '\0';
+		ptr_name = line + name_offset;
+
+		add_nameid_entry (cache, app_id, ptr_name, item_nameid,
+		                  hash_nameid_key (app_id, ptr_name));
+	}
+
+	/* Do not glue the next line to one cut by an interrupted write */
+	if (torn_line)
+		fputc ('\n', cache->file);
+
+	print_debug_information ("Exiting the function to "
+	                         "open_nameid_cache ()", __LINE__);
+
+	return cache;
+}
+
+/*===========================================================================*
+ * Function name    : close_nameid_cache                                     *
+ *                                                                           *
+ * Description      : This function close cache file and free memory         *
+ *                                                                           *
+ * Input values(s)  : cache                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void close_nameid_cache (NameIdCache *cache)
+{
+	if (cache == NULL)
+		return;
+
+	if (cache->file != NULL)
+		fclose (cache->file);
+
+	for (uint32_t index = 0; index < cache->count_entries; index++)
+	{
+		steam_free (cache->entries[index].market_hash_name);
+	}
+
+	pthread_mutex_destroy (&cache->mutex);
+
+	steam_free (cache->entries);
+	steam_free (cache->buckets);
+	steam_free (cache);
+}
+
+/*===========================================================================*
+ * Function name    : lookup_item_nameid                                     *
+ *                                                                           *
+ * Description      : This function find cached item_nameid                  *
+ *                                                                           *
+ * Input values(s)  : cache                                                  *
+ *                    app_id                                                 *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : item_nameid                                            *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE (not cached)                           *
+ *===========================================================================*/
+int8_t lookup_item_nameid (NameIdCache *cache, uint32_t app_id,
+                           const char *market_hash_name, uint64_t *item_nameid)
+{
+	uint32_t hash = hash_nameid_key (app_id, market_hash_name);
+	uint32_t bucket = 0;
+	int8_t return_value = FAILURE;
+
+	pthread_mutex_lock (&cache->mutex);
+
+	bucket = find_nameid_entry (cache, app_id, market_hash_name, hash);
+
+	if (cache->buckets[bucket] != NO_ENTRY)
+	{
+		*item_nameid = cache->entries[cache->buckets[bucket]].item_nameid;
+		return_value = SUCCESS;
+	}
+
+	pthread_mutex_unlock (&cache->mutex);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : insert_item_nameid                                     *
+ *                                                                           *
+ * Description      : This function cache item_nameid and append it to file  *
+ *                                                                           *
+ * Input values(s)  : cache                                                  *
+ *                    app_id                                                 *
+ *                    market_hash_name                                       *
+ *                    item_nameid                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t insert_item_nameid (NameIdCache *cache, uint32_t app_id,
+                           const char *market_hash_name, uint64_t item_nameid)
+{
+	uint32_t hash = hash_nameid_key (app_id, market_hash_name);
+	int8_t return_value = SUCCESS;
+
+	/* Names with line breaks would break the file format */
+	if (strpbrk (market_hash_name, "\r\n") != NULL ||
+	    strlen (market_hash_name) + 32 >= NAMEID_LINE_SIZE)
+	{
+		return FAILURE;
+	}
+
+	pthread_mutex_lock (&cache->mutex);
+
+	if (cache->buckets[find_nameid_entry (cache, app_id, market_hash_name, hash)] == NO_ENTRY)
+	{
+		return_value = add_nameid_entry (cache, app_id, market_hash_name,
+		                                 item_nameid, hash);
+
+		if (return_value == SUCCESS &&
+		    (fprintf (cache->file, "%u\t%llu\t%s\n", app_id,
+		              (unsigned long long)item_nameid, market_hash_name) < 0 ||
+		     fflush (cache->file) != 0))
+		{
+			return_value = FAILURE;
+		}
+	}
+
+	pthread_mutex_unlock (&cache->mutex);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : extract_item_nameid                                    *
+ *                                                                           *
+ * Description      : This function find Market_LoadOrderSpread( id ) in     *
+ *                    listing page                                           *
+ *                                                                           *
+ * Input values(s)  : html                                                   *
+ *                                                                           *
+ * Output values(s) : item_nameid                                            *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t extract_item_nameid (const char *html, uint64_t *item_nameid)
+{
+	static const char marker[] = "Market_LoadOrderSpread(";
+	const char *ptr = strstr (html, marker);
+	char *end = NULL;
+
+	if (ptr == NULL)
+	{
+		return FAILURE;
+	}
+
+	ptr += sizeof (marker) - 1;
+
+	while (isspace ((uint8_t)*ptr))
+		ptr++;
+
+	*item_nameid = strtoull (ptr, &end, 10);
+
+	return end != ptr && *item_nameid != 0 ? SUCCESS : FAILURE;
+}
+
+/*===========================================================================*
+ * Function name    : build_listing_url                                      *
+ *                                                                           *
+ * Description      : This function build market/listings/<appid>/<hash> url *
+ *                                                                           *
+ * Input values(s)  : url_size                                               *
+ *                    app_id                                                 *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : url                                                    *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t build_listing_url (char *url, size_t url_size, uint32_t app_id,
+                                 const char *market_hash_name)
+{
+	char *ptr_hash_name_encode = NULL;
+	int length = 0;
+
+	ptr_hash_name_encode = steam_calloc (strlen (market_hash_name) * 3 + 1,
+	                                     sizeof (char), ALLOC_TAG_MARKET);
+
+	if (ptr_hash_name_encode == NULL)
+	{
+		return FAILURE;
+	}
+
+	url_encode (market_hash_name, ptr_hash_name_encode, g_rfc3986);
+
+	length = snprintf (url, url_size, URL_STEAM_REFERER_BUY_ITEM "%u/%s",
+	                   app_id, ptr_hash_name_encode);
+
+	steam_free (ptr_hash_name_encode);
+
+	if (length < 0 || (size_t)length >= url_size)
+	{
+		url[0] = '\0';
+
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : resolve_item_nameid                                    *
+ *                                                                           *
+ * Description      : This function get item_nameid from cache, scraping     *
+ *                    listing page on a miss                                 *
+ *                                                                           *
+ * Input values(s)  : cache                                                  *
+ *                    app_id                                                 *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : item_nameid                                            *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t resolve_item_nameid (NameIdCache *cache, uint32_t app_id,
+                            const char *market_hash_name, uint64_t *item_nameid)
+{
+	char steam_url[URL_SIZE] = {0};
+	char *ptr_data = NULL;
+	int8_t return_value = FAILURE;
+
+	print_debug_information ("Entering the function to "
+	                         "resolve_item_nameid ()", __LINE__);
+
+	if (lookup_item_nameid (cache, app_id, market_hash_name, item_nameid) == SUCCESS)
+	{
+		return SUCCESS;
+	}
+
+	if (build_listing_url (steam_url, sizeof (steam_url), app_id,
+	                       market_hash_name) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	ptr_data = curl_general_request (steam_url, URL_STEAM_MARKET, NULL, 0);
+
+	if (ptr_data != NULL && extract_item_nameid (ptr_data, item_nameid) == SUCCESS)
+	{
+		insert_item_nameid (cache, app_id, market_hash_name, *item_nameid);
+		return_value = SUCCESS;
+	}
+
+	steam_free (ptr_data);
+
+	print_debug_information ("Exiting the function to "
+	                         "resolve_item_nameid ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : extract_batch_item_nameid                              *
+ *                                                                           *
+ * Description      : This function extract id from completed listing page   *
+ *                    and drop the page right away                           *
+ *                                                                           *
+ * Input values(s)  : request - user_data points to the job                  *
+ *                    user_data - batch                                      *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void extract_batch_item_nameid (SteamRequest *request, void *user_data)
+{
+	NameIdBatch *batch = user_data;
+	NameIdJob *job = request->user_data;
+
+	if (request->response.memory != NULL && request->http_code == 200 &&
+	    extract_item_nameid (request->response.memory, job->item_nameid) == SUCCESS)
+	{
+		insert_item_nameid (batch->cache, batch->app_id, job->market_hash_name,
+		                    *job->item_nameid);
+	}
+
+	steam_free (request->response.memory);
+	request->response.memory = NULL;
+	request->response.size = 0;
+}
+
+/*===========================================================================*
+ * Function name    : resolve_item_nameids                                   *
+ *                                                                           *
+ * Description      : This function resolve many names, only cache misses    *
+ *                    are scraped and they are fetched concurrently          *
+ *                                                                           *
+ * Input values(s)  : cache                                                  *
+ *                    app_id                                                 *
+ *                    market_hash_names                                      *
+ *                    count_names                                            *
+ *                    max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : item_nameids - 0 where it failed                       *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if all names were resolved, FAILURE otherwise  *
+ *===========================================================================*/
+int8_t resolve_item_nameids (NameIdCache *cache, uint32_t app_id,
+                             const char *const *market_hash_names,
+                             size_t count_names, uint64_t *item_nameids,
+                             uint32_t max_concurrency)
+{
+	SteamRequest *requests = NULL;
+	NameIdJob *jobs = NULL;
+	NameIdBatch batch;
+	size_t count_jobs = 0;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "resolve_item_nameids ()", __LINE__);
+
+	requests = steam_calloc (count_names + 1, sizeof (SteamRequest),
+	                         ALLOC_TAG_MARKET);
+	jobs = steam_calloc (count_names + 1, sizeof (NameIdJob), ALLOC_TAG_MARKET);
+
+	if (requests == NULL || jobs == NULL)
+	{
+		steam_free (requests);
+		steam_free (jobs);
+
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < count_names; index++)
+	{
+		item_nameids[index] = 0;
+
+		if (lookup_item_nameid (cache, app_id, market_hash_names[index],
+		                        &item_nameids[index]) == SUCCESS)
+		{
+			continue;
+		}
+
+		if (build_listing_url (requests[count_jobs].url,
+		                       sizeof (requests[count_jobs].url), app_id,
+		                       market_hash_names[index]) != SUCCESS)
+		{
+			continue;
+		}
+
+		snprintf (requests[count_jobs].url_referer,
+		          sizeof (requests[count_jobs].url_referer), URL_STEAM_MARKET);
+
+		jobs[count_jobs].market_hash_name = market_hash_names[index];
+		jobs[count_jobs].item_nameid = &item_nameids[index];
+		requests[count_jobs].user_data = &jobs[count_jobs];
+
+		count_jobs++;
+	}
+
+	batch.cache = cache;
+	batch.app_id = app_id;
+
+	if (count_jobs > 0)
+	{
+		curl_batch_request (requests, count_jobs, max_concurrency,
+		                    extract_batch_item_nameid, &batch);
+	}
+
+	for (size_t index = 0; index < count_names; index++)
+	{
+		if (item_nameids[index] == 0)
+			return_value = FAILURE;
+	}
+
+	free_steam_requests (requests, count_jobs);
+	steam_free (requests);
+	steam_free (jobs);
+
+	print_debug_information ("Exiting the function to "
+	                         "resolve_item_nameids ()", __LINE__);
+
+	return return_value;
+}
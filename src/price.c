@@ -0,0 +1,1040 @@
+#include <limits.h>
+
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+
+#include "../inc/price.h"
+#include "../inc/steam.h"
+#include "../inc/transport.h"
+
+#define PRICE_SERIES_MIN_CAPACITY  256
+
+static int8_t reserve_price_series (PriceSeries *, size_t);
+static void sum_weighted_volume (const int32_t *, const int32_t *, size_t,
+                                 int64_t *, int64_t *);
+static int32_t select_price (int32_t *, size_t, size_t);
+static const char *skip_json_separators (const char *);
+static int32_t parse_decimal_cents (const char **);
+static int8_t build_price_url (char *, size_t, const char *, uint32_t,
+                               const char *);
+static void parse_price_history_response (SteamRequest *, void *);
+
+/*===========================================================================*
+ * Function name    : reserve_price_series                                   *
+ *                                                                           *
+ * Description      : This function grow columns of series                   *
+ *                                                                           *
+ * Input values(s)  : series                                                 *
+ *                    capacity - required number of points                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t reserve_price_series (PriceSeries *series, size_t capacity)
+{
+	int64_t *ptr_timestamps = NULL;
+	int32_t *ptr_prices = NULL;
+	int32_t *ptr_volumes = NULL;
+
+	if (capacity <= series->capacity)
+	{
+		return SUCCESS;
+	}
+
+	if (capacity < series->capacity * 2)
+		capacity = series->capacity * 2;
+
+	if (capacity < PRICE_SERIES_MIN_CAPACITY)
+		capacity = PRICE_SERIES_MIN_CAPACITY;
+
+	ptr_timestamps = steam_realloc (series->timestamps, capacity * sizeof (int64_t),
+	                                ALLOC_TAG_MARKET);
+
+	if (ptr_timestamps == NULL)
+	{
+		return FAILURE;
+	}
+
+	series->timestamps = ptr_timestamps;
+
+	ptr_prices = steam_realloc (series->prices, capacity * sizeof (int32_t),
+	                            ALLOC_TAG_MARKET);
+
+	if (ptr_prices == NULL)
+	{
+		return FAILURE;
+	}
+
+	series->prices = ptr_prices;
+
+	ptr_volumes = steam_realloc (series->volumes, capacity * sizeof (int32_t),
+	                             ALLOC_TAG_MARKET);
+
+	if (ptr_volumes == NULL)
+	{
+		return FAILURE;
+	}
+
+	series->volumes = ptr_volumes;
+	series->capacity = capacity;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : create_price_series                                    *
+ *                                                                           *
+ * Description      : This function create empty price series                *
+ *                                                                           *
+ * Input values(s)  : capacity - expected number of points                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Price series or NULL                                   *
+ *===========================================================================*/
+PriceSeries *create_price_series (size_t capacity)
+{
+	PriceSeries *series = steam_calloc (1, sizeof (PriceSeries),
+	                                    ALLOC_TAG_MARKET);
+
+	if (series == NULL)
+	{
+		return NULL;
+	}
+
+	if (reserve_price_series (series, capacity) != SUCCESS)
+	{
+		free_price_series (series);
+
+		return NULL;
+	}
+
+	return series;
+}
+
+/*===========================================================================*
+ * Function name    : free_price_series                                      *
+ *                                                                           *
+ * Description      : This function free memory for price series             *
+ *                                                                           *
+ * Input values(s)  : series                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_price_series (PriceSeries *series)
+{
+	if (series == NULL)
+		return;
+
+	steam_free (series->timestamps);
+	steam_free (series->prices);
+	steam_free (series->volumes);
+	steam_free (series);
+}
+
+/*===========================================================================*
+ * Function name    : append_price_point                                     *
+ *                                                                           *
+ * Description      : This function append point, time must not go back     *
+ *                                                                           *
+ * Input values(s)  : series                                                 *
+ *                    timestamp                                              *
+ *                    price - in cents                                       *
+ *                    volume                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t append_price_point (PriceSeries *series, int64_t timestamp,
+                           int32_t price, int32_t volume)
+{
+	size_t count_points = series->count_points;
+
+	if (count_points > 0 && timestamp < series->timestamps[count_points - 1])
+	{
+		return FAILURE;
+	}
+
+	if (reserve_price_series (series, count_points + 1) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	series->timestamps[count_points] = timestamp;
+	series->prices[count_points] = price;
+	series->volumes[count_points] = volume;
+	series->count_points++;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : find_price_range                                       *
+ *                                                                           *
+ * Description      : This function find points within time window           *
+ *                                                                           *
+ * Input values(s)  : series                                                 *
+ *                    time_from - inclusive                                  *
+ *                    time_to - inclusive                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Range of points                                        *
+ *===========================================================================*/
+PriceRange find_price_range (const PriceSeries *series, int64_t time_from,
+                             int64_t time_to)
+{
+	PriceRange range;
+	size_t low = 0;
+	size_t high = series->count_points;
+
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+
+		if (series->timestamps[middle] < time_from)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	range.begin = low;
+	high = series->count_points;
+
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+
+		if (series->timestamps[middle] <= time_to)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	range.end = low;
+
+	return range;
+}
+
+/*===========================================================================*
+ * Function name    : find_min_price                                         *
+ *                                                                           *
+ * Description      : This function find min price (SSE4.1 when available)   *
+ *                                                                           *
+ * Input values(s)  : prices                                                 *
+ *                    count_prices                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Min price, 0 for no prices                             *
+ *===========================================================================*/
+int32_t find_min_price (const int32_t *prices, size_t count_prices)
+{
+	int32_t result = 0;
+	size_t index = 0;
+
+	if (count_prices == 0)
+	{
+		return 0;
+	}
+
+	result = prices[0];
+
+#ifdef __SSE4_1__
+	if (count_prices >= 4)
+	{
+		__m128i minimum = _mm_loadu_si128 ((const __m128i *)prices);
+
+		for (index = 4; index + 4 <= count_prices; index += 4)
+		{
+			minimum = _mm_min_epi32 (minimum,
+			                         _mm_loadu_si128 ((const __m128i *)(prices + index)));
+		}
+
+		minimum = _mm_min_epi32 (minimum, _mm_shuffle_epi32 (minimum, _MM_SHUFFLE (1, 0, 3, 2)));
+		minimum = _mm_min_epi32 (minimum, _mm_shuffle_epi32 (minimum, _MM_SHUFFLE (2, 3, 0, 1)));
+
+		result = _mm_cvtsi128_si32 (minimum);
+	}
+#endif
+
+	for (; index < count_prices; index++)
+	{
+		if (prices[index] < result)
+			result = prices[index];
+	}
+
+	return result;
+}
+
+/*===========================================================================*
+ * Function name    : find_max_price                                         *
+ *                                                                           *
+ * Description      : This function find max price (SSE4.1 when available)   *
+ *                                                                           *
+ * Input values(s)  : prices                                                 *
+ *                    count_prices                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Max price, 0 for no prices                             *
+ *===========================================================================*/
+int32_t find_max_price (const int32_t *prices, size_t count_prices)
+{
+	int32_t result = 0;
+	size_t index = 0;
+
+	if (count_prices == 0)
+	{
+		return 0;
+	}
+
+	result = prices[0];
+
+#ifdef __SSE4_1__
+	if (count_prices >= 4)
+	{
+		__m128i maximum = _mm_loadu_si128 ((const __m128i *)prices);
+
+		for (index = 4; index + 4 <= count_prices; index += 4)
+		{
+			maximum = _mm_max_epi32 (maximum,
+			                         _mm_loadu_si128 ((const __m128i *)(prices + index)));
+		}
+
+		maximum = _mm_max_epi32 (maximum, _mm_shuffle_epi32 (maximum, _MM_SHUFFLE (1, 0, 3, 2)));
+		maximum = _mm_max_epi32 (maximum, _mm_shuffle_epi32 (maximum, _MM_SHUFFLE (2, 3, 0, 1)));
+
+		result = _mm_cvtsi128_si32 (maximum);
+	}
+#endif
+
+	for (; index < count_prices; index++)
+	{
+		if (prices[index] > result)
+			result = prices[index];
+	}
+
+	return result;
+}
+
+/*===========================================================================*
+ * Function name    : select_price                                           *
+ *                                                                           *
+ * Description      : This function partially sort prices so that the k-th   *
+ *                    smallest is at index k and smaller ones precede it     *
+ *                                                                           *
+ * Input values(s)  : prices                                                 *
+ *                    count_prices                                           *
+ *                    k                                                      *
+ *                                                                           *
+ * Output values(s) : prices                                                 *
+ *                                                                           *
+ * Return value(s)  : k-th smallest price                                    *
+ *===========================================================================*/
+static int32_t select_price (int32_t *prices, size_t count_prices, size_t k)
+{
+	size_t left = 0;
+	size_t right = count_prices - 1;
+	int32_t pivot = 0;
+	int32_t swap = 0;
+
+	while (left < right)
+	{
+		size_t low = left;
+		size_t high = right;
+		size_t middle = left + (right - left) / 2;
+
+		/* Median of three keeps already sorted history linear */
+		if (prices[middle] < prices[left])
+		{
+			swap = prices[middle]; prices[middle] = prices[left]; prices[left] = swap;
+		}
+
+		if (prices[right] < prices[left])
+		{
+			swap = prices[right]; prices[right] = prices[left]; prices[left] = swap;
+		}
+
+		if (prices[right] < prices[middle])
+		{
+			swap = prices[right]; prices[right] = prices[middle]; prices[middle] = swap;
+		}
+
+		pivot = prices[middle];
+
+		while (low <= high)
+		{
+			while (prices[low] < pivot)
+				low++;
+
+			while (prices[high] > pivot)
+				high--;
+
+			if (low <= high)
+			{
+				swap = prices[low]; prices[low] = prices[high]; prices[high] = swap;
+				low++;
+
+				if (high == 0)
+					break;
+
+				high--;
+			}
+		}
+
+		if (k <= high)
+			right = high;
+		else if (k >= low)
+			left = low;
+		else
+			break;
+	}
+
+	return prices[k];
+}
+
+/*===========================================================================*
+ * Function name    : find_median_price                                      *
+ *                                                                           *
+ * Description      : This function find median price, the mean of the two   *
+ *                    middle prices for an even count                        *
+ *                                                                           *
+ * Input values(s)  : prices                                                 *
+ *                    count_prices                                           *
+ *                                                                           *
+ * Output values(s) : median                                                 *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t find_median_price (const int32_t *prices, size_t count_prices,
+                          int32_t *median)
+{
+	int32_t *scratch = NULL;
+	int32_t upper = 0;
+	int32_t lower = 0;
+	size_t middle = count_prices / 2;
+
+	if (count_prices == 0)
+	{
+		return FAILURE;
+	}
+
+	scratch = steam_malloc (count_prices * sizeof (int32_t), ALLOC_TAG_MARKET);
+
+	if (scratch == NULL)
+	{
+		return FAILURE;
+	}
+
+	memcpy (scratch, prices, count_prices * sizeof (int32_t));
+
+	upper = select_price (scratch, count_prices, middle);
+
+	if (count_prices % 2 == 0)
+	{
+		/* The lower middle is the largest of the partition before it */
+		lower = find_max_price (scratch, middle);
+		*median = ((int64_t)lower + upper) / 2;
+	}
+	else
+	{
+		*median = upper;
+	}
+
+	steam_free (scratch);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : sum_weighted_volume                                    *
+ *                                                                           *
+ * Description      : This function sum price * volume and volume (SSE4.1    *
+ *                    when available)                                        *
+ *                                                                           *
+ * Input values(s)  : prices                                                 *
+ *                    volumes                                                *
+ *                    count_points                                           *
+ *                                                                           *
+ * Output values(s) : weighted                                               *
+ *                    volume                                                 *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void sum_weighted_volume (const int32_t *prices, const int32_t *volumes,
+                                 size_t count_points, int64_t *weighted,
+                                 int64_t *volume)
+{
+	size_t index = 0;
+
+	*weighted = 0;
+	*volume = 0;
+
+#ifdef __SSE4_1__
+	__m128i sum_weighted = _mm_setzero_si128 ();
+	__m128i sum_volume = _mm_setzero_si128 ();
+	int64_t lanes[2];
+
+	for (; index + 4 <= count_points; index += 4)
+	{
+		__m128i price = _mm_loadu_si128 ((const __m128i *)(prices + index));
+		__m128i count = _mm_loadu_si128 ((const __m128i *)(volumes + index));
+
+		/* Lanes 0 and 2, then lanes 1 and 3 as 64-bit products */
+		sum_weighted = _mm_add_epi64 (sum_weighted, _mm_mul_epi32 (price, count));
+		sum_weighted = _mm_add_epi64 (sum_weighted,
+		                              _mm_mul_epi32 (_mm_srli_epi64 (price, 32),
+		                                             _mm_srli_epi64 (count, 32)));
+
+		sum_volume = _mm_add_epi64 (sum_volume, _mm_cvtepi32_epi64 (count));
+		sum_volume = _mm_add_epi64 (sum_volume,
+		                            _mm_cvtepi32_epi64 (_mm_srli_si128 (count, 8)));
+	}
+
+	_mm_storeu_si128 ((__m128i *)lanes, sum_weighted);
+	*weighted = lanes[0] + lanes[1];
+
+	_mm_storeu_si128 ((__m128i *)lanes, sum_volume);
+	*volume = lanes[0] + lanes[1];
+#endif
+
+	for (; index < count_points; index++)
+	{
+		*weighted += (int64_t)prices[index] * volumes[index];
+		*volume += volumes[index];
+	}
+}
+
+/*===========================================================================*
+ * Function name    : compute_vwap                                           *
+ *                                                                           *
+ * Description      : This function compute volume weighted average price    *
+ *                                                                           *
+ * Input values(s)  : prices                                                 *
+ *                    volumes                                                *
+ *                    count_points                                           *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : VWAP rounded to cents, 0 without volume                *
+ *===========================================================================*/
+int32_t compute_vwap (const int32_t *prices, const int32_t *volumes,
+                      size_t count_points)
+{
+	int64_t weighted = 0;
+	int64_t volume = 0;
+
+	sum_weighted_volume (prices, volumes, count_points, &weighted, &volume);
+
+	if (volume <= 0)
+	{
+		return 0;
+	}
+
+	return (weighted + volume / 2) / volume;
+}
+
+/*===========================================================================*
+ * Function name    : compute_price_stats                                    *
+ *                                                                           *
+ * Description      : This function compute statistics of time window        *
+ *                                                                           *
+ * Input values(s)  : series                                                 *
+ *                    time_from - inclusive                                  *
+ *                    time_to - inclusive                                    *
+ *                                                                           *
+ * Output values(s) : stats                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE (no points in window)                  *
+ *===========================================================================*/
+int8_t compute_price_stats (const PriceSeries *series, int64_t time_from,
+                            int64_t time_to, PriceStats *stats)
+{
+	PriceRange range = find_price_range (series, time_from, time_to);
+	const int32_t *prices = series->prices + range.begin;
+	const int32_t *volumes = series->volumes + range.begin;
+	size_t count_points = range.end - range.begin;
+	int64_t weighted = 0;
+
+	memset (stats, 0, sizeof (PriceStats));
+
+	if (count_points == 0)
+	{
+		return FAILURE;
+	}
+
+	stats->count_points = count_points;
+	stats->min_price = find_min_price (prices, count_points);
+	stats->max_price = find_max_price (prices, count_points);
+
+	sum_weighted_volume (prices, volumes, count_points, &weighted, &stats->volume);
+
+	if (stats->volume > 0)
+		stats->vwap = (weighted + stats->volume / 2) / stats->volume;
+
+	return find_median_price (prices, count_points, &stats->median_price);
+}
+
+/*===========================================================================*
+ * Function name    : skip_json_separators                                   *
+ *                                                                           *
+ * Description      : This function skip whitespace and commas               *
+ *                                                                           *
+ * Input values(s)  : data                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Next significant character                             *
+ *===========================================================================*/
+static const char *skip_json_separators (const char *data)
+{
+	while (*data == ',' || isspace ((uint8_t)*data))
+		data++;
+
+	return data;
+}
+
+/*===========================================================================*
+ * Function name    : parse_decimal_cents                                    *
+ *                                                                           *
+ * Description      : This function parse json number in currency units and  *
+ *                    round it to cents                                      *
+ *                                                                           *
+ * Input values(s)  : data                                                   *
+ *                                                                           *
+ * Output values(s) : data - after the number                               *
+ *                                                                           *
+ * Return value(s)  : Cents                                                  *
+ *===========================================================================*/
+static int32_t parse_decimal_cents (const char **data)
+{
+	const char *ptr = *data;
+	int64_t cents = 0;
+	int8_t negative = 0;
+	uint8_t fraction_digits = 0;
+
+	if (*ptr == '-')
+	{
+		negative = 1;
+		ptr++;
+	}
+
+	for (; isdigit ((uint8_t)*ptr); ptr++)
+	{
+		if (cents < INT32_MAX)
+			cents = cents * 10 + (*ptr - '0');
+	}
+
+	cents *= 100;
+
+	if (*ptr == '.')
+	{
+		for (ptr++; isdigit ((uint8_t)*ptr); ptr++, fraction_digits++)
+		{
+			if (fraction_digits == 0)
+				cents += (*ptr - '0') * 10;
+			else if (fraction_digits == 1)
+				cents += *ptr - '0';
+			else if (fraction_digits == 2 && *ptr >= '5')
+				cents++;
+		}
+	}
+
+	*data = ptr;
+
+	if (cents > INT32_MAX)
+		cents = INT32_MAX;
+
+	return negative ? -cents : cents;
+}
+
+/*===========================================================================*
+ * Function name    : parse_price_history                                    *
+ *                                                                           *
+ * Description      : This function append "prices" of pricehistory response *
+ *                    to series. Rows are ["Oct 18 2019 01: +0",0.123,"5"],  *
+ *                    they are scanned in place without building json tree   *
+ *                                                                           *
+ * Input values(s)  : data - response                                        *
+ *                                                                           *
+ * Output values(s) : series                                                 *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t parse_price_history (const char *data, PriceSeries *series)
+{
+	static const char marker[] = "\"prices\":";
+	const char *ptr = NULL;
+	char *end = NULL;
+	int64_t timestamp = 0;
+	int32_t price = 0;
+	int32_t volume = 0;
+	uint32_t day = 0;
+	uint32_t year = 0;
+	uint32_t hour = 0;
+	uint8_t month = 0;
+
+	ptr = strstr (data, marker);
+
+	if (ptr == NULL)
+	{
+		return FAILURE;
+	}
+
+	ptr = skip_json_separators (ptr + sizeof (marker) - 1);
+
+	/* "prices":false when steam has no history for the item */
+	if (*ptr != '[')
+	{
+		return FAILURE;
+	}
+
+	ptr = skip_json_separators (ptr + 1);
+
+	while (*ptr == '[')
+	{
+		ptr = skip_json_separators (ptr + 1);
+
+		if (*ptr != '"' || (month = parse_month_name (ptr + 1)) == 0)
+		{
+			return FAILURE;
+		}
+
+		day = strtoul (ptr + 4, &end, 10);
+		year = strtoul (end, &end, 10);
+		hour = strtoul (end, &end, 10);
+
+		timestamp = days_from_civil (year, month, day) * 86400 + hour * 3600;
+
+		ptr = strchr (end, '"');
+
+		if (ptr == NULL)
+		{
+			return FAILURE;
+		}
+
+		ptr = skip_json_separators (ptr + 1);
+		price = parse_decimal_cents (&ptr);
+		ptr = skip_json_separators (ptr);
+
+		if (*ptr == '"')
+			ptr++;
+
+		volume = strtol (ptr, &end, 10);
+		ptr = strchr (end, ']');
+
+		if (ptr == NULL || append_price_point (series, timestamp, price, volume) != SUCCESS)
+		{
+			return FAILURE;
+		}
+
+		ptr = skip_json_separators (ptr + 1);
+	}
+
+	return *ptr == ']' ? SUCCESS : FAILURE;
+}
+
+/*===========================================================================*
+ * Function name    : build_price_url                                        *
+ *                                                                           *
+ * Description      : This function build url of market price endpoint       *
+ *                                                                           *
+ * Input values(s)  : url_size                                               *
+ *                    endpoint - "pricehistory/?..." with app_id and         *
+ *                               market_hash_name left to append             *
+ *                    app_id                                                 *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : url                                                    *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t build_price_url (char *url, size_t url_size, const char *endpoint,
+                               uint32_t app_id, const char *market_hash_name)
+{
+	char *ptr_hash_name_encode = NULL;
+	int length = 0;
+
+	ptr_hash_name_encode = steam_calloc (strlen (market_hash_name) * 3 + 1,
+	                                     sizeof (char), ALLOC_TAG_MARKET);
+
+	if (ptr_hash_name_encode == NULL)
+	{
+		return FAILURE;
+	}
+
+	url_encode (market_hash_name, ptr_hash_name_encode, g_rfc3986);
+
+	length = snprintf (url, url_size, URL_STEAM_MARKET "%sappid=%u&market_hash_name=%s",
+	                   endpoint, app_id, ptr_hash_name_encode);
+
+	steam_free (ptr_hash_name_encode);
+
+	if (length < 0 || (size_t)length >= url_size)
+	{
+		url[0] = '\0';
+
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : get_price_overview                                     *
+ *                                                                           *
+ * Description      : This function get lowest and median price and volume   *
+ *                    of the last 24 hours                                   *
+ *                                                                           *
+ * Input values(s)  : app_id                                                 *
+ *                    currency                                               *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : overview - missing prices are left 0                   *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t get_price_overview (uint32_t app_id, uint32_t currency,
+                           const char *market_hash_name, PriceOverview *overview)
+{
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_field = NULL;
+	char steam_url[URL_SIZE] = {0};
+	char endpoint[64] = {0};
+	char *ptr_data = NULL;
+	const char *text = NULL;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "get_price_overview ()", __LINE__);
+
+	memset (overview, 0, sizeof (PriceOverview));
+
+	snprintf (endpoint, sizeof (endpoint), "priceoverview/?currency=%u&", currency);
+
+	if (build_price_url (steam_url, sizeof (steam_url), endpoint, app_id,
+	                     market_hash_name) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	ptr_data = curl_general_request (steam_url, URL_STEAM_MARKET, NULL, 0);
+
+	if (ptr_data == NULL)
+	{
+		return FAILURE;
+	}
+
+	parsed_json = parse_json_response (ptr_data);
+
+	steam_free (ptr_data);
+
+	if (parsed_json == NULL ||
+	    json_object_object_get_ex (parsed_json, "success", &json_field) == 0 ||
+	    json_object_get_boolean (json_field) == 0)
+	{
+		return_value = FAILURE;
+	}
+	else
+	{
+		if (json_object_object_get_ex (parsed_json, "lowest_price", &json_field))
+		{
+			text = json_object_get_string (json_field);
+			parse_price_text (text, strlen (text), &overview->lowest_price);
+		}
+
+		if (json_object_object_get_ex (parsed_json, "median_price", &json_field))
+		{
+			text = json_object_get_string (json_field);
+			parse_price_text (text, strlen (text), &overview->median_price);
+		}
+
+		/* Volume is shown with thousands separators, "1,234" */
+		if (json_object_object_get_ex (parsed_json, "volume", &json_field))
+		{
+			for (text = json_object_get_string (json_field); *text != '\0'; text++)
+			{
+				if (isdigit ((uint8_t)*text))
+					overview->volume = overview->volume * 10 + (*text - '0');
+			}
+		}
+	}
+
+	json_object_put (parsed_json);
+
+	print_debug_information ("Exiting the function to "
+	                         "get_price_overview ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : get_price_history                                      *
+ *                                                                           *
+ * Description      : This function get hourly/daily price history of item   *
+ *                    (requires login), prices are in wallet currency        *
+ *                                                                           *
+ * Input values(s)  : app_id                                                 *
+ *                    market_hash_name                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Price series or NULL                                   *
+ *===========================================================================*/
+PriceSeries *get_price_history (uint32_t app_id, const char *market_hash_name)
+{
+	PriceSeries *series = NULL;
+	char steam_url[URL_SIZE] = {0};
+	char *ptr_data = NULL;
+
+	print_debug_information ("Entering the function to "
+	                         "get_price_history ()", __LINE__);
+
+	if (build_price_url (steam_url, sizeof (steam_url), "pricehistory/?", app_id,
+	                     market_hash_name) != SUCCESS)
+	{
+		return NULL;
+	}
+
+	ptr_data = curl_general_request (steam_url, URL_STEAM_MARKET, NULL, 0);
+
+	if (ptr_data == NULL)
+	{
+		return NULL;
+	}
+
+	series = create_price_series (0);
+
+	if (series != NULL && parse_price_history (ptr_data, series) != SUCCESS)
+	{
+		free_price_series (series);
+		series = NULL;
+	}
+
+	steam_free (ptr_data);
+
+	print_debug_information ("Exiting the function to "
+	                         "get_price_history ()", __LINE__);
+
+	return series;
+}
+
+/*===========================================================================*
+ * Function name    : parse_price_history_response                           *
+ *                                                                           *
+ * Description      : This function parse pricehistory response as soon as   *
+ *                    it completes                                           *
+ *                                                                           *
+ * Input values(s)  : request - user_data points to the output slot          *
+ *                    user_data                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void parse_price_history_response (SteamRequest *request, void *user_data)
+{
+	PriceSeries **series = request->user_data;
+
+	if (request->response.memory == NULL || request->http_code != 200)
+	{
+		return;
+	}
+
+	*series = create_price_series (0);
+
+	if (*series != NULL && parse_price_history (request->response.memory,
+	                                            *series) != SUCCESS)
+	{
+		free_price_series (*series);
+		*series = NULL;
+	}
+
+	/* The response is not needed any more, keep peak memory low */
+	steam_free (request->response.memory);
+	request->response.memory = NULL;
+	request->response.size = 0;
+}
+
+/*===========================================================================*
+ * Function name    : get_price_histories                                    *
+ *                                                                           *
+ * Description      : This function get price history of many items          *
+ *                    concurrently                                           *
+ *                                                                           *
+ * Input values(s)  : app_id                                                 *
+ *                    market_hash_names                                      *
+ *                    count_items                                            *
+ *                    max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : series - one per item, NULL where it failed            *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if every history was fetched, FAILURE otherwise *
+ *===========================================================================*/
+int8_t get_price_histories (uint32_t app_id, const char *const *market_hash_names,
+                            size_t count_items, PriceSeries **series,
+                            uint32_t max_concurrency)
+{
+	SteamRequest *requests = NULL;
+	size_t count_requests = 0;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "get_price_histories ()", __LINE__);
+
+	memset (series, 0, count_items * sizeof (PriceSeries *));
+
+	if (count_items == 0)
+	{
+		return SUCCESS;
+	}
+
+	requests = steam_calloc (count_items, sizeof (SteamRequest),
+	                         ALLOC_TAG_MARKET);
+
+	if (requests == NULL)
+	{
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < count_items; index++)
+	{
+		SteamRequest *request = &requests[count_requests];
+
+		/* Its series stays NULL, so the item counts as failed */
+		if (build_price_url (request->url, sizeof (request->url), "pricehistory/?",
+		                     app_id, market_hash_names[index]) != SUCCESS)
+		{
+			continue;
+		}
+
+		snprintf (request->url_referer, sizeof (request->url_referer),
+		          URL_STEAM_MARKET);
+
+		request->user_data = &series[index];
+		count_requests++;
+	}
+
+	curl_batch_request (requests, count_requests, max_concurrency,
+	                    parse_price_history_response, NULL);
+
+	for (size_t index = 0; index < count_items; index++)
+	{
+		if (series[index] == NULL)
+			return_value = FAILURE;
+	}
+
+	free_steam_requests (requests, count_requests);
+	steam_free (requests);
+
+	print_debug_information ("Exiting the function to "
+	                         "get_price_histories ()", __LINE__);
+
+	return return_value;
+}
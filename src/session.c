@@ -0,0 +1,578 @@
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "../inc/session.h"
+#include "../inc/login.h"
+#include "../inc/steam.h"
+
+#define SESSION_LINE_SIZE  256
+
+/* Refresh is serialized by mutex, the generation is bumped by every
+ * successful refresh so requests that failed on the same session
+ * refresh it only once */
+typedef struct tSessionKeepalive {
+	SteamCredentials  credentials;
+	char              file_name[SESSION_LINE_SIZE];
+	uint32_t          interval_s;
+	uint8_t           has_credentials;
+	uint8_t           running;
+	uint32_t          generation;
+	pthread_t         thread;
+	pthread_mutex_t   mutex;
+	pthread_mutex_t   wait_mutex;
+	pthread_cond_t    wait_cond;
+} SessionKeepalive;
+
+static SessionKeepalive s_keepalive = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.wait_mutex = PTHREAD_MUTEX_INITIALIZER,
+	.wait_cond = PTHREAD_COND_INITIALIZER
+};
+
+/* Requests sent by the refresh itself must not refresh again */
+static __thread uint8_t s_refreshing = 0;
+
+/* g_steam_id and g_session_id change only under this mutex, other
+ * threads read them with get_steam_session () */
+static pthread_mutex_t s_session_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void *run_session_keepalive (void *);
+
+/*===========================================================================*
+ * Function name    : set_steam_session                                      *
+ *                                                                           *
+ * Description      : This function publish new steam id and/or session id.  *
+ *                    The old steam id is freed, readers hold copies only    *
+ *                                                                           *
+ * Input values(s)  : steam_id - (optional parameter)                        *
+ *                    session_id - (optional parameter)                      *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t set_steam_session (const char *steam_id, const char *session_id)
+{
+	char *ptr_steam_id = NULL;
+	char *ptr_old_steam_id = NULL;
+
+	if (steam_id != NULL)
+	{
+		ptr_steam_id = steam_strdup (steam_id, ALLOC_TAG_SESSION);
+
+		if (ptr_steam_id == NULL)
+		{
+			return FAILURE;
+		}
+	}
+
+	pthread_mutex_lock (&s_session_mutex);
+
+	if (ptr_steam_id != NULL)
+	{
+		ptr_old_steam_id = g_steam_id;
+		g_steam_id = ptr_steam_id;
+	}
+
+	if (session_id != NULL)
+		snprintf (g_session_id, sizeof (g_session_id), "%s", session_id);
+
+	pthread_mutex_unlock (&s_session_mutex);
+
+	steam_free (ptr_old_steam_id);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : get_steam_session                                      *
+ *                                                                           *
+ * Description      : This function copy steam id and session id, both of    *
+ *                    the same session                                       *
+ *                                                                           *
+ * Input values(s)  : size_steam_id                                          *
+ *                    size_session_id                                        *
+ *                                                                           *
+ * Output values(s) : steam_id - empty before login (optional parameter)     *
+ *                    session_id - (optional parameter)                      *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void get_steam_session (char *steam_id, size_t size_steam_id,
+                        char *session_id, size_t size_session_id)
+{
+	pthread_mutex_lock (&s_session_mutex);
+
+	if (steam_id != NULL)
+	{
+		snprintf (steam_id, size_steam_id, "%s",
+		          g_steam_id != NULL ? g_steam_id : "");
+	}
+
+	if (session_id != NULL)
+		snprintf (session_id, size_session_id, "%s", g_session_id);
+
+	pthread_mutex_unlock (&s_session_mutex);
+}
+
+/*===========================================================================*
+ * Function name    : save_steam_session                                     *
+ *                                                                           *
+ * Description      : This function save steam id and session id after       *
+ *                    login. Auth cookies (steamLoginSecure) are saved by    *
+ *                    save_steam_cookies ()                                  *
+ *                                                                           *
+ * Input values(s)  : file_name - readable by the owner only                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t save_steam_session (const char *file_name)
+{
+	FILE *file = NULL;
+	char steam_id[STEAM_ID_SIZE] = {0};
+	char session_id[sizeof (g_session_id)] = {0};
+	int fd = -1;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "save_steam_session ()", __LINE__);
+
+	get_steam_session (steam_id, sizeof (steam_id), session_id, sizeof (session_id));
+
+	if (steam_id[0] == '\0' || session_id[0] == '\0')
+	{
+		return FAILURE;
+	}
+
+	fd = open (file_name, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+	if (fd < 0 || (file = fdopen (fd, "w")) == NULL)
+	{
+		if (fd >= 0)
+			close (fd);
+
+		return FAILURE;
+	}
+
+	if (fprintf (file, "steamid=%s\nsessionid=%s\n", steam_id, session_id) < 0)
+	{
+		return_value = FAILURE;
+	}
+
+	if (fclose (file) != 0)
+	{
+		return_value = FAILURE;
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "save_steam_session ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : load_steam_session                                     *
+ *                                                                           *
+ * Description      : This function restore g_steam_id and g_session_id      *
+ *                    saved by save_steam_session ()                         *
+ *                                                                           *
+ * Input values(s)  : file_name                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t load_steam_session (const char *file_name)
+{
+	FILE *file = NULL;
+	char line[SESSION_LINE_SIZE] = {0};
+	char steam_id[SESSION_LINE_SIZE] = {0};
+	char session_id[sizeof (g_session_id)] = {0};
+	char *ptr_value = NULL;
+
+	print_debug_information ("Entering the function to "
+	                         "load_steam_session ()", __LINE__);
+
+	file = fopen (file_name, "r");
+
+	if (file == NULL)
+	{
+		return FAILURE;
+	}
+
+	while (fgets (line, sizeof (line), file) != NULL)
+	{
+		line[strcspn (line, "\r\n")] = '\0';
+		ptr_value = strchr (line, '=');
+
+		if (ptr_value == NULL)
+			continue;
+
+		*ptr_value++ = '\0';
+
+		if (strcmp (line, "steamid") == STRINGS_EQUAL)
+			snprintf (steam_id, sizeof (steam_id), "%s", ptr_value);
+		else if (strcmp (line, "sessionid") == STRINGS_EQUAL)
+			snprintf (session_id, sizeof (session_id), "%s", ptr_value);
+	}
+
+	fclose (file);
+
+	if (steam_id[0] == '\0' || session_id[0] == '\0')
+	{
+		return FAILURE;
+	}
+
+	if (set_steam_session (steam_id, session_id) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "load_steam_session ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : validate_steam_session                                 *
+ *                                                                           *
+ * Description      : This function check that cookies still log in as       *
+ *                    g_steam_id with one small request and pick up the      *
+ *                    current sessionid cookie                               *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS when the session is valid/FAILURE              *
+ *===========================================================================*/
+int8_t validate_steam_session (void)
+{
+	char *ptr_data = NULL;
+	char *ptr_steam_id = NULL;
+	char steam_id[STEAM_ID_SIZE] = {0};
+	int8_t return_value = FAILURE;
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_logged_in = NULL;
+
+	print_debug_information ("Entering the function to "
+	                         "validate_steam_session ()", __LINE__);
+
+	get_steam_session (steam_id, sizeof (steam_id), NULL, 0);
+
+	if (steam_id[0] == '\0')
+	{
+		return FAILURE;
+	}
+
+	ptr_data = curl_general_request (URL_STEAM_COMMUNITY "chat/clientjstoken",
+	                                 URL_STEAM_COMMUNITY, NULL, GET_COOKIE);
+
+	if (ptr_data == NULL)
+	{
+		return FAILURE;
+	}
+
+	parsed_json = parse_json_response (ptr_data);
+
+	steam_free (ptr_data);
+
+	if (parsed_json != NULL &&
+	    json_object_object_get_ex (parsed_json, "logged_in", &json_logged_in) != 0 &&
+	    json_object_get_boolean (json_logged_in) != 0 &&
+	    get_json_object_as_string (&ptr_steam_id, parsed_json, "steamid") == SUCCESS &&
+	    strcmp (ptr_steam_id, steam_id) == STRINGS_EQUAL)
+	{
+		return_value = SUCCESS;
+	}
+
+	steam_free (ptr_steam_id);
+
+	if (parsed_json != NULL)
+		json_object_put (parsed_json);
+
+	print_debug_information ("Exiting the function to "
+	                         "validate_steam_session ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : resume_steam_session                                   *
+ *                                                                           *
+ * Description      : This function restore saved session instead of         *
+ *                    steam_login () when its cookies are still valid        *
+ *                                                                           *
+ * Input values(s)  : file_name                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE, login is needed on failure            *
+ *===========================================================================*/
+int8_t resume_steam_session (const char *file_name)
+{
+	int8_t return_value = FAILURE;
+
+	print_debug_information ("Entering the function to "
+	                         "resume_steam_session ()", __LINE__);
+
+	if (load_steam_session (file_name) == SUCCESS &&
+	    validate_steam_session () == SUCCESS)
+	{
+		return_value = SUCCESS;
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "resume_steam_session ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : get_session_generation                                 *
+ *                                                                           *
+ * Description      : This function get count of session refreshes, taken    *
+ *                    before a request to pass to refresh_steam_session ()   *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Generation                                             *
+ *===========================================================================*/
+uint32_t get_session_generation (void)
+{
+	return __atomic_load_n (&s_keepalive.generation, __ATOMIC_ACQUIRE);
+}
+
+/*===========================================================================*
+ * Function name    : refresh_steam_session                                  *
+ *                                                                           *
+ * Description      : This function refresh expired session: cookies may     *
+ *                    have been renewed by steam, otherwise log in again     *
+ *                    with keepalive credentials. Threads that failed on the *
+ *                    same session wait for a single refresh. A session that *
+ *                    is still valid and unchanged is not a refresh: the     *
+ *                    request was not rejected for the session               *
+ *                                                                           *
+ * Input values(s)  : generation - get_session_generation () before the      *
+ *                                 failed request                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS when requests may be replayed/FAILURE          *
+ *===========================================================================*/
+int8_t refresh_steam_session (uint32_t generation)
+{
+	char session_id[sizeof (g_session_id)] = {0};
+	char new_session_id[sizeof (g_session_id)] = {0};
+	char login_cookie[COOKIE_VALUE_SIZE] = {0};
+	char new_login_cookie[COOKIE_VALUE_SIZE] = {0};
+	int8_t return_value = FAILURE;
+
+	print_debug_information ("Entering the function to "
+	                         "refresh_steam_session ()", __LINE__);
+
+	if (s_refreshing != 0)
+	{
+		return FAILURE;
+	}
+
+	pthread_mutex_lock (&s_keepalive.mutex);
+
+	if (get_session_generation () != generation)
+	{
+		/* Another thread has refreshed it meanwhile */
+		pthread_mutex_unlock (&s_keepalive.mutex);
+
+		return SUCCESS;
+	}
+
+	s_refreshing = 1;
+
+	get_steam_session (NULL, 0, session_id, sizeof (session_id));
+	get_steam_cookie ("steamLoginSecure", login_cookie, sizeof (login_cookie));
+
+	if (validate_steam_session () == SUCCESS)
+	{
+		get_steam_session (NULL, 0, new_session_id, sizeof (new_session_id));
+		get_steam_cookie ("steamLoginSecure", new_login_cookie,
+		                  sizeof (new_login_cookie));
+
+		/* Replaying a POST on the same session would send it twice */
+		if (strcmp (session_id, new_session_id) != STRINGS_EQUAL ||
+		    strcmp (login_cookie, new_login_cookie) != STRINGS_EQUAL)
+		{
+			return_value = SUCCESS;
+		}
+	}
+	else if (s_keepalive.has_credentials != 0 &&
+	         steam_login_with_credentials (&s_keepalive.credentials) == LOGIN_SUCCESS)
+	{
+		return_value = SUCCESS;
+	}
+
+	if (return_value == SUCCESS)
+	{
+		save_steam_cookies ();
+
+		if (s_keepalive.file_name[0] != '\0')
+			save_steam_session (s_keepalive.file_name);
+
+		__atomic_add_fetch (&s_keepalive.generation, 1, __ATOMIC_RELEASE);
+	}
+
+	s_refreshing = 0;
+
+	pthread_mutex_unlock (&s_keepalive.mutex);
+
+	print_debug_information ("Exiting the function to "
+	                         "refresh_steam_session ()", __LINE__);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : run_session_keepalive                                  *
+ *                                                                           *
+ * Description      : This function check the session every interval and     *
+ *                    refresh it before requests fail on it                  *
+ *                                                                           *
+ * Input values(s)  : arg - not used                                         *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : NULL                                                   *
+ *===========================================================================*/
+static void *run_session_keepalive (void *arg)
+{
+	struct timespec deadline;
+	uint32_t generation = 0;
+	int wait_result = 0;
+
+	(void)arg;
+
+	pthread_mutex_lock (&s_keepalive.wait_mutex);
+
+	while (s_keepalive.running != 0)
+	{
+		clock_gettime (CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += s_keepalive.interval_s;
+		wait_result = 0;
+
+		/* Woken early only by stop_session_keepalive () */
+		while (s_keepalive.running != 0 && wait_result != ETIMEDOUT)
+		{
+			wait_result = pthread_cond_timedwait (&s_keepalive.wait_cond,
+			                                      &s_keepalive.wait_mutex, &deadline);
+		}
+
+		if (s_keepalive.running == 0)
+			break;
+
+		pthread_mutex_unlock (&s_keepalive.wait_mutex);
+
+		generation = get_session_generation ();
+
+		/* Missing login cookie is known without a request */
+		if (has_steam_cookie ("steamLoginSecure") != SUCCESS ||
+		    validate_steam_session () != SUCCESS)
+		{
+			refresh_steam_session (generation);
+		}
+
+		pthread_mutex_lock (&s_keepalive.wait_mutex);
+	}
+
+	pthread_mutex_unlock (&s_keepalive.wait_mutex);
+
+	return NULL;
+}
+
+/*===========================================================================*
+ * Function name    : start_session_keepalive                                *
+ *                                                                           *
+ * Description      : This function enable session refresh of expired        *
+ *                    requests and start background thread checking the      *
+ *                    session                                                *
+ *                                                                           *
+ * Input values(s)  : credentials - to log in again (optional parameter)     *
+ *                    file_name - session store (optional parameter)         *
+ *                    interval_s - seconds between checks                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t start_session_keepalive (const SteamCredentials *credentials,
+                                const char *file_name, uint32_t interval_s)
+{
+	print_debug_information ("Entering the function to "
+	                         "start_session_keepalive ()", __LINE__);
+
+	if (s_keepalive.running != 0 || interval_s == 0)
+	{
+		return FAILURE;
+	}
+
+	pthread_mutex_lock (&s_keepalive.mutex);
+
+	if (credentials != NULL)
+	{
+		memcpy (&s_keepalive.credentials, credentials, sizeof (SteamCredentials));
+		s_keepalive.has_credentials = 1;
+	}
+
+	snprintf (s_keepalive.file_name, SESSION_LINE_SIZE, "%s",
+	          file_name != NULL ? file_name : "");
+	s_keepalive.interval_s = interval_s;
+	s_keepalive.running = 1;
+
+	pthread_mutex_unlock (&s_keepalive.mutex);
+
+	if (pthread_create (&s_keepalive.thread, NULL, run_session_keepalive, NULL) != 0)
+	{
+		s_keepalive.running = 0;
+
+		return FAILURE;
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "start_session_keepalive ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : stop_session_keepalive                                 *
+ *                                                                           *
+ * Description      : This function stop background thread and forget the    *
+ *                    credentials                                            *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void stop_session_keepalive (void)
+{
+	if (s_keepalive.running == 0)
+		return;
+
+	pthread_mutex_lock (&s_keepalive.wait_mutex);
+	s_keepalive.running = 0;
+	pthread_cond_signal (&s_keepalive.wait_cond);
+	pthread_mutex_unlock (&s_keepalive.wait_mutex);
+
+	pthread_join (s_keepalive.thread, NULL);
+
+	pthread_mutex_lock (&s_keepalive.mutex);
+	memset (&s_keepalive.credentials, 0, sizeof (SteamCredentials));
+	s_keepalive.has_credentials = 0;
+	pthread_mutex_unlock (&s_keepalive.mutex);
+}
@@ -5,9 +5,35 @@
 
 #include "../inc/steam.h"
 #include "../inc/steamdef.h"
+#include "../inc/transport.h"
+#include "../inc/session.h"
+#include "../inc/metrics.h"
 #include "../inc/steamglob.h"
 
 static size_t write_memory_callback (void *, size_t, size_t, void *);
+static void lock_curl_share (CURL *, curl_lock_data, curl_lock_access, void *);
+static void unlock_curl_share (CURL *, curl_lock_data, void *);
+static void init_curl_share (void);
+static void cleanup_thread_curl_handle (void *);
+static void init_thread_curl_handle_key (void);
+static CURL *get_thread_curl_handle (void);
+static void init_url_override (void);
+static const char *override_base_url (const char *, char *, size_t);
+static char *perform_general_request (char *, char *, char *, int8_t, int8_t *);
+
+static CURLSH *s_curl_share = NULL;
+static pthread_mutex_t s_curl_share_mutex[CURL_LOCK_DATA_LAST];
+static pthread_once_t s_curl_share_once = PTHREAD_ONCE_INIT;
+
+/* Easy handle of the thread, keeps its connections between requests */
+static pthread_key_t s_curl_handle_key;
+static pthread_once_t s_curl_handle_once = PTHREAD_ONCE_INIT;
+
+/* Base urls from STEAM_COMMUNITY_URL and STEAM_API_URL, e.g. a local
+ * stand-in server, empty when steam itself is used */
+static char s_community_url[URL_SIZE] = {0};
+static char s_api_url[URL_SIZE] = {0};
+static pthread_once_t s_url_override_once = PTHREAD_ONCE_INIT;
 
 static const char encoding_table[ENCODE_TABLE_SIZE] =
 {
@@ -140,6 +166,61 @@ void base64_encode (const void *input, size_t input_length,
 	return;
 }
 
+/*===========================================================================*
+ * Function name    : base64_decode                                          *
+ *                                                                           *
+ * Description      : This function Base64 decoding algorithm, padding and   *
+ *                    whitespace are skipped                                 *
+ *                                                                           *
+ * Input values(s)  : input - NULL-terminated Base64 string                  *
+ *                    output_size - size of output buffer                    *
+ *                                                                           *
+ * Output values(s) : output - decoded data                                  *
+ *                    output_length - length of decoded data                 *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t base64_decode (const char *input, uint8_t *output, size_t output_size,
+                      size_t *output_length)
+{
+	const char *ptr_value = NULL;
+	uint32_t buffer = 0;
+	uint8_t count_bits = 0;
+	size_t length = 0;
+
+	for (; *input != '\0' && *input != '='; input++)
+	{
+		if (isspace ((uint8_t)*input))
+			continue;
+
+		ptr_value = memchr (encoding_table, *input, ENCODE_TABLE_SIZE);
+
+		if (ptr_value == NULL)
+		{
+			return FAILURE;
+		}
+
+		buffer = (buffer << 6) | (uint32_t)(ptr_value - encoding_table);
+		count_bits += 6;
+
+		if (count_bits >= 8)
+		{
+			count_bits -= 8;
+
+			if (length == output_size)
+			{
+				return FAILURE;
+			}
+
+			output[length++] = (uint8_t)(buffer >> count_bits);
+		}
+	}
+
+	*output_length = length;
+
+	return SUCCESS;
+}
+
  /*==========================================================================*
  * Function name    : init_encode_method                                     *
  *                                                                           *
@@ -239,7 +320,8 @@ static size_t write_memory_callback (void *contents, size_t size, size_t nmemb,
 {
 	size_t real_size = size * nmemb;
 	Memory *mem = (Memory *)userp;
-	char *ptr = realloc (mem->memory, mem->size + real_size + 1);
+	char *ptr = steam_realloc (mem->memory, mem->size + real_size + 1,
+	                           ALLOC_TAG_TRANSPORT);
 	char error_message[ERROR_MESSAGE_SIZE] = {0};
 
 	print_debug_information ("Entering the function to "
@@ -253,6 +335,8 @@ static size_t write_memory_callback (void *contents, size_t size, size_t nmemb,
 		return 0;
 	}
 
+	count_allocation_metrics (real_size);
+
 	mem->memory = ptr;
 	memcpy (&(mem->memory[mem->size]), contents, real_size);
 	mem->size += real_size;
@@ -265,21 +349,342 @@ static size_t write_memory_callback (void *contents, size_t size, size_t nmemb,
 }
 
 /*===========================================================================*
- * Function name    : curl_general_request                                   *
+ * Function name    : lock_curl_share                                        *
+ *                                                                           *
+ * Description      : This function lock shared curl data                    *
+ *                                                                           *
+ * Input values(s)  : handle                                                 *
+ *                    data                                                   *
+ *                    access                                                 *
+ *                    userptr                                                *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void lock_curl_share (CURL *handle, curl_lock_data data,
+                             curl_lock_access access, void *userptr)
+{
+	pthread_mutex_lock (&s_curl_share_mutex[data % CURL_LOCK_DATA_LAST]);
+}
+
+/*===========================================================================*
+ * Function name    : unlock_curl_share                                      *
+ *                                                                           *
+ * Description      : This function unlock shared curl data                  *
+ *                                                                           *
+ * Input values(s)  : handle                                                 *
+ *                    data                                                   *
+ *                    userptr                                                *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void unlock_curl_share (CURL *handle, curl_lock_data data, void *userptr)
+{
+	pthread_mutex_unlock (&s_curl_share_mutex[data % CURL_LOCK_DATA_LAST]);
+}
+
+/*===========================================================================*
+ * Function name    : init_curl_share                                        *
+ *                                                                           *
+ * Description      : This function create share handle, so cookies, DNS     *
+ *                    cache and TLS sessions are reused by every request of  *
+ *                    the process. The cookie jar is read into it once,      *
+ *                    save_steam_cookies () writes it back                   *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void init_curl_share (void)
+{
+	CURL *curl = NULL;
+
+	for (int index = 0; index < CURL_LOCK_DATA_LAST; index++)
+	{
+		pthread_mutex_init (&s_curl_share_mutex[index], NULL);
+	}
+
+	s_curl_share = curl_share_init ();
+
+	if (s_curl_share == NULL)
+	{
+		return;
+	}
+
+	curl_share_setopt (s_curl_share, CURLSHOPT_LOCKFUNC, lock_curl_share);
+	curl_share_setopt (s_curl_share, CURLSHOPT_UNLOCKFUNC, unlock_curl_share);
+	curl_share_setopt (s_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+	curl_share_setopt (s_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt (s_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+	/* Requests only use the shared cookies, none of them reads the file */
+	curl = curl_easy_init ();
+
+	if (curl != NULL)
+	{
+		curl_easy_setopt (curl, CURLOPT_SHARE, s_curl_share);
+		curl_easy_setopt (curl, CURLOPT_COOKIEFILE, COOKIE_JAR_FILE);
+		curl_easy_setopt (curl, CURLOPT_COOKIELIST, "RELOAD");
+		curl_easy_cleanup (curl);
+	}
+
+	/* Connections are not shared: libcurl doesn't support one connection
+	 * cache used by transfers of several threads at once, they hang. Every
+	 * thread keeps its own, see get_thread_curl_handle () and
+	 * curl_batch_request () */
+}
+
+/*===========================================================================*
+ * Function name    : cleanup_thread_curl_handle                             *
+ *                                                                           *
+ * Description      : This function close easy handle of exiting thread      *
+ *                                                                           *
+ * Input values(s)  : curl                                                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void cleanup_thread_curl_handle (void *curl)
+{
+	curl_easy_cleanup (curl);
+}
+
+/*===========================================================================*
+ * Function name    : init_thread_curl_handle_key                            *
+ *                                                                           *
+ * Description      : This function create key of per-thread easy handles    *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void init_thread_curl_handle_key (void)
+{
+	pthread_key_create (&s_curl_handle_key, cleanup_thread_curl_handle);
+}
+
+/*===========================================================================*
+ * Function name    : get_thread_curl_handle                                 *
+ *                                                                           *
+ * Description      : This function get easy handle of calling thread with   *
+ *                    default options. The handle and its connections live   *
+ *                    until the thread exits, so sequential requests of a    *
+ *                    thread skip TCP and TLS handshakes                     *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Easy handle or NULL                                    *
+ *===========================================================================*/
+static CURL *get_thread_curl_handle (void)
+{
+	CURL *curl = NULL;
+
+	pthread_once (&s_curl_handle_once, init_thread_curl_handle_key);
+
+	curl = pthread_getspecific (s_curl_handle_key);
+
+	if (curl != NULL)
+	{
+		/* Options of the previous request go, connections stay */
+		curl_easy_reset (curl);
+
+		return curl;
+	}
+
+	curl = curl_easy_init ();
+
+	if (curl != NULL && pthread_setspecific (s_curl_handle_key, curl) != 0)
+	{
+		curl_easy_cleanup (curl);
+		curl = NULL;
+	}
+
+	return curl;
+}
+
+/*===========================================================================*
+ * Function name    : init_url_override                                      *
+ *                                                                           *
+ * Description      : This function read base url overrides from the         *
+ *                    environment once                                       *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
  *                                                                           *
- * Description      : This function send request                             *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void init_url_override (void)
+{
+	const char *ptr_env = NULL;
+
+	if ((ptr_env = getenv ("STEAM_COMMUNITY_URL")) != NULL)
+		snprintf (s_community_url, URL_SIZE, "%s", ptr_env);
+
+	if ((ptr_env = getenv ("STEAM_API_URL")) != NULL)
+		snprintf (s_api_url, URL_SIZE, "%s", ptr_env);
+}
+
+/*===========================================================================*
+ * Function name    : override_base_url                                      *
+ *                                                                           *
+ * Description      : This function replace URL_STEAM_COMMUNITY or           *
+ *                    URL_STEAM_API prefix of url by the override            *
+ *                                                                           *
+ * Input values(s)  : url                                                    *
+ *                    size_buffer                                            *
+ *                                                                           *
+ * Output values(s) : buffer                                                 *
+ *                                                                           *
+ * Return value(s)  : url to request, url itself when it is not overridden   *
+ *===========================================================================*/
+static const char *override_base_url (const char *url, char *buffer,
+                                      size_t size_buffer)
+{
+	const size_t length_community = sizeof (URL_STEAM_COMMUNITY) - 1;
+	const size_t length_api = sizeof (URL_STEAM_API) - 1;
+
+	pthread_once (&s_url_override_once, init_url_override);
+
+	if (s_community_url[0] != '\0' &&
+	    strncmp (url, URL_STEAM_COMMUNITY, length_community) == 0)
+	{
+		snprintf (buffer, size_buffer, "%s%s", s_community_url, url + length_community);
+		return buffer;
+	}
+
+	if (s_api_url[0] != '\0' && strncmp (url, URL_STEAM_API, length_api) == 0)
+	{
+		snprintf (buffer, size_buffer, "%s%s", s_api_url, url + length_api);
+		return buffer;
+	}
+
+	return url;
+}
+
+/*===========================================================================*
+ * Function name    : create_steam_headers                                   *
+ *                                                                           *
+ * Description      : This function create http headers of steam requests    *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Header list, free by curl_slist_free_all ()            *
+ *===========================================================================*/
+struct curl_slist *create_steam_headers (void)
+{
+	struct curl_slist *list = NULL;
+
+	list = curl_slist_append (list, "X-Requested-With:"
+	                          " com.valvesoftware.android.steam.community");
+	list = curl_slist_append (list, "Accept:"
+	                          " text/javascript, text/html, application/xml,"
+	                          " text/xml, */*");
+
+	return list;
+}
+
+/*===========================================================================*
+ * Function name    : setup_curl_handle                                      *
+ *                                                                           *
+ * Description      : This function set options of steam request, base url   *
+ *                    may be overridden by STEAM_COMMUNITY_URL and           *
+ *                    STEAM_API_URL environment variables                    *
+ *                                                                           *
+ * Input values(s)  : curl                                                   *
+ *                    url - url address                                      *
+ *                    url_referer - url referer                              *
+ *                    post_data - post data                                  *
+ *                    list - http headers                                    *
+ *                    chunk - response memory                                *
+ *                    error_buffer - CURL_ERROR_SIZE bytes                   *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void setup_curl_handle (CURL *curl, const char *url, const char *url_referer,
+                        const char *post_data, struct curl_slist *list,
+                        Memory *chunk, char *error_buffer)
+{
+	char url_override[URL_SIZE] = {0};
+
+	pthread_once (&s_curl_share_once, init_curl_share);
+
+	curl_easy_setopt (curl, CURLOPT_ENCODING, "gzip, deflate, br");
+
+	/* curl copies the url, the buffer may go out of scope */
+	curl_easy_setopt (curl, CURLOPT_URL,
+	                  override_base_url (url, url_override, URL_SIZE));
+
+	curl_easy_setopt (curl, CURLOPT_HTTPHEADER, list);
+
+	curl_easy_setopt (curl, CURLOPT_USERAGENT, "Mozilla/5.0 (Linux; U;"
+	                  " Android 4.1.1; en-us; Google Nexus 4 - 4.1.1 -"
+	                  " API 16 - 768x1280 Build/JRO03S) AppleWebKit/534.30"
+	                  " (KHTML, like Gecko) Version/4.0 Mobile Safari/534.30");
+
+	if (s_curl_share != NULL)
+	{
+		curl_easy_setopt (curl, CURLOPT_SHARE, s_curl_share);
+	}
+
+	/* Turns the cookie engine on without reading the jar, cookies come
+	 * from the share */
+	curl_easy_setopt (curl, CURLOPT_COOKIEFILE, "");
+
+	curl_easy_setopt (curl, CURLOPT_SSL_VERIFYPEER, 0);
+	curl_easy_setopt (curl, CURLOPT_SSL_VERIFYHOST, 0);
+
+	curl_easy_setopt (curl, CURLOPT_FOLLOWLOCATION, 1);
+	curl_easy_setopt (curl, CURLOPT_MAXREDIRS, 3);
+
+	curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, write_memory_callback);
+	curl_easy_setopt (curl, CURLOPT_WRITEDATA, chunk);
+
+	curl_easy_setopt (curl, CURLOPT_ERRORBUFFER, error_buffer);
+
+	if (url_referer != NULL)
+	{
+		curl_easy_setopt (curl, CURLOPT_REFERER, url_referer);
+	}
+
+	if (post_data != NULL)
+	{
+		curl_easy_setopt (curl, CURLOPT_POSTFIELDS, post_data);
+		curl_easy_setopt (curl, CURLOPT_POSTFIELDSIZE, (long)strlen (post_data));
+	}
+}
+
+/*===========================================================================*
+ * Function name    : perform_general_request                                *
+ *                                                                           *
+ * Description      : This function send request once                        *
  *                                                                           *
  * Input values(s)  : url - url address                                      *
  *                    url_referer - url referer                              *
  *                    post_data - post data                                  *
  *                    get_cookie_flag                                        *
  *                                                                           *
- * Output values(s) : None.                                                  *
+ * Output values(s) : session_expired - response is a login page or error    *
  *                                                                           *
  * Return value(s)  : Responce data                                          *
  *===========================================================================*/
-char *curl_general_request (char *url, char *url_referer, char *post_data,
-                            int8_t get_cookie_flag)
+static char *perform_general_request (char *url, char *url_referer,
+                                      char *post_data, int8_t get_cookie_flag,
+                                      int8_t *session_expired)
 {
 	CURL *curl;
 	struct curl_slist *list = NULL;
@@ -288,11 +693,14 @@ char *curl_general_request (char *url, char *url_referer, char *post_data,
 	char error_message[ERROR_MESSAGE_SIZE] = {0};
 	Memory chunk;
 
-	print_debug_information ("Entering the function to "
-	                         "curl_general_request ()", __LINE__);
+	char *effective_url = NULL;
+	long http_code = 0;
+	MetricEndpoint endpoint = classify_metric_endpoint (url);
+
+	*session_expired = 0;
 
 	/* Will be grown as needed by the realloc above */
-	chunk.memory = malloc (MEMORY_CHUNK_SIZE);
+	chunk.memory = steam_malloc (MEMORY_CHUNK_SIZE, ALLOC_TAG_TRANSPORT);
 	chunk.size = 0;
 
 	if (chunk.memory == NULL)
@@ -303,62 +711,38 @@ char *curl_general_request (char *url, char *url_referer, char *post_data,
 		return NULL;
 	}
 
-	curl = curl_easy_init ();
+	count_allocation_metrics (MEMORY_CHUNK_SIZE);
+
+	curl = get_thread_curl_handle ();
 
 	if (curl)
 	{
-		list = curl_slist_append (list, "X-Requested-With:"
-		                          " com.valvesoftware.android.steam.community");
-		list = curl_slist_append (list, "Accept:"
-		                          " text/javascript, text/html, application/xml,"
-		                          " text/xml, */*");
-
-		curl_easy_setopt (curl, CURLOPT_ENCODING, "gzip, deflate, br");
-
-		curl_easy_setopt (curl, CURLOPT_URL, url);
-
-		curl_easy_setopt (curl, CURLOPT_HTTPHEADER, list);
-
-		curl_easy_setopt (curl, CURLOPT_USERAGENT, "Mozilla/5.0 (Linux; U;"
-		                  " Android 4.1.1; en-us; Google Nexus 4 - 4.1.1 -"
-		                  " API 16 - 768x1280 Build/JRO03S) AppleWebKit/534.30"
-		                  " (KHTML, like Gecko) Version/4.0 Mobile Safari/534.30");
-
-		curl_easy_setopt (curl, CURLOPT_COOKIEJAR, "cookie.txt");
-		curl_easy_setopt (curl, CURLOPT_COOKIEFILE, "cookie.txt");
+		list = create_steam_headers ();
 
-		curl_easy_setopt (curl, CURLOPT_SSL_VERIFYPEER, 0);
-		curl_easy_setopt (curl, CURLOPT_SSL_VERIFYHOST, 0);
+		setup_curl_handle (curl, url, url_referer, post_data, list, &chunk,
+		                   error_buffer);
 
-		curl_easy_setopt (curl, CURLOPT_FOLLOWLOCATION, 1);
-		curl_easy_setopt (curl, CURLOPT_MAXREDIRS, 3);
+		acquire_request_budget (&g_request_budget);
 
-		curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, write_memory_callback);
-		curl_easy_setopt (curl, CURLOPT_WRITEDATA, &chunk);
-
-		curl_easy_setopt (curl, CURLOPT_ERRORBUFFER, error_buffer);
-
-		if (url_referer != NULL)
-		{
-			curl_easy_setopt (curl, CURLOPT_REFERER, url_referer);
-		}
-
-		if (post_data != NULL)
-		{
-			curl_easy_setopt (curl, CURLOPT_POSTFIELDS, post_data);
-			curl_easy_setopt (curl, CURLOPT_POSTFIELDSIZE, strlen (post_data));
-		}
+		begin_request_metrics (endpoint);
 
 		/* Perform the request, curl_return_code will get the return code */ 
 		curl_return_code = curl_easy_perform (curl);
 
+		end_request_metrics (endpoint, curl, curl_return_code);
+
+		/* The handle outlives the request and its locals. curl_easy_reset ()
+		 * keeps the list of cookie files, it grows on every setup otherwise */
+		curl_easy_setopt (curl, CURLOPT_COOKIEFILE, NULL);
+		curl_easy_setopt (curl, CURLOPT_HTTPHEADER, NULL);
+		curl_easy_setopt (curl, CURLOPT_ERRORBUFFER, NULL);
+
 		curl_slist_free_all (list);
 
 		/* Check for errors */ 
 		if (curl_return_code != CURLE_OK)
 		{
-			free (chunk.memory);
-			curl_easy_cleanup (curl);
+			steam_free (chunk.memory);
 
 			snprintf (error_message, ERROR_MESSAGE_SIZE,
 			          "[ERROR %u] curl_easy_perform () failed: %s",
@@ -369,11 +753,21 @@ char *curl_general_request (char *url, char *url_referer, char *post_data,
 			return NULL;
 		}
 
+		/* Login and session checks themselves are not replayed */
+		if (get_cookie_flag != GET_COOKIE)
+		{
+			curl_easy_getinfo (curl, CURLINFO_EFFECTIVE_URL, &effective_url);
+			curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_code);
+
+			*session_expired = is_session_expired (effective_url, http_code,
+			                                       chunk.memory);
+		}
+
 		if (get_cookie_flag == GET_COOKIE)
 		{
 			struct curl_slist *cookies;
 			char *tmp_ptr = NULL;
-			uint16_t start_index = 0;
+			char session_id[sizeof (g_session_id)] = {0};
 
 			curl_easy_getinfo (curl, CURLINFO_COOKIELIST, &cookies);
 
@@ -381,7 +775,6 @@ char *curl_general_request (char *url, char *url_referer, char *post_data,
 			{
 				/* A linked list of cookies in cookie file format */ 
 				struct curl_slist *each = cookies;
-				uint16_t i = 0;
 
 				while (each)
 				{
@@ -389,14 +782,8 @@ char *curl_general_request (char *url, char *url_referer, char *post_data,
 
 					if (tmp_ptr != NULL)
 					{
-						start_index = (tmp_ptr - each->data) + strlen ("sessionid") + 1;
-
-						for (i = start_index; each->data[i] != '\0'; i++)
-						{
-							g_session_id[i - start_index] = each->data[i];
-						}
-
-						g_session_id[i - start_index] = '\0';
+						snprintf (session_id, sizeof (session_id), "%s",
+						          tmp_ptr + strlen ("sessionid") + 1);
 					}
 
 					each = each->next;
@@ -404,14 +791,15 @@ char *curl_general_request (char *url, char *url_referer, char *post_data,
 				/* We must free these cookies when we're done */
 				curl_slist_free_all (cookies);
 			}
-		}
 
-		/* Always cleanup */ 
-		curl_easy_cleanup (curl);
+			/* Built aside, other threads never see a half-written id */
+			if (session_id[0] != '\0')
+				set_steam_session (NULL, session_id);
+		}
 	}
 	else
 	{
-		free (chunk.memory);
+		steam_free (chunk.memory);
 
 		snprintf (error_message, ERROR_MESSAGE_SIZE, "[ERROR %u] ", __LINE__);
 		perror (error_message);
@@ -419,52 +807,647 @@ char *curl_general_request (char *url, char *url_referer, char *post_data,
 		return NULL;
 	}
 
-	print_debug_information ("Exiting the function to "
-	                         "curl_general_request ()", __LINE__);
-
 	return chunk.memory;
 }
 
 /*===========================================================================*
- * Function name    : get_json_object_as_string                              *
+ * Function name    : curl_general_request                                   *
  *                                                                           *
- * Description      : This function get json object as string                *
+ * Description      : This function send request. When the session turns     *
+ *                    out to be expired, it is refreshed and the request     *
+ *                    is replayed once with the new sessionid                *
  *                                                                           *
- * Input values(s)  : ptr_data - contents of the object                      *
- *                    object - json data                                     *
- *                    get_object - object                                    *
+ * Input values(s)  : url - url address                                      *
+ *                    url_referer - url referer                              *
+ *                    post_data - post data                                  *
+ *                    get_cookie_flag                                        *
  *                                                                           *
- * Output values(s) : None.                                                  *
+ * Output values(s) : url, post_data - sessionid is replaced on replay       *
  *                                                                           *
- * Return value(s)  : None.                                                  *
+ * Return value(s)  : Responce data, free by steam_free ()                   *
  *===========================================================================*/
-int8_t get_json_object_as_string (char **ptr_data, struct json_object *object,
-                                  char *get_object)
+char *curl_general_request (char *url, char *url_referer, char *post_data,
+                            int8_t get_cookie_flag)
 {
-	struct json_object *tmp_object = NULL;
-	char *ptr_tmp = NULL;
-	uint16_t tmp_length = 0;
+	char *ptr_data = NULL;
+	int8_t session_expired = 0;
+	uint32_t session_generation = 0;
 
 	print_debug_information ("Entering the function to "
-	                         "get_json_object_as_string ()", __LINE__);
+	                         "curl_general_request ()", __LINE__);
+
+	session_generation = get_session_generation ();
+
+	ptr_data = perform_general_request (url, url_referer, post_data,
+	                                    get_cookie_flag, &session_expired);
+
+	if (ptr_data != NULL && session_expired != 0 &&
+	    refresh_steam_session (session_generation) == SUCCESS)
+	{
+		steam_free (ptr_data);
+
+		replace_session_id (url);
+
+		if (post_data != NULL)
+			replace_session_id (post_data);
+
+		count_retry_metrics (classify_metric_endpoint (url));
+
+		ptr_data = perform_general_request (url, url_referer, post_data,
+		                                    get_cookie_flag, &session_expired);
+	}
+
+	print_debug_information ("Exiting the function to "
+	                         "curl_general_request ()", __LINE__);
+
+	return ptr_data;
+}
+
+/*===========================================================================*
+ * Function name    : is_session_expired                                     *
+ *                                                                           *
+ * Description      : This function detect responses of a lost session:      *
+ *                    redirect to the login page or json error asking to     *
+ *                    log in. A bare 401 is not enough, private inventories  *
+ *                    answer with it too                                     *
+ *                                                                           *
+ * Input values(s)  : effective_url - url after redirects (may be NULL)      *
+ *                    http_code                                              *
+ *                    response - NULL-terminated (may be NULL)               *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : 1 when expired/0                                       *
+ *===========================================================================*/
+int8_t is_session_expired (const char *effective_url, long http_code,
+                           const char *response)
+{
+	/* Only the redirect, login endpoints themselves live under /login/ */
+	if (effective_url != NULL && strstr (effective_url, "/login/home") != NULL)
+		return 1;
+
+	if (response == NULL || response[0] != '{' ||
+	    strstr (response, "\"success\":false") == NULL)
+		return 0;
+
+	/* Only the messages asking to log in, other errors may mention
+	 * "login" too */
+	return strstr (response, "log in") != NULL ||
+	       strstr (response, "logged in") != NULL;
+}
+
+/*===========================================================================*
+ * Function name    : replace_session_id                                     *
+ *                                                                           *
+ * Description      : This function replace values of "sessionid=" by        *
+ *                    g_session_id in place (steam session ids have fixed    *
+ *                    length, others are left as is)                         *
+ *                                                                           *
+ * Input values(s)  : text - url or post data                                *
+ *                                                                           *
+ * Output values(s) : text                                                   *
+ *                                                                           *
+ * Return value(s)  : Count of replaced values                               *
+ *===========================================================================*/
+uint32_t replace_session_id (char *text)
+{
+	char session_id[sizeof (g_session_id)] = {0};
+	size_t length_session_id = 0;
+	uint32_t count_replaced = 0;
+	size_t length_value = 0;
+	char *ptr_value = text;
+
+	get_steam_session (NULL, 0, session_id, sizeof (session_id));
+
+	length_session_id = strlen (session_id);
 
-	json_object_object_get_ex (object, get_object, &tmp_object);
+	while ((ptr_value = strstr (ptr_value, "sessionid=")) != NULL)
+	{
+		ptr_value += sizeof ("sessionid=") - 1;
+		length_value = strcspn (ptr_value, "&");
+
+		if (length_value == length_session_id)
+		{
+			memcpy (ptr_value, session_id, length_session_id);
+			count_replaced++;
+		}
+
+		ptr_value += length_value;
+	}
+
+	return count_replaced;
+}
+
+/*===========================================================================*
+ * Function name    : has_steam_cookie                                       *
+ *                                                                           *
+ * Description      : This function check that cookie is in the shared       *
+ *                    cookie jar and not expired                             *
+ *                                                                           *
+ * Input values(s)  : name - e.g. "steamLoginSecure"                         *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t has_steam_cookie (const char *name)
+{
+	return get_steam_cookie (name, NULL, 0);
+}
+
+/*===========================================================================*
+ * Function name    : get_steam_cookie                                       *
+ *                                                                           *
+ * Description      : This function copy value of the cookie from the shared *
+ *                    cookie jar, expired cookie is not found                *
+ *                                                                           *
+ * Input values(s)  : name - e.g. "steamLoginSecure"                         *
+ *                    size_value                                             *
+ *                                                                           *
+ * Output values(s) : value - (optional parameter)                           *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t get_steam_cookie (const char *name, char *value, size_t size_value)
+{
+	CURL *curl = NULL;
+	struct curl_slist *cookies = NULL;
+	const char *ptr_field = NULL;
+	const size_t length_name = strlen (name);
+	int64_t expires = 0;
+	int8_t return_value = FAILURE;
+
+	if (value != NULL && size_value != 0)
+		value[0] = '\0';
+
+	pthread_once (&s_curl_share_once, init_curl_share);
+
+	curl = curl_easy_init ();
 
-	if (tmp_object == NULL)
+	if (curl == NULL || s_curl_share == NULL)
 	{
+		if (curl != NULL)
+			curl_easy_cleanup (curl);
+
 		return FAILURE;
 	}
 
-	ptr_tmp = (char *)json_object_get_string (tmp_object);
+	curl_easy_setopt (curl, CURLOPT_SHARE, s_curl_share);
+	curl_easy_getinfo (curl, CURLINFO_COOKIELIST, &cookies);
+
+	/* Netscape format: domain, tailmatch, path, secure, expires, name, value */
+	for (struct curl_slist *each = cookies; each != NULL && return_value == FAILURE;
+	     each = each->next)
+	{
+		ptr_field = each->data;
+
+		for (uint8_t field = 0; field < 4 && ptr_field != NULL; field++)
+		{
+			ptr_field = strchr (ptr_field, '\t');
+			ptr_field = ptr_field != NULL ? ptr_field + 1 : NULL;
+		}
+
+		if (ptr_field == NULL)
+			continue;
+
+		expires = strtoll (ptr_field, (char **)&ptr_field, 10);
+
+		if (*ptr_field == '\t' && strncmp (ptr_field + 1, name, length_name) == 0 &&
+		    ptr_field[1 + length_name] == '\t' &&
+		    (expires == 0 || expires > (int64_t)time (NULL)))
+		{
+			if (value != NULL)
+				snprintf (value, size_value, "%s", ptr_field + 2 + length_name);
+
+			return_value = SUCCESS;
+		}
+	}
+
+	curl_slist_free_all (cookies);
+	curl_easy_cleanup (curl);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : save_steam_cookies                                     *
+ *                                                                           *
+ * Description      : This function write the shared cookie jar to           *
+ *                    COOKIE_JAR_FILE. curl writes it under the cookie lock  *
+ *                    of the share, so saves of several threads don't mix    *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t save_steam_cookies (void)
+{
+	CURL *curl = NULL;
+	int8_t return_value = FAILURE;
+
+	pthread_once (&s_curl_share_once, init_curl_share);
+
+	curl = curl_easy_init ();
+
+	if (curl == NULL || s_curl_share == NULL)
+	{
+		if (curl != NULL)
+			curl_easy_cleanup (curl);
+
+		return FAILURE;
+	}
+
+	curl_easy_setopt (curl, CURLOPT_SHARE, s_curl_share);
+	curl_easy_setopt (curl, CURLOPT_COOKIEJAR, COOKIE_JAR_FILE);
+
+	if (curl_easy_setopt (curl, CURLOPT_COOKIELIST, "FLUSH") == CURLE_OK)
+	{
+		return_value = SUCCESS;
+	}
+
+	/* Written once, not again by curl_easy_cleanup () */
+	curl_easy_setopt (curl, CURLOPT_COOKIEJAR, NULL);
+	curl_easy_cleanup (curl);
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : parse_json_response                                    *
+ *                                                                           *
+ * Description      : This function parse json response, time of the parse   *
+ *                    is recorded in metrics                                 *
+ *                                                                           *
+ * Input values(s)  : data - NULL-terminated json                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Json object, free by json_object_put ()/NULL           *
+ *===========================================================================*/
+struct json_object *parse_json_response (const char *data)
+{
+	struct json_object *parsed_json = NULL;
+	uint64_t start_us = get_metrics_time_us ();
+
+	parsed_json = json_tokener_parse (data);
+
+	record_json_parse_metrics (get_metrics_time_us () - start_us);
+
+	return parsed_json;
+}
+
+/*===========================================================================*
+ * Function name    : get_json_object_as_string                              *
+ *                                                                           *
+ * Description      : This function get json object as string                *
+ *                                                                           *
+ * Input values(s)  : ptr_data - contents of the object                      *
+ *                    object - json data                                     *
+ *                    get_object - object                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+int8_t get_json_object_as_string (char **ptr_data, struct json_object *object,
+                                  char *get_object)
+{
+	return get_json_object_as_tagged_string (ptr_data, object, get_object,
+	                                         ALLOC_TAG_JSON);
+}
+
+/*===========================================================================*
+ * Function name    : get_json_object_as_tagged_string                       *
+ *                                                                           *
+ * Description      : This function get json object as string accounted to   *
+ *                    the subsystem that keeps it                            *
+ *                                                                           *
+ * Input values(s)  : ptr_data - contents of the object, free by             *
+ *                               steam_free ()                               *
+ *                    object - json data                                     *
+ *                    get_object - object                                    *
+ *                    tag                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t get_json_object_as_tagged_string (char **ptr_data,
+                                         struct json_object *object,
+                                         char *get_object, AllocationTag tag)
+{
+	StringView string_view;
+	char *ptr_tmp = NULL;
+
+	print_debug_information ("Entering the function to "
+	                         "get_json_object_as_tagged_string ()", __LINE__);
+
+	if (get_json_object_as_view (&string_view, object, get_object) != SUCCESS)
+	{
+		return FAILURE;
+	}
 
-	tmp_length = strlen (ptr_tmp) + 1;
+	ptr_tmp = copy_string_view (&string_view, tag);
 
-	*ptr_data = calloc (tmp_length, sizeof (char));
+	if (ptr_tmp == NULL)
+	{
+		return FAILURE;
+	}
 
-	snprintf (*ptr_data, tmp_length, "%s", ptr_tmp);
+	*ptr_data = ptr_tmp;
 
 	print_debug_information ("Exiting the function to "
-	                         "get_json_object_as_string ()", __LINE__);
+	                         "get_json_object_as_tagged_string ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : get_json_object_as_view                                *
+ *                                                                           *
+ * Description      : This function get json object as string without        *
+ *                    copying it. The view points into the parsed json and   *
+ *                    is valid until json_object_put () of it                *
+ *                                                                           *
+ * Input values(s)  : object - json data                                     *
+ *                    get_object - object                                    *
+ *                                                                           *
+ * Output values(s) : string_view                                            *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t get_json_object_as_view (StringView *string_view,
+                                struct json_object *object, char *get_object)
+{
+	struct json_object *tmp_object = NULL;
+	const char *ptr_tmp = NULL;
+
+	if (json_object_object_get_ex (object, get_object, &tmp_object) == 0 ||
+	    tmp_object == NULL)
+	{
+		return FAILURE;
+	}
+
+	ptr_tmp = json_object_get_string (tmp_object);
+
+	if (ptr_tmp == NULL)
+	{
+		return FAILURE;
+	}
+
+	string_view->data = ptr_tmp;
+
+	/* Numbers are printed into a buffer of the object, only strings
+	 * know their length */
+	string_view->length = json_object_is_type (tmp_object, json_type_string) ?
+	                      (size_t)json_object_get_string_len (tmp_object) :
+	                      strlen (ptr_tmp);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : parse_string_view_as_uint64                            *
+ *                                                                           *
+ * Description      : This function convert decimal digits of view to        *
+ *                    integer in place                                       *
+ *                                                                           *
+ * Input values(s)  : string_view                                            *
+ *                                                                           *
+ * Output values(s) : value                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE on empty view, other characters or     *
+ *                    overflow                                               *
+ *===========================================================================*/
+int8_t parse_string_view_as_uint64 (const StringView *string_view,
+                                    uint64_t *value)
+{
+	uint64_t result = 0;
+	uint8_t digit = 0;
+
+	if (string_view->length == 0)
+	{
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < string_view->length; index++)
+	{
+		digit = (uint8_t)(string_view->data[index] - '0');
+
+		if (digit > 9 || result > (UINT64_MAX - digit) / 10)
+		{
+			return FAILURE;
+		}
+
+		result = result * 10 + digit;
+	}
+
+	*value = result;
 
 	return SUCCESS;
 }
+
+/*===========================================================================*
+ * Function name    : copy_string_view                                       *
+ *                                                                           *
+ * Description      : This function copy view to NUL terminated string       *
+ *                                                                           *
+ * Input values(s)  : string_view                                            *
+ *                    tag                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : String, free by steam_free ()/NULL                     *
+ *===========================================================================*/
+char *copy_string_view (const StringView *string_view, AllocationTag tag)
+{
+	char *ptr_data = NULL;
+
+	ptr_data = steam_malloc (string_view->length + 1, tag);
+
+	if (ptr_data == NULL)
+	{
+		return NULL;
+	}
+
+	memcpy (ptr_data, string_view->data, string_view->length);
+	ptr_data[string_view->length] = '\0';
+
+	return ptr_data;
+}
+
+/*===========================================================================*
+ * Function name    : get_json_object_as_uint64                              *
+ *                                                                           *
+ * Description      : This function get json number or numeric string       *
+ *                                                                           *
+ * Input values(s)  : object - json data                                     *
+ *                    get_object - object                                    *
+ *                                                                           *
+ * Output values(s) : value                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t get_json_object_as_uint64 (uint64_t *value, struct json_object *object,
+                                  char *get_object)
+{
+	struct json_object *tmp_object = NULL;
+	const char *ptr_tmp = NULL;
+
+	if (json_object_object_get_ex (object, get_object, &tmp_object) == 0 ||
+	    tmp_object == NULL)
+	{
+		return FAILURE;
+	}
+
+	ptr_tmp = json_object_get_string (tmp_object);
+
+	if (ptr_tmp == NULL)
+	{
+		return FAILURE;
+	}
+
+	*value = strtoull (ptr_tmp, NULL, 10);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : parse_price_text                                       *
+ *                                                                           *
+ * Description      : This function parse price as shown by steam, e.g.      *
+ *                    "$1,234.56", "0,35 pуб." or "12,--€" to cents          *
+ *                                                                           *
+ * Input values(s)  : text                                                   *
+ *                    length - max length of text                            *
+ *                                                                           *
+ * Output values(s) : price - in cents                                       *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t parse_price_text (const char *text, size_t length, uint32_t *price)
+{
+	uint64_t integer_part = 0;
+	uint64_t fraction_part = 0;
+	uint8_t fraction_digits = 0;
+	uint8_t started = 0;
+	uint8_t after_separator = 0;
+
+	for (size_t index = 0; index < length && text[index] != '\0' &&
+	     text[index] != '<'; index++)
+	{
+		char ch = text[index];
+
+		if (isdigit ((uint8_t)ch))
+		{
+			started = 1;
+
+			if (after_separator)
+			{
+				fraction_part = fraction_part * 10 + (ch - '0');
+				fraction_digits++;
+			}
+			else
+			{
+				integer_part = integer_part * 10 + (ch - '0');
+			}
+		}
+		else if (started && (ch == '.' || ch == ','))
+		{
+			/* The previous separator grouped thousands */
+			if (after_separator)
+			{
+				for (uint8_t digit = 0; digit < fraction_digits; digit++)
+					integer_part *= 10;
+
+				integer_part += fraction_part;
+				fraction_part = 0;
+				fraction_digits = 0;
+			}
+
+			after_separator = 1;
+		}
+		else if (started && ch != ' ' && ch != '\'' && (uint8_t)ch != 0xA0 &&
+		         (uint8_t)ch != 0xC2 && ch != '-')
+		{
+			break;
+		}
+	}
+
+	if (started == 0)
+	{
+		return FAILURE;
+	}
+
+	/* "1,234" - three digits after the only separator are thousands */
+	if (fraction_digits > 2)
+	{
+		for (uint8_t digit = 0; digit < fraction_digits; digit++)
+			integer_part *= 10;
+
+		integer_part += fraction_part;
+		fraction_part = 0;
+		fraction_digits = 0;
+	}
+
+	if (fraction_digits == 1)
+		fraction_part *= 10;
+
+	*price = integer_part * 100 + fraction_part;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : days_from_civil                                        *
+ *                                                                           *
+ * Description      : This function convert date to days since 1970-01-01    *
+ *                                                                           *
+ * Input values(s)  : year                                                   *
+ *                    month - 1..12                                          *
+ *                    day - 1..31                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Days                                                   *
+ *===========================================================================*/
+int64_t days_from_civil (int32_t year, uint8_t month, uint8_t day)
+{
+	int64_t era = 0;
+	int64_t year_of_era = 0;
+	int64_t day_of_year = 0;
+
+	year -= month <= 2;
+	era = (year >= 0 ? year : year - 399) / 400;
+	year_of_era = year - era * 400;
+	day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+
+	return era * 146097 + year_of_era * 365 + year_of_era / 4 -
+	       year_of_era / 100 + day_of_year - 719468;
+}
+
+/*===========================================================================*
+ * Function name    : parse_month_name                                       *
+ *                                                                           *
+ * Description      : This function parse english month abbreviation         *
+ *                                                                           *
+ * Input values(s)  : text - at least three characters                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Month 1..12, 0 if not a month                          *
+ *===========================================================================*/
+uint8_t parse_month_name (const char *text)
+{
+	static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+	for (uint8_t index = 0; index < 12; index++)
+	{
+		if (strncasecmp (text, months + index * 3, 3) == STRINGS_EQUAL)
+			return index + 1;
+	}
+
+	return 0;
+}
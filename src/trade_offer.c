@@ -0,0 +1,588 @@
+#include <time.h>
+
+#include "../inc/trade_offer.h"
+#include "../inc/steam.h"
+#include "../inc/inventory.h"
+#include "../inc/transport.h"
+#include "../inc/session.h"
+
+static SteamInventory *parse_trade_offer_items (struct json_object *);
+static void free_trade_offer (TradeOffer *);
+static int8_t parse_trade_offer (struct json_object *, TradeOffer *);
+static int8_t add_trade_offers (TradeOfferList *, size_t *,
+                                struct json_object *, int64_t, int64_t *);
+static void build_trade_offer_request (SteamRequest *,
+                                       const TradeOfferResponse *, char *);
+static void parse_trade_offer_result (const SteamRequest *, TradeOfferAction,
+                                      TradeOfferResult *);
+
+/*===========================================================================*
+ * Function name    : parse_trade_offer_items                                *
+ *                                                                           *
+ * Description      : This function map assets of one side of an offer to    *
+ *                    inventory items                                        *
+ *                                                                           *
+ * Input values(s)  : json_items - items_to_give/items_to_receive            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Steam inventory or NULL when the side is empty         *
+ *===========================================================================*/
+static SteamInventory *parse_trade_offer_items (struct json_object *json_items)
+{
+	SteamInventory *steam_inventory = NULL;
+	size_t size_items_table = 0;
+	size_t count_items = 0;
+
+	if (json_object_is_type (json_items, json_type_array) == 0 ||
+	    (size_items_table = json_object_array_length (json_items)) == 0)
+	{
+		return NULL;
+	}
+
+	steam_inventory = steam_calloc (1, sizeof (SteamInventory), ALLOC_TAG_TRADE);
+
+	if (steam_inventory == NULL)
+	{
+		return NULL;
+	}
+
+	steam_inventory->inventory_items = steam_calloc (size_items_table,
+	                                                 sizeof (InventoryItem),
+	                                                 ALLOC_TAG_TRADE);
+
+	if (steam_inventory->inventory_items == NULL)
+	{
+		steam_free (steam_inventory);
+
+		return NULL;
+	}
+
+	for (size_t index = 0; index < size_items_table; index++)
+	{
+		/* Assets without ids are dropped, the rest move up */
+		if (parse_inventory_item (json_object_array_get_idx (json_items, index),
+		                          &steam_inventory->inventory_items[count_items]) == SUCCESS)
+		{
+			count_items++;
+		}
+		else
+		{
+			memset (&steam_inventory->inventory_items[count_items], 0,
+			        sizeof (InventoryItem));
+		}
+	}
+
+	steam_inventory->count_items = count_items;
+
+	return steam_inventory;
+}
+
+/*===========================================================================*
+ * Function name    : free_trade_offer                                       *
+ *                                                                           *
+ * Description      : This function free memory owned by offer, the offer    *
+ *                    itself is not freed                                    *
+ *                                                                           *
+ * Input values(s)  : trade_offer                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void free_trade_offer (TradeOffer *trade_offer)
+{
+	steam_free (trade_offer->message);
+	free_steam_inventory (trade_offer->items_to_give);
+	free_steam_inventory (trade_offer->items_to_receive);
+
+	memset (trade_offer, 0, sizeof (TradeOffer));
+}
+
+/*===========================================================================*
+ * Function name    : parse_trade_offer                                      *
+ *                                                                           *
+ * Description      : This function parse one offer of GetTradeOffers        *
+ *                                                                           *
+ * Input values(s)  : json_offer                                             *
+ *                                                                           *
+ * Output values(s) : trade_offer - free by free_trade_offer ()              *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t parse_trade_offer (struct json_object *json_offer,
+                                 TradeOffer *trade_offer)
+{
+	struct json_object *json_value = NULL;
+	uint64_t value = 0;
+
+	memset (trade_offer, 0, sizeof (TradeOffer));
+
+	if (get_json_object_as_uint64 (&trade_offer->trade_offer_id, json_offer,
+	                               "tradeofferid") != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	/* Partner comes as 32 bit account id */
+	if (get_json_object_as_uint64 (&value, json_offer, "accountid_other") == SUCCESS)
+		trade_offer->partner_steam_id = STEAM_ID64_BASE + value;
+
+	if (get_json_object_as_uint64 (&value, json_offer, "trade_offer_state") == SUCCESS)
+		trade_offer->state = (TradeOfferState)value;
+
+	if (json_object_object_get_ex (json_offer, "is_our_offer", &json_value) != 0)
+		trade_offer->is_our_offer = json_object_get_boolean (json_value) != 0;
+
+	if (get_json_object_as_uint64 (&value, json_offer, "time_created") == SUCCESS)
+		trade_offer->time_created = (int64_t)value;
+
+	if (get_json_object_as_uint64 (&value, json_offer, "time_updated") == SUCCESS)
+		trade_offer->time_updated = (int64_t)value;
+
+	if (get_json_object_as_uint64 (&value, json_offer, "expiration_time") == SUCCESS)
+		trade_offer->expiration_time = (int64_t)value;
+
+	if (get_json_object_as_uint64 (&value, json_offer, "escrow_end_date") == SUCCESS)
+		trade_offer->escrow_end_date = (int64_t)value;
+
+	get_json_object_as_tagged_string (&trade_offer->message, json_offer,
+	                                  "message", ALLOC_TAG_TRADE);
+
+	json_value = NULL;
+	json_object_object_get_ex (json_offer, "items_to_give", &json_value);
+	trade_offer->items_to_give = parse_trade_offer_items (json_value);
+
+	json_value = NULL;
+	json_object_object_get_ex (json_offer, "items_to_receive", &json_value);
+	trade_offer->items_to_receive = parse_trade_offer_items (json_value);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : add_trade_offers                                       *
+ *                                                                           *
+ * Description      : This function add offers updated since cutoff to list  *
+ *                                                                           *
+ * Input values(s)  : trade_offer_list                                       *
+ *                    capacity - of trade_offer_list->offers                 *
+ *                    json_offers - trade_offers_sent/trade_offers_received  *
+ *                    time_cutoff - older offers are skipped                 *
+ *                    time_updated - latest update seen                      *
+ *                                                                           *
+ * Output values(s) : trade_offer_list                                       *
+ *                    capacity                                               *
+ *                    time_updated                                           *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t add_trade_offers (TradeOfferList *trade_offer_list,
+                                size_t *capacity, struct json_object *json_offers,
+                                int64_t time_cutoff, int64_t *time_updated)
+{
+	size_t count_offers = 0;
+	TradeOffer *ptr_offers = NULL;
+	TradeOffer *trade_offer = NULL;
+
+	if (json_object_is_type (json_offers, json_type_array) == 0)
+	{
+		return SUCCESS;
+	}
+
+	count_offers = json_object_array_length (json_offers);
+
+	for (size_t index = 0; index < count_offers; index++)
+	{
+		if (trade_offer_list->count_offers == *capacity)
+		{
+			*capacity = *capacity > 0 ? *capacity * 2 : count_offers;
+
+			ptr_offers = steam_realloc (trade_offer_list->offers,
+			                            *capacity * sizeof (TradeOffer),
+			                            ALLOC_TAG_TRADE);
+
+			if (ptr_offers == NULL)
+			{
+				return FAILURE;
+			}
+
+			trade_offer_list->offers = ptr_offers;
+		}
+
+		trade_offer = &trade_offer_list->offers[trade_offer_list->count_offers];
+
+		if (parse_trade_offer (json_object_array_get_idx (json_offers, index),
+		                       trade_offer) != SUCCESS)
+		{
+			continue;
+		}
+
+		/* Active offers come back on every poll, unchanged ones are not
+		 * news */
+		if (trade_offer->time_updated < time_cutoff)
+		{
+			free_trade_offer (trade_offer);
+			continue;
+		}
+
+		if (trade_offer->time_updated > *time_updated)
+			*time_updated = trade_offer->time_updated;
+
+		trade_offer_list->count_offers++;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : poll_trade_offers                                      *
+ *                                                                           *
+ * Description      : This function get offers created or changed since the  *
+ *                    cursor with IEconService/GetTradeOffers, descriptions  *
+ *                    of the items go to the shared cache. An offer updated  *
+ *                    in the same second as the cursor may come twice        *
+ *                                                                           *
+ * Input values(s)  : api_key - Steam Web API key                            *
+ *                    flags - TRADE_OFFERS_SENT | TRADE_OFFERS_RECEIVED      *
+ *                    cursor                                                 *
+ *                                                                           *
+ * Output values(s) : cursor - moved past returned offers on success         *
+ *                                                                           *
+ * Return value(s)  : Offers, free by free_trade_offers ()/NULL              *
+ *===========================================================================*/
+TradeOfferList *poll_trade_offers (const char *api_key, uint8_t flags,
+                                   TradeOfferCursor *cursor)
+{
+	TradeOfferList *trade_offer_list = NULL;
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_response = NULL;
+	struct json_object *json_value = NULL;
+	char steam_url[URL_SIZE] = {0};
+	char *ptr_data = NULL;
+	size_t capacity = 0;
+	uint64_t page_cursor = 0;
+	uint32_t count_pages = 0;
+	int64_t time_cutoff = cursor->time_historical_cutoff;
+	int64_t time_updated = 0;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "poll_trade_offers ()", __LINE__);
+
+	if (api_key == NULL)
+	{
+		return NULL;
+	}
+
+	trade_offer_list = steam_calloc (1, sizeof (TradeOfferList), ALLOC_TAG_TRADE);
+
+	if (trade_offer_list == NULL)
+	{
+		return NULL;
+	}
+
+	/* First poll: no history, only what is active now */
+	if (time_cutoff == 0)
+		time_cutoff = (int64_t)time (NULL);
+
+	time_updated = time_cutoff;
+
+	do
+	{
+		snprintf (steam_url, sizeof (steam_url), URL_STEAM_API
+		          "IEconService/GetTradeOffers/v1/?key=%s&get_sent_offers=%d"
+		          "&get_received_offers=%d&get_descriptions=1&language=english"
+		          "&active_only=1&time_historical_cutoff=%lld&cursor=%llu",
+		          api_key, (flags & TRADE_OFFERS_SENT) != 0,
+		          (flags & TRADE_OFFERS_RECEIVED) != 0, (long long)time_cutoff,
+		          (unsigned long long)page_cursor);
+
+		ptr_data = curl_general_request (steam_url, NULL, NULL, 0);
+
+		if (ptr_data == NULL)
+		{
+			return_value = FAILURE;
+			break;
+		}
+
+		parsed_json = parse_json_response (ptr_data);
+
+		steam_free (ptr_data);
+
+		if (parsed_json == NULL ||
+		    json_object_object_get_ex (parsed_json, "response", &json_response) == 0)
+		{
+			if (parsed_json != NULL)
+				json_object_put (parsed_json);
+
+			return_value = FAILURE;
+			break;
+		}
+
+		if (json_object_object_get_ex (json_response, "descriptions", &json_value) != 0)
+			cache_item_descriptions (json_value);
+
+		/* Offers active now are taken whatever their age on the first poll */
+		json_value = NULL;
+		json_object_object_get_ex (json_response, "trade_offers_sent", &json_value);
+		return_value = add_trade_offers (trade_offer_list, &capacity, json_value,
+		                                 cursor->time_historical_cutoff,
+		                                 &time_updated);
+
+		json_value = NULL;
+		json_object_object_get_ex (json_response, "trade_offers_received", &json_value);
+
+		if (return_value == SUCCESS)
+			return_value = add_trade_offers (trade_offer_list, &capacity, json_value,
+			                                 cursor->time_historical_cutoff,
+			                                 &time_updated);
+
+		page_cursor = 0;
+		get_json_object_as_uint64 (&page_cursor, json_response, "next_cursor");
+
+		json_object_put (parsed_json);
+
+	} while (return_value == SUCCESS && page_cursor != 0 &&
+	         ++count_pages < TRADE_OFFER_MAX_PAGES);
+
+	if (return_value != SUCCESS)
+	{
+		free_trade_offers (trade_offer_list);
+
+		return NULL;
+	}
+
+	cursor->time_historical_cutoff = time_updated;
+
+	print_debug_information ("Exiting the function to "
+	                         "poll_trade_offers ()", __LINE__);
+
+	return trade_offer_list;
+}
+
+/*===========================================================================*
+ * Function name    : free_trade_offers                                      *
+ *                                                                           *
+ * Description      : This function free memory of offers                    *
+ *                                                                           *
+ * Input values(s)  : trade_offer_list                                       *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_trade_offers (TradeOfferList *trade_offer_list)
+{
+	if (trade_offer_list == NULL)
+		return;
+
+	for (size_t index = 0; index < trade_offer_list->count_offers; index++)
+	{
+		free_trade_offer (&trade_offer_list->offers[index]);
+	}
+
+	steam_free (trade_offer_list->offers);
+	steam_free (trade_offer_list);
+}
+
+/*===========================================================================*
+ * Function name    : build_trade_offer_request                              *
+ *                                                                           *
+ * Description      : This function build accept/decline/cancel request      *
+ *                                                                           *
+ * Input values(s)  : trade_offer_response                                   *
+ *                    post_data - POST_DATA_SIZE bytes                       *
+ *                                                                           *
+ * Output values(s) : request                                                *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void build_trade_offer_request (SteamRequest *request,
+                                       const TradeOfferResponse *trade_offer_response,
+                                       char *post_data)
+{
+	static const char *action_names[] = { "accept", "decline", "cancel" };
+	unsigned long long trade_offer_id = trade_offer_response->trade_offer_id;
+	char session_id[sizeof (g_session_id)] = {0};
+
+	get_steam_session (NULL, 0, session_id, sizeof (session_id));
+
+	snprintf (request->url, sizeof (request->url), URL_STEAM_COMMUNITY
+	          "tradeoffer/%llu/%s", trade_offer_id,
+	          action_names[trade_offer_response->action]);
+
+	snprintf (request->url_referer, sizeof (request->url_referer),
+	          URL_STEAM_COMMUNITY "tradeoffer/%llu/", trade_offer_id);
+
+	if (trade_offer_response->action == TRADE_OFFER_ACCEPT)
+	{
+		snprintf (post_data, POST_DATA_SIZE,
+		          "sessionid=" "%s" "&"
+		          "serverid=" "1" "&"
+		          "tradeofferid=" "%llu" "&"
+		          "partner=" "%llu" "&"
+		          "captcha=",
+		          session_id, trade_offer_id,
+		          (unsigned long long)trade_offer_response->partner_steam_id);
+	}
+	else
+	{
+		snprintf (post_data, POST_DATA_SIZE, "sessionid=" "%s", session_id);
+	}
+
+	request->post_data = post_data;
+}
+
+/*===========================================================================*
+ * Function name    : parse_trade_offer_result                               *
+ *                                                                           *
+ * Description      : This function get result of accept/decline/cancel      *
+ *                                                                           *
+ * Input values(s)  : request                                                *
+ *                    action                                                 *
+ *                                                                           *
+ * Output values(s) : trade_offer_result                                     *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void parse_trade_offer_result (const SteamRequest *request,
+                                      TradeOfferAction action,
+                                      TradeOfferResult *trade_offer_result)
+{
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_value = NULL;
+	uint64_t trade_offer_id = 0;
+
+	memset (trade_offer_result, 0, sizeof (TradeOfferResult));
+
+	trade_offer_result->success = FAILURE;
+	trade_offer_result->http_code = request->http_code;
+
+	if (request->curl_code != CURLE_OK || request->response.memory == NULL)
+	{
+		snprintf (trade_offer_result->message, sizeof (trade_offer_result->message),
+		          "%s", curl_easy_strerror (request->curl_code));
+		return;
+	}
+
+	parsed_json = parse_json_response (request->response.memory);
+
+	if (parsed_json == NULL)
+	{
+		snprintf (trade_offer_result->message, sizeof (trade_offer_result->message),
+		          "unexpected response (http %ld)", request->http_code);
+		return;
+	}
+
+	if (json_object_object_get_ex (parsed_json, "strError", &json_value) != 0)
+	{
+		snprintf (trade_offer_result->message, sizeof (trade_offer_result->message),
+		          "%s", json_object_get_string (json_value));
+	}
+	else if (action == TRADE_OFFER_ACCEPT)
+	{
+		get_json_object_as_uint64 (&trade_offer_result->trade_id, parsed_json,
+		                           "tradeid");
+
+		/* Accepting an offer that gives items away waits for mobile or
+		 * email confirmation, see respond_to_confirmations () */
+		if ((json_object_object_get_ex (parsed_json, "needs_mobile_confirmation",
+		                                &json_value) != 0 &&
+		     json_object_get_boolean (json_value) != 0) ||
+		    (json_object_object_get_ex (parsed_json, "needs_email_confirmation",
+		                                &json_value) != 0 &&
+		     json_object_get_boolean (json_value) != 0))
+		{
+			trade_offer_result->needs_confirmation = 1;
+		}
+
+		if (request->http_code == 200 &&
+		    (trade_offer_result->trade_id != 0 ||
+		     trade_offer_result->needs_confirmation != 0))
+		{
+			trade_offer_result->success = SUCCESS;
+		}
+	}
+	else if (request->http_code == 200 &&
+	         get_json_object_as_uint64 (&trade_offer_id, parsed_json,
+	                                    "tradeofferid") == SUCCESS)
+	{
+		trade_offer_result->success = SUCCESS;
+	}
+
+	if (trade_offer_result->success != SUCCESS &&
+	    trade_offer_result->message[0] == '\0')
+	{
+		snprintf (trade_offer_result->message, sizeof (trade_offer_result->message),
+		          "unexpected response (http %ld)", request->http_code);
+	}
+
+	json_object_put (parsed_json);
+}
+
+/*===========================================================================*
+ * Function name    : respond_to_trade_offers                                *
+ *                                                                           *
+ * Description      : This function accept, decline or cancel offers with    *
+ *                    concurrent requests                                    *
+ *                                                                           *
+ * Input values(s)  : trade_offer_responses                                  *
+ *                    count_responses                                        *
+ *                    max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : trade_offer_results - in the same order                *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if every offer was handled, otherwise FAILURE  *
+ *===========================================================================*/
+int8_t respond_to_trade_offers (const TradeOfferResponse *trade_offer_responses,
+                                size_t count_responses,
+                                TradeOfferResult *trade_offer_results,
+                                uint32_t max_concurrency)
+{
+	SteamRequest *requests = NULL;
+	char *post_data = NULL;
+	int8_t return_value = SUCCESS;
+
+	print_debug_information ("Entering the function to "
+	                         "respond_to_trade_offers ()", __LINE__);
+
+	requests = steam_calloc (count_responses + 1, sizeof (SteamRequest),
+	                         ALLOC_TAG_TRADE);
+	post_data = steam_calloc (count_responses + 1, POST_DATA_SIZE, ALLOC_TAG_TRADE);
+
+	if (requests == NULL || post_data == NULL)
+	{
+		steam_free (requests);
+		steam_free (post_data);
+
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < count_responses; index++)
+	{
+		build_trade_offer_request (&requests[index], &trade_offer_responses[index],
+		                           post_data + index * POST_DATA_SIZE);
+	}
+
+	curl_batch_request (requests, count_responses, max_concurrency, NULL, NULL);
+
+	for (size_t index = 0; index < count_responses; index++)
+	{
+		parse_trade_offer_result (&requests[index],
+		                          trade_offer_responses[index].action,
+		                          &trade_offer_results[index]);
+
+		if (trade_offer_results[index].success != SUCCESS)
+			return_value = FAILURE;
+	}
+
+	free_steam_requests (requests, count_responses);
+	steam_free (requests);
+	steam_free (post_data);
+
+	print_debug_information ("Exiting the function to "
+	                         "respond_to_trade_offers ()", __LINE__);
+
+	return return_value;
+}
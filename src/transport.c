@@ -0,0 +1,564 @@
+#include <errno.h>
+
+#include "../inc/transport.h"
+#include "../inc/session.h"
+#include "../inc/metrics.h"
+#include "../inc/steam.h"
+
+#define BATCH_WAIT_MS  100
+
+static double elapsed_seconds (const struct timespec *, const struct timespec *);
+static void refill_request_budget (RequestBudget *);
+static CURL *start_batch_request (CURLM *, SteamRequest *,
+                                  struct curl_slist *);
+static void acquire_request_budget_delay (uint32_t);
+static int8_t replay_expired_request (CURLM *, CURL *, SteamRequest *,
+                                      struct curl_slist *);
+static void cleanup_thread_multi_handle (void *);
+static void init_thread_multi_handle_key (void);
+static CURLM *acquire_thread_multi_handle (void);
+static void release_thread_multi_handle (CURLM *);
+
+/* Multi handle of the thread, keeps its connections between batches */
+static pthread_key_t s_multi_handle_key;
+static pthread_once_t s_multi_handle_once = PTHREAD_ONCE_INIT;
+static __thread uint8_t s_multi_handle_busy = 0;
+
+/*===========================================================================*
+ * Function name    : elapsed_seconds                                        *
+ *                                                                           *
+ * Description      : This function get time between two moments             *
+ *                                                                           *
+ * Input values(s)  : start                                                  *
+ *                    end                                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Seconds                                                *
+ *===========================================================================*/
+static double elapsed_seconds (const struct timespec *start,
+                               const struct timespec *end)
+{
+	return (double)(end->tv_sec - start->tv_sec) +
+	       (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*===========================================================================*
+ * Function name    : refill_request_budget                                  *
+ *                                                                           *
+ * Description      : This function add tokens for elapsed time (mutex must  *
+ *                    be held)                                               *
+ *                                                                           *
+ * Input values(s)  : budget                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void refill_request_budget (RequestBudget *budget)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	if (budget->last_refill.tv_sec == 0 && budget->last_refill.tv_nsec == 0)
+	{
+		budget->tokens = budget->burst;
+	}
+	else
+	{
+		budget->tokens += elapsed_seconds (&budget->last_refill, &now) * budget->rate;
+
+		if (budget->tokens > budget->burst)
+			budget->tokens = budget->burst;
+	}
+
+	budget->last_refill = now;
+}
+
+/*===========================================================================*
+ * Function name    : init_request_budget                                    *
+ *                                                                           *
+ * Description      : This function set request rate limit                   *
+ *                                                                           *
+ * Input values(s)  : budget                                                 *
+ *                    rate - requests per second, 0 for unlimited            *
+ *                    burst - max requests sent at once                      *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void init_request_budget (RequestBudget *budget, double rate, double burst)
+{
+	pthread_mutex_lock (&budget->mutex);
+
+	budget->rate = rate;
+	budget->burst = burst < 1.0 ? 1.0 : burst;
+	budget->tokens = budget->burst;
+	clock_gettime (CLOCK_MONOTONIC, &budget->last_refill);
+
+	pthread_mutex_unlock (&budget->mutex);
+}
+
+/*===========================================================================*
+ * Function name    : try_acquire_request_budget                             *
+ *                                                                           *
+ * Description      : This function take one request from budget without     *
+ *                    blocking                                               *
+ *                                                                           *
+ * Input values(s)  : budget                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : 0 if taken, otherwise milliseconds to wait             *
+ *===========================================================================*/
+uint32_t try_acquire_request_budget (RequestBudget *budget)
+{
+	uint32_t wait_ms = 0;
+
+	pthread_mutex_lock (&budget->mutex);
+
+	if (budget->rate > 0.0)
+	{
+		refill_request_budget (budget);
+
+		if (budget->tokens >= 1.0)
+		{
+			budget->tokens -= 1.0;
+		}
+		else
+		{
+			wait_ms = (uint32_t)((1.0 - budget->tokens) / budget->rate * 1000.0) + 1;
+		}
+	}
+
+	pthread_mutex_unlock (&budget->mutex);
+
+	return wait_ms;
+}
+
+/*===========================================================================*
+ * Function name    : acquire_request_budget_delay                           *
+ *                                                                           *
+ * Description      : This function sleep while waiting for budget           *
+ *                                                                           *
+ * Input values(s)  : wait_ms - milliseconds                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void acquire_request_budget_delay (uint32_t wait_ms)
+{
+	struct timespec delay;
+
+	delay.tv_sec = wait_ms / 1000;
+	delay.tv_nsec = (long)(wait_ms % 1000) * 1000000L;
+
+	while (nanosleep (&delay, &delay) != 0 && errno == EINTR);
+}
+
+/*===========================================================================*
+ * Function name    : acquire_request_budget                                 *
+ *                                                                           *
+ * Description      : This function take one request from budget, sleeping   *
+ *                    until it is available                                  *
+ *                                                                           *
+ * Input values(s)  : budget                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void acquire_request_budget (RequestBudget *budget)
+{
+	uint32_t wait_ms = 0;
+
+	while ((wait_ms = try_acquire_request_budget (budget)) != 0)
+	{
+		acquire_request_budget_delay (wait_ms);
+	}
+}
+
+/*===========================================================================*
+ * Function name    : start_batch_request                                    *
+ *                                                                           *
+ * Description      : This function add request to multi handle              *
+ *                                                                           *
+ * Input values(s)  : multi                                                  *
+ *                    request                                                *
+ *                    list - http headers                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Easy handle or NULL                                    *
+ *===========================================================================*/
+static CURL *start_batch_request (CURLM *multi, SteamRequest *request,
+                                  struct curl_slist *list)
+{
+	CURL *curl = NULL;
+
+	request->response.memory = steam_malloc (MEMORY_CHUNK_SIZE,
+	                                         ALLOC_TAG_TRANSPORT);
+	request->response.size = 0;
+
+	if (request->response.memory == NULL)
+	{
+		return NULL;
+	}
+
+	count_allocation_metrics (MEMORY_CHUNK_SIZE);
+
+	request->response.memory[0] = '\0';
+	request->error_buffer[0] = '\0';
+	request->session_generation = get_session_generation ();
+
+	curl = curl_easy_init ();
+
+	if (curl == NULL)
+	{
+		steam_free (request->response.memory);
+		request->response.memory = NULL;
+
+		return NULL;
+	}
+
+	setup_curl_handle (curl, request->url,
+	                   request->url_referer[0] != '\0' ? request->url_referer : NULL,
+	                   request->post_data, list, &request->response,
+	                   request->error_buffer);
+
+	curl_easy_setopt (curl, CURLOPT_PRIVATE, request);
+
+	begin_request_metrics (classify_metric_endpoint (request->url));
+
+	curl_multi_add_handle (multi, curl);
+
+	return curl;
+}
+
+/*===========================================================================*
+ * Function name    : replay_expired_request                                 *
+ *                                                                           *
+ * Description      : This function restart request that failed on expired   *
+ *                    session after the session is refreshed, once per       *
+ *                    request unless it has no_session_replay                *
+ *                                                                           *
+ * Input values(s)  : multi                                                  *
+ *                    curl - completed easy handle, before cleanup           *
+ *                    request                                                *
+ *                    list - http headers                                    *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS when the request is in flight again/FAILURE    *
+ *===========================================================================*/
+static int8_t replay_expired_request (CURLM *multi, CURL *curl,
+                                      SteamRequest *request,
+                                      struct curl_slist *list)
+{
+	char *effective_url = NULL;
+
+	if (request->curl_code != CURLE_OK || request->count_replays != 0 ||
+	    request->no_session_replay != 0)
+	{
+		return FAILURE;
+	}
+
+	curl_easy_getinfo (curl, CURLINFO_EFFECTIVE_URL, &effective_url);
+
+	if (is_session_expired (effective_url, request->http_code,
+	                        request->response.memory) == 0 ||
+	    refresh_steam_session (request->session_generation) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	steam_free (request->response.memory);
+	request->response.memory = NULL;
+	request->response.size = 0;
+
+	replace_session_id (request->url);
+
+	if (request->post_data != NULL)
+		replace_session_id (request->post_data);
+
+	request->count_replays++;
+
+	count_retry_metrics (classify_metric_endpoint (request->url));
+
+	acquire_request_budget (&g_request_budget);
+
+	if (start_batch_request (multi, request, list) == NULL)
+	{
+		request->curl_code = CURLE_OUT_OF_MEMORY;
+
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : cleanup_thread_multi_handle                            *
+ *                                                                           *
+ * Description      : This function close multi handle of exiting thread     *
+ *                                                                           *
+ * Input values(s)  : multi                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void cleanup_thread_multi_handle (void *multi)
+{
+	curl_multi_cleanup (multi);
+}
+
+/*===========================================================================*
+ * Function name    : init_thread_multi_handle_key                           *
+ *                                                                           *
+ * Description      : This function create key of per-thread multi handles   *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void init_thread_multi_handle_key (void)
+{
+	pthread_key_create (&s_multi_handle_key, cleanup_thread_multi_handle);
+}
+
+/*===========================================================================*
+ * Function name    : acquire_thread_multi_handle                            *
+ *                                                                           *
+ * Description      : This function get multi handle of calling thread, its  *
+ *                    connections stay open from one batch to the next. A    *
+ *                    batch started from on_complete of another batch gets   *
+ *                    a temporary handle                                     *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Multi handle or NULL                                   *
+ *===========================================================================*/
+static CURLM *acquire_thread_multi_handle (void)
+{
+	CURLM *multi = NULL;
+
+	if (s_multi_handle_busy != 0)
+	{
+		return curl_multi_init ();
+	}
+
+	pthread_once (&s_multi_handle_once, init_thread_multi_handle_key);
+
+	multi = pthread_getspecific (s_multi_handle_key);
+
+	if (multi == NULL)
+	{
+		multi = curl_multi_init ();
+
+		if (multi != NULL && pthread_setspecific (s_multi_handle_key, multi) != 0)
+		{
+			curl_multi_cleanup (multi);
+			multi = NULL;
+		}
+	}
+
+	if (multi != NULL)
+		s_multi_handle_busy = 1;
+
+	return multi;
+}
+
+/*===========================================================================*
+ * Function name    : release_thread_multi_handle                            *
+ *                                                                           *
+ * Description      : This function give multi handle back after the batch,  *
+ *                    temporary handle is closed                             *
+ *                                                                           *
+ * Input values(s)  : multi                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void release_thread_multi_handle (CURLM *multi)
+{
+	if (multi == pthread_getspecific (s_multi_handle_key))
+	{
+		s_multi_handle_busy = 0;
+		return;
+	}
+
+	curl_multi_cleanup (multi);
+}
+
+/*===========================================================================*
+ * Function name    : curl_batch_request                                     *
+ *                                                                           *
+ * Description      : This function send requests concurrently within        *
+ *                    g_request_budget over connections of the thread        *
+ *                                                                           *
+ * Input values(s)  : requests                                               *
+ *                    count_requests                                         *
+ *                    max_concurrency - max requests in flight               *
+ *                    on_complete - called for every completed request       *
+ *                                  (optional parameter)                     *
+ *                    user_data                                              *
+ *                                                                           *
+ * Output values(s) : requests - response, http_code and curl_code           *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t curl_batch_request (SteamRequest *requests, size_t count_requests,
+                           uint32_t max_concurrency,
+                           SteamRequestCallback on_complete, void *user_data)
+{
+	CURLM *multi = NULL;
+	CURL *curl = NULL;
+	CURLMsg *message = NULL;
+	SteamRequest *request = NULL;
+	struct curl_slist *list = NULL;
+	size_t next_request = 0;
+	uint32_t count_active = 0;
+	uint32_t wait_ms = 0;
+	int still_running = 0;
+	int messages_left = 0;
+
+	print_debug_information ("Entering the function to "
+	                         "curl_batch_request ()", __LINE__);
+
+	if (max_concurrency == 0)
+		max_concurrency = 1;
+
+	multi = acquire_thread_multi_handle ();
+
+	if (multi == NULL)
+	{
+		return FAILURE;
+	}
+
+	curl_multi_setopt (multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)max_concurrency);
+
+	list = create_steam_headers ();
+
+	while (next_request < count_requests || count_active > 0)
+	{
+		wait_ms = BATCH_WAIT_MS;
+
+		while (count_active < max_concurrency && next_request < count_requests)
+		{
+			uint32_t budget_wait_ms = try_acquire_request_budget (&g_request_budget);
+
+			if (budget_wait_ms != 0)
+			{
+				wait_ms = budget_wait_ms < wait_ms ? budget_wait_ms : wait_ms;
+				break;
+			}
+
+			request = &requests[next_request++];
+			request->count_replays = 0;
+
+			if (start_batch_request (multi, request, list) == NULL)
+			{
+				request->curl_code = CURLE_OUT_OF_MEMORY;
+
+				if (on_complete != NULL)
+					on_complete (request, user_data);
+
+				continue;
+			}
+
+			count_active++;
+		}
+
+		curl_multi_perform (multi, &still_running);
+
+		while ((message = curl_multi_info_read (multi, &messages_left)) != NULL)
+		{
+			if (message->msg != CURLMSG_DONE)
+				continue;
+
+			curl = message->easy_handle;
+
+			curl_easy_getinfo (curl, CURLINFO_PRIVATE, (char **)&request);
+			curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &request->http_code);
+
+			request->curl_code = message->data.result;
+
+			end_request_metrics (classify_metric_endpoint (request->url), curl,
+			                     request->curl_code);
+
+			curl_multi_remove_handle (multi, curl);
+
+			/* Requests in flight when the session expired are sent again
+			 * with the new sessionid */
+			if (replay_expired_request (multi, curl, request, list) == SUCCESS)
+			{
+				curl_easy_cleanup (curl);
+				continue;
+			}
+
+			curl_easy_cleanup (curl);
+
+			count_active--;
+
+			if (request->curl_code != CURLE_OK)
+			{
+				steam_free (request->response.memory);
+				request->response.memory = NULL;
+				request->response.size = 0;
+			}
+
+			if (on_complete != NULL)
+				on_complete (request, user_data);
+		}
+
+		if (count_active > 0)
+		{
+			curl_multi_wait (multi, NULL, 0, wait_ms, NULL);
+		}
+		else if (next_request < count_requests)
+		{
+			/* Nothing in flight, only waiting for the budget */
+			acquire_request_budget_delay (wait_ms);
+		}
+	}
+
+	curl_slist_free_all (list);
+	release_thread_multi_handle (multi);
+
+	print_debug_information ("Exiting the function to "
+	                         "curl_batch_request ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : free_steam_requests                                    *
+ *                                                                           *
+ * Description      : This function free responses of requests, the array    *
+ *                    itself and post data are not freed                     *
+ *                                                                           *
+ * Input values(s)  : requests                                               *
+ *                    count_requests                                         *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_steam_requests (SteamRequest *requests, size_t count_requests)
+{
+	for (size_t index = 0; index < count_requests; index++)
+	{
+		steam_free (requests[index].response.memory);
+		requests[index].response.memory = NULL;
+		requests[index].response.size = 0;
+	}
+}
@@ -0,0 +1,653 @@
+#include <time.h>
+#include <errno.h>
+
+#include "../inc/watchlist.h"
+#include "../inc/money.h"
+#include "../inc/steam.h"
+#include "../inc/transport.h"
+
+static int64_t get_monotonic_ms (void);
+static int8_t parse_order_ladder (struct json_object *, OrderLadder *);
+static int8_t order_ladders_equal (const OrderLadder *, const OrderLadder *);
+static void update_watched_item (Watchlist *, WatchedItem *, SteamRequest *,
+                                 int64_t);
+static uint32_t get_watchlist_wait (const Watchlist *, int64_t);
+
+/*===========================================================================*
+ * Function name    : get_monotonic_ms                                       *
+ *                                                                           *
+ * Description      : This function get monotonic clock                      *
+ *                                                                           *
+ * Input values(s)  : None.                                                  *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Milliseconds                                           *
+ *===========================================================================*/
+static int64_t get_monotonic_ms (void)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/*===========================================================================*
+ * Function name    : create_watchlist                                       *
+ *                                                                           *
+ * Description      : This function create empty watchlist                   *
+ *                                                                           *
+ * Input values(s)  : currency                                               *
+ *                    min_interval_ms - poll interval of volatile items      *
+ *                    max_interval_ms - poll interval of idle items          *
+ *                    max_concurrency                                        *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Watchlist or NULL                                      *
+ *===========================================================================*/
+Watchlist *create_watchlist (uint32_t currency, uint32_t min_interval_ms,
+                             uint32_t max_interval_ms, uint32_t max_concurrency)
+{
+	Watchlist *watchlist = steam_calloc (1, sizeof (Watchlist),
+	                                     ALLOC_TAG_MARKET);
+
+	if (watchlist == NULL)
+	{
+		return NULL;
+	}
+
+	if (min_interval_ms == 0)
+		min_interval_ms = 1;
+
+	watchlist->currency = currency;
+	watchlist->min_interval_ms = min_interval_ms;
+	watchlist->max_interval_ms = max_interval_ms < min_interval_ms ?
+	                             min_interval_ms : max_interval_ms;
+	watchlist->max_concurrency = max_concurrency;
+
+	return watchlist;
+}
+
+/*===========================================================================*
+ * Function name    : free_watchlist                                         *
+ *                                                                           *
+ * Description      : This function free memory for watchlist                *
+ *                                                                           *
+ * Input values(s)  : watchlist                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_watchlist (Watchlist *watchlist)
+{
+	if (watchlist == NULL)
+		return;
+
+	for (size_t index = 0; index < watchlist->count_items; index++)
+	{
+		free_order_book (&watchlist->items[index].book);
+	}
+
+	steam_free (watchlist->items);
+	steam_free (watchlist->subscribers);
+	steam_free (watchlist);
+}
+
+/*===========================================================================*
+ * Function name    : watch_item                                             *
+ *                                                                           *
+ * Description      : This function add item to watchlist, it is polled at   *
+ *                    the next cycle (must not be called from subscriber)    *
+ *                                                                           *
+ * Input values(s)  : watchlist                                              *
+ *                    item_nameid                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t watch_item (Watchlist *watchlist, uint64_t item_nameid)
+{
+	WatchedItem *ptr_items = NULL;
+	WatchedItem *item = NULL;
+
+	for (size_t index = 0; index < watchlist->count_items; index++)
+	{
+		if (watchlist->items[index].item_nameid == item_nameid)
+			return SUCCESS;
+	}
+
+	if (watchlist->count_items == watchlist->capacity)
+	{
+		size_t capacity = watchlist->capacity ? watchlist->capacity * 2 : 64;
+
+		ptr_items = steam_realloc (watchlist->items, capacity * sizeof (WatchedItem),
+		                           ALLOC_TAG_MARKET);
+
+		if (ptr_items == NULL)
+		{
+			return FAILURE;
+		}
+
+		watchlist->items = ptr_items;
+		watchlist->capacity = capacity;
+	}
+
+	item = &watchlist->items[watchlist->count_items++];
+
+	memset (item, 0, sizeof (WatchedItem));
+
+	item->item_nameid = item_nameid;
+	item->interval_ms = watchlist->min_interval_ms;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : unwatch_item                                           *
+ *                                                                           *
+ * Description      : This function remove item from watchlist (must not be  *
+ *                    called from subscriber)                                *
+ *                                                                           *
+ * Input values(s)  : watchlist                                              *
+ *                    item_nameid                                            *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE (not watched)                          *
+ *===========================================================================*/
+int8_t unwatch_item (Watchlist *watchlist, uint64_t item_nameid)
+{
+	for (size_t index = 0; index < watchlist->count_items; index++)
+	{
+		if (watchlist->items[index].item_nameid == item_nameid)
+		{
+			free_order_book (&watchlist->items[index].book);
+
+			watchlist->items[index] = watchlist->items[--watchlist->count_items];
+
+			return SUCCESS;
+		}
+	}
+
+	return FAILURE;
+}
+
+/*===========================================================================*
+ * Function name    : subscribe_order_book                                   *
+ *                                                                           *
+ * Description      : This function add callback called when order book of   *
+ *                    any watched item changes. Previous book is NULL for    *
+ *                    the first snapshot                                     *
+ *                                                                           *
+ * Input values(s)  : watchlist                                              *
+ *                    callback                                               *
+ *                    user_data                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t subscribe_order_book (Watchlist *watchlist, OrderBookSubscriber callback,
+                             void *user_data)
+{
+	WatchSubscriber *ptr_subscribers = NULL;
+
+	ptr_subscribers = steam_realloc (watchlist->subscribers,
+	                                 (watchlist->count_subscribers + 1) *
+	                                 sizeof (WatchSubscriber),
+	                                 ALLOC_TAG_MARKET);
+
+	if (ptr_subscribers == NULL)
+	{
+		return FAILURE;
+	}
+
+	watchlist->subscribers = ptr_subscribers;
+	watchlist->subscribers[watchlist->count_subscribers].callback = callback;
+	watchlist->subscribers[watchlist->count_subscribers].user_data = user_data;
+	watchlist->count_subscribers++;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : parse_order_ladder                                     *
+ *                                                                           *
+ * Description      : This function parse order graph, rows are              *
+ *                    [price, cumulative quantity, description]              *
+ *                                                                           *
+ * Input values(s)  : json_graph                                             *
+ *                                                                           *
+ * Output values(s) : ladder                                                 *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+static int8_t parse_order_ladder (struct json_object *json_graph,
+                                  OrderLadder *ladder)
+{
+	struct json_object *json_row = NULL;
+	size_t count_levels = json_object_array_length (json_graph);
+	int64_t cumulative = 0;
+	int64_t previous = 0;
+
+	if (count_levels == 0)
+	{
+		return SUCCESS;
+	}
+
+	ladder->prices = steam_malloc (count_levels * sizeof (int32_t),
+	                               ALLOC_TAG_MARKET);
+	ladder->quantities = steam_malloc (count_levels * sizeof (uint32_t),
+	                                   ALLOC_TAG_MARKET);
+
+	if (ladder->prices == NULL || ladder->quantities == NULL)
+	{
+		return FAILURE;
+	}
+
+	for (size_t index = 0; index < count_levels; index++)
+	{
+		json_row = json_object_array_get_idx (json_graph, index);
+
+		if (json_object_array_length (json_row) < 2)
+		{
+			return FAILURE;
+		}
+
+		ladder->prices[index] = money_from_double (json_object_get_double (
+		                        json_object_array_get_idx (json_row, 0)));
+
+		cumulative = json_object_get_int64 (json_object_array_get_idx (json_row, 1));
+
+		ladder->quantities[index] = cumulative > previous ? cumulative - previous : 0;
+		previous = cumulative;
+	}
+
+	ladder->count_levels = count_levels;
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : parse_order_book                                       *
+ *                                                                           *
+ * Description      : This function parse itemordershistogram response       *
+ *                    (norender=1)                                           *
+ *                                                                           *
+ * Input values(s)  : data                                                   *
+ *                                                                           *
+ * Output values(s) : order_book                                             *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t parse_order_book (const char *data, OrderBook *order_book)
+{
+	struct json_object *parsed_json = NULL;
+	struct json_object *json_field = NULL;
+	uint64_t value = 0;
+	int8_t return_value = SUCCESS;
+
+	memset (order_book, 0, sizeof (OrderBook));
+
+	parsed_json = parse_json_response (data);
+
+	if (parsed_json == NULL ||
+	    json_object_object_get_ex (parsed_json, "success", &json_field) == 0 ||
+	    json_object_get_int (json_field) != 1)
+	{
+		json_object_put (parsed_json);
+
+		return FAILURE;
+	}
+
+	if (get_json_object_as_uint64 (&value, parsed_json, "highest_buy_order") == SUCCESS)
+		order_book->highest_buy_order = value;
+
+	if (get_json_object_as_uint64 (&value, parsed_json, "lowest_sell_order") == SUCCESS)
+		order_book->lowest_sell_order = value;
+
+	if (json_object_object_get_ex (parsed_json, "buy_order_graph", &json_field))
+		return_value &= parse_order_ladder (json_field, &order_book->buy);
+
+	if (json_object_object_get_ex (parsed_json, "sell_order_graph", &json_field))
+		return_value &= parse_order_ladder (json_field, &order_book->sell);
+
+	json_object_put (parsed_json);
+
+	if (return_value != SUCCESS)
+	{
+		free_order_book (order_book);
+	}
+
+	return return_value;
+}
+
+/*===========================================================================*
+ * Function name    : free_order_book                                        *
+ *                                                                           *
+ * Description      : This function free ladders of order book               *
+ *                                                                           *
+ * Input values(s)  : order_book                                             *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void free_order_book (OrderBook *order_book)
+{
+	steam_free (order_book->buy.prices);
+	steam_free (order_book->buy.quantities);
+	steam_free (order_book->sell.prices);
+	steam_free (order_book->sell.quantities);
+
+	memset (order_book, 0, sizeof (OrderBook));
+}
+
+/*===========================================================================*
+ * Function name    : order_ladders_equal                                    *
+ *                                                                           *
+ * Description      : This function compare two ladders                      *
+ *                                                                           *
+ * Input values(s)  : first                                                  *
+ *                    second                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if equal, FAILURE otherwise                    *
+ *===========================================================================*/
+static int8_t order_ladders_equal (const OrderLadder *first,
+                                   const OrderLadder *second)
+{
+	if (first->count_levels != second->count_levels)
+	{
+		return FAILURE;
+	}
+
+	if (first->count_levels == 0)
+	{
+		return SUCCESS;
+	}
+
+	if (memcmp (first->prices, second->prices,
+	            first->count_levels * sizeof (int32_t)) != 0 ||
+	    memcmp (first->quantities, second->quantities,
+	            first->count_levels * sizeof (uint32_t)) != 0)
+	{
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : order_books_equal                                      *
+ *                                                                           *
+ * Description      : This function compare two order books                  *
+ *                                                                           *
+ * Input values(s)  : first                                                  *
+ *                    second                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS if equal, FAILURE otherwise                    *
+ *===========================================================================*/
+int8_t order_books_equal (const OrderBook *first, const OrderBook *second)
+{
+	if (first->highest_buy_order != second->highest_buy_order ||
+	    first->lowest_sell_order != second->lowest_sell_order)
+	{
+		return FAILURE;
+	}
+
+	if (order_ladders_equal (&first->buy, &second->buy) != SUCCESS)
+	{
+		return FAILURE;
+	}
+
+	return order_ladders_equal (&first->sell, &second->sell);
+}
+
+/*===========================================================================*
+ * Function name    : update_watched_item                                    *
+ *                                                                           *
+ * Description      : This function diff polled book with the previous one,  *
+ *                    notify subscribers on change and adapt interval        *
+ *                                                                           *
+ * Input values(s)  : watchlist                                              *
+ *                    item                                                   *
+ *                    request                                                *
+ *                    now_ms                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+static void update_watched_item (Watchlist *watchlist, WatchedItem *item,
+                                 SteamRequest *request, int64_t now_ms)
+{
+	OrderBook order_book;
+	uint64_t interval_ms = item->interval_ms;
+
+	if (request->response.memory == NULL || request->http_code != 200 ||
+	    parse_order_book (request->response.memory, &order_book) != SUCCESS)
+	{
+		/* Back off on errors (429 included) like on an idle book */
+		interval_ms *= 2;
+	}
+	else if (item->has_book && order_books_equal (&item->book, &order_book) == SUCCESS)
+	{
+		free_order_book (&order_book);
+
+		interval_ms *= 2;
+	}
+	else
+	{
+		for (size_t index = 0; index < watchlist->count_subscribers; index++)
+		{
+			watchlist->subscribers[index].callback (item->item_nameid,
+			                                        item->has_book ? &item->book : NULL,
+			                                        &order_book,
+			                                        watchlist->subscribers[index].user_data);
+		}
+
+		if (item->has_book)
+			interval_ms /= 2;
+
+		free_order_book (&item->book);
+
+		item->book = order_book;
+		item->has_book = 1;
+	}
+
+	if (interval_ms < watchlist->min_interval_ms)
+		interval_ms = watchlist->min_interval_ms;
+
+	if (interval_ms > watchlist->max_interval_ms)
+		interval_ms = watchlist->max_interval_ms;
+
+	item->interval_ms = interval_ms;
+	item->next_poll_ms = now_ms + interval_ms;
+}
+
+/*===========================================================================*
+ * Function name    : get_watchlist_wait                                     *
+ *                                                                           *
+ * Description      : This function get time until the next item is due      *
+ *                                                                           *
+ * Input values(s)  : watchlist                                              *
+ *                    now_ms                                                 *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : Milliseconds                                           *
+ *===========================================================================*/
+static uint32_t get_watchlist_wait (const Watchlist *watchlist, int64_t now_ms)
+{
+	int64_t wait_ms = watchlist->max_interval_ms;
+
+	for (size_t index = 0; index < watchlist->count_items; index++)
+	{
+		if (watchlist->items[index].next_poll_ms - now_ms < wait_ms)
+			wait_ms = watchlist->items[index].next_poll_ms - now_ms;
+	}
+
+	return wait_ms > 0 ? wait_ms : 0;
+}
+
+/*===========================================================================*
+ * Function name    : poll_watchlist                                         *
+ *                                                                           *
+ * Description      : This function poll items that are due, the most        *
+ *                    overdue first, at most WATCHLIST_BATCH_SIZE per cycle. *
+ *                    Requests go through g_request_budget                   *
+ *                                                                           *
+ * Input values(s)  : watchlist                                              *
+ *                                                                           *
+ * Output values(s) : wait_ms - time until the next item is due              *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t poll_watchlist (Watchlist *watchlist, uint32_t *wait_ms)
+{
+	SteamRequest *requests = NULL;
+	size_t due[WATCHLIST_BATCH_SIZE];
+	size_t count_due = 0;
+	int64_t now_ms = get_monotonic_ms ();
+
+	print_debug_information ("Entering the function to "
+	                         "poll_watchlist ()", __LINE__);
+
+	/* Keep the most overdue items, sorted by due time */
+	for (size_t index = 0; index < watchlist->count_items; index++)
+	{
+		int64_t next_poll_ms = watchlist->items[index].next_poll_ms;
+		size_t position = count_due;
+
+		if (next_poll_ms > now_ms)
+			continue;
+
+		while (position > 0 &&
+		       watchlist->items[due[position - 1]].next_poll_ms > next_poll_ms)
+		{
+			position--;
+		}
+
+		if (position == WATCHLIST_BATCH_SIZE)
+			continue;
+
+		if (count_due < WATCHLIST_BATCH_SIZE)
+			count_due++;
+
+		memmove (&due[position + 1], &due[position],
+		         (count_due - 1 - position) * sizeof (size_t));
+
+		due[position] = index;
+	}
+
+	if (count_due > 0)
+	{
+		requests = steam_calloc (count_due, sizeof (SteamRequest),
+		                         ALLOC_TAG_MARKET);
+
+		if (requests == NULL)
+		{
+			return FAILURE;
+		}
+
+		for (size_t index = 0; index < count_due; index++)
+		{
+			snprintf (requests[index].url, sizeof (requests[index].url),
+			          URL_STEAM_MARKET "itemordershistogram?country=US&language=english"
+			          "&currency=%u&item_nameid=%llu&two_factor=0&norender=1",
+			          watchlist->currency,
+			          (unsigned long long)watchlist->items[due[index]].item_nameid);
+
+			snprintf (requests[index].url_referer, sizeof (requests[index].url_referer),
+			          URL_STEAM_MARKET);
+		}
+
+		curl_batch_request (requests, count_due, watchlist->max_concurrency,
+		                    NULL, NULL);
+
+		now_ms = get_monotonic_ms ();
+
+		for (size_t index = 0; index < count_due; index++)
+		{
+			update_watched_item (watchlist, &watchlist->items[due[index]],
+			                     &requests[index], now_ms);
+		}
+
+		free_steam_requests (requests, count_due);
+		steam_free (requests);
+	}
+
+	if (wait_ms != NULL)
+		*wait_ms = get_watchlist_wait (watchlist, get_monotonic_ms ());
+
+	print_debug_information ("Exiting the function to "
+	                         "poll_watchlist ()", __LINE__);
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : run_watchlist                                          *
+ *                                                                           *
+ * Description      : This function poll watchlist until stop_watchlist ()   *
+ *                                                                           *
+ * Input values(s)  : watchlist                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : SUCCESS/FAILURE                                        *
+ *===========================================================================*/
+int8_t run_watchlist (Watchlist *watchlist)
+{
+	struct timespec delay;
+	uint32_t wait_ms = 0;
+
+	__atomic_store_n (&watchlist->running, 1, __ATOMIC_RELEASE);
+
+	while (__atomic_load_n (&watchlist->running, __ATOMIC_ACQUIRE))
+	{
+		if (poll_watchlist (watchlist, &wait_ms) != SUCCESS)
+		{
+			return FAILURE;
+		}
+
+		if (wait_ms == 0)
+			continue;
+
+		/* Wake up regularly to notice stop_watchlist () */
+		if (wait_ms > 1000)
+			wait_ms = 1000;
+
+		delay.tv_sec = wait_ms / 1000;
+		delay.tv_nsec = (long)(wait_ms % 1000) * 1000000L;
+
+		while (nanosleep (&delay, &delay) != 0 && errno == EINTR);
+	}
+
+	return SUCCESS;
+}
+
+/*===========================================================================*
+ * Function name    : stop_watchlist                                         *
+ *                                                                           *
+ * Description      : This function stop run_watchlist () after the current  *
+ *                    cycle (may be called from subscriber or other thread)  *
+ *                                                                           *
+ * Input values(s)  : watchlist                                              *
+ *                                                                           *
+ * Output values(s) : None.                                                  *
+ *                                                                           *
+ * Return value(s)  : None.                                                  *
+ *===========================================================================*/
+void stop_watchlist (Watchlist *watchlist)
+{
+	__atomic_store_n (&watchlist->running, 0, __ATOMIC_RELEASE);
+}